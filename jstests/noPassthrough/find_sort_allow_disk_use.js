@@ -0,0 +1,75 @@
+/**
+ * Tests that a blocking sort in a find command fails once it exceeds its memory limit, unless
+ * 'allowDiskUse' is set, in which case the sort spills to disk and returns all results in order.
+ * Also checks the spilled bytes reported before and after compression.
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");  // For 'getPlanStage'.
+
+    const mongodOptions = {setParameter: "internalQueryExecMaxBlockingSortBytes=65536"};
+    const conn = MongoRunner.runMongod(mongodOptions);
+    assert.neq(null, conn, "mongod failed to start with options " + tojson(mongodOptions));
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.find_sort_allow_disk_use;
+    coll.drop();
+
+    const kNumDocs = 1000;
+    const padding = "x".repeat(256);
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < kNumDocs; ++i) {
+        bulk.insert({_id: i, a: (i * 7) % kNumDocs, padding: padding});
+    }
+    assert.writeOK(bulk.execute());
+
+    // Without 'allowDiskUse' the sort uses more than the memory limit and fails.
+    assert.commandFailedWithCode(testDB.runCommand({find: coll.getName(), sort: {a: 1}}),
+                                 ErrorCodes.OperationFailed);
+
+    // With 'allowDiskUse' the sort spills and returns every document in order.
+    function checkSortedResults(limit) {
+        let cursor = coll.find({}, {a: 1}).sort({a: 1}).allowDiskUse();
+        if (limit) {
+            cursor = cursor.limit(limit);
+        }
+        const results = cursor.toArray();
+        assert.eq(limit || kNumDocs, results.length);
+        for (let i = 0; i < results.length; ++i) {
+            assert.eq(i, results[i].a, tojson(results[i]));
+        }
+    }
+    checkSortedResults(0);
+    checkSortedResults(500);
+
+    // The explain output reports that the sort spilled.
+    const explain = coll.find().sort({a: 1}).allowDiskUse().explain("executionStats");
+    const sortStage = getPlanStage(explain.executionStats.executionStages, "SORT");
+    assert.neq(null, sortStage, tojson(explain));
+    assert.eq(true, sortStage.usedDisk, tojson(sortStage));
+    assert.gt(sortStage.spills, 0, tojson(sortStage));
+
+    // The padding compresses well, so the spilled blocks take less space on disk than the data.
+    assert.gt(sortStage.spilledBytes, 0, tojson(sortStage));
+    assert.lt(sortStage.spilledCompressedBytes, sortStage.spilledBytes, tojson(sortStage));
+
+    const sorterMetrics = assert.commandWorked(testDB.serverStatus()).metrics.sorter;
+    assert.gte(sorterMetrics.spilledBytes, sortStage.spilledBytes, tojson(sorterMetrics));
+    assert.lt(
+        sorterMetrics.spilledCompressedBytes, sorterMetrics.spilledBytes, tojson(sorterMetrics));
+
+    // Without compression, the block headers are written on top of the data.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryExternalSortCompressionLevel: 0}));
+    const uncompressedExplain = coll.find().sort({a: 1}).allowDiskUse().explain("executionStats");
+    const uncompressedSort =
+        getPlanStage(uncompressedExplain.executionStats.executionStages, "SORT");
+    assert.eq(sortStage.spilledBytes, uncompressedSort.spilledBytes, tojson(uncompressedSort));
+    assert.gt(uncompressedSort.spilledCompressedBytes,
+              uncompressedSort.spilledBytes,
+              tojson(uncompressedSort));
+    checkSortedResults(0);
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,61 @@
+/**
+ * Tests that initial sync clones a collection split into ranges of _id through one cursor per
+ * range, including when the _ids are of different types, and that capped collections still keep
+ * their insertion order.
+ * @tags: [requires_replication]
+ */
+(function() {
+    'use strict';
+    load('jstests/libs/check_log.js');
+
+    const rst = new ReplSetTest({nodes: 1});
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const testDB = primary.getDB('test');
+
+    const nDocuments = 1000;
+    let bulk = testDB.mixed.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocuments; i++) {
+        bulk.insert({_id: i, a: i});
+        bulk.insert({_id: 'str' + i, a: i});
+        bulk.insert({_id: {i: i}, a: i});
+        bulk.insert({a: i});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(testDB.mixed.createIndex({a: 1}));
+
+    assert.commandWorked(testDB.createCollection('capped', {capped: true, size: 1024 * 1024}));
+    bulk = testDB.capped.initializeOrderedBulkOp();
+    for (let i = 0; i < nDocuments; i++) {
+        bulk.insert({_id: nDocuments - i});
+    }
+    assert.writeOK(bulk.execute());
+
+    const secondary = rst.add({
+        rsConfig: {priority: 0, votes: 0},
+        setParameter: {
+            maxNumInitialSyncCollectionClonerIdRanges: 4,
+            initialSyncCollectionClonerMinDocumentsPerIdRange: 100,
+        }
+    });
+    rst.reInitiate();
+    rst.awaitSecondaryNodes();
+    rst.awaitReplication();
+
+    secondary.setSlaveOk();
+    const secondaryDB = secondary.getDB('test');
+    assert.eq(4 * nDocuments, secondaryDB.mixed.find().itcount());
+    assert.eq(4 * nDocuments, secondaryDB.mixed.find().hint({a: 1}).itcount());
+    let i = 0;
+    secondaryDB.capped.find().forEach(function(doc) {
+        assert.eq(nDocuments - i, doc._id, 'capped is out of order on the secondary');
+        i++;
+    });
+    assert.eq(nDocuments, i);
+
+    checkLog.contains(secondary, 'Cloning collection test.mixed in 4 ranges of _id');
+
+    rst.stopSet();
+})();
@@ -0,0 +1,86 @@
+/**
+ * Tests that a secondary started with oplogFetcherBatchCompressor gets its batches of oplog entries
+ * packed into single compressed blocks, and with oplogFetcherExcludeWallClockTime gets the entries
+ * without their wall clock times, and that it still ends up with the same data as the primary. Also
+ * tests that it falls back to plain batches when the sync source rejects the compressor.
+ * @tags: [requires_replication]
+ */
+(function() {
+    'use strict';
+
+    const rst = new ReplSetTest({
+        nodes: [
+            {networkMessageCompressors: 'snappy'},
+            {
+              networkMessageCompressors: 'snappy',
+              rsConfig: {priority: 0},
+              setParameter: {
+                  oplogFetcherBatchCompressor: 'snappy',
+                  oplogFetcherExcludeWallClockTime: true,
+              }
+            }
+        ]
+    });
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const secondary = rst.getSecondary();
+    const testDB = primary.getDB('test');
+
+    const nDocuments = 1000;
+    let bulk = testDB.coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocuments; i++) {
+        bulk.insert({_id: i, padding: 'x'.repeat(100)});
+    }
+    assert.writeOK(bulk.execute());
+    rst.awaitReplication();
+
+    secondary.setSlaveOk();
+    assert.eq(nDocuments, secondary.getDB('test').coll.find().itcount());
+
+    const primaryEntry = primary.getDB('local').oplog.rs.findOne({ns: 'test.coll'});
+    const secondaryEntry =
+        secondary.getDB('local').oplog.rs.findOne({ns: 'test.coll', ts: primaryEntry.ts});
+    assert.neq(null, secondaryEntry);
+    assert(primaryEntry.hasOwnProperty('wall'), tojson(primaryEntry));
+    assert(!secondaryEntry.hasOwnProperty('wall'), tojson(secondaryEntry));
+
+    const network = assert.commandWorked(secondary.adminCommand({serverStatus: 1}))
+                        .metrics.repl.network;
+    assert.gt(network.compressedBytes, 0, tojson(network));
+    assert.gt(network.compressedBytesSaved, 0, tojson(network));
+
+    // Asking for compressed batches of anything but the oplog fails.
+    assert.commandFailedWithCode(
+        testDB.runCommand({find: 'coll', batchCompressor: 'snappy'}), ErrorCodes.InvalidOptions);
+
+    rst.stopSet();
+
+    // A secondary whose sync source can't compress batches with the requested compressor falls
+    // back to plain batches.
+    const plainRst = new ReplSetTest({
+        nodes: [
+            {networkMessageCompressors: 'disabled'},
+            {
+              networkMessageCompressors: 'snappy',
+              rsConfig: {priority: 0},
+              setParameter: {oplogFetcherBatchCompressor: 'snappy'}
+            }
+        ]
+    });
+    plainRst.startSet();
+    plainRst.initiate();
+
+    const plainPrimary = plainRst.getPrimary();
+    const plainSecondary = plainRst.getSecondary();
+    assert.writeOK(plainPrimary.getDB('test').coll.insert({_id: 0}, {writeConcern: {w: 2}}));
+
+    plainSecondary.setSlaveOk();
+    assert.eq(1, plainSecondary.getDB('test').coll.find().itcount());
+    const plainNetwork = assert.commandWorked(plainSecondary.adminCommand({serverStatus: 1}))
+                             .metrics.repl.network;
+    assert.eq(0, plainNetwork.compressedBytes, tojson(plainNetwork));
+
+    plainRst.stopSet();
+})();
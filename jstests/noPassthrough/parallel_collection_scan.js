@@ -0,0 +1,85 @@
+/**
+ * Tests that collection scans of large collections run on several threads when
+ * 'internalQueryParallelCollScanThreads' is set, and that they return the same documents as a
+ * serial scan, both for find and for aggregations with a $match and a $group.
+ * @tags: [requires_wiredtiger]
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");  // For 'getPlanStage'.
+
+    const conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, "mongod failed to start");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.parallel_collection_scan;
+    coll.drop();
+
+    const kNumDocs = 5000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < kNumDocs; ++i) {
+        bulk.insert({_id: i, a: i % 10, b: i});
+    }
+    assert.writeOK(bulk.execute());
+
+    const filter = {a: {$in: [1, 3, 5]}, b: {$gte: 100}};
+    const pipeline = [{$match: filter}, {$group: {_id: "$a", total: {$sum: "$b"}}}];
+
+    function setThreads(nThreads) {
+        assert.commandWorked(testDB.adminCommand({
+            setParameter: 1,
+            internalQueryParallelCollScanThreads: nThreads,
+            internalQueryParallelCollScanMinRecords: 1000
+        }));
+    }
+
+    function sortById(docs) {
+        return docs.sort((x, y) => x._id - y._id);
+    }
+
+    setThreads(1);
+    const serialFind = coll.find(filter).toArray();
+    const serialAgg = sortById(coll.aggregate(pipeline).toArray());
+    assert.eq(1470, serialFind.length);
+    assert.eq(null, getPlanStage(coll.find(filter).explain(), "PARALLEL_COLLSCAN"));
+
+    setThreads(4);
+    let explain = coll.find(filter).explain("executionStats");
+    let stage = getPlanStage(explain, "PARALLEL_COLLSCAN");
+    assert.neq(null, stage, tojson(explain));
+    assert.eq(4, stage.workers, tojson(stage));
+    assert.gte(stage.ranges, stage.workers, tojson(stage));
+    assert.eq(kNumDocs, stage.docsExamined, tojson(stage));
+    assert.eq(serialFind.length, explain.executionStats.nReturned, tojson(explain));
+
+    // The parallel scan returns documents in no particular order.
+    assert.sameMembers(serialFind, coll.find(filter).batchSize(10).toArray());
+    assert.eq(serialAgg, sortById(coll.aggregate(pipeline).toArray()));
+    assert.eq(serialFind.length, coll.find(filter).itcount());
+
+    // Scans which need the order of the collection, or filters which cannot run on several
+    // threads, stay serial.
+    function assertSerial(cursor) {
+        const explain = cursor.explain();
+        assert.eq(null, getPlanStage(explain, "PARALLEL_COLLSCAN"), tojson(explain));
+    }
+    assertSerial(coll.find(filter).sort({$natural: 1}));
+    assertSerial(coll.find(filter).limit(5));
+    assertSerial(coll.find({$expr: {$eq: ["$a", 1]}}));
+
+    // Small collections are scanned serially.
+    assert.commandWorked(testDB.adminCommand(
+        {setParameter: 1, internalQueryParallelCollScanMinRecords: kNumDocs + 1}));
+    assertSerial(coll.find(filter));
+
+    // Closing the cursor of a parallel scan before it is exhausted stops its workers.
+    setThreads(4);
+    const cursor = coll.find(filter).batchSize(2);
+    assert(cursor.hasNext());
+    cursor.next();
+    cursor.close();
+    assert.eq(serialFind.length, coll.find(filter).itcount());
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,51 @@
+/**
+ * Tests that a secondary reports the time spent in each phase of fetching and applying batches of
+ * oplog entries as histograms in serverStatus, and how evenly the batches were spread among the
+ * writer threads.
+ * @tags: [requires_replication]
+ */
+(function() {
+    "use strict";
+
+    const rst = new ReplSetTest({nodes: [{}, {rsConfig: {priority: 0}}]});
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const secondary = rst.getSecondary();
+    const testDB = primary.getDB("test");
+
+    // Every update of a single document goes to the same writer thread.
+    assert.writeOK(testDB.hot.insert({_id: 0, n: 0}));
+    let bulk = testDB.hot.initializeOrderedBulkOp();
+    for (let i = 0; i < 1000; i++) {
+        bulk.find({_id: 0}).updateOne({$inc: {n: 1}});
+    }
+    assert.writeOK(bulk.execute());
+    rst.awaitReplication();
+
+    const checkHistogram = function(histogram, name) {
+        assert(histogram, name);
+        assert.gt(histogram.num, 0, name + ": " + tojson(histogram));
+        let total = 0;
+        for (let bucket in histogram.histogram) {
+            total += histogram.histogram[bucket];
+        }
+        assert.eq(histogram.num, total, name + ": " + tojson(histogram));
+    };
+
+    const metrics = assert.commandWorked(secondary.adminCommand({serverStatus: 1})).metrics.repl;
+    checkHistogram(metrics.network.latency.getmores, "network.latency.getmores");
+    checkHistogram(metrics.buffer.latency.push, "buffer.latency.push");
+    for (let phase of ["batchWait", "oplogWrite", "partition", "writers"]) {
+        checkHistogram(metrics.apply.latency[phase], "apply.latency." + phase);
+    }
+    checkHistogram(metrics.apply.writers.skew, "apply.writers.skew");
+    assert.gte(metrics.apply.writers.ops, 1001, tojson(metrics.apply.writers));
+    assert.gte(metrics.apply.writers.busiestWriterOps,
+               metrics.apply.writers.ops / 2,
+               tojson(metrics.apply.writers));
+    assert.gt(metrics.apply.writers.serializedBatches, 0, tojson(metrics.apply.writers));
+
+    rst.stopSet();
+})();
@@ -0,0 +1,64 @@
+/**
+ * Tests that a secondary started with replOplogBufferSpillToDisk keeps fetching while its
+ * applier is stopped, spilling the oplog entries beyond replOplogBufferMaxMemoryMB to disk, and
+ * ends up with the same data as the primary once it applies them.
+ *
+ * @tags: [requires_replication]
+ */
+(function() {
+    "use strict";
+
+    const rst = new ReplSetTest({
+        nodes: [
+            {},
+            {
+              rsConfig: {priority: 0, votes: 0},
+              setParameter: {replOplogBufferSpillToDisk: true, replOplogBufferMaxMemoryMB: 1},
+            },
+        ]
+    });
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const secondary = rst.getSecondary();
+    const coll = primary.getDB("test").getCollection("spill");
+    assert.writeOK(coll.insert({_id: "setup"}, {writeConcern: {w: 2}}));
+
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "rsSyncApplyStop", mode: "alwaysOn"}));
+
+    // Buffer about 8MB of inserts, updates and deletes on the secondary.
+    const nDocuments = 2000;
+    const filler = "x".repeat(4 * 1024);
+    let bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocuments; i++) {
+        bulk.insert({_id: i, x: filler, updated: 0});
+    }
+    assert.writeOK(bulk.execute());
+    bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocuments; i++) {
+        if (i % 2 === 0) {
+            bulk.find({_id: i}).updateOne({$inc: {updated: 1}});
+        } else {
+            bulk.find({_id: i}).removeOne();
+        }
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.soon(function() {
+        const metrics =
+            assert.commandWorked(secondary.adminCommand({serverStatus: 1})).metrics.repl;
+        return metrics.buffer.spills > 0 && metrics.buffer.count >= 2 * nDocuments;
+    }, "secondary did not spill its oplog buffer");
+
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "rsSyncApplyStop", mode: "off"}));
+    rst.awaitReplication();
+
+    const secondaryColl = secondary.getDB("test").getCollection("spill");
+    assert.eq(nDocuments / 2 + 1, secondaryColl.find().itcount());
+    assert.eq(nDocuments / 2, secondaryColl.find({updated: 1}).itcount());
+
+    rst.stopSet();
+})();
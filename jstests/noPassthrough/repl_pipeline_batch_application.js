@@ -0,0 +1,58 @@
+/**
+ * Tests that a secondary started with replPipelineBatchApplication, which writes the next batch to
+ * the oplog and partitions it while the current one is being applied, ends up with the same data as
+ * the primary. Batches creating collections are interleaved with inserts into them, since the next
+ * batch must not be partitioned before a collection it writes to has been created.
+ *
+ * @tags: [requires_replication, requires_document_locking]
+ */
+(function() {
+    "use strict";
+
+    const rst = new ReplSetTest({
+        nodes: [{}, {rsConfig: {priority: 0}}],
+        nodeOptions: {setParameter: {replPipelineBatchApplication: true}}
+    });
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const secondary = rst.getSecondary();
+    const testDB = primary.getDB("test");
+
+    const nRounds = 10;
+    const nDocuments = 1000;
+    for (let round = 0; round < nRounds; round++) {
+        // Documents inserted into a capped collection must keep their order on the secondary,
+        // which requires the batch after the create to see that the collection is capped.
+        assert.commandWorked(
+            testDB.createCollection("capped" + round, {capped: true, size: 1024 * 1024}));
+
+        let cappedBulk = testDB["capped" + round].initializeOrderedBulkOp();
+        let bulk = testDB.plain.initializeUnorderedBulkOp();
+        for (let i = 0; i < nDocuments; i++) {
+            cappedBulk.insert({_id: i});
+            bulk.insert({round: round, i: i});
+        }
+        assert.writeOK(cappedBulk.execute());
+        assert.writeOK(bulk.execute());
+        assert.writeOK(testDB.plain.update({round: round}, {$inc: {updated: 1}}, {multi: true}));
+    }
+    rst.awaitReplication();
+
+    const secondaryDB = secondary.getDB("test");
+    for (let round = 0; round < nRounds; round++) {
+        let i = 0;
+        secondaryDB["capped" + round].find().forEach(function(doc) {
+            assert.eq(i, doc._id, "capped" + round + " is out of order on the secondary");
+            i++;
+        });
+        assert.eq(nDocuments, i);
+    }
+    assert.eq(nRounds * nDocuments, secondaryDB.plain.find({updated: 1}).itcount());
+
+    const metrics = assert.commandWorked(secondary.adminCommand({serverStatus: 1})).metrics;
+    assert.gte(metrics.repl.apply.pipelinedBatches, 0, tojson(metrics.repl.apply));
+
+    rst.stopSet();
+})();
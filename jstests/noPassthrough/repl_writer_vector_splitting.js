@@ -0,0 +1,71 @@
+/**
+ * Tests that a secondary splits a writer vector holding most of a batch into chunks which idle
+ * writer threads take over, keeping the inserts into a capped collection in order, and ends up with
+ * the same data as the primary.
+ *
+ * @tags: [requires_replication, requires_document_locking]
+ */
+(function() {
+    "use strict";
+
+    const rst = new ReplSetTest({
+        nodes: [
+            {},
+            {
+              rsConfig: {priority: 0, votes: 0},
+              setParameter: {replWriterThreadCount: 4, replWriterMinOpsPerChunk: 1},
+            },
+        ]
+    });
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const secondary = rst.getSecondary();
+    const testDB = primary.getDB("test");
+    assert.commandWorked(testDB.createCollection("capped", {capped: true, size: 1024 * 1024}));
+    assert.writeOK(testDB.plain.insert({_id: "setup"}, {writeConcern: {w: 2}}));
+
+    // Buffer the ops on the secondary, so that they are applied in a single batch in which the
+    // writer vector of the capped collection holds most of the ops.
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "rsSyncApplyStop", mode: "alwaysOn"}));
+
+    const nDocuments = 1000;
+    const nPlainDocuments = 100;
+    let cappedBulk = testDB.capped.initializeOrderedBulkOp();
+    for (let i = 0; i < nDocuments; i++) {
+        cappedBulk.insert({_id: i});
+    }
+    assert.writeOK(cappedBulk.execute());
+    let bulk = testDB.plain.initializeUnorderedBulkOp();
+    for (let i = 0; i < nPlainDocuments; i++) {
+        bulk.insert({_id: i});
+        bulk.find({_id: i}).updateOne({$inc: {updated: 1}});
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.soon(function() {
+        const metrics = assert.commandWorked(secondary.adminCommand({serverStatus: 1})).metrics;
+        return metrics.repl.buffer.count >= nDocuments + 2 * nPlainDocuments;
+    }, "secondary did not fetch the ops");
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "rsSyncApplyStop", mode: "off"}));
+    rst.awaitReplication();
+
+    const secondaryDB = secondary.getDB("test");
+    let i = 0;
+    secondaryDB.capped.find().forEach(function(doc) {
+        assert.eq(i, doc._id, "capped is out of order on the secondary");
+        i++;
+    });
+    assert.eq(nDocuments, i);
+    assert.eq(nPlainDocuments, secondaryDB.plain.find({updated: 1}).itcount());
+
+    const writers = assert.commandWorked(secondary.adminCommand({serverStatus: 1}))
+                        .metrics.repl.apply.writers;
+    assert.gt(writers.splitWriterVectors, 0, tojson(writers));
+    assert.gte(writers.splitChunks, 2 * writers.splitWriterVectors, tojson(writers));
+
+    rst.stopSet();
+})();
@@ -0,0 +1,82 @@
+/**
+ * Tests that stages which exceed the stage memory limit fail the query by default, and spill their
+ * buffered data to disk instead when 'internalQueryStageMemUsageSpill' is set. The spilled bytes
+ * are reported per stage in serverStatus.
+ */
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({
+        setParameter: {
+            internalQueryStageMemUsageSwitch: true,
+            internalQueryStageMemUsageMAX: 1,
+            internalQueryStageMemUsageMIN: 4096,
+        }
+    });
+    assert.neq(null, conn, "mongod failed to start");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.stage_mem_spill;
+    coll.drop();
+
+    const kNumDocs = 500;
+    const padding = "x".repeat(128);
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < kNumDocs; ++i) {
+        bulk.insert({
+            _id: i,
+            a: (i * 7) % kNumDocs,
+            text: "common word" + (i % 2 ? " odd" : ""),
+            loc: [i % 50, Math.floor(i / 50)],
+            padding: padding
+        });
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({text: "text"}));
+    assert.commandWorked(coll.createIndex({loc: "2d"}));
+
+    const sortCmd = {find: coll.getName(), sort: {a: 1}, batchSize: kNumDocs};
+    const textCmd = {
+        find: coll.getName(),
+        filter: {$text: {$search: "common odd"}},
+        batchSize: kNumDocs
+    };
+    const nearCmd = {
+        find: coll.getName(),
+        filter: {loc: {$near: [0, 0]}},
+        limit: kNumDocs,
+        batchSize: kNumDocs
+    };
+
+    // Without spilling, the stages fail once they go over the limit.
+    for (let cmd of[sortCmd, textCmd, nearCmd]) {
+        assert.commandFailedWithCode(testDB.runCommand(cmd), ErrorCodes.OperationFailed);
+    }
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryStageMemUsageSpill: true}));
+
+    let res = assert.commandWorked(testDB.runCommand(sortCmd));
+    assert.eq(kNumDocs, res.cursor.firstBatch.length);
+    res.cursor.firstBatch.forEach((doc, i) => assert.eq(i, doc.a, tojson(doc)));
+
+    res = assert.commandWorked(testDB.runCommand(textCmd));
+    assert.eq(kNumDocs, res.cursor.firstBatch.length);
+
+    res = assert.commandWorked(testDB.runCommand(nearCmd));
+    assert.eq(kNumDocs, res.cursor.firstBatch.length);
+    let lastDistance = 0;
+    res.cursor.firstBatch.forEach(function(doc) {
+        const distance = Math.sqrt(doc.loc[0] * doc.loc[0] + doc.loc[1] * doc.loc[1]);
+        assert.gte(distance, lastDistance, tojson(doc));
+        lastDistance = distance;
+    });
+
+    const stageMem = assert.commandWorked(testDB.serverStatus()).StageMemCounters;
+    assert.gt(stageMem["Total Spilled Stage Memory"], 0, tojson(stageMem));
+    for (let stage of["SortStage", "TextOrStage", "GeoNear2DStage"]) {
+        assert.gt(stageMem[stage].SpilledBytes, 0, tojson(stageMem));
+    }
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,52 @@
+/**
+ * Tests that a mongod started with the experimental io_uring transport layer serves clients with
+ * both the synchronous and the adaptive service executor. The test is skipped where the server was
+ * built without it or the kernel does not support io_uring, since mongod then fails to start.
+ */
+(function() {
+    "use strict";
+
+    if (_isWindows()) {
+        return;
+    }
+
+    function runTest(serviceExecutor) {
+        const conn =
+            MongoRunner.runMongod({transportLayer: "uring", serviceExecutor: serviceExecutor});
+        if (conn === null) {
+            jsTestLog("Skipping test, io_uring is not available");
+            return false;
+        }
+
+        const testDB = conn.getDB("test");
+        const nDocuments = 1000;
+        let bulk = testDB.coll.initializeUnorderedBulkOp();
+        for (let i = 0; i < nDocuments; i++) {
+            // Some documents are larger than the registered buffers the reads start out in.
+            bulk.insert({_id: i, padding: "x".repeat(i % 100 === 0 ? 64 * 1024 : 10)});
+        }
+        assert.writeOK(bulk.execute());
+        assert.eq(nDocuments, testDB.coll.find().itcount());
+
+        const awaitShells = [];
+        for (let i = 0; i < 4; i++) {
+            awaitShells.push(startParallelShell(function() {
+                for (let j = 0; j < 100; j++) {
+                    assert.commandWorked(db.adminCommand({ping: 1}));
+                    assert.eq(1000, db.getSiblingDB("test").coll.find().itcount());
+                }
+            }, conn.port));
+        }
+        awaitShells.forEach((awaitShell) => awaitShell());
+
+        const status = assert.commandWorked(testDB.adminCommand({serverStatus: 1}));
+        assert.gte(status.connections.totalCreated, 5, tojson(status.connections));
+
+        MongoRunner.stopMongod(conn);
+        return true;
+    }
+
+    if (runTest("synchronous")) {
+        runTest("adaptive");
+    }
+})();
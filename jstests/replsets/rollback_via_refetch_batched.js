@@ -0,0 +1,92 @@
+/**
+ * Tests that rollback via refetch restores documents inserted or modified with a pre-image in the
+ * oplog without refetching them, refetches the other documents from the sync source in batches
+ * per collection, and reports its progress in replSetGetStatus.
+ */
+(function() {
+    'use strict';
+
+    load("jstests/replsets/libs/rollback_test.js");
+
+    const name = "rollback_via_refetch_batched";
+    const dbName = name;
+    const nDocuments = 100;
+
+    // We disable majority reads on all nodes so that they will use the "rollbackViaRefetch"
+    // algorithm.
+    const replTest = new ReplSetTest({
+        name,
+        nodes: 3,
+        useBridge: true,
+        nodeOptions: {
+            enableMajorityReadConcern: "false",
+            setParameter: {rollbackRefetchBatchSize: 10, rollbackRefetchThreads: 4}
+        }
+    });
+    replTest.startSet();
+    const nodes = replTest.nodeList();
+    replTest.initiate({
+        _id: name,
+        members: [
+            {_id: 0, host: nodes[0]},
+            {_id: 1, host: nodes[1]},
+            {_id: 2, host: nodes[2], arbiterOnly: true}
+        ]
+    });
+
+    const rollbackTest = new RollbackTest(name, replTest);
+
+    const primaryDB = rollbackTest.getPrimary().getDB(dbName);
+    for (let collName of ["a", "b"]) {
+        let bulk = primaryDB[collName].initializeUnorderedBulkOp();
+        for (let i = 0; i < nDocuments; i++) {
+            bulk.insert({_id: i, common: true});
+        }
+        assert.writeOK(bulk.execute());
+    }
+    assert.writeOK(primaryDB.c.insert({_id: 0, common: true}));
+
+    const rollbackNode = rollbackTest.transitionToRollbackOperations();
+    const rollbackDB = rollbackNode.getDB(dbName);
+    for (let collName of ["a", "b"]) {
+        // Roll back updates without a pre-image in the oplog, which are refetched.
+        assert.writeOK(rollbackDB[collName].update({}, {$set: {rollbackNode: 1}}, {multi: true}));
+        // Roll back inserts, which are deleted without being refetched.
+        let bulk = rollbackDB[collName].initializeUnorderedBulkOp();
+        for (let i = nDocuments; i < 2 * nDocuments; i++) {
+            bulk.insert({_id: i});
+        }
+        assert.writeOK(bulk.execute());
+    }
+
+    // Roll back a retryable findAndModify, whose pre-image is in the oplog. The session document
+    // it updated in config.transactions is refetched.
+    const session = rollbackNode.startSession({retryWrites: true});
+    assert.commandWorked(session.getDatabase(dbName).runCommand(
+        {findAndModify: "c", query: {_id: 0}, update: {$set: {rollbackNode: 1}}}));
+
+    const syncSourceNode = rollbackTest.transitionToSyncSourceOperationsBeforeRollback();
+    const syncSourceDB = syncSourceNode.getDB(dbName);
+    assert.writeOK(syncSourceDB.a.update({_id: 0}, {$set: {syncSource: 1}}));
+
+    rollbackTest.transitionToSyncSourceOperationsDuringRollback();
+    rollbackTest.transitionToSteadyStateOperations();
+
+    for (let collName of ["a", "b"]) {
+        assert.eq(nDocuments, rollbackDB[collName].find({common: true}).itcount());
+        assert.eq(0, rollbackDB[collName].find({rollbackNode: 1}).itcount());
+    }
+    assert.eq(1, rollbackDB.a.find({syncSource: 1}).itcount());
+    assert.docEq({_id: 0, common: true}, rollbackDB.c.findOne());
+
+    const status = assert.commandWorked(rollbackNode.adminCommand({replSetGetStatus: 1}));
+    const progress = status.rollbackRefetch;
+    assert(progress, tojson(status));
+    assert.eq(false, progress.active, tojson(progress));
+    assert.eq(2 * nDocuments + 1, progress.docsToRefetch, tojson(progress));
+    assert.eq(2 * nDocuments + 1, progress.docsRefetched, tojson(progress));
+    assert.eq(2 * nDocuments + 1, progress.docsRestoredLocally, tojson(progress));
+    assert.eq(2 * nDocuments / 10 + 1, progress.batchesRefetched, tojson(progress));
+
+    rollbackTest.stop();
+}());
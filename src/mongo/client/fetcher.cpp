@@ -37,6 +37,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/transport/message_compressor_batch.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/log.h"
@@ -57,6 +58,7 @@ const char* kNamespaceFieldName = "ns";
 
 const char* kFirstBatchFieldName = "firstBatch";
 const char* kNextBatchFieldName = "nextBatch";
+const char* kCompressedBatchFieldName = "compressedBatch";
 
 /**
  * Parses cursor response in command result for cursor ID, namespace and documents.
@@ -161,6 +163,27 @@ Status parseCursorResponse(const BSONObj& obj,
         doc.shareOwnershipWith(obj);
     }
 
+    BSONElement compressedBatchElement = cursorObj.getField(kCompressedBatchFieldName);
+    if (!compressedBatchElement.eoo()) {
+        if (!compressedBatchElement.isABSONObj()) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "'" << kCursorFieldName << "."
+                                        << kCompressedBatchFieldName
+                                        << "' field must be an object: "
+                                        << obj);
+        }
+        auto compressedBatch = CompressedBatch::parse(compressedBatchElement.Obj());
+        if (!compressedBatch.isOK()) {
+            return compressedBatch.getStatus();
+        }
+        auto& documents = compressedBatch.getValue().documents;
+        batchData->documents.insert(batchData->documents.end(),
+                                    std::make_move_iterator(documents.begin()),
+                                    std::make_move_iterator(documents.end()));
+        batchData->compressedBatchBytes = compressedBatch.getValue().compressedBytes;
+        batchData->uncompressedBatchBytes = compressedBatch.getValue().uncompressedBytes;
+    }
+
     return Status::OK();
 }
 
@@ -69,6 +69,10 @@ public:
         struct OtherFields {
             BSONObj metadata;
         } otherFields;
+        // Bytes the documents took on the wire and once decompressed, when the remote packed
+        // them into one compressed block. Both are zero for an uncompressed batch.
+        std::size_t compressedBatchBytes = 0;
+        std::size_t uncompressedBatchBytes = 0;
         Milliseconds elapsedMillis = Milliseconds(0);
         bool first = false;
     };
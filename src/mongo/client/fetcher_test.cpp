@@ -35,6 +35,10 @@
 #include "mongo/executor/network_interface_mock.h"
 #include "mongo/executor/thread_pool_task_executor_test_fixture.h"
 #include "mongo/rpc/metadata.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_batch.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_snappy.h"
 
 #include "mongo/unittest/unittest.h"
 
@@ -580,6 +584,61 @@ TEST_F(FetcherTest, FetchOneDocument) {
     ASSERT_BSONOBJ_EQ(doc, documents.front());
 }
 
+TEST_F(FetcherTest, FetchCompressedBatch) {
+    auto& registry = MessageCompressorRegistry::get();
+    if (!registry.getCompressor("snappy")) {
+        registry.setSupportedCompressors({"snappy"});
+        registry.registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+    }
+
+    ASSERT_OK(fetcher->schedule());
+    const BSONObj doc1 = BSON("_id" << 1);
+    const BSONObj doc2 = BSON("_id" << 2);
+    BufBuilder buf;
+    doc1.appendSelfToBufBuilder(buf);
+    doc2.appendSelfToBufBuilder(buf);
+    BSONObjBuilder cursorBob;
+    cursorBob.append("firstBatch", BSONArray());
+    CompressedBatch::append(registry.getCompressor("snappy"),
+                            ConstDataRange(buf.buf(), buf.len()),
+                            2,
+                            "compressedBatch",
+                            &cursorBob);
+    cursorBob.append("id", 0LL);
+    cursorBob.append("ns", "db.coll");
+    processNetworkResponse(BSON("cursor" << cursorBob.obj() << "ok" << 1),
+                           ReadyQueueState::kEmpty,
+                           FetcherState::kInactive);
+    ASSERT_OK(status);
+    ASSERT_EQUALS(0, cursorId);
+    ASSERT_EQUALS(2U, documents.size());
+    ASSERT_BSONOBJ_EQ(doc1, documents.front());
+    ASSERT_BSONOBJ_EQ(doc2, documents.back());
+}
+
+TEST_F(FetcherTest, CompressedBatchWithUnknownCompressorIsRejected) {
+    ASSERT_OK(fetcher->schedule());
+    const BSONObj compressedBatch = BSON("compressor"
+                                         << "lz4"
+                                         << "count"
+                                         << 1
+                                         << "size"
+                                         << 5
+                                         << "data"
+                                         << BSONBinData("", 0, BinDataGeneral));
+    processNetworkResponse(BSON("cursor" << BSON("id" << 0LL << "ns"
+                                                      << "db.coll"
+                                                      << "firstBatch"
+                                                      << BSONArray()
+                                                      << "compressedBatch"
+                                                      << compressedBatch)
+                                         << "ok"
+                                         << 1),
+                           ReadyQueueState::kEmpty,
+                           FetcherState::kInactive);
+    ASSERT_EQUALS(ErrorCodes::BadValue, status.code());
+}
+
 TEST_F(FetcherTest, SetNextActionToContinueWhenNextBatchIsNotAvailable) {
     ASSERT_OK(fetcher->schedule());
     const BSONObj doc = BSON("_id" << 1);
@@ -70,6 +70,8 @@ public:
 
         virtual void ignoreUniqueConstraint() = 0;
 
+        virtual void allowParallelKeyGeneration(std::size_t numWorkers) = 0;
+
         virtual void removeExistingIndexes(std::vector<BSONObj>* specs) const = 0;
 
         virtual StatusWith<std::vector<BSONObj>> init(const std::vector<BSONObj>& specs) = 0;
@@ -159,6 +161,15 @@ public:
         return this->_impl().ignoreUniqueConstraint();
     }
 
+    /**
+     * If this is called before init(), the keys of the inserted documents are generated and added
+     * to the external sorters of the indexes on up to 'numWorkers' threads, while insert() only
+     * hands the documents over. This only affects foreground builds.
+     */
+    inline void allowParallelKeyGeneration(const std::size_t numWorkers) {
+        return this->_impl().allowParallelKeyGeneration(numWorkers);
+    }
+
     /**
      * Removes pre-existing indexes from 'specs'. If this isn't done, init() may fail with
      * IndexAlreadyExists.
@@ -32,6 +32,8 @@
 
 #include "mongo/db/catalog/index_create_impl.h"
 
+#include <deque>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/init.h"
 #include "mongo/client/dbclientinterface.h"
@@ -50,8 +52,12 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -137,15 +143,169 @@ private:
     MultiIndexBlockImpl* const _indexer;
 };
 
+/**
+ * Generates the keys of the documents inserted into a foreground index build on worker threads.
+ * Each worker owns the indexes whose position is its number modulo the number of workers, and
+ * adds the keys of every document to their bulk builders, which are not thread safe. The
+ * documents are handed over in batches shared by all the workers, and the number of batches in
+ * flight is bounded, so that insert() waits for the slowest worker rather than buffer the whole
+ * collection.
+ */
+class MultiIndexBlockImpl::KeyGenerator {
+    MONGO_DISALLOW_COPYING(KeyGenerator);
+
+public:
+    KeyGenerator(std::vector<IndexToBuild>* indexes, std::size_t numWorkers)
+        : _indexes(indexes), _numWorkers(numWorkers), _nextBatch(numWorkers, 0) {
+        for (std::size_t worker = 0; worker < numWorkers; ++worker) {
+            _workers.emplace_back([this, worker] { _workerLoop(worker); });
+        }
+    }
+
+    ~KeyGenerator() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _shutdown = true;
+        }
+        _cv.notify_all();
+        for (auto&& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Buffers the document, and hands the buffered documents over to the workers once there are
+     * enough of them. Returns the first error of the workers, if any.
+     */
+    Status insert(const BSONObj& doc, const RecordId& loc) {
+        _buffered.emplace_back(doc.getOwned(), loc);
+        _bufferedBytes += doc.objsize();
+        if (_buffered.size() < kMaxBatchDocuments && _bufferedBytes < kMaxBatchBytes) {
+            return Status::OK();
+        }
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return !_status.isOK() || _batches.size() < kMaxBatchesInFlight; });
+        if (!_status.isOK()) {
+            return _status;
+        }
+        _handOverBuffered(lk);
+        return Status::OK();
+    }
+
+    /**
+     * Hands the remaining documents over and waits until the workers have generated all the keys.
+     */
+    Status done() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (!_buffered.empty()) {
+            _handOverBuffered(lk);
+        }
+        _cv.wait(lk, [&] { return !_status.isOK() || _batches.empty(); });
+        return _status;
+    }
+
+private:
+    using Batch = std::vector<std::pair<BSONObj, RecordId>>;
+
+    // Documents are handed over in batches of up to this many documents or bytes.
+    static constexpr std::size_t kMaxBatchDocuments = 1000;
+    static constexpr std::size_t kMaxBatchBytes = 4 * 1024 * 1024;
+    static constexpr std::size_t kMaxBatchesInFlight = 8;
+
+    void _handOverBuffered(WithLock) {
+        _batches.push_back(std::make_shared<Batch>());
+        _batches.back()->swap(_buffered);
+        _bufferedBytes = 0;
+        _cv.notify_all();
+    }
+
+    void _workerLoop(std::size_t worker) {
+        setThreadName(str::stream() << "indexKeyGenerator-" << worker);
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        while (true) {
+            _cv.wait(lk, [&] { return _shutdown || _nextBatch[worker] < _endBatch(); });
+            if (_shutdown) {
+                return;
+            }
+            std::shared_ptr<Batch> batch = _batches[_nextBatch[worker] - _firstBatch];
+            lk.unlock();
+
+            auto status = _generateKeys(worker, *batch);
+
+            lk.lock();
+            if (!status.isOK() && _status.isOK()) {
+                _status = status;
+            }
+            ++_nextBatch[worker];
+            // The front batch is released once every worker has generated its keys.
+            while (!_batches.empty() &&
+                   *std::min_element(_nextBatch.begin(), _nextBatch.end()) > _firstBatch) {
+                _batches.pop_front();
+                ++_firstBatch;
+            }
+            _cv.notify_all();
+        }
+    }
+
+    Status _generateKeys(std::size_t worker, const Batch& batch) noexcept {
+        try {
+            for (std::size_t i = worker; i < _indexes->size(); i += _numWorkers) {
+                auto& index = (*_indexes)[i];
+                for (auto&& doc : batch) {
+                    if (index.filterExpression && !index.filterExpression->matchesBSON(doc.first)) {
+                        continue;
+                    }
+                    // The bulk builder does not use the OperationContext, which belongs to the
+                    // thread inserting the documents.
+                    int64_t unused;
+                    auto status =
+                        index.bulk->insert(nullptr, doc.first, doc.second, index.options, &unused);
+                    if (!status.isOK()) {
+                        return status;
+                    }
+                }
+            }
+        } catch (...) {
+            return exceptionToStatus();
+        }
+        return Status::OK();
+    }
+
+    std::uint64_t _endBatch() const {
+        return _firstBatch + _batches.size();
+    }
+
+    std::vector<IndexToBuild>* const _indexes;
+    const std::size_t _numWorkers;
+
+    // Only used by the thread inserting the documents.
+    Batch _buffered;
+    std::size_t _bufferedBytes = 0;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;  // Signaled when batches are handed over or released.
+    std::deque<std::shared_ptr<Batch>> _batches;  // Batches some worker has not processed yet.
+    std::uint64_t _firstBatch = 0;                // Sequence number of the front of '_batches'.
+    std::vector<std::uint64_t> _nextBatch;        // Next batch to process by each worker.
+    Status _status = Status::OK();                // First error of the workers.
+    bool _shutdown = false;
+    std::vector<stdx::thread> _workers;
+};
+
 MultiIndexBlockImpl::MultiIndexBlockImpl(OperationContext* opCtx, Collection* collection)
     : _collection(collection),
       _opCtx(opCtx),
       _buildInBackground(false),
       _allowInterruption(false),
       _ignoreUnique(false),
+      _keyGenerationWorkers(0),
       _needToCleanup(true) {}
 
 MultiIndexBlockImpl::~MultiIndexBlockImpl() {
+    // The workers must be stopped before the indexes they generate keys for are failed.
+    _keyGenerator.reset();
+
     if (!_needToCleanup && !_indexes.empty()) {
         _collection->infoCache()->clearQueryCache();
     }
@@ -314,6 +474,12 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlockImpl::init(const std::vector<BSO
 
     wunit.commit();
 
+    if (_keyGenerationWorkers > 0 && !_buildInBackground && !_indexes.empty()) {
+        const auto numWorkers = std::min(_keyGenerationWorkers, _indexes.size());
+        log() << "\t generating index keys on " << numWorkers << " worker threads";
+        _keyGenerator = stdx::make_unique<KeyGenerator>(&_indexes, numWorkers);
+    }
+
     if (MONGO_FAIL_POINT(crashAfterStartingIndexBuild)) {
         log() << "Index build interrupted due to 'crashAfterStartingIndexBuild' failpoint. Exiting "
                  "after waiting for changes to become durable.";
@@ -484,6 +650,10 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection(std::set<RecordId>* d
 }
 
 Status MultiIndexBlockImpl::insert(const BSONObj& doc, const RecordId& loc) {
+    if (_keyGenerator) {
+        return _keyGenerator->insert(doc, loc);
+    }
+
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].filterExpression && !_indexes[i].filterExpression->matchesBSON(doc)) {
             continue;
@@ -505,6 +675,13 @@ Status MultiIndexBlockImpl::insert(const BSONObj& doc, const RecordId& loc) {
 
 Status MultiIndexBlockImpl::doneInserting(std::set<RecordId>* dupsOut) {
     invariant(!_opCtx->lockState()->inAWriteUnitOfWork());
+    if (_keyGenerator) {
+        auto status = _keyGenerator->done();
+        _keyGenerator.reset();
+        if (!status.isOK()) {
+            return status;
+        }
+    }
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].bulk == NULL)
             continue;
@@ -524,6 +701,7 @@ Status MultiIndexBlockImpl::doneInserting(std::set<RecordId>* dupsOut) {
 }
 
 void MultiIndexBlockImpl::abortWithoutCleanup() {
+    _keyGenerator.reset();
     _indexes.clear();
     _needToCleanup = false;
 }
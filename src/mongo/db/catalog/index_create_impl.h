@@ -101,6 +101,17 @@ public:
         _ignoreUnique = true;
     }
 
+    /**
+     * If this is called before init(), the keys of the inserted documents are generated and added
+     * to the external sorters of the indexes on up to 'numWorkers' threads, each of which owns a
+     * subset of the indexes. insert() then only buffers the documents and hands them over in
+     * batches, and doneInserting() waits for the workers before merging the sorted keys. This only
+     * affects foreground builds.
+     */
+    void allowParallelKeyGeneration(std::size_t numWorkers) override {
+        _keyGenerationWorkers = numWorkers;
+    }
+
     /**
      * Removes pre-existing indexes from 'specs'. If this isn't done, init() may fail with
      * IndexAlreadyExists.
@@ -191,6 +202,7 @@ public:
 private:
     class SetNeedToCleanupOnRollback;
     class CleanupIndexesVectorOnRollback;
+    class KeyGenerator;
 
     struct IndexToBuild {
         std::unique_ptr<IndexCatalogImpl::IndexBuildBlock> block;
@@ -204,6 +216,10 @@ private:
 
     std::vector<IndexToBuild> _indexes;
 
+    // Generates the keys of the inserted documents on worker threads. Declared after '_indexes',
+    // whose bulk builders it fills, so that it is destroyed first.
+    std::unique_ptr<KeyGenerator> _keyGenerator;
+
     std::unique_ptr<BackgroundOperation> _backgroundOperation;
 
     // Pointers not owned here and must outlive 'this'
@@ -213,6 +229,7 @@ private:
     bool _buildInBackground;
     bool _allowInterruption;
     bool _ignoreUnique;
+    std::size_t _keyGenerationWorkers;
 
     bool _needToCleanup;
 };
@@ -387,6 +387,10 @@ public:
 
         // Stream query results, adding them to a BSONArray as we go.
         CursorResponseBuilder firstBatch(/*isInitialResponse*/ true, &result);
+        if (originalQR.getBatchCompressor()) {
+            firstBatch.compressBatchWith(
+                FindCommon::getBatchCompressor(nss, *originalQR.getBatchCompressor()));
+        }
         BSONObj obj;
         PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
         long long numResults = 0;
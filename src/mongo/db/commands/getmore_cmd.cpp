@@ -402,6 +402,10 @@ public:
 
         CursorId respondWithId = 0;
         CursorResponseBuilder nextBatch(/*isInitialResponse*/ false, &result);
+        if (request.batchCompressor) {
+            nextBatch.compressBatchWith(
+                FindCommon::getBatchCompressor(request.nss, *request.batchCompressor));
+        }
         BSONObj obj;
         PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
         long long numResults = 0;
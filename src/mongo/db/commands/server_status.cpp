@@ -34,6 +34,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_internal.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/log.h"
@@ -217,6 +218,11 @@ extern StageMemCounter globalStageMemCounters;
 
 StageMemStatSection globalStageMemStat("StageMemCounters", &globalStageMemCounters);
 
+static ServerStatusMetricField<Counter64> displaySorterSpilledBytes("sorter.spilledBytes",
+                                                                    &sorterSpilledBytes);
+static ServerStatusMetricField<Counter64> displaySorterSpilledCompressedBytes(
+    "sorter.spilledCompressedBytes", &sorterSpilledCompressedBytes);
+
 namespace {
 
 // some universal sections
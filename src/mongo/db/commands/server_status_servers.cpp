@@ -37,6 +37,7 @@
 #include "mongo/util/net/hostname_canonicalization.h"
 #include "mongo/util/net/socket_utils.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -82,6 +83,10 @@ public:
         BSONObjBuilder b;
         networkCounter.append(b);
         appendMessageCompressionStats(&b);
+        {
+            BSONObjBuilder bufferPoolBuilder(b.subobjStart("bufferPool"));
+            SharedBuffer::appendPoolStats(&bufferPoolBuilder);
+        }
         auto executor = opCtx->getServiceContext()->getServiceExecutor();
         if (executor)
             executor->appendStats(&b);
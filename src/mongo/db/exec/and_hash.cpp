@@ -32,8 +32,10 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace {
 
@@ -102,7 +104,7 @@ bool AndHashStage::isEOF() {
     // Or we're streaming in results from the last child.
 
     // If there's nothing to probe against, we're EOF.
-    if (_dataMap.empty()) {
+    if (dataMapEmpty()) {
         return true;
     }
 
@@ -118,8 +120,11 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
     }
 
     if (chkCachedMemOversize()) {
-        *out = chkMemFailureRet(_ws);
-        return PlanStage::FAILURE;
+        if (!canSpillCachedMem()) {
+            *out = chkMemFailureRet(_ws);
+            return PlanStage::FAILURE;
+        }
+        spillDataMap();
     }
 
     // Fast-path for one of our children being EOF immediately.  We work each child a few times.
@@ -148,6 +153,7 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
                     // A child went right to EOF.  Bail out.
                     _hashingChildren = false;
                     _dataMap.clear();
+                    releaseSpilled();
                     return PlanStage::IS_EOF;
                 } else if (PlanStage::ADVANCED == childStatus) {
                     // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we
@@ -203,11 +209,19 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
     // hash map.
 
     // We should be EOF if we're not hashing results and the dataMap is empty.
-    verify(!_dataMap.empty());
+    verify(!dataMapEmpty());
 
     // We probe _dataMap with the last child.
     verify(_currentChild == _children.size() - 1);
 
+    // Callers stop working the stage once it is EOF, which it becomes as soon as the last child is
+    // exhausted, whatever is left in the hash table.
+    ON_BLOCK_EXIT([this] {
+        if (isEOF()) {
+            releaseSpilled();
+        }
+    });
+
     // Get the next result for the (_children.size() - 1)-th child.
     StageState childStatus = workChild(_children.size() - 1, out);
     if (PlanStage::ADVANCED != childStatus) {
@@ -224,6 +238,7 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
         return PlanStage::NEED_TIME;
     }
 
+    restoreSpilled(member->recordId);
     DataMap::iterator it = _dataMap.find(member->recordId);
     if (_dataMap.end() == it) {
         // Child's output wasn't in every previous child.  Throw it out.
@@ -270,7 +285,8 @@ PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
             return PlanStage::NEED_TIME;
         }
 
-        if (!_dataMap.insert(std::make_pair(member->recordId, id)).second) {
+        if (_spilledDataMap.count(member->recordId) ||
+            !_dataMap.insert(std::make_pair(member->recordId, id)).second) {
             // Didn't insert because we already had this RecordId inside the map. This should only
             // happen if we're seeing a newer copy of the same doc in a more recent snapshot.
             // Throw out the newer copy of the doc.
@@ -291,12 +307,13 @@ PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
         _currentChild = 1;
 
         // If our first child was empty, don't scan any others, no possible results.
-        if (_dataMap.empty()) {
+        if (dataMapEmpty()) {
             _hashingChildren = false;
+            releaseSpilled();
             return PlanStage::IS_EOF;
         }
 
-        _specificStats.mapAfterChild.push_back(_dataMap.size());
+        _specificStats.mapAfterChild.push_back(_dataMap.size() + _spilledDataMap.size());
 
         return PlanStage::NEED_TIME;
     } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
@@ -331,6 +348,7 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
         }
 
         verify(member->hasRecordId());
+        restoreSpilled(member->recordId);
         size_t cachedSize = 0;
         if (_dataMap.end() == _dataMap.find(member->recordId)) {
             // Ignore.  It's not in any previous child.
@@ -374,8 +392,17 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
                 ++it;
             }
         }
+        SpilledDataMap::iterator spilledIt = _spilledDataMap.begin();
+        while (spilledIt != _spilledDataMap.end()) {
+            if (_seenMap.end() == _seenMap.find(spilledIt->first)) {
+                releaseSize += _dataMapItemSize;
+                spilledIt = _spilledDataMap.erase(spilledIt);
+            } else {
+                ++spilledIt;
+            }
+        }
 
-        _specificStats.mapAfterChild.push_back(_dataMap.size());
+        _specificStats.mapAfterChild.push_back(_dataMap.size() + _spilledDataMap.size());
         releaseSize += _seenMap.size() * sizeof(RecordId);
         decCachedMemory(releaseSize);
         _seenMap.clear();
@@ -383,8 +410,9 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
         // _dataMap is now the intersection of the first _currentChild nodes.
 
         // If we have nothing to AND with after finishing any child, stop.
-        if (_dataMap.empty()) {
+        if (dataMapEmpty()) {
             _hashingChildren = false;
+            releaseSpilled();
             return PlanStage::IS_EOF;
         }
 
@@ -437,6 +465,7 @@ void AndHashStage::doInvalidate(OperationContext* opCtx,
     //
     // So, we flag and try to pick it up later.
     size_t releaseSize = 0;
+    restoreSpilled(dl);
     DataMap::iterator it = _dataMap.find(dl);
     if (_dataMap.end() != it) {
         WorkingSetID id = it->second;
@@ -466,6 +495,49 @@ void AndHashStage::doInvalidate(OperationContext* opCtx,
     }
 }
 
+void AndHashStage::spillDataMap() {
+    if (_dataMap.empty()) {
+        return;
+    }
+
+    if (!_spillArea) {
+        _spillArea = stdx::make_unique<WorkingSetSpillArea>(storageGlobalParams.dbpath + "/_tmp");
+    }
+
+    size_t releaseSize = 0;
+    for (auto&& entry : _dataMap) {
+        const size_t memUsage = _ws->get(entry.second)->getMemUsage();
+        _spilledDataMap[entry.first] = _spillArea->spill(_ws, entry.second);
+        releaseSize += memUsage;
+    }
+    _dataMap.clear();
+
+    _memUsage -= releaseSize;
+    decCachedMemory(releaseSize);
+    incSpilledMemory(releaseSize);
+}
+
+void AndHashStage::releaseSpilled() {
+    decCachedMemory(_spilledDataMap.size() * _dataMapItemSize);
+    _spilledDataMap.clear();
+    _spillArea.reset();
+}
+
+void AndHashStage::restoreSpilled(const RecordId& recordId) {
+    SpilledDataMap::iterator it = _spilledDataMap.find(recordId);
+    if (_spilledDataMap.end() == it) {
+        return;
+    }
+
+    WorkingSetID id = _spillArea->restore(_ws, it->second);
+    _spilledDataMap.erase(it);
+    _dataMap[recordId] = id;
+
+    const size_t memUsage = _ws->get(id)->getMemUsage();
+    _memUsage += memUsage;
+    incCachedMemory(memUsage);
+}
+
 unique_ptr<PlanStageStats> AndHashStage::getStats() {
     _commonStats.isEOF = isEOF();
 
@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
@@ -50,6 +51,9 @@ namespace mongo {
  * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
  * operates with RecordIds, we are unable to evaluate the AND for the invalidated RecordId, and it
  * must be fully matched later.
+ *
+ * When the stage memory limit is exceeded and spilling is enabled, the members buffered in the
+ * hash table are moved to disk and read back when a later child hits their RecordId.
  */
 class AndHashStage final : public PlanStage {
 public:
@@ -97,6 +101,29 @@ private:
     StageState hashOtherChildren(WorkingSetID* out);
     StageState workChild(size_t childNo, WorkingSetID* out);
 
+    /**
+     * Moves every member in _dataMap to _spilledDataMap.
+     */
+    void spillDataMap();
+
+    /**
+     * If 'recordId' was spilled, reads its member back into _dataMap.
+     */
+    void restoreSpilled(const RecordId& recordId);
+
+    /**
+     * Drops whatever is left in _spilledDataMap and removes the spill file. Called once the stage
+     * is EOF, since nothing spilled can be returned anymore.
+     */
+    void releaseSpilled();
+
+    /**
+     * True if neither _dataMap nor _spilledDataMap holds anything.
+     */
+    bool dataMapEmpty() const {
+        return _dataMap.empty() && _spilledDataMap.empty();
+    }
+
     // Not owned by us.
     const Collection* _collection;
 
@@ -114,6 +141,13 @@ private:
     DataMap _dataMap;
     static const size_t _dataMapItemSize;
 
+    // Entries of _dataMap whose members were moved to disk. Each is accounted for with the same
+    // _dataMapItemSize as an in-memory entry.
+    typedef stdx::unordered_map<RecordId, WorkingSetSpillArea::Location, RecordId::Hasher>
+        SpilledDataMap;
+    SpilledDataMap _spilledDataMap;
+    std::unique_ptr<WorkingSetSpillArea> _spillArea;
+
     // Keeps track of what elements from _dataMap subsequent children have seen.
     // Only used while _hashingChildren.
     typedef stdx::unordered_set<RecordId, RecordId::Hasher> SeenMap;
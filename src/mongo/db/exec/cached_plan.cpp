@@ -36,6 +36,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/stage_memory_admission.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
@@ -114,7 +115,9 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
             updatePlanCache();
             return Status::OK();
         } else if (PlanStage::NEED_YIELD == state) {
-            if (id == WorkingSet::INVALID_ID) {
+            if (id == WorkingSet::INVALID_ID && StageMemoryReservation::isWaitPending(getOpCtx())) {
+                // A stage is waiting for memory, which the yield below waits for.
+            } else if (id == WorkingSet::INVALID_ID) {
                 if (!yieldPolicy->canAutoYield()) {
                     throw WriteConflictException();
                 }
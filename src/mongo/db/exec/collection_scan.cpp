@@ -97,6 +97,8 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    makeUnownedResultOwned();
+
     boost::optional<Record> record;
     const bool needToMakeCursor = !_cursor;
     try {
@@ -200,6 +202,68 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+bool CollectionScan::canWorkBatch() {
+    return _cursor && !_isDead && !_commonStats.isEOF && !_params.tailable && !_params.maxTs &&
+        !_params.shouldTrackLatestOplogTimestamp && !_params.maxScan &&
+        !_params.stopApplyingFilterAfterFirstMatch &&
+        (_params.start.isNull() || !_lastSeenId.isNull());
+}
+
+PlanStage::StageState CollectionScan::doWorkBatch(size_t maxWorks,
+                                                  std::vector<WorkingSetID>* out,
+                                                  WorkingSetID* id) {
+    const size_t first = out->size();
+    size_t works = 0;
+    StageState state = PlanStage::NEED_TIME;
+    try {
+        while (works < maxWorks) {
+            ++works;
+
+            // Any call on the cursor invalidates the data of the previous record.
+            makeUnownedResultOwned();
+
+            if (auto fetcher = _cursor->fetcherForNext()) {
+                WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+                member->setFetcher(fetcher.release());
+                *id = _wsidForFetch;
+                state = PlanStage::NEED_YIELD;
+                break;
+            }
+
+            boost::optional<Record> record = _cursor->next();
+            if (!record) {
+                _commonStats.isEOF = true;
+                state = PlanStage::IS_EOF;
+                break;
+            }
+            _lastSeenId = record->id;
+
+            // Test the record while its data is valid, so that documents which don't match are
+            // never copied. The last match stays unowned until the cursor moves or we yield.
+            ++_specificStats.docsTested;
+            WorkingSetID memberId = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(memberId);
+            member->recordId = record->id;
+            member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(),
+                           record->data.releaseToBson()};
+            _workingSet->transitionToRecordIdAndObj(memberId);
+            if (!Filter::passes(member, _filter)) {
+                _workingSet->free(memberId);
+                continue;
+            }
+            _unownedResultId = memberId;
+            out->push_back(memberId);
+        }
+    } catch (const WriteConflictException&) {
+        // The cursor is left where it was, so the next batch picks up after the last record.
+        *id = WorkingSet::INVALID_ID;
+        state = PlanStage::NEED_YIELD;
+    }
+
+    recordBatchStats(works, out->size() - first, state);
+    return state;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -261,7 +325,15 @@ void CollectionScan::doInvalidate(OperationContext* opCtx,
     }
 }
 
+void CollectionScan::makeUnownedResultOwned() {
+    if (_unownedResultId != WorkingSet::INVALID_ID && !_workingSet->isFree(_unownedResultId)) {
+        _workingSet->get(_unownedResultId)->makeObjOwnedIfNeeded();
+    }
+    _unownedResultId = WorkingSet::INVALID_ID;
+}
+
 void CollectionScan::doSaveState() {
+    makeUnownedResultOwned();
     if (_cursor) {
         _cursor->save();
     }
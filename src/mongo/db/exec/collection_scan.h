@@ -58,6 +58,12 @@ public:
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
 
+    /**
+     * Plain forward or backward scans which have created their cursor work in batches. Tailable,
+     * oplog and bounded scans always go through doWork().
+     */
+    bool canWorkBatch() final;
+
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
     void doSaveState() final;
     void doRestoreState() final;
@@ -78,6 +84,11 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* id) final;
+
 private:
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
@@ -92,6 +103,12 @@ private:
      */
     Status setLatestOplogEntryTimestamp(const Record& record);
 
+    /**
+     * Makes the last result of a batch own its object, if it is still in use. Called before the
+     * cursor moves or is saved, which invalidates the data it returned.
+     */
+    void makeUnownedResultOwned();
+
     // WorkingSet is not owned by us.
     WorkingSet* _workingSet;
 
@@ -111,6 +128,9 @@ private:
 
     RecordId _lastSeenId;  // Null if nothing has been returned from _cursor yet.
 
+    // The last result of doWorkBatch(), whose object points into the data of _cursor.
+    WorkingSetID _unownedResultId = WorkingSet::INVALID_ID;
+
     // We allocate a working set member with this id on construction of the stage. It gets used for
     // all fetch requests. This should only be used for passing up the Fetcher for a NEED_YIELD, and
     // should remain in the INVALID state.
@@ -35,6 +35,7 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
@@ -71,7 +72,7 @@ bool FetchStage::isEOF() {
         return false;
     }
 
-    return child()->isEOF();
+    return _idsPending.empty() && child()->isEOF();
 }
 
 PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
@@ -82,7 +83,11 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     StageState status;
-    if (_idRetrying == WorkingSet::INVALID_ID) {
+    if (_idRetrying == WorkingSet::INVALID_ID && !_idsPending.empty()) {
+        status = ADVANCED;
+        id = _idsPending.front();
+        _idsPending.pop_front();
+    } else if (_idRetrying == WorkingSet::INVALID_ID) {
         status = child()->work(&id);
     } else {
         status = ADVANCED;
@@ -144,6 +149,63 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+bool FetchStage::canWorkBatch() {
+    return _idRetrying == WorkingSet::INVALID_ID && _idsPending.empty() && supportsDocLocking();
+}
+
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxWorks,
+                                              std::vector<WorkingSetID>* out,
+                                              WorkingSetID* id) {
+    const size_t first = out->size();
+    const size_t childWorksBefore = child()->getCommonStats()->works;
+    StageState status = child()->workBatch(maxWorks, out, id);
+    const size_t works = child()->getCommonStats()->works - childWorksBefore;
+
+    size_t kept = first;
+    size_t i = first;
+    try {
+        for (; i < out->size(); ++i) {
+            WorkingSetID memberId = (*out)[i];
+            WorkingSetMember* member = _ws->get(memberId);
+
+            if (member->hasObj()) {
+                ++_specificStats.alreadyHasObj;
+            } else {
+                verify(WorkingSetMember::RID_AND_IDX == member->getState());
+                verify(member->hasRecordId());
+
+                if (!_cursor)
+                    _cursor = _collection->getCursor(getOpCtx());
+
+                if (!WorkingSetCommon::fetch(getOpCtx(), _ws, memberId, _cursor)) {
+                    _ws->free(memberId);
+                    continue;
+                }
+
+                // The next fetch repositions the cursor, which invalidates unowned objects.
+                member->makeObjOwnedIfNeeded();
+            }
+            (*out)[kept++] = memberId;
+        }
+    } catch (const WriteConflictException&) {
+        // Retry the member which conflicted, then return the rest of the batch, as doWork() would
+        // have done one at a time.
+        _ws->get((*out)[i])->makeObjOwnedIfNeeded();
+        _idRetrying = (*out)[i];
+        _idsPending.assign(out->begin() + i + 1, out->end());
+        *id = WorkingSet::INVALID_ID;
+        status = NEED_YIELD;
+    }
+    out->resize(kept);
+
+    // See returnIfMatches() for what counts as examining a document.
+    _specificStats.docsExamined += out->size() - first;
+    Filter::passesBatch(_ws, _filter, out, first);
+
+    recordBatchStats(works, out->size() - first, status);
+    return status;
+}
+
 void FetchStage::doSaveState() {
     if (_cursor)
         _cursor->saveUnpositioned();
@@ -174,6 +236,13 @@ void FetchStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inval
             WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
         }
     }
+
+    for (auto pendingId : _idsPending) {
+        WorkingSetMember* member = _ws->get(pendingId);
+        if (member->hasRecordId() && (member->recordId == dl)) {
+            WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        }
+    }
 }
 
 PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 
 #include "mongo/db/exec/plan_stage.h"
@@ -60,6 +61,13 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    /**
+     * Works in batches when it has nothing left to retry. Only storage engines without
+     * document-level locking hand out RecordFetchers, and a batch cannot stop to page one in, so
+     * those always go through doWork().
+     */
+    bool canWorkBatch() final;
+
     void doSaveState() final;
     void doRestoreState() final;
     void doDetachFromOperationContext() final;
@@ -76,6 +84,11 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* id) final;
+
 private:
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
@@ -98,6 +111,10 @@ private:
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results of a batch from our child which were not fetched yet when fetching _idRetrying hit
+    // a write conflict. Returned after _idRetrying, before asking our child for more.
+    std::deque<WorkingSetID> _idsPending;
+
     // Stats
     FetchStats _specificStats;
 };
@@ -166,6 +166,50 @@ public:
         IndexKeyMatchableDocument doc(keyData, keyPattern);
         return filter->matches(&doc, NULL);
     }
+
+    /**
+     * Removes the members of 'ids', from position 'first' on, which do not satisfy 'filter', and
+     * frees them from 'ws'. The members keep their order. If all of them have an object, they are
+     * checked together with MatchExpression::matchesBatch().
+     */
+    static void passesBatch(WorkingSet* ws,
+                            const MatchExpression* filter,
+                            std::vector<WorkingSetID>* ids,
+                            size_t first = 0) {
+        if (NULL == filter || first == ids->size()) {
+            return;
+        }
+
+        std::vector<const BSONObj*> docs;
+        docs.reserve(ids->size() - first);
+        for (size_t i = first; i < ids->size(); ++i) {
+            WorkingSetMember* member = ws->get((*ids)[i]);
+            if (!member->hasObj()) {
+                break;
+            }
+            docs.push_back(&member->obj.value());
+        }
+
+        std::vector<bool> results;
+        if (docs.size() == ids->size() - first) {
+            filter->matchesBatch(docs, &results);
+        } else {
+            results.resize(ids->size() - first);
+            for (size_t i = first; i < ids->size(); ++i) {
+                results[i - first] = passes(ws->get((*ids)[i]), filter);
+            }
+        }
+
+        size_t kept = first;
+        for (size_t i = first; i < ids->size(); ++i) {
+            if (results[i - first]) {
+                (*ids)[kept++] = (*ids)[i];
+            } else {
+                ws->free((*ids)[i]);
+            }
+        }
+        ids->resize(kept);
+    }
 };
 
 }  // namespace mongo
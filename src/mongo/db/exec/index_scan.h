@@ -99,6 +99,15 @@ public:
 
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
+
+    /**
+     * Batches call doWork() directly. Scans which dedup RecordIds buffer them, which work()
+     * accounts for, so they do not work in batches.
+     */
+    bool canWorkBatch() final {
+        return !_shouldDedup;
+    }
+
     void doSaveState() final;
     void doRestoreState() final;
     void doDetachFromOperationContext() final;
@@ -41,6 +41,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/stage_memory_admission.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
@@ -371,7 +372,9 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
             // Assumes that the ranking will pick this plan.
             doneWorking = true;
         } else if (PlanStage::NEED_YIELD == state) {
-            if (id == WorkingSet::INVALID_ID) {
+            if (id == WorkingSet::INVALID_ID && StageMemoryReservation::isWaitPending(getOpCtx())) {
+                // A stage is waiting for memory, which the yield below waits for.
+            } else if (id == WorkingSet::INVALID_ID) {
                 if (!yieldPolicy->canAutoYield())
                     throw WriteConflictException();
             } else {
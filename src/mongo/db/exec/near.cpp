@@ -30,8 +30,11 @@
 
 #include "mongo/db/exec/near.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
 
@@ -92,8 +95,11 @@ PlanStage::StageState NearStage::doWork(WorkingSetID* out) {
     PlanStage::StageState nextState = PlanStage::NEED_TIME;
 
     if (chkCachedMemOversize()) {
-        *out = chkMemFailureRet(_workingSet);
-        return PlanStage::FAILURE;
+        if (!canSpillCachedMem()) {
+            *out = chkMemFailureRet(_workingSet);
+            return PlanStage::FAILURE;
+        }
+        spillResults();
     }
 
     //
@@ -132,15 +138,24 @@ PlanStage::StageState NearStage::doWork(WorkingSetID* out) {
  * Holds a generic search result with a distance computed in some fashion.
  */
 struct NearStage::SearchResult {
-    SearchResult(WorkingSetID resultID, double distance) : resultID(resultID), distance(distance) {}
+    SearchResult(WorkingSetID resultID, double distance, size_t memUsage)
+        : resultID(resultID),
+          distance(distance),
+          spillLocation(WorkingSetSpillArea::kInvalidLocation),
+          memUsage(memUsage) {}
 
     bool operator<(const SearchResult& other) const {
         // We want increasing distance, not decreasing, so we reverse the <
         return distance > other.distance;
     }
 
+    // Invalid once the result has been spilled to 'spillLocation'.
     WorkingSetID resultID;
     double distance;
+    WorkingSetSpillArea::Location spillLocation;
+
+    // The memory reported for the member while it is buffered in memory.
+    size_t memUsage;
 };
 
 // Set "toReturn" when NEED_YIELD.
@@ -198,7 +213,8 @@ PlanStage::StageState NearStage::bufferNext(WorkingSetID* toReturn, Status* erro
 
     // The child stage may not dedup so we must dedup them ourselves.
     if (_nextInterval->dedupCovering && nextMember->hasRecordId()) {
-        if (_seenDocuments.end() != _seenDocuments.find(nextMember->recordId)) {
+        if (_seenDocuments.end() != _seenDocuments.find(nextMember->recordId) ||
+            _spilledDocuments.end() != _spilledDocuments.find(nextMember->recordId)) {
             _workingSet->free(nextMemberID);
             return PlanStage::NEED_TIME;
         }
@@ -220,13 +236,33 @@ PlanStage::StageState NearStage::bufferNext(WorkingSetID* toReturn, Status* erro
 
     // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
     nextMember->makeObjOwnedIfNeeded();
-    _resultBuffer.push(SearchResult(nextMemberID, memberDistance));
+    SearchResult result(nextMemberID, memberDistance, nextMember->getMemUsage());
     size_t cachedSize = sizeof(SearchResult);
     // Store the member's RecordId, if available, for quick invalidation
-    if (nextMember->hasRecordId()) {
-        _seenDocuments.insert(std::make_pair(nextMember->recordId, nextMemberID));
+    const RecordId recordId = nextMember->recordId;
+    const bool tracked = nextMember->hasRecordId() && !_spilledDocuments.count(recordId) &&
+        _seenDocuments.insert(std::make_pair(recordId, nextMemberID)).second;
+    if (tracked) {
         cachedSize += _seenDocItemSize;
     }
+
+    // Once we have started spilling, new results go straight to disk while we are over the
+    // memory limit.
+    if (_spillArea && chkCachedMemOversize()) {
+        incSpilledMemory(result.memUsage);
+        result.spillLocation = _spillArea->spill(_workingSet, nextMemberID);
+        result.resultID = WorkingSet::INVALID_ID;
+        if (tracked) {
+            _seenDocuments.erase(recordId);
+            _spilledDocuments[recordId] = result.spillLocation;
+        }
+    } else {
+        cachedSize += result.memUsage;
+        ++_numResultsInMemory;
+    }
+
+    _resultBuffer.push_back(result);
+    std::push_heap(_resultBuffer.begin(), _resultBuffer.end());
     incCachedMemory(cachedSize);
 
     return PlanStage::NEED_TIME;
@@ -237,42 +273,28 @@ PlanStage::StageState NearStage::advanceNext(WorkingSetID* toReturn) {
     // If the document does not fall in the current interval, it will be buffered so that
     // it might be returned in a following interval.
 
-    size_t releaseSize = 0;
     // Check if the next member is in the search interval and that the buffer isn't empty
-    WorkingSetID resultID = WorkingSet::INVALID_ID;
-    // memberDistance is initialized to produce an error if used before its value is changed
-    double memberDistance = std::numeric_limits<double>::lowest();
+    bool inInterval = false;
     if (!_resultBuffer.empty()) {
-        SearchResult result = _resultBuffer.top();
-        memberDistance = result.distance;
+        double memberDistance = _resultBuffer.front().distance;
 
         // Throw out all documents with memberDistance < minDistance
         if (memberDistance < _nextInterval->minDistance) {
-            WorkingSetMember* member = _workingSet->get(result.resultID);
-            if (member->hasRecordId()) {
-                _seenDocuments.erase(member->recordId);
-                releaseSize = _seenDocItemSize;
-            }
-            _resultBuffer.pop();
-            releaseSize += sizeof(SearchResult);
-            _workingSet->free(result.resultID);
-            decCachedMemory(releaseSize);
+            _workingSet->free(popResult());
             return PlanStage::NEED_TIME;
         }
 
-        bool inInterval = _nextInterval->inclusiveMax ? memberDistance <= _nextInterval->maxDistance
-                                                      : memberDistance < _nextInterval->maxDistance;
-        if (inInterval) {
-            resultID = result.resultID;
-        }
+        inInterval = _nextInterval->inclusiveMax ? memberDistance <= _nextInterval->maxDistance
+                                                 : memberDistance < _nextInterval->maxDistance;
     } else {
         // A document should be in _seenDocuments if and only if it's in _resultBuffer
         invariant(_seenDocuments.empty());
+        invariant(_spilledDocuments.empty());
     }
 
     // memberDistance is not in the interval or _resultBuffer is empty,
     // so we need to move to the next interval.
-    if (WorkingSet::INVALID_ID == resultID) {
+    if (!inInterval) {
         _nextInterval = nullptr;
         _nextIntervalStats = nullptr;
         _searchState = SearchState_Buffering;
@@ -280,23 +302,83 @@ PlanStage::StageState NearStage::advanceNext(WorkingSetID* toReturn) {
     }
 
     // The next document in _resultBuffer is in the search interval, so we can return it.
-    _resultBuffer.pop();
-    releaseSize = sizeof(SearchResult);
+    *toReturn = popResult();
+
+    // This value is used by nextInterval() to determine the size of the next interval.
+    ++_nextIntervalStats->numResultsReturned;
+
+    return PlanStage::ADVANCED;
+}
+
+WorkingSetID NearStage::popResult() {
+    std::pop_heap(_resultBuffer.begin(), _resultBuffer.end());
+    const SearchResult result = _resultBuffer.back();
+    _resultBuffer.pop_back();
+    size_t releaseSize = sizeof(SearchResult);
+
+    WorkingSetID resultID = result.resultID;
+    if (WorkingSetSpillArea::kInvalidLocation == result.spillLocation) {
+        releaseSize += result.memUsage;
+        --_numResultsInMemory;
+    } else {
+        auto invalidatedIt = _invalidatedSpills.find(result.spillLocation);
+        if (_invalidatedSpills.end() != invalidatedIt) {
+            resultID = invalidatedIt->second;
+            releaseSize += _workingSet->get(resultID)->getMemUsage();
+            _invalidatedSpills.erase(invalidatedIt);
+        } else {
+            resultID = _spillArea->restore(_workingSet, result.spillLocation);
+        }
+    }
 
     // If we're returning something, take it out of our RecordId -> WSID map so that future
     // calls to invalidate don't cause us to take action for a RecordId we're done with.
-    *toReturn = resultID;
-    WorkingSetMember* member = _workingSet->get(*toReturn);
-    if (member->hasRecordId()) {
-        _seenDocuments.erase(member->recordId);
+    WorkingSetMember* member = _workingSet->get(resultID);
+    if (member->hasRecordId() &&
+        (_seenDocuments.erase(member->recordId) || _spilledDocuments.erase(member->recordId))) {
         releaseSize += _seenDocItemSize;
     }
     decCachedMemory(releaseSize);
 
-    // This value is used by nextInterval() to determine the size of the next interval.
-    ++_nextIntervalStats->numResultsReturned;
+    return resultID;
+}
 
-    return PlanStage::ADVANCED;
+void NearStage::spillResults() {
+    if (0 == _numResultsInMemory) {
+        return;
+    }
+
+    if (!_spillArea) {
+        _spillArea = make_unique<WorkingSetSpillArea>(storageGlobalParams.dbpath + "/_tmp");
+    }
+
+    // Spilling does not change the distance of any result, so the heap stays valid.
+    size_t releaseSize = 0;
+    for (auto&& result : _resultBuffer) {
+        if (WorkingSetSpillArea::kInvalidLocation != result.spillLocation) {
+            continue;
+        }
+
+        WorkingSetMember* member = _workingSet->get(result.resultID);
+        const RecordId recordId = member->recordId;
+        auto seenIt = _seenDocuments.find(recordId);
+        const bool seen = member->hasRecordId() && _seenDocuments.end() != seenIt &&
+            seenIt->second == result.resultID;
+        if (seen) {
+            _seenDocuments.erase(seenIt);
+        }
+
+        result.spillLocation = _spillArea->spill(_workingSet, result.resultID);
+        result.resultID = WorkingSet::INVALID_ID;
+        if (seen) {
+            _spilledDocuments[recordId] = result.spillLocation;
+        }
+        releaseSize += result.memUsage;
+    }
+    _numResultsInMemory = 0;
+
+    decCachedMemory(releaseSize);
+    incSpilledMemory(releaseSize);
 }
 
 bool NearStage::isEOF() {
@@ -319,6 +401,22 @@ void NearStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Invali
         _seenDocuments.erase(seenIt);
         decCachedMemory(_seenDocItemSize);
     }
+
+    // A spilled result would no longer be fetchable by the time it is read back, so read it back
+    // now and keep it in memory until it is returned.
+    auto spilledIt = _spilledDocuments.find(dl);
+    if (spilledIt != _spilledDocuments.end()) {
+        WorkingSetID id = _spillArea->restore(_workingSet, spilledIt->second);
+        WorkingSetMember* member = _workingSet->get(id);
+        verify(member->hasRecordId());
+        WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        verify(!member->hasRecordId());
+
+        _invalidatedSpills[spilledIt->second] = id;
+        _spilledDocuments.erase(spilledIt);
+        incCachedMemory(member->getMemUsage());
+        decCachedMemory(_seenDocItemSize);
+    }
 }
 
 unique_ptr<PlanStageStats> NearStage::getStats() {
@@ -29,7 +29,6 @@
 #pragma once
 
 #include <memory>
-#include <queue>
 #include <vector>
 
 #include "mongo/base/status_with.h"
@@ -38,6 +37,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/stats/counters.h"
@@ -91,6 +91,10 @@ namespace mongo {
  * same interval and the invalidation occurs between the scan of the first cell and the second, so
  * NearStage no longer knows that it's seen this document before.
  *
+ * When the stage memory limit is exceeded and spilling is enabled, buffered results are moved to
+ * disk and read back as they reach the front of _resultBuffer. Only the distance, and the
+ * RecordId used for deduplication, stay in memory.
+ *
  * TODO: Right now the interface allows the nextCovering() to be adaptive, but doesn't allow
  * aborting and shrinking a covered range being buffered if we guess wrong.
  */
@@ -166,6 +170,17 @@ private:
     StageState bufferNext(WorkingSetID* toReturn, Status* error);
     StageState advanceNext(WorkingSetID* toReturn);
 
+    /**
+     * Removes the closest result from _resultBuffer and returns its member, reading it back from
+     * disk if needed.
+     */
+    WorkingSetID popResult();
+
+    /**
+     * Moves every buffered result that is still in memory to disk.
+     */
+    void spillResults();
+
     //
     // Generic state for progressive near search
     //
@@ -188,13 +203,27 @@ private:
     stdx::unordered_map<RecordId, WorkingSetID, RecordId::Hasher> _seenDocuments;
     static const size_t _seenDocItemSize;
 
+    // Like _seenDocuments, for buffered results that were spilled to disk.
+    stdx::unordered_map<RecordId, WorkingSetSpillArea::Location, RecordId::Hasher>
+        _spilledDocuments;
+
+    // Spilled results that were read back early because their RecordId was invalidated, keyed
+    // by the location they were spilled to.
+    stdx::unordered_map<WorkingSetSpillArea::Location, WorkingSetID> _invalidatedSpills;
+
+    std::unique_ptr<WorkingSetSpillArea> _spillArea;
+
+    // Number of results in _resultBuffer which are held in memory.
+    size_t _numResultsInMemory = 0;
+
     // Stats for the stage covering this interval
     // This is owned by _specificStats
     IntervalStats* _nextIntervalStats;
 
-    // Sorted buffered results to be returned - the current interval
+    // Sorted buffered results to be returned - the current interval. This is a heap, maintained
+    // with std::push_heap() and std::pop_heap(), so that spilling can visit every result.
     struct SearchResult;
-    std::priority_queue<SearchResult> _resultBuffer;
+    std::vector<SearchResult> _resultBuffer;
 
     // Stats
     const StageType _stageType;
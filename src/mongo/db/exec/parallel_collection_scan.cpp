@@ -0,0 +1,385 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+
+// Each worker gets a few ranges so that the work evens out when some ranges are denser than
+// others.
+const size_t kRangesPerWorker = 4;
+
+// A worker hands over its documents and releases its locks after this many matching documents or
+// bytes, whichever comes first.
+const size_t kMaxBatchDocs = 128;
+const size_t kMaxBatchBytes = 1024 * 1024;
+
+// Number of batches per worker which may wait to be returned before the workers stop reading.
+const size_t kQueuedBatchesPerWorker = 2;
+
+// How long doWork() waits for a batch before returning NEED_TIME, which lets the operation yield
+// and check for interrupts while the workers are reading.
+const Milliseconds kBatchWaitTime(10);
+
+bool canMatchInParallel(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::WHERE:
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO_NEAR:
+            return false;
+        default:
+            break;
+    }
+    for (size_t i = 0; i < expr->numChildren(); i++) {
+        if (!canMatchInParallel(expr->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : PlanStage(kStageType, opCtx),
+      _workingSet(workingSet),
+      _filter(filter),
+      _nss(collection->ns()),
+      _uuid(collection->uuid()),
+      _collection(collection) {
+    invariant(_uuid);
+}
+
+ParallelCollectionScan::~ParallelCollectionScan() {
+    stop();
+}
+
+// static
+bool ParallelCollectionScan::canScan(OperationContext* opCtx,
+                                     const Collection* collection,
+                                     const MatchExpression* filter) {
+    if (internalQueryParallelCollScanThreads.load() < 2 || !supportsDocLocking()) {
+        return false;
+    }
+
+    // The workers read outside of the operation's storage transaction, so they would not see the
+    // writes of a multi-statement transaction.
+    if (opCtx->lockState()->inAWriteUnitOfWork()) {
+        return false;
+    }
+
+    if (!collection || collection->isCapped() || collection->ns().isOplog() ||
+        !collection->uuid()) {
+        return false;
+    }
+
+    if (collection->numRecords(opCtx) <
+        static_cast<uint64_t>(internalQueryParallelCollScanMinRecords.load())) {
+        return false;
+    }
+
+    return !filter || canMatchInParallel(filter);
+}
+
+void ParallelCollectionScan::start() {
+    // Workers read at the same point in time as the operation if it has one, which is only known
+    // once the snapshot is open.
+    getOpCtx()->recoveryUnit()->preallocateSnapshot();
+    _readTimestamp = getOpCtx()->recoveryUnit()->getPointInTimeReadTimestamp();
+
+    const size_t maxWorkers = internalQueryParallelCollScanThreads.load();
+    auto splitPoints = _collection->getRecordStore()->getRangeSplitPoints(
+        getOpCtx(), maxWorkers * kRangesPerWorker);
+
+    RecordId start;
+    for (auto&& splitPoint : splitPoints) {
+        _ranges.push_back({start, splitPoint});
+        start = splitPoint;
+    }
+    _ranges.push_back({start, RecordId()});
+
+    const size_t numWorkers = std::min(maxWorkers, _ranges.size());
+    _specificStats.workers = numWorkers;
+    _specificStats.ranges = _ranges.size();
+    LOG(2) << "Scanning " << _nss << " in " << _ranges.size() << " ranges on " << numWorkers
+           << " threads";
+
+    _maxQueuedBatches = numWorkers * kQueuedBatchesPerWorker;
+    _workerOpCtxs.resize(numWorkers, nullptr);
+    _numActiveWorkers = numWorkers;
+    for (size_t i = 0; i < numWorkers; i++) {
+        _workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+void ParallelCollectionScan::stop() {
+    _stopping.store(true);
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        for (auto opCtx : _workerOpCtxs) {
+            if (opCtx) {
+                stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+                opCtx->getServiceContext()->killOperation(opCtx);
+            }
+        }
+        _cv.notify_all();
+    }
+
+    for (auto&& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (!_started) {
+        _started = true;
+        start();
+        return PlanStage::NEED_TIME;
+    }
+
+    if (_currentPos == _current.docs.size()) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait_for(lk, kBatchWaitTime.toSystemDuration(), [&] {
+            return !_batches.empty() || !_status.isOK() || _numActiveWorkers == 0;
+        });
+
+        if (!_status.isOK()) {
+            *out = WorkingSetCommon::allocateStatusMember(_workingSet, _status);
+            return PlanStage::FAILURE;
+        }
+
+        if (_batches.empty()) {
+            if (_numActiveWorkers == 0) {
+                _commonStats.isEOF = true;
+                return PlanStage::IS_EOF;
+            }
+            return PlanStage::NEED_TIME;
+        }
+
+        _current = std::move(_batches.front());
+        _batches.pop_front();
+        _currentPos = 0;
+        _cv.notify_all();
+
+        _specificStats.docsTested += _current.docsTested;
+        if (_current.docs.empty()) {
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    auto& doc = _current.docs[_currentPos++];
+
+    WorkingSetID id = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(id);
+    member->recordId = doc.first;
+    // The document comes from a worker's snapshot. A null id never matches the snapshot of the
+    // operation, so stages which need the current version refetch it.
+    member->obj = {SnapshotId(), std::move(doc.second)};
+    _workingSet->transitionToRecordIdAndObj(id);
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+void ParallelCollectionScan::workerLoop(size_t index) {
+    Client::initThread(str::stream() << "parallelCollScan-" << index);
+    ON_BLOCK_EXIT([] { Client::destroy(); });
+
+    auto opCtx = cc().makeOperationContext();
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _workerOpCtxs[index] = opCtx.get();
+    }
+
+    // Runs before the OperationContext is destroyed, so stop() never kills a destroyed one.
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _workerOpCtxs[index] = nullptr;
+        --_numActiveWorkers;
+        _cv.notify_all();
+    });
+
+    try {
+        if (_readTimestamp) {
+            opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kProvided,
+                                                          *_readTimestamp);
+        }
+
+        while (!_stopping.load()) {
+            Range range;
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                if (_ranges.empty()) {
+                    return;
+                }
+                range = _ranges.front();
+                _ranges.pop_front();
+            }
+            scanRange(opCtx.get(), range);
+        }
+    } catch (const DBException& ex) {
+        Status status = ex.toStatus();
+        if (status == ErrorCodes::NamespaceNotFound) {
+            status = {ErrorCodes::QueryPlanKilled,
+                      str::stream() << "collection dropped during parallel scan of " << _nss.ns()};
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        // Workers are interrupted when the stage is destroyed, which is not an error.
+        if (_status.isOK() && !_stopping.load()) {
+            _status = status;
+        }
+    }
+}
+
+void ParallelCollectionScan::scanRange(OperationContext* opCtx, const Range& range) {
+    std::unique_ptr<RecordCursor> cursor;
+    bool exhausted = false;
+
+    while (!exhausted) {
+        opCtx->checkForInterrupt();
+
+        Batch batch;
+        size_t batchBytes = 0;
+        {
+            AutoGetCollection autoColl(
+                opCtx, NamespaceStringOrUUID(_nss.db().toString(), *_uuid), MODE_IS);
+            const Collection* collection = autoColl.getCollection();
+            uassert(ErrorCodes::NamespaceNotFound, "collection dropped", collection);
+
+            try {
+                if (!cursor) {
+                    cursor = collection->getRecordStore()->getRangeCursor(
+                        opCtx, range.start, range.end);
+                } else {
+                    cursor->reattachToOperationContext(opCtx);
+                    invariant(cursor->restore());
+                }
+
+                while (batch.docs.size() < kMaxBatchDocs && batchBytes < kMaxBatchBytes) {
+                    auto record = cursor->next();
+                    if (!record) {
+                        exhausted = true;
+                        break;
+                    }
+
+                    ++batch.docsTested;
+                    BSONObj obj = record->data.releaseToBson();
+                    if (_filter && !_filter->matchesBSON(obj)) {
+                        continue;
+                    }
+                    batchBytes += obj.objsize();
+                    batch.docs.emplace_back(record->id, obj.getOwned());
+                }
+            } catch (const WriteConflictException&) {
+                // Hand over what was read so far. The cursor continues after the last record it
+                // returned once it is restored on a new snapshot.
+            }
+
+            if (exhausted) {
+                cursor.reset();
+            } else if (cursor) {
+                cursor->save();
+                cursor->detachFromOperationContext();
+            }
+        }
+        opCtx->recoveryUnit()->abandonSnapshot();
+
+        if (batch.docsTested > 0 && !pushBatch(std::move(batch))) {
+            return;
+        }
+    }
+}
+
+bool ParallelCollectionScan::pushBatch(Batch batch) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _cv.wait(lk, [&] { return _stopping.load() || _batches.size() < _maxQueuedBatches; });
+    if (_stopping.load()) {
+        return false;
+    }
+    _batches.push_back(std::move(batch));
+    _cv.notify_all();
+    return true;
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF;
+}
+
+std::unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    _commonStats.isEOF = isEOF();
+
+    if (_filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    auto ret = stdx::make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = stdx::make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
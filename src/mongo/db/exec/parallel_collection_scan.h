@@ -0,0 +1,158 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/bson/timestamp.h"
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+
+class Collection;
+class MatchExpression;
+class OperationContext;
+class WorkingSet;
+
+/**
+ * Scans a collection on several worker threads, returning the documents which match 'filter' in
+ * no particular order.
+ *
+ * The collection is split into RecordId ranges with RecordStore::getRangeSplitPoints(), a few
+ * more than there are workers so that a worker which finishes early picks up the remaining
+ * ranges. Each worker has its own Client and OperationContext, and reads batches of documents
+ * while holding its own intent lock on the collection, releasing it in between batches the way a
+ * yielding CollectionScan does. The workers apply the filter and hand the matching documents to
+ * this stage, which returns them on the thread of the operation.
+ *
+ * If the operation reads at a point in time, the workers read at the same timestamp. Otherwise
+ * each batch is read from the latest snapshot. Either way the documents were not read in the
+ * operation's snapshot, so they are returned owned and without a snapshot id, and are refetched by
+ * stages which need them to be current.
+ */
+class ParallelCollectionScan final : public PlanStage {
+public:
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const Collection* collection,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    ~ParallelCollectionScan();
+
+    /**
+     * Returns true if a scan of 'collection' with 'filter' can run in parallel, which requires
+     * internalQueryParallelCollScanThreads to be above one, a storage engine with document level
+     * locking, a collection of at least internalQueryParallelCollScanMinRecords which is not
+     * capped, and a filter which may be evaluated on several threads at once.
+     */
+    static bool canScan(OperationContext* opCtx,
+                        const Collection* collection,
+                        const MatchExpression* filter);
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+private:
+    struct Range {
+        RecordId start;
+        RecordId end;
+    };
+
+    struct Batch {
+        std::vector<std::pair<RecordId, BSONObj>> docs;
+        size_t docsTested = 0;
+    };
+
+    /**
+     * Splits the collection into ranges and starts the workers.
+     */
+    void start();
+
+    /**
+     * Stops the workers, interrupting any which are waiting for a lock.
+     */
+    void stop();
+
+    void workerLoop(size_t index);
+    void scanRange(OperationContext* opCtx, const Range& range);
+
+    // Queues 'batch' for the stage to return, waiting while too many batches are queued. Returns
+    // false if the stage is stopping.
+    bool pushBatch(Batch batch);
+
+    // Not owned by us.
+    WorkingSet* _workingSet;
+    const MatchExpression* _filter;
+
+    const NamespaceString _nss;
+    const OptionalCollectionUUID _uuid;
+    const Collection* _collection;
+    boost::optional<Timestamp> _readTimestamp;
+
+    bool _started = false;
+    Batch _current;          // The batch whose documents are being returned.
+    size_t _currentPos = 0;  // Position of the next document to return from _current.
+
+    // Shared with the workers.
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;  // Signaled when batches are queued or taken, or workers stop.
+    std::deque<Range> _ranges;     // Ranges which no worker has claimed yet.
+    std::deque<Batch> _batches;    // Batches waiting to be returned.
+    size_t _maxQueuedBatches = 0;
+    std::vector<OperationContext*> _workerOpCtxs;  // Indexed by worker, null once it is done.
+    size_t _numActiveWorkers = 0;
+    Status _status = Status::OK();  // The first error of any worker.
+    AtomicWord<bool> _stopping{false};
+
+    std::vector<stdx::thread> _workers;
+
+    ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
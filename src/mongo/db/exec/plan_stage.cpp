@@ -34,7 +34,9 @@
 
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_options.h"
 
 namespace mongo {
 
@@ -43,6 +45,16 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
     ++_commonStats.works;
 
+    // Reserve memory for what this stage may buffer next. If the budget is taken, yield so that
+    // the executor waits for other queries to release theirs without holding our locks.
+    if (_cachedMemSize > 0 || _memReservation.reserved() > 0) {
+        if (StageMemoryAdmission::enabled() && !_memReservation.adjust(_opCtx, _cachedMemSize)) {
+            *out = WorkingSet::INVALID_ID;
+            ++_commonStats.needYield;
+            return StageState::NEED_YIELD;
+        }
+    }
+
     StageState workResult = doWork(out);
 
     if (StageState::ADVANCED == workResult) {
@@ -56,6 +68,72 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(size_t maxWorks,
+                                           std::vector<WorkingSetID>* out,
+                                           WorkingSetID* id) {
+    invariant(_opCtx);
+    invariant(maxWorks > 0);
+
+    const size_t nResultsBefore = out->size();
+    if (!canWorkBatch()) {
+        for (size_t i = 0; i < maxWorks; ++i) {
+            StageState state = work(id);
+            if (StageState::ADVANCED == state) {
+                out->push_back(*id);
+            } else if (StageState::NEED_TIME != state) {
+                return state;
+            }
+        }
+    } else {
+        ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+        StageState state = doWorkBatch(maxWorks, out, id);
+        if (StageState::ADVANCED != state && StageState::NEED_TIME != state) {
+            return state;
+        }
+    }
+
+    *id = WorkingSet::INVALID_ID;
+    return out->size() > nResultsBefore ? StageState::ADVANCED : StageState::NEED_TIME;
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(size_t maxWorks,
+                                             std::vector<WorkingSetID>* out,
+                                             WorkingSetID* id) {
+    size_t works = 0;
+    size_t advanced = 0;
+    StageState state = StageState::NEED_TIME;
+    while (works < maxWorks) {
+        ++works;
+        state = doWork(id);
+        if (StageState::ADVANCED == state) {
+            ++advanced;
+            out->push_back(*id);
+        } else if (StageState::NEED_TIME != state) {
+            break;
+        }
+    }
+
+    recordBatchStats(works, advanced, state);
+    return state;
+}
+
+void PlanStage::recordBatchStats(size_t works, size_t advanced, StageState state) {
+    _commonStats.works += works;
+    _commonStats.advanced += advanced;
+
+    // Every unit of work which produced no result asked for more time, except the one which
+    // ended the batch early.
+    size_t needTime = works - advanced;
+    if (needTime > 0 && StageState::ADVANCED != state && StageState::NEED_TIME != state) {
+        --needTime;
+    }
+    _commonStats.needTime += needTime;
+
+    if (StageState::NEED_YIELD == state) {
+        ++_commonStats.needYield;
+    }
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -123,6 +201,14 @@ WorkingSetID PlanStage::chkMemFailureRet(WorkingSet* ws) const {
     return WorkingSetCommon::allocateStatusMember(ws, status);
 }
 
+bool PlanStage::canSpillCachedMem() const {
+    return internalQueryStageMemUsageSpill.load() && !storageGlobalParams.readOnly;
+}
+
+void PlanStage::incSpilledMemory(const size_t& memSize) {
+    globalStageMemCounters.incSpilledMemSize(stageType(), memSize);
+}
+
 void PlanStage::incCachedMemory(const size_t& memSize) {
     globalStageMemCounters.incCachedMemSize(stageType(), memSize);
     _cachedMemSize += memSize;
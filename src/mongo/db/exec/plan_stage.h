@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/exec/stage_memory_admission.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/invalidation_type.h"
@@ -190,6 +191,26 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Performs up to 'maxWorks' units of work, appending each result to 'out'. Equivalent to
+     * calling work() that many times, but stages for which canWorkBatch() is true produce the
+     * batch without paying for a work() call per result.
+     *
+     * Stops early when a unit of work returns anything other than ADVANCED or NEED_TIME, in which
+     * case it returns that state and sets '*id' as work() would. Otherwise returns ADVANCED if it
+     * appended any results and NEED_TIME if not. The caller must free the results appended to
+     * 'out' whatever the returned state.
+     */
+    StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out, WorkingSetID* id);
+
+    /**
+     * Returns true if the next call to workBatch() uses this stage's own batch implementation
+     * rather than calling work() once per unit of work.
+     */
+    virtual bool canWorkBatch() {
+        return false;
+    }
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -352,6 +373,17 @@ public:
     virtual bool chkCachedMemOversize() const;
     WorkingSetID chkMemFailureRet(WorkingSet* ws) const;
 
+    /**
+     * Returns true if a stage whose chkCachedMemOversize() is true should move its buffered data
+     * to disk rather than fail the operation.
+     */
+    bool canSpillCachedMem() const;
+
+    /**
+     * Reports that 'memSize' bytes of buffered data were written to disk by this stage.
+     */
+    void incSpilledMemory(const size_t& memSize);
+
     void incCachedMemory(const size_t& memSize);
     void decCachedMemory(const size_t& memSize);
 
@@ -363,12 +395,34 @@ public:
      */
     size_t _cachedMemSize;
 
+    /**
+     * The memory reserved for this stage with the globalStageMemAdmission, kept one chunk ahead of
+     * _cachedMemSize by work() while internalQueryStageMemAdmissionControl is set.
+     */
+    StageMemoryReservation _memReservation;
+
 protected:
     /**
      * Performs one unit of work.  See comment at work() above.
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs a batch of work when canWorkBatch() is true. See comment at workBatch() above.
+     * Implementations update the common stats themselves, usually with recordBatchStats().
+     *
+     * By default calls doWork() up to 'maxWorks' times, which saves only the overhead of work().
+     */
+    virtual StageState doWorkBatch(size_t maxWorks,
+                                   std::vector<WorkingSetID>* out,
+                                   WorkingSetID* id);
+
+    /**
+     * Adds a batch of 'works' units of work, 'advanced' of which produced a result, to the common
+     * stats. 'state' is the state returned for the batch.
+     */
+    void recordBatchStats(size_t works, size_t advanced, StageState state);
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
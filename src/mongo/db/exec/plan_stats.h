@@ -213,6 +213,19 @@ struct CollectionScanStats : public SpecificStats {
     boost::optional<Timestamp> maxTs;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new ParallelCollectionScanStats(*this);
+    }
+
+    // How many documents did the workers check against our filter?
+    size_t docsTested = 0;
+
+    // The number of threads scanning the collection, and of RecordId ranges they split it into.
+    size_t workers = 0;
+    size_t ranges = 0;
+};
+
 struct CountStats : public SpecificStats {
     CountStats() : nCounted(0), nSkipped(0), recordStoreCount(false) {}
 
@@ -513,7 +526,14 @@ struct ProjectionStats : public SpecificStats {
 };
 
 struct SortStats : public SpecificStats {
-    SortStats() : forcedFetches(0), memUsage(0), memLimit(0) {}
+    SortStats()
+        : forcedFetches(0),
+          memUsage(0),
+          memLimit(0),
+          usedDisk(false),
+          spills(0),
+          spilledBytes(0),
+          spilledCompressedBytes(0) {}
 
     SpecificStats* clone() const final {
         SortStats* specific = new SortStats(*this);
@@ -534,6 +554,16 @@ struct SortStats : public SpecificStats {
 
     // The pattern according to which we are sorting.
     BSONObj sortPattern;
+
+    // Did we switch to an external sort after exceeding our memory limit?
+    bool usedDisk;
+
+    // The number of files written by the external sort.
+    size_t spills;
+
+    // The bytes of data spilled by the external sort, and what they took on disk once compressed.
+    long long spilledBytes;
+    long long spilledCompressedBytes;
 };
 
 struct MergeSortStats : public SpecificStats {
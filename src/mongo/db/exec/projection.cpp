@@ -221,6 +221,34 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxWorks,
+                                                   std::vector<WorkingSetID>* out,
+                                                   WorkingSetID* id) {
+    const size_t first = out->size();
+    const size_t childWorksBefore = child()->getCommonStats()->works;
+    StageState status = child()->workBatch(maxWorks, out, id);
+    const size_t works = child()->getCommonStats()->works - childWorksBefore;
+
+    for (size_t i = first; i < out->size(); ++i) {
+        Status projStatus = transform(_ws->get((*out)[i]));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+
+            // Return the results projected so far along with the failure.
+            for (size_t j = i; j < out->size(); ++j) {
+                _ws->free((*out)[j]);
+            }
+            out->resize(i);
+            *id = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+            recordBatchStats(works, i - first, PlanStage::FAILURE);
+            return PlanStage::FAILURE;
+        }
+    }
+
+    recordBatchStats(works, out->size() - first, status);
+    return status;
+}
+
 unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_PROJECTION);
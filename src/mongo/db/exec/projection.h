@@ -83,6 +83,13 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    /**
+     * Projects a batch of results from our child at once.
+     */
+    bool canWorkBatch() final {
+        return true;
+    }
+
     StageType stageType() const final {
         return STAGE_PROJECTION;
     }
@@ -112,6 +119,11 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* id) final;
+
 private:
     Status transform(WorkingSetMember* member);
 
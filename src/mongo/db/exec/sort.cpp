@@ -41,7 +41,10 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/bufreader.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -51,10 +54,75 @@ using std::unique_ptr;
 using std::vector;
 using stdx::make_unique;
 
+namespace {
+
+// Field names used to carry a working set member's computed data through a spill file.
+const char kTextScoreField[] = "textScore";
+const char kGeoDistanceField[] = "geoDistance";
+const char kGeoNearPointField[] = "geoNearPoint";
+const char kIndexKeyField[] = "indexKey";
+
+}  // namespace
+
 // static
 const char* SortStage::kStageType = "SORT";
 const size_t SortStage::_dataMapItemSize = sizeof(RecordId) + sizeof(WorkingSetID);
 
+struct SortStage::SpilledMember {
+    struct SorterDeserializeSettings {};  // unused
+
+    SpilledMember() = default;
+    SpilledMember(RecordId rid, BSONObj doc, BSONObj computedData)
+        : recordId(std::move(rid)), obj(std::move(doc)), computed(std::move(computedData)) {}
+
+    void serializeForSorter(BufBuilder& buf) const {
+        recordId.serializeForSorter(buf);
+        obj.serializeForSorter(buf);
+        computed.serializeForSorter(buf);
+    }
+
+    static SpilledMember deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+        // Note: the fields must be read in the order in which they were serialized.
+        auto rid = RecordId::deserializeForSorter(buf, RecordId::SorterDeserializeSettings());
+        auto doc = BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+        auto computedData =
+            BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+        return SpilledMember(std::move(rid), std::move(doc), std::move(computedData));
+    }
+
+    int memUsageForSorter() const {
+        return recordId.memUsageForSorter() + obj.memUsageForSorter() +
+            computed.memUsageForSorter();
+    }
+
+    SpilledMember getOwned() const {
+        return SpilledMember(recordId, obj.getOwned(), computed.getOwned());
+    }
+
+    // Breaks ties between equal sort keys, and is restored on the result when it is read back.
+    RecordId recordId;
+    BSONObj obj;
+    BSONObj computed;
+};
+
+class SortStage::SpillComparator {
+public:
+    explicit SpillComparator(BSONObj pattern) : _pattern(std::move(pattern)) {}
+
+    int operator()(const std::pair<BSONObj, SpilledMember>& lhs,
+                   const std::pair<BSONObj, SpilledMember>& rhs) const {
+        // False means ignore field names.
+        int result = lhs.first.woCompare(rhs.first, _pattern, false);
+        if (0 != result) {
+            return result;
+        }
+        return lhs.second.recordId.compare(rhs.second.recordId);
+    }
+
+private:
+    BSONObj _pattern;
+};
+
 SortStage::WorkingSetComparator::WorkingSetComparator(BSONObj p) : pattern(p) {}
 
 bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
@@ -77,6 +145,7 @@ SortStage::SortStage(OperationContext* opCtx,
       _ws(ws),
       _pattern(params.pattern),
       _limit(params.limit),
+      _allowDiskUse(params.allowDiskUse),
       _sorted(false),
       _resultIterator(_data.end()),
       _memUsage(0) {
@@ -101,6 +170,9 @@ SortStage::~SortStage() {
 bool SortStage::isEOF() {
     // We're done when our child has no more results, we've sorted the child's results, and
     // we've returned all sorted results.
+    if (_spillIterator) {
+        return child()->isEOF() && _sorted && !_spillIterator->more();
+    }
     return child()->isEOF() && _sorted && (_data.end() == _resultIterator);
 }
 
@@ -109,7 +181,8 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     if (_memUsage > maxBytes) {
         mongoutils::str::stream ss;
         ss << "Sort operation used more than the maximum " << maxBytes
-           << " bytes of RAM. Add an index, or specify a smaller limit.";
+           << " bytes of RAM. Add an index, specify a smaller limit, or pass allowDiskUse:true"
+           << " to opt in to an external sort.";
         Status status(ErrorCodes::OperationFailed, ss);
         *out = WorkingSetCommon::allocateStatusMember(_ws, status);
         return PlanStage::FAILURE;
@@ -120,8 +193,15 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     if (chkCachedMemOversize()) {
-        *out = chkMemFailureRet(_ws);
-        return PlanStage::FAILURE;
+        // Once the results are sorted, the buffer only shrinks as results are returned, so it is
+        // no longer worth spilling.
+        if (!canSpillCachedMem() || _sorted || _limit == 1) {
+            *out = chkMemFailureRet(_ws);
+            return PlanStage::FAILURE;
+        }
+        spillBuffer(std::min(
+            maxBytes,
+            static_cast<size_t>(internalQueryStageMemUsageSpillSortBytes.load())));
     }
 
     // Still reading in results to sort.
@@ -160,14 +240,33 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
                 item.recordId = member->recordId;
             }
 
+            if (_spillSorter) {
+                addToSpillSorter(item);
+                return PlanStage::NEED_TIME;
+            }
+
             addToBuffer(item);
 
+            if (_allowDiskUse && _limit != 1 && _memUsage > maxBytes &&
+                !storageGlobalParams.readOnly) {
+                spillBuffer(maxBytes);
+            }
+
             return PlanStage::NEED_TIME;
         } else if (PlanStage::IS_EOF == code) {
             // TODO: We don't need the lock for this.  We could ask for a yield and do this work
             // unlocked.  Also, this is performing a lot of work for one call to work(...)
-            sortBuffer();
-            _resultIterator = _data.begin();
+            if (_spillSorter) {
+                _spillIterator.reset(_spillSorter->done());
+                _specificStats.spills = _spillSorter->numFiles();
+                _specificStats.spilledBytes = _spillSorter->spillStats().bytes;
+                _specificStats.spilledCompressedBytes = _spillSorter->spillStats().compressedBytes;
+                _spillSorter.reset();
+                _resultIterator = _data.end();
+            } else {
+                sortBuffer();
+                _resultIterator = _data.begin();
+            }
             _sorted = true;
             return PlanStage::NEED_TIME;
         } else if (PlanStage::FAILURE == code || PlanStage::DEAD == code) {
@@ -184,6 +283,12 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     // Returning results.
+    if (_spillIterator) {
+        verify(_sorted);
+        *out = nextSpilledResult();
+        return PlanStage::ADVANCED;
+    }
+
     verify(_resultIterator != _data.end());
     verify(_sorted);
     *out = _resultIterator->wsid;
@@ -231,6 +336,11 @@ unique_ptr<PlanStageStats> SortStage::getStats() {
     _specificStats.memLimit = maxBytes;
     _specificStats.memUsage = _memUsage;
     _specificStats.limit = _limit;
+    if (_spillSorter) {
+        _specificStats.spills = _spillSorter->numFiles();
+        _specificStats.spilledBytes = _spillSorter->spillStats().bytes;
+        _specificStats.spilledCompressedBytes = _spillSorter->spillStats().compressedBytes;
+    }
     _specificStats.sortPattern = _pattern.getOwned();
 
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_SORT);
@@ -366,4 +476,119 @@ void SortStage::sortBuffer() {
     }
 }
 
+void SortStage::spillBuffer(size_t sorterMemBytes) {
+    if (!_spillSorter) {
+        SortOptions opts;
+        opts.limit = _limit;
+        opts.maxMemoryUsageBytes = sorterMemBytes;
+        opts.extSortAllowed = true;
+        opts.tempDir = storageGlobalParams.dbpath + "/_tmp";
+        opts.workerThreads = internalQueryExternalSortWorkerThreads.load();
+        opts.compressionLevel = internalQueryExternalSortCompressionLevel.load();
+
+        _spillSorter.reset(
+            SpillSorter::make(opts, SpillComparator(FindCommon::transformSortSpec(_pattern))));
+        _specificStats.usedDisk = true;
+
+        LOG(1) << "Sort stage is buffering " << _memUsage
+               << " bytes of RAM. Switching to an external sort using at most " << sorterMemBytes
+               << " bytes of RAM.";
+    }
+
+    if (_dataSet) {
+        for (auto&& item : *_dataSet) {
+            addToSpillSorter(item);
+        }
+        _dataSet->clear();
+    } else {
+        for (auto&& item : _data) {
+            addToSpillSorter(item);
+        }
+        std::vector<SortableDataItem>().swap(_data);
+    }
+
+    // Everything this stage was holding on to now lives in the sorter, which enforces its own
+    // memory limit.
+    _wsidByRecordId.clear();
+    decCachedMemory(_cachedMemSize);
+    _memUsage = 0;
+}
+
+void SortStage::addToSpillSorter(const SortableDataItem& item) {
+    WorkingSetMember* member = _ws->get(item.wsid);
+
+    BSONObjBuilder computed;
+    if (member->hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+        auto score = static_cast<const TextScoreComputedData*>(
+            member->getComputed(WSM_COMPUTED_TEXT_SCORE));
+        computed.append(kTextScoreField, score->getScore());
+    }
+    if (member->hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
+        auto dist = static_cast<const GeoDistanceComputedData*>(
+            member->getComputed(WSM_COMPUTED_GEO_DISTANCE));
+        computed.append(kGeoDistanceField, dist->getDist());
+    }
+    if (member->hasComputed(WSM_GEO_NEAR_POINT)) {
+        auto point =
+            static_cast<const GeoNearPointComputedData*>(member->getComputed(WSM_GEO_NEAR_POINT));
+        computed.append(kGeoNearPointField, point->getPoint());
+    }
+    if (member->hasComputed(WSM_INDEX_KEY)) {
+        auto key = static_cast<const IndexKeyComputedData*>(member->getComputed(WSM_INDEX_KEY));
+        computed.append(kIndexKeyField, key->getKey());
+    }
+
+    // The sorter may hold on to what we give it across yields, so it must be owned.
+    _spillSorter->add(item.sortKey,
+                      SpilledMember(item.recordId, member->obj.value().getOwned(), computed.obj()));
+
+    if (member->hasRecordId() && _wsidByRecordId.erase(member->recordId)) {
+        decCachedMemory(_dataMapItemSize);
+    }
+    incSpilledMemory(member->getMemUsage());
+    _ws->free(item.wsid);
+}
+
+WorkingSetID SortStage::nextSpilledResult() {
+    auto next = _spillIterator->next();
+
+    WorkingSetID id = _ws->allocate();
+    WorkingSetMember* member = _ws->get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), next.second.obj.getOwned());
+
+    // Keep the RecordId so that an update or delete above us can still act on the document, as
+    // it would for a result sorted in memory. The null snapshot id makes it refetch first.
+    // Spilled members no longer receive invalidations, so on engines that rely on them the
+    // RecordId may be stale and the document is returned owned, as an invalidation would.
+    if (!next.second.recordId.isNull() && supportsDocLocking()) {
+        member->recordId = next.second.recordId;
+        _ws->transitionToRecordIdAndObj(id);
+    } else {
+        member->transitionToOwnedObj();
+    }
+
+    member->addComputed(new SortKeyComputedData(next.first));
+
+    BSONObj computed = next.second.computed;
+    if (computed.hasField(kTextScoreField)) {
+        member->addComputed(new TextScoreComputedData(computed[kTextScoreField].Double()));
+    }
+    if (computed.hasField(kGeoDistanceField)) {
+        member->addComputed(new GeoDistanceComputedData(computed[kGeoDistanceField].Double()));
+    }
+    if (computed.hasField(kGeoNearPointField)) {
+        member->addComputed(new GeoNearPointComputedData(computed[kGeoNearPointField].Obj()));
+    }
+    if (computed.hasField(kIndexKeyField)) {
+        member->addComputed(new IndexKeyComputedData(computed[kIndexKeyField].Obj()));
+    }
+
+    return id;
+}
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj,
+                    mongo::SortStage::SpilledMember,
+                    mongo::SortStage::SpillComparator);
@@ -37,6 +37,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/stdx/unordered_map.h"
 
@@ -47,7 +48,7 @@ class BtreeKeyGenerator;
 // Parameters that must be provided to a SortStage
 class SortStageParams {
 public:
-    SortStageParams() : collection(NULL), limit(0) {}
+    SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) {}
 
     // Used for resolving RecordIds to BSON
     const Collection* collection;
@@ -57,11 +58,19 @@ public:
 
     // Equal to 0 for no limit.
     size_t limit;
+
+    // Whether the stage may spill its buffered data to disk rather than fail once it uses more
+    // than 'internalQueryExecMaxBlockingSortBytes'.
+    bool allowDiskUse;
 };
 
 /**
  * Sorts the input received from the child according to the sort pattern provided.
  *
+ * If 'allowDiskUse' is set, the buffered data is handed off to an external Sorter once the stage
+ * exceeds its memory limit, and all subsequent input is sorted through temporary files in the
+ * dbpath. Results read back from disk are returned as owned objects without a RecordId.
+ *
  * Preconditions:
  *   -- For each field in 'pattern', all inputs in the child must handle a getFieldDotted for that
  *   field.
@@ -91,6 +100,14 @@ public:
     static const char* kStageType;
 
 private:
+    // A buffered WorkingSetMember in the form in which it is written to a spill file.
+    struct SpilledMember;
+    // Orders (sortKey, SpilledMember) pairs the same way as WorkingSetComparator.
+    class SpillComparator;
+
+    typedef Sorter<BSONObj, SpilledMember> SpillSorter;
+    typedef SortIteratorInterface<BSONObj, SpilledMember> SpillIterator;
+
     //
     // Query Stage
     //
@@ -107,6 +124,9 @@ private:
     // Equal to 0 for no limit.
     size_t _limit;
 
+    // May we switch to an external sort once we run out of memory?
+    bool _allowDiskUse;
+
     //
     // Data storage
     //
@@ -155,6 +175,25 @@ private:
      */
     void sortBuffer();
 
+    /**
+     * Moves everything in the data buffer into '_spillSorter', creating it if needed, and frees
+     * the corresponding working set members. After this is called, all further input bypasses the
+     * data buffer and goes straight to the sorter. A newly created sorter keeps at most
+     * 'sorterMemBytes' in memory before writing to disk.
+     */
+    void spillBuffer(size_t sorterMemBytes);
+
+    /**
+     * Hands the working set member 'item' refers to over to '_spillSorter' and frees it.
+     */
+    void addToSpillSorter(const SortableDataItem& item);
+
+    /**
+     * Allocates a working set member in '_ws' holding the next result read back from the
+     * external sort and returns its id.
+     */
+    WorkingSetID nextSpilledResult();
+
     // Comparator for data buffer
     // Initialization follows sort key generator
     std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -178,6 +217,12 @@ private:
     DataMap _wsidByRecordId;
     static const size_t _dataMapItemSize;
 
+    // Non-null once we have exceeded our memory limit and switched to an external sort.
+    std::unique_ptr<SpillSorter> _spillSorter;
+
+    // Iterates through the output of '_spillSorter' once all data has been gathered.
+    std::unique_ptr<SpillIterator> _spillIterator;
+
     SortStats _specificStats;
 
     // The usage in bytes of all buffered data that we're sorting.
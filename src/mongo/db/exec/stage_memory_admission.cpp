@@ -0,0 +1,374 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/stage_memory_admission.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/json.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/destructor_guard.h"
+#include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+StageMemoryAdmission globalStageMemAdmission;
+
+namespace {
+
+// The reservation of a stage run by the operation which is waiting for memory, if any.
+const auto waitingReservation = OperationContext::declareDecoration<StageMemoryReservation*>();
+
+size_t chunkBytes() {
+    return static_cast<size_t>(
+        std::max(1LL, internalQueryStageMemAdmissionChunkBytes.load()));
+}
+
+class StageMemAdmissionWeights : public ServerParameter {
+public:
+    StageMemAdmissionWeights()
+        : ServerParameter(ServerParameterSet::getGlobal(),
+                          "internalQueryStageMemAdmissionWeights") {}
+
+    void append(OperationContext* opCtx, BSONObjBuilder& b, const std::string& name) final {
+        b.append(name, globalStageMemAdmission.getWeights());
+    }
+
+    Status set(const BSONElement& newValueElement) final {
+        if (newValueElement.type() != Object) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << name() << " must be an object of tenant weights");
+        }
+        return globalStageMemAdmission.setWeights(newValueElement.Obj());
+    }
+
+    Status setFromString(const std::string& str) final {
+        BSONObj weights;
+        try {
+            weights = fromjson(str);
+        } catch (const DBException& ex) {
+            return ex.toStatus();
+        }
+        return globalStageMemAdmission.setWeights(weights);
+    }
+} stageMemAdmissionWeights;
+
+class StageMemAdmissionSection : public ServerStatusSection {
+public:
+    StageMemAdmissionSection() : ServerStatusSection("StageMemAdmission") {}
+
+    bool includeByDefault() const final {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const final {
+        return globalStageMemAdmission.getObj();
+    }
+} stageMemAdmissionSection;
+
+}  // namespace
+
+bool StageMemoryAdmission::enabled() {
+    return internalQueryStageMemAdmissionControl.load();
+}
+
+std::string StageMemoryAdmission::tenantFor(OperationContext* opCtx) {
+    if (internalQueryStageMemAdmissionByUser.load() && opCtx->getClient() &&
+        AuthorizationSession::exists(opCtx->getClient())) {
+        UserNameIterator users =
+            AuthorizationSession::get(opCtx->getClient())->getAuthenticatedUserNames();
+        if (users.more()) {
+            return users.next().getFullName();
+        }
+    }
+    return nsToDatabase(CurOp::get(opCtx)->getNS());
+}
+
+double StageMemoryAdmission::weightFor_inlock(const std::string& tenant) const {
+    auto it = _weights.find(tenant);
+    return it == _weights.end() ? 1.0 : it->second;
+}
+
+bool StageMemoryAdmission::canGrant_inlock(const std::string& tenant,
+                                           size_t bytes,
+                                           bool holding) const {
+    if (_totalReserved == 0) {
+        return true;
+    }
+
+    // Nothing would ever be released, so let the limit on the stages themselves take over.
+    if (holding && _numHoldersWaiting == _numHolders) {
+        return true;
+    }
+
+    const size_t budget = static_cast<size_t>(internalQueryStageMemUsageMAX.load());
+    if (_totalReserved + bytes > budget) {
+        return false;
+    }
+
+    // Split the budget between the tenants which are holding or waiting for memory.
+    bool othersWaiting = false;
+    double totalWeight = 0;
+    for (auto&& entry : _tenants) {
+        if (entry.first != tenant) {
+            totalWeight += weightFor_inlock(entry.first);
+            othersWaiting = othersWaiting || entry.second.waiting > 0;
+        }
+    }
+    if (!othersWaiting) {
+        return true;
+    }
+
+    const double weight = weightFor_inlock(tenant);
+    const double share = budget * weight / (totalWeight + weight);
+    auto it = _tenants.find(tenant);
+    const size_t reserved = it == _tenants.end() ? 0 : it->second.reserved;
+    return reserved + bytes <= share;
+}
+
+void StageMemoryAdmission::reserve(OperationContext* opCtx,
+                                   const std::string& tenant,
+                                   size_t bytes,
+                                   bool holding) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+
+    if (!canGrant_inlock(tenant, bytes, holding)) {
+        ++_tenants[tenant].waiting;
+        ++_numWaits;
+        if (holding) {
+            ++_numHoldersWaiting;
+        }
+        const auto guard = MakeGuard([&] {
+            auto it = _tenants.find(tenant);
+            if (0 == --it->second.waiting && 0 == it->second.reserved) {
+                _tenants.erase(it);
+            }
+            if (holding) {
+                --_numHoldersWaiting;
+            }
+        });
+
+        // A new waiter may change who is entitled to memory, or complete a cycle of waiters.
+        _cv.notify_all();
+
+        LOG(2) << "Waiting to reserve " << bytes << " bytes of stage memory for '" << tenant
+               << "', " << _totalReserved << " bytes are reserved";
+        try {
+            opCtx->waitForConditionOrInterrupt(
+                _cv, lk, [&] { return canGrant_inlock(tenant, bytes, holding); });
+        } catch (const DBException& ex) {
+            if (ex.code() == ErrorCodes::ExceededTimeLimit) {
+                ++_numTimeouts;
+            }
+            throw;
+        }
+    }
+
+    grant_inlock(tenant, bytes, holding);
+}
+
+bool StageMemoryAdmission::tryReserve(const std::string& tenant,
+                                      size_t bytes,
+                                      bool holding,
+                                      bool overBudget) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (!overBudget && !canGrant_inlock(tenant, bytes, holding)) {
+        return false;
+    }
+    grant_inlock(tenant, bytes, holding);
+    return true;
+}
+
+void StageMemoryAdmission::grant_inlock(const std::string& tenant, size_t bytes, bool holding) {
+    const size_t budget = static_cast<size_t>(internalQueryStageMemUsageMAX.load());
+    if (_totalReserved > 0 && _totalReserved + bytes > budget) {
+        ++_numOverBudgetGrants;
+    }
+
+    _tenants[tenant].reserved += bytes;
+    _totalReserved += bytes;
+    if (!holding) {
+        ++_numHolders;
+    }
+}
+
+void StageMemoryAdmission::release(const std::string& tenant, size_t bytes, bool holding) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _tenants.find(tenant);
+    invariant(it != _tenants.end());
+    invariant(it->second.reserved >= bytes);
+
+    it->second.reserved -= bytes;
+    _totalReserved -= bytes;
+    if (!holding) {
+        --_numHolders;
+    }
+    if (0 == it->second.reserved && 0 == it->second.waiting) {
+        _tenants.erase(it);
+    }
+    _cv.notify_all();
+}
+
+Status StageMemoryAdmission::setWeights(const BSONObj& weights) {
+    std::map<std::string, double> newWeights;
+    for (auto&& elem : weights) {
+        if (!elem.isNumber() || elem.numberDouble() <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "weight of tenant '" << elem.fieldName()
+                                        << "' must be a positive number");
+        }
+        newWeights[elem.fieldName()] = elem.numberDouble();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _weights.swap(newWeights);
+    _cv.notify_all();
+    return Status::OK();
+}
+
+BSONObj StageMemoryAdmission::getWeights() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    BSONObjBuilder b;
+    for (auto&& entry : _weights) {
+        b.append(entry.first, entry.second);
+    }
+    return b.obj();
+}
+
+BSONObj StageMemoryAdmission::getObj() const {
+    if (!enabled()) {
+        return BSONObj();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    BSONObjBuilder b;
+    b.appendNumber("reservedBytes", static_cast<long long>(_totalReserved));
+    b.appendNumber("waits", _numWaits);
+    b.appendNumber("timeouts", _numTimeouts);
+    b.appendNumber("overBudgetGrants", _numOverBudgetGrants);
+
+    BSONObjBuilder tenants(b.subobjStart("tenants"));
+    for (auto&& entry : _tenants) {
+        BSONObjBuilder sub(tenants.subobjStart(entry.first));
+        sub.appendNumber("reservedBytes", static_cast<long long>(entry.second.reserved));
+        sub.appendNumber("waiting", static_cast<long long>(entry.second.waiting));
+        sub.append("weight", weightFor_inlock(entry.first));
+    }
+    tenants.done();
+    return b.obj();
+}
+
+StageMemoryReservation::~StageMemoryReservation() {
+    if (_waitingOpCtx && waitingReservation(_waitingOpCtx) == this) {
+        waitingReservation(_waitingOpCtx) = nullptr;
+    }
+    if (_reserved > 0) {
+        DESTRUCTOR_GUARD(globalStageMemAdmission.release(_tenant, _reserved, false);)
+    }
+}
+
+size_t StageMemoryReservation::targetFor(size_t usedBytes) const {
+    const size_t chunk = chunkBytes();
+    return usedBytes == 0 ? 0 : (usedBytes / chunk + 1) * chunk;
+}
+
+bool StageMemoryReservation::adjust(OperationContext* opCtx, size_t usedBytes) {
+    if (!_waitStatus.isOK()) {
+        Status status = std::move(_waitStatus);
+        _waitStatus = Status::OK();
+        uassertStatusOK(status);
+    }
+
+    const size_t target = targetFor(usedBytes);
+    if (usedBytes > _reserved) {
+        if (_tenant.empty()) {
+            _tenant = StageMemoryAdmission::tenantFor(opCtx);
+        }
+
+        // Still registered means the plan came back without waiting for us, so it can't release
+        // its locks and waiting here would hold them. Let the stage memory limit take over.
+        const bool overBudget = _waitingOpCtx != nullptr;
+        if (overBudget && waitingReservation(_waitingOpCtx) == this) {
+            waitingReservation(_waitingOpCtx) = nullptr;
+        }
+        _waitingOpCtx = nullptr;
+
+        if (!globalStageMemAdmission.tryReserve(
+                _tenant, target - _reserved, _reserved > 0, overBudget)) {
+            _waitingOpCtx = opCtx;
+            _waitingForBytes = usedBytes;
+            waitingReservation(opCtx) = this;
+            return false;
+        }
+        _reserved = target;
+    } else if (_reserved > target + chunkBytes() || (usedBytes == 0 && _reserved > 0)) {
+        globalStageMemAdmission.release(_tenant, _reserved - target, target > 0);
+        _reserved = target;
+    }
+    return true;
+}
+
+bool StageMemoryReservation::isWaitPending(OperationContext* opCtx) {
+    return waitingReservation(opCtx) != nullptr;
+}
+
+void StageMemoryReservation::waitWhileYielded(OperationContext* opCtx) {
+    StageMemoryReservation* reservation = waitingReservation(opCtx);
+    if (!reservation) {
+        return;
+    }
+    waitingReservation(opCtx) = nullptr;
+    reservation->_waitingOpCtx = nullptr;
+
+    const size_t target = reservation->targetFor(reservation->_waitingForBytes);
+    if (target <= reservation->_reserved) {
+        return;
+    }
+    try {
+        globalStageMemAdmission.reserve(opCtx,
+                                        reservation->_tenant,
+                                        target - reservation->_reserved,
+                                        reservation->_reserved > 0);
+        reservation->_reserved = target;
+    } catch (const DBException& ex) {
+        reservation->_waitStatus = ex.toStatus();
+    }
+}
+
+}  // namespace mongo
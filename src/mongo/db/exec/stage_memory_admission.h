@@ -0,0 +1,196 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+class OperationContext;
+
+/**
+ * Admission control for the memory that query stages buffer, layered on top of the
+ * globalStageMemCounters accounting.
+ *
+ * Before a stage buffers more data it reserves memory here in chunks of
+ * internalQueryStageMemAdmissionChunkBytes. Reservations are charged to a tenant, which is the
+ * database of the operation or, with internalQueryStageMemAdmissionByUser, its authenticated
+ * user. A reservation is granted when it fits in internalQueryStageMemUsageMAX and the tenant
+ * stays within its weighted share of that budget, where the share is split between the tenants
+ * currently holding or waiting for memory. A tenant may go beyond its share while no other
+ * tenant is waiting.
+ *
+ * Otherwise the operation waits until memory is released, or until it is interrupted or its
+ * maxTimeMS expires. If every stage holding memory is itself waiting for more, nothing would ever
+ * be released, so the waiter is granted its reservation over budget and the
+ * globalStageMemCounters limit applies as before.
+ *
+ * Plan stages never wait while they hold locks and a storage snapshot; see
+ * StageMemoryReservation.
+ */
+class StageMemoryAdmission {
+    MONGO_DISALLOW_COPYING(StageMemoryAdmission);
+
+public:
+    StageMemoryAdmission() = default;
+
+    /**
+     * True if internalQueryStageMemAdmissionControl is set.
+     */
+    static bool enabled();
+
+    /**
+     * Returns the tenant that memory buffered on behalf of 'opCtx' is charged to.
+     */
+    static std::string tenantFor(OperationContext* opCtx);
+
+    /**
+     * Reserves 'bytes' more for 'tenant', waiting until they can be granted. 'holding' is true if
+     * the caller already holds a reservation. Throws if 'opCtx' is interrupted while waiting.
+     */
+    void reserve(OperationContext* opCtx, const std::string& tenant, size_t bytes, bool holding);
+
+    /**
+     * Reserves 'bytes' more for 'tenant' if they can be granted without waiting, or regardless of
+     * the budget if 'overBudget' is true. Returns whether they were reserved.
+     */
+    bool tryReserve(const std::string& tenant, size_t bytes, bool holding, bool overBudget);
+
+    /**
+     * Returns 'bytes' reserved for 'tenant'. 'holding' is true if the caller keeps part of its
+     * reservation.
+     */
+    void release(const std::string& tenant, size_t bytes, bool holding);
+
+    /**
+     * Sets the weight of each tenant from an object of the form {<tenant>: <weight>, ...}.
+     * Tenants which are not listed have a weight of 1.
+     */
+    Status setWeights(const BSONObj& weights);
+    BSONObj getWeights() const;
+
+    /**
+     * Reports reservations and waits per tenant, for serverStatus.
+     */
+    BSONObj getObj() const;
+
+private:
+    struct TenantState {
+        size_t reserved = 0;
+        size_t waiting = 0;
+    };
+
+    bool canGrant_inlock(const std::string& tenant, size_t bytes, bool holding) const;
+    void grant_inlock(const std::string& tenant, size_t bytes, bool holding);
+    double weightFor_inlock(const std::string& tenant) const;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+
+    std::map<std::string, TenantState> _tenants;
+    std::map<std::string, double> _weights;
+
+    size_t _totalReserved = 0;
+
+    // Number of reservations with memory, and how many of them are waiting for more.
+    size_t _numHolders = 0;
+    size_t _numHoldersWaiting = 0;
+
+    long long _numWaits = 0;
+    long long _numTimeouts = 0;
+    long long _numOverBudgetGrants = 0;
+};
+
+extern StageMemoryAdmission globalStageMemAdmission;
+
+/**
+ * The memory reserved by one plan stage. Whatever is still reserved is released on destruction.
+ *
+ * A stage must not wait for memory from within PlanStage::work(), where its plan holds locks and
+ * a storage snapshot. When more memory can't be granted right away, the reservation is registered
+ * as waiting on the OperationContext and the stage returns NEED_YIELD. The plan's next yield waits
+ * for the memory through waitWhileYielded() once locks are released. If the stage is worked again
+ * without that wait, because its plan cannot release locks, the memory is granted over budget.
+ */
+class StageMemoryReservation {
+    MONGO_DISALLOW_COPYING(StageMemoryReservation);
+
+public:
+    StageMemoryReservation() = default;
+    ~StageMemoryReservation();
+
+    /**
+     * Adjusts the reservation so that a stage buffering 'usedBytes' has one chunk of headroom. A
+     * reservation more than a chunk larger than needed is shrunk.
+     *
+     * Never waits. Returns false if more memory is needed and cannot be granted yet, in which case
+     * the stage should return NEED_YIELD. Throws if the wait for memory during the last yield was
+     * interrupted.
+     */
+    bool adjust(OperationContext* opCtx, size_t usedBytes);
+
+    size_t reserved() const {
+        return _reserved;
+    }
+
+    /**
+     * True if a stage run by 'opCtx' returned NEED_YIELD to wait for memory.
+     */
+    static bool isWaitPending(OperationContext* opCtx);
+
+    /**
+     * Waits for the memory a stage run by 'opCtx' is waiting for, if any. Must only be called
+     * while the plan has yielded its locks. Does not throw: an interruption is reported by the
+     * stage's next adjust().
+     */
+    static void waitWhileYielded(OperationContext* opCtx);
+
+private:
+    size_t targetFor(size_t usedBytes) const;
+
+    std::string _tenant;
+    size_t _reserved = 0;
+
+    // Set while this reservation is registered as waiting on an OperationContext, to the bytes it
+    // is waiting to be able to buffer.
+    OperationContext* _waitingOpCtx = nullptr;
+    size_t _waitingForBytes = 0;
+
+    // The error which interrupted the last wait, thrown by the next adjust().
+    Status _waitStatus = Status::OK();
+};
+
+}  // namespace mongo
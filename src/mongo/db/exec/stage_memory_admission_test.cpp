@@ -0,0 +1,281 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/stage_memory_admission.cpp
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/stage_memory_admission.h"
+
+#include "mongo/db/client.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context_d_test_fixture.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+using namespace mongo;
+
+namespace {
+
+const long long kBudget = 100;
+
+class StageMemoryAdmissionTest : public ServiceContextMongoDTest {
+protected:
+    StageMemoryAdmissionTest()
+        : _oldSwitch(internalQueryStageMemAdmissionControl.load()),
+          _oldBudget(internalQueryStageMemUsageMAX.load()) {
+        internalQueryStageMemAdmissionControl.store(true);
+        internalQueryStageMemUsageMAX.store(kBudget);
+        _opCtx = makeOperationContext();
+    }
+
+    ~StageMemoryAdmissionTest() {
+        internalQueryStageMemAdmissionControl.store(_oldSwitch);
+        internalQueryStageMemUsageMAX.store(_oldBudget);
+    }
+
+    OperationContext* opCtx() {
+        return _opCtx.get();
+    }
+
+    /**
+     * Reserves on a separate thread, which must end up waiting for the reservation.
+     */
+    stdx::thread reserveInBackground(const std::string& tenant, size_t bytes) {
+        stdx::thread waiter([this, tenant, bytes] {
+            auto client = getServiceContext()->makeClient("waiter");
+            auto waiterOpCtx = client->makeOperationContext();
+            admission.reserve(waiterOpCtx.get(), tenant, bytes, false);
+        });
+        while (admission.getObj()["tenants"][tenant]["waiting"].numberLong() == 0) {
+            sleepmillis(1);
+        }
+        return waiter;
+    }
+
+    void assertTimesOut(const std::string& tenant, size_t bytes, bool holding) {
+        auto client = getServiceContext()->makeClient("timeout");
+        auto timeoutOpCtx = client->makeOperationContext();
+        timeoutOpCtx->setDeadlineAfterNowBy(Milliseconds(10), ErrorCodes::ExceededTimeLimit);
+        ASSERT_THROWS_CODE(admission.reserve(timeoutOpCtx.get(), tenant, bytes, holding),
+                           DBException,
+                           ErrorCodes::ExceededTimeLimit);
+    }
+
+    StageMemoryAdmission admission;
+
+private:
+    const bool _oldSwitch;
+    const long long _oldBudget;
+    ServiceContext::UniqueOperationContext _opCtx;
+};
+
+TEST_F(StageMemoryAdmissionTest, GrantsWithinBudget) {
+    admission.reserve(opCtx(), "a", 40, false);
+    admission.reserve(opCtx(), "b", 40, false);
+    admission.reserve(opCtx(), "a", 20, true);
+
+    BSONObj stats = admission.getObj();
+    ASSERT_EQUALS(100, stats["reservedBytes"].numberLong());
+    ASSERT_EQUALS(60, stats["tenants"]["a"]["reservedBytes"].numberLong());
+    ASSERT_EQUALS(0, stats["waits"].numberLong());
+
+    admission.release("a", 60, false);
+    admission.release("b", 40, false);
+    stats = admission.getObj();
+    ASSERT_EQUALS(0, stats["reservedBytes"].numberLong());
+    ASSERT_TRUE(stats["tenants"].Obj().isEmpty());
+}
+
+TEST_F(StageMemoryAdmissionTest, FirstReservationIsAlwaysGranted) {
+    admission.reserve(opCtx(), "a", 2 * kBudget, false);
+    ASSERT_EQUALS(2 * kBudget, admission.getObj()["reservedBytes"].numberLong());
+    admission.release("a", 2 * kBudget, false);
+}
+
+TEST_F(StageMemoryAdmissionTest, WaitHonoursDeadline) {
+    admission.reserve(opCtx(), "a", 90, false);
+    assertTimesOut("b", 20, false);
+
+    BSONObj stats = admission.getObj();
+    ASSERT_EQUALS(1, stats["waits"].numberLong());
+    ASSERT_EQUALS(1, stats["timeouts"].numberLong());
+    ASSERT_FALSE(stats["tenants"].Obj().hasField("b"));
+    admission.release("a", 90, false);
+}
+
+TEST_F(StageMemoryAdmissionTest, WaiterIsGrantedOnRelease) {
+    admission.reserve(opCtx(), "a", 90, false);
+    stdx::thread waiter = reserveInBackground("b", 20);
+
+    admission.release("a", 90, false);
+    waiter.join();
+    ASSERT_EQUALS(20, admission.getObj()["tenants"]["b"]["reservedBytes"].numberLong());
+    admission.release("b", 20, false);
+}
+
+TEST_F(StageMemoryAdmissionTest, TenantsAreLimitedToTheirShareWhileOthersWait) {
+    ASSERT_OK(admission.setWeights(BSON("a" << 6)));
+    admission.reserve(opCtx(), "a", 60, false);
+    admission.reserve(opCtx(), "c", 10, false);
+    stdx::thread waiter = reserveInBackground("b", 40);
+
+    // 'a' may have 6/8 of the budget while 'b' is waiting, even though 90 bytes would fit.
+    assertTimesOut("a", 20, true);
+    admission.reserve(opCtx(), "a", 10, true);
+    ASSERT_EQUALS(70, admission.getObj()["tenants"]["a"]["reservedBytes"].numberLong());
+
+    admission.release("a", 70, false);
+    admission.release("c", 10, false);
+    waiter.join();
+    ASSERT_EQUALS(40, admission.getObj()["reservedBytes"].numberLong());
+    admission.release("b", 40, false);
+}
+
+TEST_F(StageMemoryAdmissionTest, GrantsOverBudgetWhenAllHoldersWait) {
+    admission.reserve(opCtx(), "a", 90, false);
+    stdx::thread waiter = reserveInBackground("b", 20);
+
+    // The only holder of memory asking for more can never be satisfied by a release.
+    admission.reserve(opCtx(), "a", 20, true);
+    BSONObj stats = admission.getObj();
+    ASSERT_EQUALS(110, stats["reservedBytes"].numberLong());
+    ASSERT_EQUALS(1, stats["overBudgetGrants"].numberLong());
+
+    admission.release("a", 110, false);
+    waiter.join();
+    admission.release("b", 20, false);
+}
+
+TEST_F(StageMemoryAdmissionTest, RejectsInvalidWeights) {
+    ASSERT_NOT_OK(admission.setWeights(BSON("a" << 0)));
+    ASSERT_NOT_OK(admission.setWeights(BSON("a"
+                                            << "heavy")));
+    ASSERT_OK(admission.setWeights(BSON("a" << 2 << "b" << 0.5)));
+    ASSERT_BSONOBJ_EQ(BSON("a" << 2.0 << "b" << 0.5), admission.getWeights());
+}
+
+TEST_F(StageMemoryAdmissionTest, ReservationKeepsAChunkOfHeadroom) {
+    const long long oldChunk = internalQueryStageMemAdmissionChunkBytes.load();
+    internalQueryStageMemAdmissionChunkBytes.store(10);
+    internalQueryStageMemUsageMAX.store(1000);
+    {
+        StageMemoryReservation reservation;
+        ASSERT_TRUE(reservation.adjust(opCtx(), 0));
+        ASSERT_EQUALS(0U, reservation.reserved());
+
+        ASSERT_TRUE(reservation.adjust(opCtx(), 5));
+        ASSERT_EQUALS(10U, reservation.reserved());
+        ASSERT_TRUE(reservation.adjust(opCtx(), 25));
+        ASSERT_EQUALS(30U, reservation.reserved());
+        ASSERT_TRUE(reservation.adjust(opCtx(), 18));
+        ASSERT_EQUALS(30U, reservation.reserved());
+        ASSERT_TRUE(reservation.adjust(opCtx(), 3));
+        ASSERT_EQUALS(10U, reservation.reserved());
+        ASSERT_TRUE(reservation.adjust(opCtx(), 42));
+        ASSERT_EQUALS(50U, globalStageMemAdmission.getObj()["reservedBytes"].numberLong());
+    }
+    ASSERT_EQUALS(0, globalStageMemAdmission.getObj()["reservedBytes"].numberLong());
+    internalQueryStageMemAdmissionChunkBytes.store(oldChunk);
+}
+
+TEST_F(StageMemoryAdmissionTest, ReservationWaitsOnlyWhileYielded) {
+    const long long oldChunk = internalQueryStageMemAdmissionChunkBytes.load();
+    internalQueryStageMemAdmissionChunkBytes.store(10);
+    {
+        StageMemoryReservation reservation;
+        globalStageMemAdmission.reserve(opCtx(), "other", 90, false);
+        const long long waits = globalStageMemAdmission.getObj()["waits"].numberLong();
+
+        // The stage is told to yield instead of waiting for memory from within work().
+        ASSERT_FALSE(reservation.adjust(opCtx(), 25));
+        ASSERT_TRUE(StageMemoryReservation::isWaitPending(opCtx()));
+        ASSERT_EQUALS(0U, reservation.reserved());
+        ASSERT_EQUALS(waits, globalStageMemAdmission.getObj()["waits"].numberLong());
+
+        globalStageMemAdmission.release("other", 90, false);
+        StageMemoryReservation::waitWhileYielded(opCtx());
+        ASSERT_FALSE(StageMemoryReservation::isWaitPending(opCtx()));
+        ASSERT_EQUALS(30U, reservation.reserved());
+        ASSERT_TRUE(reservation.adjust(opCtx(), 25));
+        ASSERT_EQUALS(30U, reservation.reserved());
+    }
+    ASSERT_EQUALS(0, globalStageMemAdmission.getObj()["reservedBytes"].numberLong());
+    internalQueryStageMemAdmissionChunkBytes.store(oldChunk);
+}
+
+TEST_F(StageMemoryAdmissionTest, ReservationIsGrantedOverBudgetIfThePlanDoesNotYield) {
+    const long long oldChunk = internalQueryStageMemAdmissionChunkBytes.load();
+    internalQueryStageMemAdmissionChunkBytes.store(10);
+    {
+        StageMemoryReservation reservation;
+        globalStageMemAdmission.reserve(opCtx(), "other", 90, false);
+        const long long overBudgetGrants =
+            globalStageMemAdmission.getObj()["overBudgetGrants"].numberLong();
+
+        ASSERT_FALSE(reservation.adjust(opCtx(), 25));
+        ASSERT_TRUE(reservation.adjust(opCtx(), 25));
+        ASSERT_FALSE(StageMemoryReservation::isWaitPending(opCtx()));
+        ASSERT_EQUALS(30U, reservation.reserved());
+        ASSERT_EQUALS(overBudgetGrants + 1,
+                      globalStageMemAdmission.getObj()["overBudgetGrants"].numberLong());
+
+        globalStageMemAdmission.release("other", 90, false);
+    }
+    ASSERT_EQUALS(0, globalStageMemAdmission.getObj()["reservedBytes"].numberLong());
+    internalQueryStageMemAdmissionChunkBytes.store(oldChunk);
+}
+
+TEST_F(StageMemoryAdmissionTest, InterruptedWaitIsReportedByTheNextAdjust) {
+    const long long oldChunk = internalQueryStageMemAdmissionChunkBytes.load();
+    internalQueryStageMemAdmissionChunkBytes.store(10);
+    {
+        auto client = getServiceContext()->makeClient("timeout");
+        auto timeoutOpCtx = client->makeOperationContext();
+        StageMemoryReservation reservation;
+        globalStageMemAdmission.reserve(opCtx(), "other", 90, false);
+
+        ASSERT_FALSE(reservation.adjust(timeoutOpCtx.get(), 25));
+        timeoutOpCtx->setDeadlineAfterNowBy(Milliseconds(10), ErrorCodes::ExceededTimeLimit);
+        StageMemoryReservation::waitWhileYielded(timeoutOpCtx.get());
+        ASSERT_EQUALS(0U, reservation.reserved());
+        ASSERT_THROWS_CODE(reservation.adjust(timeoutOpCtx.get(), 25),
+                           DBException,
+                           ErrorCodes::ExceededTimeLimit);
+
+        globalStageMemAdmission.release("other", 90, false);
+    }
+    ASSERT_EQUALS(0, globalStageMemAdmission.getObj()["reservedBytes"].numberLong());
+    internalQueryStageMemAdmissionChunkBytes.store(oldChunk);
+}
+
+}  // namespace
@@ -40,6 +40,7 @@
 #include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 
 namespace mongo {
@@ -114,6 +115,11 @@ void TextOrStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inva
         if (scoreIt == _scoreIterator) {
             _scoreIterator++;
         }
+        if (WorkingSet::INVALID_ID != scoreIt->second.wsid) {
+            decCachedMemory(_ws->get(scoreIt->second.wsid)->getMemUsage());
+            _ws->free(scoreIt->second.wsid);
+            --_numDocsInMemory;
+        }
         decCachedMemory(_scoresItemSize);
         _scores.erase(scoreIt);
     }
@@ -148,8 +154,11 @@ PlanStage::StageState TextOrStage::doWork(WorkingSetID* out) {
     }
 
     if (chkCachedMemOversize()) {
-        *out = chkMemFailureRet(_ws);
-        return PlanStage::FAILURE;
+        if (!canSpillCachedMem()) {
+            *out = chkMemFailureRet(_ws);
+            return PlanStage::FAILURE;
+        }
+        spillScores();
     }
 
     PlanStage::StageState stageState = PlanStage::IS_EOF;
@@ -247,9 +256,11 @@ PlanStage::StageState TextOrStage::returnResults(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
-    // Retrieve the record that contains the text score.
+    // Retrieve the record that contains the text score. Once returned, it no longer needs to be
+    // buffered or invalidated.
     TextRecordData textRecordData = _scoreIterator->second;
-    ++_scoreIterator;
+    _scoreIterator = _scores.erase(_scoreIterator);
+    decCachedMemory(_scoresItemSize);
 
     // Ignore non-matched documents.
     if (textRecordData.score < 0) {
@@ -257,6 +268,13 @@ PlanStage::StageState TextOrStage::returnResults(WorkingSetID* out) {
         return PlanStage::NEED_TIME;
     }
 
+    if (WorkingSetSpillArea::kInvalidLocation != textRecordData.spillLocation) {
+        textRecordData.wsid = _spillArea->restore(_ws, textRecordData.spillLocation);
+    } else {
+        decCachedMemory(_ws->get(textRecordData.wsid)->getMemUsage());
+        --_numDocsInMemory;
+    }
+
     WorkingSetMember* wsm = _ws->get(textRecordData.wsid);
 
     // Populate the working set member with the text score and return it.
@@ -284,7 +302,8 @@ PlanStage::StageState TextOrStage::addTerm(WorkingSetID wsid, WorkingSetID* out)
         return NEED_TIME;
     }
 
-    if (WorkingSet::INVALID_ID == textRecordData->wsid) {
+    if (WorkingSet::INVALID_ID == textRecordData->wsid &&
+        WorkingSetSpillArea::kInvalidLocation == textRecordData->spillLocation) {
         // We haven't seen this RecordId before.
         invariant(textRecordData->score == 0);
 
@@ -314,14 +333,24 @@ PlanStage::StageState TextOrStage::addTerm(WorkingSetID wsid, WorkingSetID* out)
 
         // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
         wsm->makeObjOwnedIfNeeded();
+
+        // Once we have started spilling, new documents go straight to disk while we are over the
+        // memory limit.
+        if (_spillArea && chkCachedMemOversize()) {
+            incSpilledMemory(wsm->getMemUsage());
+            textRecordData->spillLocation = _spillArea->spill(_ws, wsid);
+            textRecordData->wsid = WorkingSet::INVALID_ID;
+        } else {
+            incCachedMemory(wsm->getMemUsage());
+            ++_numDocsInMemory;
+        }
     } else {
-        // We already have a working set member for this RecordId. Free the new WSM and retrieve the
-        // old one. Note that since we don't keep all index keys, we could get a score that doesn't
-        // match the document, but this has always been a problem.
+        // We already have a working set member (in memory or spilled) for this RecordId. Free the
+        // new WSM and keep the old one. Note that since we don't keep all index keys, we could get
+        // a score that doesn't match the document, but this has always been a problem.
         // TODO something to improve the situation.
         invariant(wsid != textRecordData->wsid);
         _ws->free(wsid);
-        wsm = _ws->get(textRecordData->wsid);
     }
 
     // Locate score within possibly compound key: {prefix,term,score,suffix}.
@@ -340,4 +369,29 @@ PlanStage::StageState TextOrStage::addTerm(WorkingSetID wsid, WorkingSetID* out)
     return NEED_TIME;
 }
 
+void TextOrStage::spillScores() {
+    if (0 == _numDocsInMemory) {
+        return;
+    }
+
+    if (!_spillArea) {
+        _spillArea = make_unique<WorkingSetSpillArea>(storageGlobalParams.dbpath + "/_tmp");
+    }
+
+    size_t releaseSize = 0;
+    for (auto&& entry : _scores) {
+        TextRecordData& textRecordData = entry.second;
+        if (WorkingSet::INVALID_ID == textRecordData.wsid) {
+            continue;
+        }
+        releaseSize += _ws->get(textRecordData.wsid)->getMemUsage();
+        textRecordData.spillLocation = _spillArea->spill(_ws, textRecordData.wsid);
+        textRecordData.wsid = WorkingSet::INVALID_ID;
+    }
+    _numDocsInMemory = 0;
+
+    decCachedMemory(releaseSize);
+    incSpilledMemory(releaseSize);
+}
+
 }  // namespace mongo
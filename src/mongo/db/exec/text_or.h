@@ -32,6 +32,7 @@
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/fts/fts_spec.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/matcher/expression.h"
@@ -124,6 +125,11 @@ private:
      */
     StageState returnResults(WorkingSetID* out);
 
+    /**
+     * Moves the fetched documents buffered in _scores to disk. The scores stay in memory.
+     */
+    void spillScores();
+
     // The index spec used to determine where to find the score.
     FTSSpec _ftsSpec;
 
@@ -139,18 +145,27 @@ private:
     /**
      *  Temporary score data filled out by children.
      *  Maps from RecordID -> (aggregate score for doc, wsid).
-     *  Map each buffered record id to this data.
+     *  Map each buffered record id to this data. Once spilled, the document is found at
+     *  'spillLocation' of _spillArea instead of in 'wsid'.
      */
     struct TextRecordData {
-        TextRecordData() : wsid(WorkingSet::INVALID_ID), score(0.0) {}
+        TextRecordData()
+            : wsid(WorkingSet::INVALID_ID),
+              score(0.0),
+              spillLocation(WorkingSetSpillArea::kInvalidLocation) {}
         WorkingSetID wsid;
         double score;
+        WorkingSetSpillArea::Location spillLocation;
     };
 
     typedef stdx::unordered_map<RecordId, TextRecordData, RecordId::Hasher> ScoreMap;
     ScoreMap _scores;
     ScoreMap::const_iterator _scoreIterator;
     static const size_t _scoresItemSize;
+    std::unique_ptr<WorkingSetSpillArea> _spillArea;
+
+    // Number of entries in _scores whose document is held in memory.
+    size_t _numDocsInMemory = 0;
 
     TextOrStats _specificStats;
 
@@ -0,0 +1,282 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/working_set_spill.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/exec/working_set_computed_data.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/encryption_hooks.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/destructor_guard.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+namespace {
+
+AtomicUInt32 fileCounter;
+
+const char kStateField[] = "state";
+const char kRecordIdField[] = "recordId";
+const char kObjField[] = "obj";
+const char kKeyDataField[] = "keyData";
+const char kKeyPatternIndexField[] = "index";
+const char kKeyField[] = "key";
+const char kTextScoreField[] = "textScore";
+const char kGeoDistanceField[] = "geoDistance";
+const char kGeoNearPointField[] = "geoNearPoint";
+const char kIndexKeyField[] = "indexKey";
+const char kSortKeyField[] = "sortKey";
+
+}  // namespace
+
+// static
+const WorkingSetSpillArea::Location WorkingSetSpillArea::kInvalidLocation;
+
+WorkingSetSpillArea::WorkingSetSpillArea(std::string tempDir) : _tempDir(std::move(tempDir)) {}
+
+WorkingSetSpillArea::~WorkingSetSpillArea() {
+    if (_fileName.empty()) {
+        return;
+    }
+    _file.close();
+    DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName);)
+}
+
+void WorkingSetSpillArea::openFile() {
+    massert(51000,
+            "Attempting to spill working set members without a temporary directory",
+            !_tempDir.empty());
+
+    _fileName = str::stream() << _tempDir << "/stagespill." << fileCounter.addAndFetch(1);
+    boost::filesystem::create_directories(_tempDir);
+
+    _file.open(_fileName.c_str(),
+               std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    massert(51001,
+            str::stream() << "error opening file \"" << _fileName
+                          << "\": " << errnoWithDescription(),
+            _file.good());
+
+    LOG(1) << "Spilling buffered query stage data to " << _fileName;
+}
+
+BSONObj WorkingSetSpillArea::serializeMember(const WorkingSetMember* member) {
+    BSONObjBuilder bob;
+    bob.append(kStateField, static_cast<int>(member->getState()));
+    if (member->hasRecordId()) {
+        bob.append(kRecordIdField, member->recordId.repr());
+    }
+    if (member->hasObj()) {
+        bob.append(kObjField, member->obj.value());
+    }
+
+    if (!member->keyData.empty()) {
+        BSONArrayBuilder keys(bob.subarrayStart(kKeyDataField));
+        for (const auto& datum : member->keyData) {
+            size_t index = 0;
+            while (index < _indexes.size() && _indexes[index].second != datum.index) {
+                ++index;
+            }
+            if (index == _indexes.size()) {
+                _indexes.emplace_back(datum.indexKeyPattern, datum.index);
+            }
+
+            BSONObjBuilder key(keys.subobjStart());
+            key.append(kKeyPatternIndexField, static_cast<int>(index));
+            key.append(kKeyField, datum.keyData);
+        }
+    }
+
+    if (member->hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+        auto score = static_cast<const TextScoreComputedData*>(
+            member->getComputed(WSM_COMPUTED_TEXT_SCORE));
+        bob.append(kTextScoreField, score->getScore());
+    }
+    if (member->hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
+        auto dist = static_cast<const GeoDistanceComputedData*>(
+            member->getComputed(WSM_COMPUTED_GEO_DISTANCE));
+        bob.append(kGeoDistanceField, dist->getDist());
+    }
+    if (member->hasComputed(WSM_GEO_NEAR_POINT)) {
+        auto point =
+            static_cast<const GeoNearPointComputedData*>(member->getComputed(WSM_GEO_NEAR_POINT));
+        bob.append(kGeoNearPointField, point->getPoint());
+    }
+    if (member->hasComputed(WSM_INDEX_KEY)) {
+        auto key = static_cast<const IndexKeyComputedData*>(member->getComputed(WSM_INDEX_KEY));
+        bob.append(kIndexKeyField, key->getKey());
+    }
+    if (member->hasComputed(WSM_SORT_KEY)) {
+        auto key = static_cast<const SortKeyComputedData*>(member->getComputed(WSM_SORT_KEY));
+        bob.append(kSortKeyField, key->getSortKey());
+    }
+    return bob.obj();
+}
+
+WorkingSetSpillArea::Location WorkingSetSpillArea::spill(WorkingSet* ws, WorkingSetID id) {
+    if (_fileName.empty()) {
+        openFile();
+    }
+
+    const BSONObj serialized = serializeMember(ws->get(id));
+    const char* data = serialized.objdata();
+    int32_t size = serialized.objsize();
+
+    std::unique_ptr<char[]> out;
+    auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
+    if (encryptionHooks->enabled()) {
+        size_t protectedSizeMax = size + encryptionHooks->additionalBytesForProtectedBuffer();
+        out.reset(new char[protectedSizeMax]);
+        size_t resultLen;
+        Status status = encryptionHooks->protectTmpData(reinterpret_cast<const uint8_t*>(data),
+                                                        size,
+                                                        reinterpret_cast<uint8_t*>(out.get()),
+                                                        protectedSizeMax,
+                                                        &resultLen);
+        massert(51002,
+                str::stream() << "Failed to protect data: " << status.toString(),
+                status.isOK());
+        data = out.get();
+        size = resultLen;
+    }
+
+    const Location location = _fileSize;
+    _file.seekp(location);
+    _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    _file.write(data, size);
+    massert(51003,
+            str::stream() << "error writing to file \"" << _fileName
+                          << "\": " << errnoWithDescription(),
+            _file.good());
+
+    _fileSize += sizeof(size) + size;
+    ++_numSpilled;
+    ws->free(id);
+    return location;
+}
+
+WorkingSetID WorkingSetSpillArea::restore(WorkingSet* ws, Location location) {
+    invariant(location >= 0 && static_cast<uint64_t>(location) < _fileSize);
+
+    int32_t size;
+    _file.seekg(location);
+    _file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    massert(51004,
+            str::stream() << "error reading file \"" << _fileName
+                          << "\": " << errnoWithDescription(),
+            _file.good() && size > 0);
+
+    std::unique_ptr<char[]> data(new char[size]);
+    _file.read(data.get(), size);
+    massert(51005,
+            str::stream() << "error reading file \"" << _fileName
+                          << "\": " << errnoWithDescription(),
+            _file.good());
+
+    size_t objSize = size;
+    auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
+    if (encryptionHooks->enabled()) {
+        std::unique_ptr<char[]> out(new char[size]);
+        Status status = encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(data.get()),
+                                                          size,
+                                                          reinterpret_cast<uint8_t*>(out.get()),
+                                                          size,
+                                                          &objSize);
+        massert(51006,
+                str::stream() << "Failed to unprotect data: " << status.toString(),
+                status.isOK());
+        data.swap(out);
+    }
+
+    SharedBuffer buffer = SharedBuffer::allocate(objSize);
+    memcpy(buffer.get(), data.get(), objSize);
+    const BSONObj serialized(std::move(buffer));
+
+    WorkingSetID id = ws->allocate();
+    WorkingSetMember* member = ws->get(id);
+
+    if (serialized.hasField(kRecordIdField)) {
+        member->recordId = RecordId(serialized[kRecordIdField].Long());
+    }
+    if (serialized.hasField(kObjField)) {
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), serialized[kObjField].Obj().getOwned());
+    }
+    if (serialized.hasField(kKeyDataField)) {
+        for (auto&& elem : serialized[kKeyDataField].Obj()) {
+            const BSONObj key = elem.Obj();
+            const auto& index = _indexes[key[kKeyPatternIndexField].numberInt()];
+            member->keyData.push_back(
+                IndexKeyDatum(index.first, key[kKeyField].Obj().getOwned(), index.second));
+        }
+    }
+
+    if (serialized.hasField(kTextScoreField)) {
+        member->addComputed(new TextScoreComputedData(serialized[kTextScoreField].Double()));
+    }
+    if (serialized.hasField(kGeoDistanceField)) {
+        member->addComputed(new GeoDistanceComputedData(serialized[kGeoDistanceField].Double()));
+    }
+    if (serialized.hasField(kGeoNearPointField)) {
+        member->addComputed(new GeoNearPointComputedData(serialized[kGeoNearPointField].Obj()));
+    }
+    if (serialized.hasField(kIndexKeyField)) {
+        member->addComputed(new IndexKeyComputedData(serialized[kIndexKeyField].Obj()));
+    }
+    if (serialized.hasField(kSortKeyField)) {
+        member->addComputed(new SortKeyComputedData(serialized[kSortKeyField].Obj()));
+    }
+
+    switch (static_cast<WorkingSetMember::MemberState>(serialized[kStateField].numberInt())) {
+        case WorkingSetMember::RID_AND_IDX:
+            ws->transitionToRecordIdAndIdx(id);
+            member->isSuspicious = true;
+            break;
+        case WorkingSetMember::RID_AND_OBJ:
+            ws->transitionToRecordIdAndObj(id);
+            break;
+        case WorkingSetMember::OWNED_OBJ:
+            member->transitionToOwnedObj();
+            break;
+        default:
+            MONGO_UNREACHABLE;
+    }
+    return id;
+}
+
+}  // namespace mongo
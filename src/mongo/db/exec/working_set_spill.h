@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+class IndexAccessMethod;
+
+/**
+ * A temporary file that stages use to park WorkingSetMembers they are buffering when the stage
+ * memory limit is exceeded (see internalQueryStageMemUsageSpill).
+ *
+ * spill() writes a member to the end of the file, frees it from the WorkingSet and returns the
+ * location at which it was written. restore() reads the member at a location back into a newly
+ * allocated WorkingSetMember. Locations stay valid for the lifetime of the spill area, so a member
+ * may be restored more than once. The file is created on the first spill and removed when the
+ * spill area is destroyed.
+ *
+ * Restored members are conservative copies of the originals: they carry no storage snapshot, so
+ * consumers which compare snapshots will re-fetch the document, and members in the RID_AND_IDX
+ * state are flagged as suspicious since a yield may have happened while they were on disk.
+ */
+class WorkingSetSpillArea {
+    MONGO_DISALLOW_COPYING(WorkingSetSpillArea);
+
+public:
+    typedef int64_t Location;
+
+    static const Location kInvalidLocation = -1;
+
+    /**
+     * The spill file is created in 'tempDir' when it is first needed.
+     */
+    explicit WorkingSetSpillArea(std::string tempDir);
+    ~WorkingSetSpillArea();
+
+    /**
+     * Writes the member 'id' to disk and frees it from 'ws'.
+     */
+    Location spill(WorkingSet* ws, WorkingSetID id);
+
+    /**
+     * Reads back the member written at 'location' into a newly allocated member of 'ws'.
+     */
+    WorkingSetID restore(WorkingSet* ws, Location location);
+
+    /**
+     * Number of bytes written to the spill file so far.
+     */
+    uint64_t bytesWritten() const {
+        return _fileSize;
+    }
+
+    /**
+     * Number of members spilled so far.
+     */
+    size_t numSpilled() const {
+        return _numSpilled;
+    }
+
+private:
+    void openFile();
+
+    BSONObj serializeMember(const WorkingSetMember* member);
+
+    const std::string _tempDir;
+    std::string _fileName;
+    std::fstream _file;
+    uint64_t _fileSize = 0;
+    size_t _numSpilled = 0;
+
+    // Spilled index key data refers to its index by position in this list. The key pattern is not
+    // owned, exactly like in IndexKeyDatum.
+    std::vector<std::pair<BSONObj, const IndexAccessMethod*>> _indexes;
+};
+
+}  // namespace mongo
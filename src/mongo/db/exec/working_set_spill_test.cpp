@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/working_set_spill.cpp
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/working_set_spill.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/exec/working_set_computed_data.h"
+#include "mongo/db/service_context_d_test_fixture.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+class WorkingSetSpillAreaTest : public ServiceContextMongoDTest {
+protected:
+    WorkingSetSpillAreaTest() : _tempDir("working_set_spill_test") {}
+
+    std::string tempDir() {
+        return _tempDir.path() + "/_tmp";
+    }
+
+    WorkingSet ws;
+
+private:
+    unittest::TempDir _tempDir;
+};
+
+TEST_F(WorkingSetSpillAreaTest, RoundTripsRecordIdAndObj) {
+    WorkingSetSpillArea spillArea(tempDir());
+
+    WorkingSetID id = ws.allocate();
+    WorkingSetMember* member = ws.get(id);
+    member->recordId = RecordId(42);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << 1 << "b" << "text"));
+    ws.transitionToRecordIdAndObj(id);
+    member->addComputed(new TextScoreComputedData(1.5));
+    member->addComputed(new SortKeyComputedData(BSON("" << 1)));
+
+    WorkingSetSpillArea::Location location = spillArea.spill(&ws, id);
+    ASSERT_NOT_EQUALS(WorkingSetSpillArea::kInvalidLocation, location);
+    ASSERT_EQUALS(1U, spillArea.numSpilled());
+    ASSERT_GT(spillArea.bytesWritten(), 0U);
+
+    WorkingSetID restoredId = spillArea.restore(&ws, location);
+    WorkingSetMember* restored = ws.get(restoredId);
+    ASSERT_EQUALS(WorkingSetMember::RID_AND_OBJ, restored->getState());
+    ASSERT_EQUALS(RecordId(42), restored->recordId);
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1 << "b"
+                               << "text"),
+                      restored->obj.value());
+    ASSERT_TRUE(restored->obj.value().isOwned());
+
+    auto score = static_cast<const TextScoreComputedData*>(
+        restored->getComputed(WSM_COMPUTED_TEXT_SCORE));
+    ASSERT_EQUALS(1.5, score->getScore());
+    auto sortKey = static_cast<const SortKeyComputedData*>(restored->getComputed(WSM_SORT_KEY));
+    ASSERT_BSONOBJ_EQ(BSON("" << 1), sortKey->getSortKey());
+    ASSERT_FALSE(restored->hasComputed(WSM_COMPUTED_GEO_DISTANCE));
+}
+
+TEST_F(WorkingSetSpillAreaTest, RestoresIndexKeysAsSuspicious) {
+    WorkingSetSpillArea spillArea(tempDir());
+    const BSONObj keyPattern = BSON("a" << 1);
+
+    WorkingSetID id = ws.allocate();
+    WorkingSetMember* member = ws.get(id);
+    member->recordId = RecordId(7);
+    member->keyData.push_back(IndexKeyDatum(keyPattern, BSON("" << 3), NULL));
+    ws.transitionToRecordIdAndIdx(id);
+
+    WorkingSetID restoredId = spillArea.restore(&ws, spillArea.spill(&ws, id));
+    WorkingSetMember* restored = ws.get(restoredId);
+    ASSERT_EQUALS(WorkingSetMember::RID_AND_IDX, restored->getState());
+    ASSERT_EQUALS(RecordId(7), restored->recordId);
+    ASSERT_TRUE(restored->isSuspicious);
+    ASSERT_EQUALS(1U, restored->keyData.size());
+    ASSERT_BSONOBJ_EQ(keyPattern, restored->keyData[0].indexKeyPattern);
+    ASSERT_BSONOBJ_EQ(BSON("" << 3), restored->keyData[0].keyData);
+
+    BSONElement elt;
+    ASSERT_TRUE(restored->getFieldDotted("a", &elt));
+    ASSERT_EQUALS(3, elt.numberInt());
+}
+
+TEST_F(WorkingSetSpillAreaTest, RoundTripsOwnedObj) {
+    WorkingSetSpillArea spillArea(tempDir());
+
+    WorkingSetID id = ws.allocate();
+    WorkingSetMember* member = ws.get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("x" << 1));
+    member->transitionToOwnedObj();
+    member->addComputed(new GeoDistanceComputedData(2.0));
+    member->addComputed(new GeoNearPointComputedData(BSON("type"
+                                                          << "Point")));
+
+    WorkingSetID restoredId = spillArea.restore(&ws, spillArea.spill(&ws, id));
+    WorkingSetMember* restored = ws.get(restoredId);
+    ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, restored->getState());
+    ASSERT_FALSE(restored->hasRecordId());
+    ASSERT_BSONOBJ_EQ(BSON("x" << 1), restored->obj.value());
+
+    auto dist = static_cast<const GeoDistanceComputedData*>(
+        restored->getComputed(WSM_COMPUTED_GEO_DISTANCE));
+    ASSERT_EQUALS(2.0, dist->getDist());
+    auto point =
+        static_cast<const GeoNearPointComputedData*>(restored->getComputed(WSM_GEO_NEAR_POINT));
+    ASSERT_BSONOBJ_EQ(BSON("type"
+                           << "Point"),
+                      point->getPoint());
+}
+
+TEST_F(WorkingSetSpillAreaTest, RestoresInAnyOrderAndRemovesFile) {
+    boost::filesystem::path spillDir(tempDir());
+    {
+        WorkingSetSpillArea spillArea(tempDir());
+        ASSERT_FALSE(boost::filesystem::exists(spillDir));
+
+        std::vector<WorkingSetSpillArea::Location> locations;
+        for (int i = 0; i < 100; ++i) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* member = ws.get(id);
+            member->recordId = RecordId(i + 1);
+            member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("i" << i));
+            ws.transitionToRecordIdAndObj(id);
+            locations.push_back(spillArea.spill(&ws, id));
+        }
+        ASSERT_EQUALS(100U, spillArea.numSpilled());
+        ASSERT_FALSE(boost::filesystem::is_empty(spillDir));
+
+        for (int i = 99; i >= 0; --i) {
+            WorkingSetID id = spillArea.restore(&ws, locations[i]);
+            ASSERT_EQUALS(RecordId(i + 1), ws.get(id)->recordId);
+            ASSERT_EQUALS(i, ws.get(id)->obj.value()["i"].numberInt());
+            ws.free(id);
+        }
+
+        // Locations remain valid after being restored.
+        WorkingSetID id = spillArea.restore(&ws, locations[50]);
+        ASSERT_EQUALS(50, ws.get(id)->obj.value()["i"].numberInt());
+    }
+    ASSERT_TRUE(boost::filesystem::is_empty(spillDir));
+}
+
+}  // namespace
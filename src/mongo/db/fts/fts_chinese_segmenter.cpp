@@ -0,0 +1,320 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/fts/fts_chinese_segmenter.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <third_party/murmurhash3/MurmurHash3.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status_with.h"
+#include "mongo/db/fts/fts_chinese_tokenizer.h"
+#include "mongo/db/fts/jieba/Jieba.hpp"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace fts {
+
+const char kChineseCompiledDictName[] = "jieba.dict.dat";
+
+namespace {
+
+const char kDictName[] = "jieba.dict.utf8";
+const char kHmmModelName[] = "hmm_model.utf8";
+const char kUserDictName[] = "user.dict.utf8";
+const char kIdfName[] = "idf.utf8";
+const char kStopWordsName[] = "stop_words.utf8";
+
+// Guards the segmenter in use and the directory it was loaded from.
+stdx::mutex segmenterMutex;
+std::shared_ptr<const cppjieba::Jieba> segmenter;
+std::string segmenterDictDir;
+
+// Serializes loads, so that two of them do not compile the same directory at once.
+stdx::mutex loadMutex;
+
+/**
+ * A compiled dictionary, either mapped from its file or held in memory.
+ */
+class DictImage {
+    MONGO_DISALLOW_COPYING(DictImage);
+
+public:
+    explicit DictImage(std::string buffer)
+        : _buffer(std::move(buffer)), _data(_buffer.data()), _size(_buffer.size()) {}
+
+    DictImage(void* mapping, size_t size)
+        : _mapping(mapping), _data(static_cast<const char*>(mapping)), _size(size) {}
+
+    ~DictImage() {
+#ifndef _WIN32
+        if (_mapping) {
+            munmap(_mapping, _size);
+        }
+#endif
+    }
+
+    const char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    std::string _buffer;
+    void* _mapping = nullptr;
+    const char* _data;
+    size_t _size;
+};
+
+std::string dictPath(const std::string& dictDir, const char* name) {
+    return dictDir + "/" + name;
+}
+
+/**
+ * Maps a compiled dictionary read-only. Where mapping files is not supported it is read instead.
+ */
+StatusWith<std::shared_ptr<DictImage>> mapImage(const std::string& path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Status(ErrorCodes::FileNotOpen,
+                      str::stream() << "failed to open " << path << ": " << errnoWithDescription());
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        int err = errno;
+        close(fd);
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "failed to read " << path << ": "
+                                    << errnoWithDescription(err));
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "failed to map " << path << ": "
+                                    << errnoWithDescription(err));
+    }
+    return std::make_shared<DictImage>(mapping, st.st_size);
+#else
+    std::ifstream in(path, std::ios::binary);
+    std::string buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!in.good() && !in.eof()) {
+        return Status(ErrorCodes::FileStreamFailed, str::stream() << "failed to read " << path);
+    }
+    return std::make_shared<DictImage>(std::move(buffer));
+#endif
+}
+
+/**
+ * Saves a compiled dictionary under a temporary name and renames it over 'path', so that
+ * processes which have the previous file mapped keep it.
+ */
+Status writeImage(const std::string& path, const std::string& image) {
+    const std::string tmpPath =
+        path + boost::filesystem::unique_path(".%%%%-%%%%.tmp").string();
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(image.data(), image.size());
+        out.close();
+        if (!out) {
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpPath, ec);
+            return Status(ErrorCodes::FileStreamFailed,
+                          str::stream() << "failed to write " << tmpPath);
+        }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        boost::filesystem::remove(tmpPath, ec);
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "failed to rename " << tmpPath << ": " << ec.message());
+    }
+    return Status::OK();
+}
+
+/**
+ * Identifies the text dictionaries a compiled dictionary is built from by their sizes and
+ * modification times.
+ */
+uint64_t sourceStamp(const std::vector<std::string>& paths) {
+    StringBuilder sb;
+    for (const auto& path : paths) {
+        boost::system::error_code ec;
+        sb << path << ':' << static_cast<long long>(boost::filesystem::file_size(path, ec)) << ':'
+           << static_cast<long long>(boost::filesystem::last_write_time(path, ec)) << ';';
+    }
+    const std::string key = sb.str();
+    uint64_t hash[2];
+    MurmurHash3_x64_128(key.data(), key.size(), 0, hash);
+    return hash[0];
+}
+
+bool isCompiledFrom(const DictImage& image, bool haveSources, uint64_t stamp) {
+    std::string error;
+    const auto header = cppjieba::DictTrie::CheckImage(image.data(), image.size(), error);
+    return header && (!haveSources || header->stamp == stamp);
+}
+
+/**
+ * Returns the compiled dictionary of 'dictDir', compiling it first if it is missing or was built
+ * from other text dictionaries.
+ */
+StatusWith<std::shared_ptr<DictImage>> loadImage(const std::string& dictDir) {
+    const std::string compiledPath = dictPath(dictDir, kChineseCompiledDictName);
+    const std::string textPath = dictPath(dictDir, kDictName);
+    const std::string userPath = dictPath(dictDir, kUserDictName);
+    const bool haveSources = boost::filesystem::exists(textPath);
+    const uint64_t stamp = haveSources ? sourceStamp({textPath, userPath}) : 0;
+
+    if (boost::filesystem::exists(compiledPath)) {
+        auto swImage = mapImage(compiledPath);
+        if (swImage.isOK() && isCompiledFrom(*swImage.getValue(), haveSources, stamp)) {
+            return swImage;
+        }
+        log() << "Recompiling Chinese dictionary " << compiledPath << ": "
+              << (swImage.isOK() ? "it is out of date" : swImage.getStatus().reason());
+    }
+    if (!haveSources) {
+        return Status(ErrorCodes::NonExistentPath,
+                      str::stream() << "missing Chinese dictionary " << textPath);
+    }
+
+    std::string buffer;
+    std::string error;
+    if (!cppjieba::DictTrie::Compile(
+            textPath, userPath, cppjieba::DictTrie::WordWeightMedian, stamp, buffer, error)) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "failed to compile Chinese dictionary " << textPath
+                                    << ": "
+                                    << error);
+    }
+
+    Status written = writeImage(compiledPath, buffer);
+    if (written.isOK()) {
+        auto swImage = mapImage(compiledPath);
+        if (swImage.isOK() && isCompiledFrom(*swImage.getValue(), true, stamp)) {
+            return swImage;
+        }
+    } else {
+        warning() << "Could not save compiled Chinese dictionary, it will be compiled again on "
+                     "the next load: "
+                  << written;
+    }
+    return std::make_shared<DictImage>(std::move(buffer));
+}
+
+}  // namespace
+
+Status loadChineseSegmenter(const std::string& dictDir) {
+    stdx::lock_guard<stdx::mutex> loadLk(loadMutex);
+    Timer timer;
+
+    for (auto name : {kHmmModelName, kUserDictName, kIdfName, kStopWordsName}) {
+        const std::string path = dictPath(dictDir, name);
+        if (!boost::filesystem::exists(path)) {
+            return Status(ErrorCodes::NonExistentPath,
+                          str::stream() << "missing Chinese dictionary " << path);
+        }
+    }
+
+    auto swImage = loadImage(dictDir);
+    if (!swImage.isOK()) {
+        return swImage.getStatus();
+    }
+    const auto& image = swImage.getValue();
+
+    // cppjieba aborts the process on dictionaries it can't load, so they are all checked first.
+    std::string error;
+    if (!cppjieba::Jieba::Validate(image->data(),
+                                   image->size(),
+                                   dictPath(dictDir, kHmmModelName),
+                                   dictPath(dictDir, kIdfName),
+                                   dictPath(dictDir, kStopWordsName),
+                                   error)) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "invalid Chinese dictionary in " << dictDir << ": "
+                                    << error);
+    }
+
+    std::shared_ptr<const cppjieba::Jieba> loaded =
+        std::make_shared<const cppjieba::Jieba>(image,
+                                                image->data(),
+                                                image->size(),
+                                                dictPath(dictDir, kHmmModelName),
+                                                dictPath(dictDir, kIdfName),
+                                                dictPath(dictDir, kStopWordsName));
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(segmenterMutex);
+        segmenter.swap(loaded);
+        segmenterDictDir = dictDir;
+    }
+
+    // 'loaded' now holds the previous segmenter, which goes away with the last tokenizer using
+    // it. The segmentations it made cannot be used any more.
+    ChineseFTSTokenizer::clearSegmentCache();
+
+    log() << "Loaded Chinese dictionaries from " << dictDir << " in " << timer.millis() << "ms";
+    return Status::OK();
+}
+
+std::shared_ptr<const cppjieba::Jieba> getChineseSegmenter() {
+    stdx::lock_guard<stdx::mutex> lk(segmenterMutex);
+    return segmenter;
+}
+
+std::string getChineseDictDir() {
+    stdx::lock_guard<stdx::mutex> lk(segmenterMutex);
+    return segmenterDictDir;
+}
+
+}  // namespace fts
+}  // namespace mongo
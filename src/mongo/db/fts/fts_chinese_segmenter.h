@@ -0,0 +1,76 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "mongo/base/status.h"
+
+namespace cppjieba {
+class Jieba;
+}  // namespace cppjieba
+
+namespace mongo {
+namespace fts {
+
+/**
+ * Name of the compiled word dictionary kept next to the text dictionaries of a dictionary
+ * directory.
+ */
+extern const char kChineseCompiledDictName[];
+
+/**
+ * Loads the Jieba dictionaries in 'dictDir' and makes them the ones used by the Chinese
+ * tokenizers created from then on; tokenizers which already exist keep the dictionaries they
+ * were created with.
+ *
+ * The word and user dictionaries are compiled once into kChineseCompiledDictName, which later
+ * loads map in place, so that they take no time to parse and are shared through the page cache by
+ * every process using the directory. The compiled dictionary is rebuilt when the text
+ * dictionaries change, and is not written if the directory is read-only.
+ *
+ * Returns an error, and leaves the current dictionaries in use, if 'dictDir' lacks a dictionary or
+ * one of them is malformed.
+ */
+Status loadChineseSegmenter(const std::string& dictDir);
+
+/**
+ * Returns the segmenter for Chinese text, or nullptr if no dictionaries were loaded.
+ */
+std::shared_ptr<const cppjieba::Jieba> getChineseSegmenter();
+
+/**
+ * Returns the directory the dictionaries of getChineseSegmenter() were loaded from, or an empty
+ * string if none were.
+ */
+std::string getChineseDictDir();
+
+}  // namespace fts
+}  // namespace mongo
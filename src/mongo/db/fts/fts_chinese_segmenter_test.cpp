@@ -0,0 +1,221 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+#include "mongo/db/fts/fts_chinese_segmenter.h"
+#include "mongo/db/fts/fts_chinese_tokenizer.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace fts {
+namespace {
+
+/**
+ * Writes a dictionary directory of a handful of words and a trivial HMM model.
+ */
+class ChineseSegmenterTest : public unittest::Test {
+public:
+    ChineseSegmenterTest() : _dir("fts_chinese_segmenter_test") {
+        std::ofstream(path("jieba.dict.utf8")) << "中华 100 ns\n人民 100 n\n共和国 100 n\n"
+                                               << "数据 100 n\n数据库 100 n\n全文 100 n\n"
+                                               << "索引 100 n\n";
+        std::ofstream(path("hmm_model.utf8")) << "-0.26 -3.14e+100 -3.14e+100 -1.46\n"
+                                              << "-3.14e+100 -0.51 -0.91 -3.14e+100\n"
+                                              << "-0.59 -3.14e+100 -3.14e+100 -0.81\n"
+                                              << "-3.14e+100 -0.33 -1.26 -3.14e+100\n"
+                                              << "-0.72 -3.14e+100 -3.14e+100 -0.67\n"
+                                              << "的:-3.0\n的:-3.0\n的:-3.0\n的:-3.0\n";
+        std::ofstream(path("user.dict.utf8")).close();
+        std::ofstream(path("idf.utf8")) << "数据 5.0\n";
+        std::ofstream(path("stop_words.utf8")) << "的\n";
+    }
+
+    std::string path(StringData file = "") {
+        return _dir.path() + "/" + file;
+    }
+
+    std::string dir() {
+        return _dir.path();
+    }
+
+    static std::vector<std::string> cut(const std::shared_ptr<const cppjieba::Jieba>& segmenter,
+                                        const std::string& text) {
+        std::vector<std::string> words;
+        segmenter->CutForSearch(text, words);
+        return words;
+    }
+
+    static bool contains(const std::vector<std::string>& words, const std::string& word) {
+        return std::find(words.begin(), words.end(), word) != words.end();
+    }
+
+private:
+    unittest::TempDir _dir;
+};
+
+TEST_F(ChineseSegmenterTest, LoadCompilesTheWordDictionary) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    ASSERT_TRUE(boost::filesystem::exists(path(kChineseCompiledDictName)));
+    ASSERT_EQUALS(dir(), getChineseDictDir());
+
+    auto words = cut(getChineseSegmenter(), "中华人民共和国的数据库");
+    ASSERT_TRUE(contains(words, "中华"));
+    ASSERT_TRUE(contains(words, "共和国"));
+    ASSERT_TRUE(contains(words, "数据库"));
+}
+
+TEST_F(ChineseSegmenterTest, CompiledDictionaryLoadsWithoutTheTextDictionary) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    boost::filesystem::remove(path("jieba.dict.utf8"));
+
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    ASSERT_TRUE(contains(cut(getChineseSegmenter(), "全文数据库"), "数据库"));
+}
+
+TEST_F(ChineseSegmenterTest, ChangedUserDictionaryIsRecompiled) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    ASSERT_FALSE(contains(cut(getChineseSegmenter(), "全文索引"), "全文索引"));
+
+    std::ofstream(path("user.dict.utf8")) << "全文索引 n\n";
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    ASSERT_TRUE(contains(cut(getChineseSegmenter(), "全文索引"), "全文索引"));
+}
+
+TEST_F(ChineseSegmenterTest, CorruptCompiledDictionaryIsRecompiled) {
+    std::ofstream(path(kChineseCompiledDictName)) << "not a dictionary";
+
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    ASSERT_TRUE(contains(cut(getChineseSegmenter(), "数据库"), "数据库"));
+}
+
+TEST_F(ChineseSegmenterTest, CompiledDictionaryWithWordsOutOfBoundsIsRecompiled) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+
+    auto assertRecompiledAfter = [&](const std::function<void(cppjieba::DictUnit*)>& corrupt) {
+        std::string image;
+        {
+            std::ifstream in(path(kChineseCompiledDictName), std::ios::binary);
+            image.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        cppjieba::DictImageHeader header;
+        ASSERT_GREATER_THAN_OR_EQUALS(image.size(), sizeof(header));
+        memcpy(&header, image.data(), sizeof(header));
+        cppjieba::DictUnit unit;
+        memcpy(&unit, &image[header.unitOffset], sizeof(unit));
+        corrupt(&unit);
+        memcpy(&image[header.unitOffset], &unit, sizeof(unit));
+        std::ofstream(path(kChineseCompiledDictName), std::ios::binary | std::ios::trunc)
+            << image;
+
+        ASSERT_OK(loadChineseSegmenter(dir()));
+        ASSERT_TRUE(contains(cut(getChineseSegmenter(), "中华人民共和国"), "中华"));
+    };
+
+    assertRecompiledAfter([](cppjieba::DictUnit* unit) { unit->tag = 1 << 30; });
+    assertRecompiledAfter([](cppjieba::DictUnit* unit) { unit->length = 1 << 30; });
+    assertRecompiledAfter([](cppjieba::DictUnit* unit) { unit->length = 0; });
+}
+
+TEST_F(ChineseSegmenterTest, ReloadLeavesExistingTokenizersOnTheirDictionaries) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    auto before = getChineseSegmenter();
+    ChineseFTSTokenizer tokenizer(nullptr, before);
+
+    std::ofstream(path("user.dict.utf8")) << "全文索引 n\n";
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    auto after = getChineseSegmenter();
+    ASSERT_NOT_EQUALS(before.get(), after.get());
+
+    // The same text is segmented again by the new dictionaries rather than found in the cache.
+    std::vector<std::string> words;
+    tokenizer.reset("全文索引", FTSTokenizer::kNone);
+    while (tokenizer.moveNext()) {
+        words.push_back(tokenizer.get().toString());
+    }
+    ASSERT_FALSE(contains(words, "全文索引"));
+
+    ChineseFTSTokenizer newTokenizer(nullptr, after);
+    words.clear();
+    newTokenizer.reset("全文索引", FTSTokenizer::kNone);
+    while (newTokenizer.moveNext()) {
+        words.push_back(newTokenizer.get().toString());
+    }
+    ASSERT_TRUE(contains(words, "全文索引"));
+}
+
+TEST_F(ChineseSegmenterTest, FailedLoadKeepsTheCurrentDictionaries) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    auto current = getChineseSegmenter();
+
+    ASSERT_EQUALS(ErrorCodes::NonExistentPath,
+                  loadChineseSegmenter(path("no_such_directory")).code());
+    ASSERT_EQUALS(current.get(), getChineseSegmenter().get());
+    ASSERT_EQUALS(dir(), getChineseDictDir());
+}
+
+TEST_F(ChineseSegmenterTest, MalformedDictionariesFailToLoad) {
+    ASSERT_OK(loadChineseSegmenter(dir()));
+    auto current = getChineseSegmenter();
+
+    auto assertFailsToLoadWith = [&](const char* name, const std::string& contents) {
+        std::ifstream in(path(name));
+        const std::string original((std::istreambuf_iterator<char>(in)),
+                                   std::istreambuf_iterator<char>());
+        std::ofstream(path(name), std::ios::trunc) << contents;
+        ASSERT_EQUALS(ErrorCodes::FailedToParse, loadChineseSegmenter(dir()).code()) << name;
+        ASSERT_EQUALS(current.get(), getChineseSegmenter().get());
+        std::ofstream(path(name), std::ios::trunc) << original;
+    };
+
+    assertFailsToLoadWith("hmm_model.utf8", "");
+    assertFailsToLoadWith("hmm_model.utf8", "-0.26 -3.14e+100 -3.14e+100\n");
+    assertFailsToLoadWith("hmm_model.utf8",
+                          "-0.26 -3.14e+100 -3.14e+100 -1.46\n"
+                          "-3.14e+100 -0.51 -0.91 -3.14e+100\n"
+                          "-0.59 -3.14e+100 -3.14e+100 -0.81\n"
+                          "-3.14e+100 -0.33 -1.26 -3.14e+100\n"
+                          "-0.72 -3.14e+100 -3.14e+100 -0.67\n"
+                          "的-3.0\n");
+    assertFailsToLoadWith("idf.utf8", "");
+    assertFailsToLoadWith("idf.utf8", "数据 -5.0\n");
+    assertFailsToLoadWith("stop_words.utf8", "");
+
+    ASSERT_OK(loadChineseSegmenter(dir()));
+}
+
+}  // namespace
+}  // namespace fts
+}  // namespace mongo
@@ -4,62 +4,177 @@
 
 #include "mongo/db/fts/fts_chinese_tokenizer.h"
 
-#include "mongo/db/fts/fts_query_impl.h"
-#include "mongo/db/fts/fts_spec.h"
-#include "mongo/db/fts/stemmer.h"
-#include "mongo/db/fts/stop_words.h"
-#include "mongo/db/fts/tokenizer.h"
-#include "mongo/db/server_options.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <third_party/murmurhash3/MurmurHash3.h>
+
+#include "mongo/base/counter.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/log.h"
-#include "mongo/util/mongoutils/str.h"
-#include "mongo/util/stringutils.h"
+#include "mongo/util/lru_cache.h"
 
 namespace mongo {
 namespace fts {
 
-ChineseFTSTokenizer::ChineseFTSTokenizer(const FTSLanguage* language,
-                                         const cppjieba::Jieba* segmenter)
-    : _language(language), _segmenter(segmenter) {}
+namespace {
 
-void ChineseFTSTokenizer::reset(StringData document, Options options) {
-    (void)options;
-    _document = document.toString();
-    const auto& tmp = split(_document);
-    for (const auto& v : tmp) {
-        _words.emplace_back(v);
+// Budget for the texts and word spans held by the segment cache.
+const size_t kSegmentCacheMaxBytes = 16 * 1024 * 1024;
+
+// Texts larger than this are segmented every time rather than evicting much of the cache.
+const size_t kSegmentCacheMaxTextBytes = 64 * 1024;
+
+bool isWhitespaceWord(StringData word) {
+    return word.size() == 1 && std::strchr("\n\t\r\f\v ", word[0]) != nullptr;
+}
+
+/**
+ * LRU cache of segmentations keyed by a hash of the text. Each entry keeps its text so that a
+ * hash collision is a miss rather than a wrong segmentation.
+ */
+class SegmentCache {
+public:
+    struct Entry {
+        // Compared by owner, since a segmenter which was reloaded may be freed and its address
+        // reused while its segmentations are still cached.
+        std::weak_ptr<const cppjieba::Jieba> segmenter;
+        std::string text;
+        std::shared_ptr<const ChineseFTSTokenizer::Segmentation> segmentation;
+    };
+
+    std::shared_ptr<const ChineseFTSTokenizer::Segmentation> find(
+        const std::shared_ptr<const cppjieba::Jieba>& segmenter, StringData text, uint64_t hash) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto it = _cache.find(hash);
+        if (it == _cache.end() || !_sameOwner(it->second.segmenter, segmenter) ||
+            it->second.text != text) {
+            return nullptr;
+        }
+        return _cache.promote(it)->second.segmentation;
+    }
+
+    void add(const std::shared_ptr<const cppjieba::Jieba>& segmenter,
+             StringData text,
+             uint64_t hash,
+             std::shared_ptr<const ChineseFTSTokenizer::Segmentation> segmentation) {
+        const size_t bytes = _entryBytes(text.size(), *segmentation);
+        if (bytes > kSegmentCacheMaxBytes) {
+            return;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto it = _cache.find(hash);
+        if (it != _cache.end()) {
+            _bytes -= _entryBytes(it->second.text.size(), *it->second.segmentation);
+            _cache.erase(it);
+        }
+        while (!_cache.empty() && _bytes + bytes > kSegmentCacheMaxBytes) {
+            auto last = std::prev(_cache.end());
+            _bytes -= _entryBytes(last->second.text.size(), *last->second.segmentation);
+            _cache.erase(last);
+        }
+        _cache.add(hash, Entry{segmenter, text.toString(), std::move(segmentation)});
+        _bytes += bytes;
+    }
+
+    void clear() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _cache.clear();
+        _bytes = 0;
+    }
+
+private:
+    static bool _sameOwner(const std::weak_ptr<const cppjieba::Jieba>& lhs,
+                           const std::shared_ptr<const cppjieba::Jieba>& rhs) {
+        return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
     }
-    _stem = "";
+
+    static size_t _entryBytes(size_t textSize,
+                              const ChineseFTSTokenizer::Segmentation& segmentation) {
+        return sizeof(Entry) + textSize + segmentation.size() * sizeof(cppjieba::WordSpan);
+    }
+
+    stdx::mutex _mutex;
+
+    // Bounded by '_bytes' rather than by its number of entries.
+    LRUCache<uint64_t, Entry> _cache{std::numeric_limits<size_t>::max()};
+    size_t _bytes = 0;
+};
+
+SegmentCache segmentCache;
+
+// Number of texts whose segmentation was found in the cache.
+Counter64 segmentCacheHits;
+
+uint64_t hashText(StringData text) {
+    uint64_t hash[2];
+    MurmurHash3_x64_128(text.rawData(), text.size(), 0, hash);
+    return hash[0];
 }
 
-std::list<std::string> ChineseFTSTokenizer::split(const StringData& doc) {
-    std::vector<std::string> tmp;
-    std::list<std::string> result;
-    LOG(2) << "split string " << doc;
-    _segmenter->CutForSearch(doc.toString(), tmp);
-    LOG(2) << "split string size " << tmp.size();
-    for (const auto& v : tmp) {
-        LOG(2) << "ChineseFTSTokenizer " << v;
-        if (v == "\n" || v == "\t" || v == "\r" || v == "\f" || v == "\v" || v == " ") {
-            continue;
+}  // namespace
+
+ChineseFTSTokenizer::ChineseFTSTokenizer(const FTSLanguage* language,
+                                         std::shared_ptr<const cppjieba::Jieba> segmenter)
+    : _language(language), _segmenter(std::move(segmenter)) {}
+
+void ChineseFTSTokenizer::reset(StringData document, Options options) {
+    _document = document;
+    _pos = 0;
+    _word = StringData();
+
+    // Texts too large to be cached are neither hashed nor looked up.
+    const bool cacheable = document.size() <= kSegmentCacheMaxTextBytes;
+    uint64_t hash = 0;
+    if (cacheable) {
+        hash = hashText(document);
+        _segmentation = segmentCache.find(_segmenter, document, hash);
+        if (_segmentation) {
+            segmentCacheHits.increment();
+            return;
         }
-        result.push_back(v);
     }
-    return result;
+
+    Segmentation spans;
+    _segmenter->CutForSearch(document.rawData(), document.size(), spans);
+    spans.erase(std::remove_if(spans.begin(),
+                               spans.end(),
+                               [&](const cppjieba::WordSpan& span) {
+                                   return isWhitespaceWord(
+                                       document.substr(span.first, span.second));
+                               }),
+                spans.end());
+    LOG(2) << "ChineseFTSTokenizer split " << document.size() << " bytes into " << spans.size()
+           << " words";
+
+    _segmentation = std::make_shared<const Segmentation>(std::move(spans));
+    if (cacheable) {
+        segmentCache.add(_segmenter, document, hash, _segmentation);
+    }
 }
 
 bool ChineseFTSTokenizer::moveNext() {
-    if (_words.size() == 0) {
-        _stem = "";
+    if (!_segmentation || _pos >= _segmentation->size()) {
+        _word = StringData();
         return false;
     }
-    _stem = *(_words.begin());
-    _words.pop_front();
+    const auto& span = (*_segmentation)[_pos++];
+    _word = _document.substr(span.first, span.second);
     return true;
 }
 
 StringData ChineseFTSTokenizer::get() const {
-    return _stem;
+    return _word;
+}
+
+void ChineseFTSTokenizer::clearSegmentCache() {
+    segmentCache.clear();
+}
+
+long long ChineseFTSTokenizer::getSegmentCacheHits() {
+    return segmentCacheHits.get();
 }
 
 }  // namespace fts
@@ -1,24 +1,39 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/fts/fts_tokenizer.h"
 #include "mongo/db/fts/jieba/Jieba.hpp"
-#include "mongo/db/fts/stemmer.h"
-#include "mongo/db/fts/tokenizer.h"
-#include "mongo/db/fts/unicode/string.h"
 
 namespace mongo {
 namespace fts {
 
 class FTSLanguage;
-class StopWords;
 
+/**
+ * ChineseFTSTokenizer
+ * A iterator of "documents" where a document is Chinese text segmented into words by Jieba in
+ * search mode.
+ *
+ * The words returned by get() are slices of the document passed to reset(), so that document
+ * must outlive the iteration. Segmentations are kept in a process-wide cache bounded in bytes and
+ * keyed by a hash of the text, so re-indexing a text which did not change (e.g. computing the old
+ * keys of a document on update) does not segment it again.
+ */
 class ChineseFTSTokenizer final : public FTSTokenizer {
     MONGO_DISALLOW_COPYING(ChineseFTSTokenizer);
 
 public:
-    ChineseFTSTokenizer(const FTSLanguage* language, const cppjieba::Jieba* segmenter);
+    /**
+     * Byte offsets and lengths of the words of a text, without whitespace.
+     */
+    using Segmentation = std::vector<cppjieba::WordSpan>;
+
+    ChineseFTSTokenizer(const FTSLanguage* language,
+                        std::shared_ptr<const cppjieba::Jieba> segmenter);
 
     void reset(StringData document, Options options) override;
 
@@ -26,18 +41,25 @@ public:
 
     StringData get() const override;
 
-private:
-    std::list<std::string> split(const StringData& doc);
-
-    const FTSLanguage* const _language;
-
-    std::string _document;
+    /**
+     * Drops every cached segmentation.
+     */
+    static void clearSegmentCache();
 
-    std::string _stem;
+    /**
+     * Returns the number of texts whose segmentation was found in the cache.
+     */
+    static long long getSegmentCacheHits();
 
-    std::list<std::string> _words;
+private:
+    const FTSLanguage* const _language;
+    // Shared so that the dictionaries can be reloaded while the tokenizer is in use.
+    const std::shared_ptr<const cppjieba::Jieba> _segmenter;
 
-    const cppjieba::Jieba* const _segmenter;
+    StringData _document;
+    std::shared_ptr<const Segmentation> _segmentation;
+    size_t _pos = 0;
+    StringData _word;
 };
 
 }  // namespace fts
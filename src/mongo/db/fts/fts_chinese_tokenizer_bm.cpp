@@ -0,0 +1,217 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/fts/fts_chinese_segmenter.h"
+#include "mongo/db/fts/fts_chinese_tokenizer.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace fts {
+namespace {
+
+const char* const kWords[] = {
+    "中华", "人民", "共和国", "中华人民共和国", "数据", "数据库", "全文", "索引",
+    "分词", "搜索", "引擎", "文档", "更新", "性能", "测试", "的",
+    "是",   "在",   "我们",   "服务器",         "集合", "查询", "结果", "，",
+    "。",   " ",    "mongo",  "2018",
+};
+
+const size_t kNumWords = sizeof(kWords) / sizeof(kWords[0]);
+const int kNumTexts = 256;
+
+/**
+ * Writes a small Jieba dictionary and HMM model covering 'kWords', plus 'numExtraWords' random
+ * words, to a temporary directory, and loads a segmenter from it, so the benchmark does not depend
+ * on the dictionaries of an install.
+ */
+class Segmenter {
+public:
+    explicit Segmenter(int numExtraWords = 0)
+        : _dir(boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path("fts_chinese_tokenizer_bm-%%%%")) {
+        boost::filesystem::create_directories(_dir);
+
+        boost::filesystem::ofstream dict(_dir / "jieba.dict.utf8");
+        for (size_t i = 0; i < kNumWords; i++) {
+            if (StringData(kWords[i]) != " ") {
+                dict << kWords[i] << " " << 100 + i << " n\n";
+            }
+        }
+        PseudoRandom random(2);
+        for (int i = 0; i < numExtraWords; i++) {
+            // Two to four runes of the CJK block, encoded as UTF-8.
+            for (int j = random.nextInt32(3) + 2; j > 0; j--) {
+                const int rune = 0x4e00 + random.nextInt32(5000);
+                dict << char(0xe0 | (rune >> 12)) << char(0x80 | ((rune >> 6) & 0x3f))
+                     << char(0x80 | (rune & 0x3f));
+            }
+            dict << " " << random.nextInt32(10000) + 1 << " n\n";
+        }
+        dict.close();
+
+        boost::filesystem::ofstream hmm(_dir / "hmm_model.utf8");
+        hmm << "-0.26 -3.14e+100 -3.14e+100 -1.46\n"
+            << "-3.14e+100 -0.51 -0.91 -3.14e+100\n"
+            << "-0.59 -3.14e+100 -3.14e+100 -0.81\n"
+            << "-3.14e+100 -0.33 -1.26 -3.14e+100\n"
+            << "-0.72 -3.14e+100 -3.14e+100 -0.67\n";
+        for (int i = 0; i < 4; i++) {
+            hmm << "的:-3.0,是:-4.0\n";
+        }
+        hmm.close();
+
+        boost::filesystem::ofstream(_dir / "user.dict.utf8").close();
+        boost::filesystem::ofstream(_dir / "idf.utf8") << "数据 5.0\n";
+        boost::filesystem::ofstream(_dir / "stop_words.utf8") << "的\n";
+
+        _jieba = std::make_shared<const cppjieba::Jieba>((_dir / "jieba.dict.utf8").string(),
+                                                         (_dir / "hmm_model.utf8").string(),
+                                                         (_dir / "user.dict.utf8").string(),
+                                                         (_dir / "idf.utf8").string(),
+                                                         (_dir / "stop_words.utf8").string());
+    }
+
+    ~Segmenter() {
+        boost::filesystem::remove_all(_dir);
+    }
+
+    std::shared_ptr<const cppjieba::Jieba> get() const {
+        return _jieba;
+    }
+
+    std::string dir() const {
+        return _dir.string();
+    }
+
+private:
+    const boost::filesystem::path _dir;
+    std::shared_ptr<const cppjieba::Jieba> _jieba;
+};
+
+std::vector<std::string> makeTexts(int numWords) {
+    PseudoRandom random(1);
+    std::vector<std::string> texts(kNumTexts);
+    for (auto& text : texts) {
+        for (int i = 0; i < numWords; i++) {
+            text += kWords[random.nextInt32(kNumWords)];
+        }
+    }
+    return texts;
+}
+
+/**
+ * Tokenizes 'texts' the way a text index does, returning the number of bytes of text processed.
+ */
+size_t tokenizeAll(ChineseFTSTokenizer* tokenizer, const std::vector<std::string>& texts) {
+    size_t bytes = 0;
+    for (const auto& text : texts) {
+        tokenizer->reset(text, FTSTokenizer::kFilterStopWords);
+        while (tokenizer->moveNext()) {
+            benchmark::DoNotOptimize(tokenizer->get().rawData());
+        }
+        bytes += text.size();
+    }
+    return bytes;
+}
+
+/**
+ * Indexes texts which were never seen before, as on inserts. The argument is the number of words
+ * per text.
+ */
+void BM_ChineseTokenizeNewText(benchmark::State& state) {
+    Segmenter segmenter;
+    const auto texts = makeTexts(state.range(0));
+    // The tokenizer does not depend on the language beyond its construction.
+    ChineseFTSTokenizer tokenizer(nullptr, segmenter.get());
+
+    size_t bytes = 0;
+    for (auto keepRunning : state) {
+        state.PauseTiming();
+        ChineseFTSTokenizer::clearSegmentCache();
+        state.ResumeTiming();
+        bytes += tokenizeAll(&tokenizer, texts);
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+/**
+ * Re-indexes texts which did not change, as when computing the old and new keys of an update
+ * which does not touch the text-indexed fields.
+ */
+void BM_ChineseTokenizeUnchangedText(benchmark::State& state) {
+    Segmenter segmenter;
+    const auto texts = makeTexts(state.range(0));
+    ChineseFTSTokenizer tokenizer(nullptr, segmenter.get());
+
+    ChineseFTSTokenizer::clearSegmentCache();
+    tokenizeAll(&tokenizer, texts);
+
+    size_t bytes = 0;
+    for (auto keepRunning : state) {
+        bytes += tokenizeAll(&tokenizer, texts);
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+/**
+ * Loads a dictionary directory whose word dictionary has the argument number of words. The
+ * dictionary is compiled on every load when the second argument is 0, and mapped from the file
+ * compiled by the first load when it is 1.
+ */
+void BM_ChineseDictionaryLoad(benchmark::State& state) {
+    Segmenter segmenter(state.range(0));
+    const boost::filesystem::path compiled =
+        boost::filesystem::path(segmenter.dir()) / kChineseCompiledDictName;
+
+    for (auto keepRunning : state) {
+        if (state.range(1) == 0) {
+            state.PauseTiming();
+            boost::filesystem::remove(compiled);
+            state.ResumeTiming();
+        }
+        invariant(loadChineseSegmenter(segmenter.dir()).isOK());
+    }
+}
+
+BENCHMARK(BM_ChineseDictionaryLoad)
+    ->Args({100 * 1000, 0})
+    ->Args({100 * 1000, 1})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChineseTokenizeNewText)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK(BM_ChineseTokenizeUnchangedText)->Arg(16)->Arg(256)->Arg(4096);
+
+}  // namespace
+}  // namespace fts
+}  // namespace mongo
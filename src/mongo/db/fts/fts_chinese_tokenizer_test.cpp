@@ -0,0 +1,157 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <fstream>
+
+#include "mongo/db/fts/fts_chinese_tokenizer.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace fts {
+namespace {
+
+/**
+ * Loads a segmenter from a dictionary of a handful of words and a trivial HMM model.
+ */
+class ChineseFTSTokenizerTest : public unittest::Test {
+public:
+    ChineseFTSTokenizerTest() : _dir("fts_chinese_tokenizer_test") {
+        std::ofstream(path("jieba.dict.utf8")) << "中华 100 ns\n人民 100 n\n共和国 100 n\n"
+                                               << "中华人民共和国 100 ns\n数据 100 n\n"
+                                               << "数据库 100 n\n全文 100 n\n索引 100 n\n";
+        std::ofstream(path("hmm_model.utf8")) << "-0.26 -3.14e+100 -3.14e+100 -1.46\n"
+                                              << "-3.14e+100 -0.51 -0.91 -3.14e+100\n"
+                                              << "-0.59 -3.14e+100 -3.14e+100 -0.81\n"
+                                              << "-3.14e+100 -0.33 -1.26 -3.14e+100\n"
+                                              << "-0.72 -3.14e+100 -3.14e+100 -0.67\n"
+                                              << "的:-3.0\n的:-3.0\n的:-3.0\n的:-3.0\n";
+        std::ofstream(path("user.dict.utf8")).close();
+        std::ofstream(path("idf.utf8")) << "数据 5.0\n";
+        std::ofstream(path("stop_words.utf8")) << "的\n";
+
+        _segmenter = std::make_shared<const cppjieba::Jieba>(path("jieba.dict.utf8"),
+                                                             path("hmm_model.utf8"),
+                                                             path("user.dict.utf8"),
+                                                             path("idf.utf8"),
+                                                             path("stop_words.utf8"));
+        ChineseFTSTokenizer::clearSegmentCache();
+    }
+
+    std::string path(StringData file) {
+        return _dir.path() + "/" + file;
+    }
+
+    std::vector<StringData> tokenize(ChineseFTSTokenizer* tokenizer, StringData text) {
+        tokenizer->reset(text, FTSTokenizer::kFilterStopWords);
+        std::vector<StringData> words;
+        while (tokenizer->moveNext()) {
+            words.push_back(tokenizer->get());
+        }
+        return words;
+    }
+
+protected:
+    unittest::TempDir _dir;
+    std::shared_ptr<const cppjieba::Jieba> _segmenter;
+};
+
+TEST_F(ChineseFTSTokenizerTest, SegmentsForSearchAndDropsWhitespace) {
+    ChineseFTSTokenizer tokenizer(nullptr, _segmenter);
+    const std::string text = "中华人民共和国的数据库\n全文 索引";
+
+    auto words = tokenize(&tokenizer, text);
+    const std::vector<StringData> expected = {
+        "中华", "人民", "共和国", "中华人民共和国", "的", "数据", "数据库", "全文", "索引"};
+    ASSERT_EQUALS(expected.size(), words.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQUALS(expected[i], words[i]);
+    }
+}
+
+TEST_F(ChineseFTSTokenizerTest, WordsAreSlicesOfTheDocument) {
+    ChineseFTSTokenizer tokenizer(nullptr, _segmenter);
+    const std::string text = "数据库 全文索引";
+
+    for (auto word : tokenize(&tokenizer, text)) {
+        ASSERT_GTE(word.rawData(), text.data());
+        ASSERT_LTE(word.rawData() + word.size(), text.data() + text.size());
+    }
+}
+
+TEST_F(ChineseFTSTokenizerTest, CachedSegmentationIsReusedForEqualText) {
+    ChineseFTSTokenizer tokenizer(nullptr, _segmenter);
+    const std::string first = "中华人民共和国 数据库";
+    const std::string second = first;
+    const auto hits = ChineseFTSTokenizer::getSegmentCacheHits();
+
+    auto firstWords = tokenize(&tokenizer, first);
+    ASSERT_EQUALS(hits, ChineseFTSTokenizer::getSegmentCacheHits());
+    auto secondWords = tokenize(&tokenizer, second);
+    ASSERT_EQUALS(hits + 1, ChineseFTSTokenizer::getSegmentCacheHits());
+
+    // The second text is served from the cache, but its words still point into its own buffer.
+    ASSERT_EQUALS(firstWords.size(), secondWords.size());
+    for (size_t i = 0; i < firstWords.size(); i++) {
+        ASSERT_EQUALS(firstWords[i], secondWords[i]);
+        ASSERT_GTE(secondWords[i].rawData(), second.data());
+        ASSERT_LTE(secondWords[i].rawData() + secondWords[i].size(),
+                   second.data() + second.size());
+    }
+
+    auto otherWords = tokenize(&tokenizer, "全文 索引");
+    ASSERT_EQUALS(2U, otherWords.size());
+    ASSERT_EQUALS("全文", otherWords[0]);
+    ASSERT_EQUALS("索引", otherWords[1]);
+}
+
+TEST_F(ChineseFTSTokenizerTest, LargeTextIsNotCached) {
+    ChineseFTSTokenizer tokenizer(nullptr, _segmenter);
+    std::string text;
+    while (text.size() <= 64 * 1024) {
+        text += "中华人民共和国 数据库 ";
+    }
+    const auto hits = ChineseFTSTokenizer::getSegmentCacheHits();
+
+    auto firstWords = tokenize(&tokenizer, text);
+    auto secondWords = tokenize(&tokenizer, text);
+    ASSERT_EQUALS(hits, ChineseFTSTokenizer::getSegmentCacheHits());
+    ASSERT_EQUALS(firstWords.size(), secondWords.size());
+}
+
+TEST_F(ChineseFTSTokenizerTest, EmptyDocumentHasNoWords) {
+    ChineseFTSTokenizer tokenizer(nullptr, _segmenter);
+    ASSERT_TRUE(tokenize(&tokenizer, "").empty());
+    ASSERT_FALSE(tokenizer.moveNext());
+}
+
+}  // namespace
+}  // namespace fts
+}  // namespace mongo
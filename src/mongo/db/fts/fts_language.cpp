@@ -29,15 +29,14 @@
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
 
 #include "mongo/db/fts/fts_language.h"
-#include "mongo/db/fts/jieba/Jieba.hpp"
 #include "mongo/db/server_options.h"
 
-#include <boost/filesystem/operations.hpp>
 #include <string>
 
 #include "mongo/base/init.h"
 #include "mongo/db/fts/fts_basic_phrase_matcher.h"
 #include "mongo/db/fts/fts_basic_tokenizer.h"
+#include "mongo/db/fts/fts_chinese_segmenter.h"
 #include "mongo/db/fts/fts_chinese_tokenizer.h"
 #include "mongo/db/fts/fts_unicode_phrase_matcher.h"
 #include "mongo/db/fts/fts_unicode_tokenizer.h"
@@ -89,8 +88,6 @@ LanguageMap languageMapV2;
 // Case-sensitive by lookup key.
 typedef std::map<StringData, const FTSLanguage*> LanguageMapLegacy;
 LanguageMapLegacy languageMapV1;
-
-std::unique_ptr<cppjieba::Jieba> cnSegmenter;
 }
 
 MONGO_INITIALIZER_GROUP(FTSAllLanguagesRegistered, MONGO_NO_PREREQUISITES, MONGO_NO_DEPENDENTS);
@@ -144,21 +141,13 @@ MONGO_FTS_LANGUAGE_LIST(LANGUAGE_DECLV3);
 
 MONGO_INITIALIZER_GENERAL(FTSChineseLoad, ("EndStartupOptionStorage"), MONGO_NO_DEPENDENTS)
 (::mongo::InitializerContext* context) {
-    static const std::string dictPath = serverGlobalParams.ftsDictDir + "/jieba.dict.utf8";
-    static const std::string hmmPath = serverGlobalParams.ftsDictDir + "/hmm_model.utf8";
-    static const std::string userDictPath = serverGlobalParams.ftsDictDir + "/user.dict.utf8";
-    static const std::string idfPath = serverGlobalParams.ftsDictDir + "/idf.utf8";
-    static const std::string stopWordsPath = serverGlobalParams.ftsDictDir + "/stop_words.utf8";
-    bool supportChinese = true;
-    std::vector<std::string> paths = {dictPath, hmmPath, userDictPath, idfPath, stopWordsPath};
-    for (const auto& p : paths) {
-        if (!boost::filesystem::exists(p)) {
-            supportChinese = false;
+    bool supportChinese = false;
+    if (!serverGlobalParams.ftsDictDir.empty()) {
+        Status status = loadChineseSegmenter(serverGlobalParams.ftsDictDir);
+        if (!status.isOK()) {
+            log() << "Chinese text indexes are not available: " << status;
         }
-    }
-    if (supportChinese) {
-        cnSegmenter = stdx::make_unique<cppjieba::Jieba>(
-            dictPath, hmmPath, userDictPath, idfPath, stopWordsPath);
+        supportChinese = status.isOK();
     }
     LOG(0) << "fts chinese supported:" << (supportChinese ? "yes" : "no");
     return Status::OK();
@@ -339,10 +328,11 @@ const FTSPhraseMatcher& BasicFTSLanguage::getPhraseMatcher() const {
 
 std::unique_ptr<FTSTokenizer> UnicodeFTSLanguage::createTokenizer() const {
     if (str() == "chinese") {
-        if (!cnSegmenter) {
+        auto segmenter = getChineseSegmenter();
+        if (!segmenter) {
             return nullptr;
         }
-        return stdx::make_unique<ChineseFTSTokenizer>(this, cnSegmenter.get());
+        return stdx::make_unique<ChineseFTSTokenizer>(this, std::move(segmenter));
     }
     return stdx::make_unique<UnicodeFTSTokenizer>(this);
 }
@@ -26,5 +26,101 @@
 *    it in the license file.
 */
 
-// This file intentionally blank. ftsmongod.cpp exists to anchor construction of the ftsmongod
-// library, which would otherwise have no object files.
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/fts/fts_chinese_segmenter.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace fts {
+namespace {
+
+/**
+ * Returns the namespace of a collection with a text index, or an empty string if there is none.
+ */
+std::string findTextIndexedCollection(OperationContext* opCtx) {
+    std::vector<std::string> dbNames;
+    {
+        Lock::GlobalLock lk(opCtx, MODE_IS);
+        opCtx->getServiceContext()->getStorageEngine()->listDatabases(&dbNames);
+    }
+
+    for (const auto& dbName : dbNames) {
+        Lock::DBLock dbLock(opCtx, dbName, MODE_IS);
+        Database* db = DatabaseHolder::getDatabaseHolder().get(opCtx, dbName);
+        if (!db) {
+            continue;
+        }
+        for (Collection* coll : *db) {
+            Lock::CollectionLock collLock(opCtx->lockState(), coll->ns().ns(), MODE_IS);
+            std::vector<IndexDescriptor*> textIndexes;
+            coll->getIndexCatalog()->findIndexByType(opCtx, IndexNames::TEXT, textIndexes, true);
+            if (!textIndexes.empty()) {
+                return coll->ns().ns();
+            }
+        }
+    }
+    return "";
+}
+
+/**
+ * Reloads the dictionaries of Chinese text from a directory, which may be the one they were loaded
+ * from at startup, without a restart. Index operations which are running finish with the previous
+ * dictionaries.
+ *
+ * Any text index may hold keys of Chinese text, since documents can name their language. Keys made
+ * with the previous dictionaries would no longer be found and removed when their documents change,
+ * so the dictionaries can only be reloaded at run time while there are no text indexes.
+ */
+class FTSDictDirParameter final : public ServerParameter {
+public:
+    FTSDictDirParameter()
+        : ServerParameter(ServerParameterSet::getGlobal(), "ftsDictDir", false, true) {}
+
+    void append(OperationContext* opCtx, BSONObjBuilder& b, const std::string& name) final {
+        b.append(name, getChineseDictDir());
+    }
+
+    Status set(const BSONElement& newValueElement) final {
+        if (newValueElement.type() != String) {
+            return Status(ErrorCodes::BadValue, "ftsDictDir only supports type string");
+        }
+
+        auto opCtx = cc().getOperationContext();
+        invariant(opCtx);
+
+        // Writes, and so the creation of text indexes, wait until the dictionaries are replaced.
+        Lock::GlobalRead lk(opCtx);
+        const auto textIndexedCollection = findTextIndexedCollection(opCtx);
+        if (!textIndexedCollection.empty()) {
+            return Status(ErrorCodes::IllegalOperation,
+                          str::stream() << "Cannot reload the Chinese dictionaries while text "
+                                           "indexes exist, such as on "
+                                        << textIndexedCollection
+                                        << "; drop the text indexes, reload the dictionaries "
+                                           "and build the indexes again");
+        }
+        return setFromString(newValueElement.str());
+    }
+
+    Status setFromString(const std::string& str) final {
+        return loadChineseSegmenter(str);
+    }
+} ftsDictDirParameter;
+
+}  // namespace
+}  // namespace fts
+}  // namespace mongo
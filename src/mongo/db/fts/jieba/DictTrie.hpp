@@ -12,6 +12,7 @@
 #include <iostream>
 #include <limits>
 #include <map>
+#include <memory>
 #include <stdint.h>
 #include <string>
 
@@ -24,6 +25,30 @@ const double MAX_DOUBLE = 3.14e+100;
 const size_t DICT_COLUMN_NUM = 3;
 const char* const UNKNOWN_TAG = "";
 
+const char DICT_IMAGE_MAGIC[8] = {'J', 'I', 'E', 'B', 'A', 'D', 'A', 'T'};
+const uint32_t DICT_IMAGE_VERSION = 1;
+const uint32_t DICT_IMAGE_BYTE_ORDER = 0x01020304;
+
+// Header of a compiled dictionary image. The sections it points to follow it at offsets aligned
+// to 8 bytes, so the image can be used in place from a memory mapped file.
+struct DictImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t imageSize;
+    uint64_t stamp;  // chosen by the caller of Compile() to recognise the sources of the image
+    double minWeight;
+    double userWordDefaultWeight;
+    uint64_t unitCount;
+    uint64_t unitOffset;
+    uint64_t slotCount;
+    uint64_t slotOffset;
+    uint64_t singleCount;  // single rune words of the user dictionaries, sorted
+    uint64_t singleOffset;
+    uint64_t tagSize;
+    uint64_t tagOffset;
+};  // struct DictImageHeader
+
 class DictTrie {
 public:
     enum UserWordWeightOption {
@@ -35,44 +60,132 @@ public:
     DictTrie(const string& dict_path,
              const string& user_dict_paths = "",
              UserWordWeightOption user_word_weight_opt = WordWeightMedian) {
-        Init(dict_path, user_dict_paths, user_word_weight_opt);
+        string error;
+        XCHECK(Compile(dict_path, user_dict_paths, user_word_weight_opt, 0, owned_image_, error))
+            << error;
+        XCHECK(Attach(owned_image_.data(), owned_image_.size(), error)) << error;
     }
 
-    ~DictTrie() {
-        delete trie_;
+    // Uses a compiled image in place. 'owner' keeps the memory of the image alive.
+    DictTrie(shared_ptr<const void> owner, const char* image, size_t size) : owner_(owner) {
+        string error;
+        XCHECK(Attach(image, size, error)) << error;
     }
 
-    bool InsertUserWord(const string& word, const string& tag = UNKNOWN_TAG) {
-        DictUnit node_info;
-        if (!MakeNodeInfo(node_info, word, user_word_default_weight_, tag)) {
+    ~DictTrie() {}
+
+    // Compiles text dictionaries into an image which can be saved and used by the constructor
+    // above. Returns false and sets 'error' if a dictionary cannot be read.
+    static bool Compile(const string& dict_path,
+                        const string& user_dict_paths,
+                        UserWordWeightOption user_word_weight_opt,
+                        uint64_t stamp,
+                        string& image,
+                        string& error) {
+        Source source;
+        if (!LoadDict(dict_path, source, error)) {
             return false;
         }
-        active_node_infos_.push_back(node_info);
-        trie_->InsertNode(node_info.word, &active_node_infos_.back());
-        return true;
-    }
+        if (source.units.empty()) {
+            error = "no words in " + dict_path;
+            return false;
+        }
+        double freq_sum = CalcFreqSum(source.units);
+        CalculateWeight(source.units, freq_sum);
+        double default_weight = SetStaticWordWeights(source, user_word_weight_opt);
 
-    bool InsertUserWord(const string& word, int freq, const string& tag = UNKNOWN_TAG) {
-        DictUnit node_info;
-        double weight = freq ? log(1.0 * freq / freq_sum_) : user_word_default_weight_;
-        if (!MakeNodeInfo(node_info, word, weight, tag)) {
+        if (user_dict_paths.size() &&
+            !LoadUserDict(user_dict_paths, freq_sum, default_weight, source, error)) {
             return false;
         }
-        active_node_infos_.push_back(node_info);
-        trie_->InsertNode(node_info.word, &active_node_infos_.back());
+
+        TrieBuilder builder(source.words);
+        sort(source.singles.begin(), source.singles.end());
+        source.singles.erase(unique(source.singles.begin(), source.singles.end()),
+                             source.singles.end());
+
+        DictImageHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, DICT_IMAGE_MAGIC, sizeof(header.magic));
+        header.version = DICT_IMAGE_VERSION;
+        header.byteOrder = DICT_IMAGE_BYTE_ORDER;
+        header.stamp = stamp;
+        header.minWeight = source.min_weight;
+        header.userWordDefaultWeight = default_weight;
+
+        image.assign(sizeof(header), '\0');
+        header.unitCount = source.units.size();
+        header.unitOffset = AppendSection(image, source.units);
+        header.slotCount = builder.Slots().size();
+        header.slotOffset = AppendSection(image, builder.Slots());
+        header.singleCount = source.singles.size();
+        header.singleOffset = AppendSection(image, source.singles);
+        header.tagSize = source.tags.size();
+        header.tagOffset =
+            AppendSection(image, vector<char>(source.tags.begin(), source.tags.end()));
+        header.imageSize = image.size();
+        memcpy(&image[0], &header, sizeof(header));
         return true;
     }
 
+    // Returns the header of 'image' if the constructor taking an image can use it, or NULL and
+    // sets 'error' if it can't. Every word must have a tag of the pool and the length of the key
+    // which leads to it, since segmentation steps over the text by that length.
+    static const DictImageHeader* CheckImage(const char* image, size_t size, string& error) {
+        const DictImageHeader* header = GetImageHeader(image, size);
+        if (header == NULL) {
+            error = "invalid dictionary image";
+            return NULL;
+        }
+        const DictUnit* units = reinterpret_cast<const DictUnit*>(image + header->unitOffset);
+        for (size_t i = 0; i < header->unitCount; i++) {
+            if (units[i].tag >= header->tagSize || units[i].length == 0) {
+                error = "invalid dictionary image";
+                return NULL;
+            }
+        }
+        const TrieSlot* slots = reinterpret_cast<const TrieSlot*>(image + header->slotOffset);
+        for (size_t i = 0; i < header->slotCount; i++) {
+            if (slots[i].value < 0) {
+                continue;
+            }
+            if (slots[i].value >= int64_t(header->unitCount) ||
+                KeyLength(slots, header->slotCount, i) != units[slots[i].value].length) {
+                error = "invalid dictionary image";
+                return NULL;
+            }
+        }
+        return header;
+    }
+
+    static const DictImageHeader* GetImageHeader(const char* image, size_t size) {
+        if (size < sizeof(DictImageHeader) || reinterpret_cast<uintptr_t>(image) % 8 != 0) {
+            return NULL;
+        }
+        const DictImageHeader* header = reinterpret_cast<const DictImageHeader*>(image);
+        if (memcmp(header->magic, DICT_IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != DICT_IMAGE_VERSION || header->byteOrder != DICT_IMAGE_BYTE_ORDER ||
+            header->imageSize != size || header->unitCount == 0 || header->slotCount == 0 ||
+            !InImage(size, header->unitOffset, header->unitCount, sizeof(DictUnit)) ||
+            !InImage(size, header->slotOffset, header->slotCount, sizeof(TrieSlot)) ||
+            !InImage(size, header->singleOffset, header->singleCount, sizeof(Rune)) ||
+            !InImage(size, header->tagOffset, header->tagSize, 1) || header->tagSize == 0 ||
+            image[header->tagOffset + header->tagSize - 1] != '\0') {
+            return NULL;
+        }
+        return header;
+    }
+
     const DictUnit* Find(RuneStrArray::const_iterator begin,
                          RuneStrArray::const_iterator end) const {
-        return trie_->Find(begin, end);
+        return trie_.Find(begin, end);
     }
 
     void Find(RuneStrArray::const_iterator begin,
               RuneStrArray::const_iterator end,
               vector<struct Dag>& res,
               size_t max_word_len = MAX_WORD_LENGTH) const {
-        trie_->Find(begin, end, res, max_word_len);
+        trie_.Find(begin, end, res, max_word_len);
     }
 
     bool Find(const string& word) {
@@ -89,144 +202,203 @@ public:
         }
     }
 
+    const char* GetTag(const DictUnit* unit) const {
+        return tags_ + unit->tag;
+    }
+
     bool IsUserDictSingleChineseWord(const Rune& word) const {
-        return IsIn(user_dict_single_chinese_word_, word);
+        return binary_search(singles_, singles_ + single_count_, word);
     }
 
     double GetMinWeight() const {
         return min_weight_;
     }
 
-    void InserUserDictNode(const string& line) {
-        vector<string> buf;
-        DictUnit node_info;
-        Split(line, buf, " ");
-        if (buf.size() == 1) {
-            MakeNodeInfo(node_info, buf[0], user_word_default_weight_, UNKNOWN_TAG);
-        } else if (buf.size() == 2) {
-            MakeNodeInfo(node_info, buf[0], user_word_default_weight_, buf[1]);
-        } else if (buf.size() == 3) {
-            int freq = atoi(buf[1].c_str());
-            assert(freq_sum_ > 0.0);
-            double weight = log(1.0 * freq / freq_sum_);
-            MakeNodeInfo(node_info, buf[0], weight, buf[2]);
+private:
+    // Words of the text dictionaries, with the tags interned into a pool of NUL-terminated tags.
+    struct Source {
+        Source() : tags(1, '\0'), min_weight(0.0) {}
+        vector<Unicode> words;
+        vector<DictUnit> units;
+        vector<Rune> singles;
+        string tags;
+        map<string, uint32_t> tag_offsets;
+        double min_weight;
+    };
+
+    bool Attach(const char* image, size_t size, string& error) {
+        const DictImageHeader* header = CheckImage(image, size, error);
+        if (header == NULL) {
+            return false;
         }
-        static_node_infos_.push_back(node_info);
-        if (node_info.word.size() == 1) {
-            user_dict_single_chinese_word_.insert(node_info.word[0]);
+        const DictUnit* units = reinterpret_cast<const DictUnit*>(image + header->unitOffset);
+        const TrieSlot* slots = reinterpret_cast<const TrieSlot*>(image + header->slotOffset);
+        trie_ = Trie(slots, header->slotCount, units);
+        singles_ = reinterpret_cast<const Rune*>(image + header->singleOffset);
+        single_count_ = header->singleCount;
+        tags_ = image + header->tagOffset;
+        min_weight_ = header->minWeight;
+        return true;
+    }
+
+    // Returns the number of runes of the key which leads from the root to 'state', or 0 if 'state'
+    // can't be reached from the root.
+    static size_t KeyLength(const TrieSlot* slots, size_t slot_count, size_t state) {
+        size_t runes = 0;
+        for (size_t depth = 0; state != 0; depth++) {
+            int32_t parent = slots[state].check;
+            if (parent < 0 || size_t(parent) >= slot_count || depth >= slot_count) {
+                return 0;
+            }
+            int64_t byte = int64_t(state) - slots[parent].base - 1;
+            if (byte < 0 || byte > 0xff) {
+                return 0;
+            }
+            // Continuation bytes don't start a rune.
+            if ((byte & 0xc0) != 0x80) {
+                runes++;
+            }
+            state = size_t(parent);
         }
+        return runes;
+    }
+
+    static bool InImage(size_t size, uint64_t offset, uint64_t count, size_t width) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / width;
     }
 
-    void LoadUserDict(const vector<string>& buf) {
-        for (size_t i = 0; i < buf.size(); i++) {
-            InserUserDictNode(buf[i]);
+    template <typename T>
+    static uint64_t AppendSection(string& image, const vector<T>& values) {
+        image.resize((image.size() + 7) / 8 * 8, '\0');
+        uint64_t offset = image.size();
+        if (!values.empty()) {
+            image.append(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
         }
+        return offset;
     }
 
-    void LoadUserDict(const set<string>& buf) {
-        std::set<string>::const_iterator iter;
-        for (iter = buf.begin(); iter != buf.end(); iter++) {
-            InserUserDictNode(*iter);
+    static bool MakeNodeInfo(Source& source,
+                             const string& word,
+                             double weight,
+                             const string& tag,
+                             string& error) {
+        Unicode runes;
+        if (!DecodeRunesInString(word, runes)) {
+            XLOG(ERROR) << "Decode " << word << " failed.";
+            return true;
+        }
+        map<string, uint32_t>::const_iterator it = source.tag_offsets.find(tag);
+        uint32_t tag_offset = 0;
+        if (it != source.tag_offsets.end()) {
+            tag_offset = it->second;
+        } else if (!tag.empty()) {
+            tag_offset = uint32_t(source.tags.size());
+            source.tags.append(tag.c_str(), tag.size() + 1);
+            source.tag_offsets[tag] = tag_offset;
         }
+        DictUnit unit;
+        unit.weight = weight;
+        unit.length = uint32_t(runes.size());
+        unit.tag = tag_offset;
+        source.words.push_back(runes);
+        source.units.push_back(unit);
+        return true;
+    }
+
+    static bool InserUserDictNode(const string& line,
+                                  double freq_sum,
+                                  double default_weight,
+                                  Source& source,
+                                  string& error) {
+        vector<string> buf;
+        Split(line, buf, " ");
+        size_t count = source.words.size();
+        bool ok = true;
+        if (buf.size() == 1) {
+            ok = MakeNodeInfo(source, buf[0], default_weight, UNKNOWN_TAG, error);
+        } else if (buf.size() == 2) {
+            ok = MakeNodeInfo(source, buf[0], default_weight, buf[1], error);
+        } else if (buf.size() == 3) {
+            int freq = atoi(buf[1].c_str());
+            assert(freq_sum > 0.0);
+            double weight = log(1.0 * freq / freq_sum);
+            ok = MakeNodeInfo(source, buf[0], weight, buf[2], error);
+        } else {
+            return true;
+        }
+        if (ok && source.words.size() > count && source.words.back().size() == 1) {
+            source.singles.push_back(source.words.back()[0]);
+        }
+        return ok;
     }
 
-    void LoadUserDict(const string& filePaths) {
+    static bool LoadUserDict(const string& filePaths,
+                             double freq_sum,
+                             double default_weight,
+                             Source& source,
+                             string& error) {
         vector<string> files = limonp::Split(filePaths, "|;");
-        size_t lineno = 0;
         for (size_t i = 0; i < files.size(); i++) {
             ifstream ifs(files[i].c_str());
-            XCHECK(ifs.is_open()) << "open " << files[i] << " failed";
+            if (!ifs.is_open()) {
+                error = "open " + files[i] + " failed";
+                return false;
+            }
             string line;
-
-            for (; getline(ifs, line); lineno++) {
+            while (getline(ifs, line)) {
                 if (line.size() == 0) {
                     continue;
                 }
-                InserUserDictNode(line);
+                if (!InserUserDictNode(line, freq_sum, default_weight, source, error)) {
+                    return false;
+                }
             }
         }
-    }
-
-
-private:
-    void Init(const string& dict_path,
-              const string& user_dict_paths,
-              UserWordWeightOption user_word_weight_opt) {
-        LoadDict(dict_path);
-        freq_sum_ = CalcFreqSum(static_node_infos_);
-        CalculateWeight(static_node_infos_, freq_sum_);
-        SetStaticWordWeights(user_word_weight_opt);
-
-        if (user_dict_paths.size()) {
-            LoadUserDict(user_dict_paths);
-        }
-        Shrink(static_node_infos_);
-        CreateTrie(static_node_infos_);
-    }
-
-    void CreateTrie(const vector<DictUnit>& dictUnits) {
-        assert(dictUnits.size());
-        vector<Unicode> words;
-        vector<const DictUnit*> valuePointers;
-        for (size_t i = 0; i < dictUnits.size(); i++) {
-            words.push_back(dictUnits[i].word);
-            valuePointers.push_back(&dictUnits[i]);
-        }
-
-        trie_ = new Trie(words, valuePointers);
-    }
-
-
-    bool MakeNodeInfo(DictUnit& node_info, const string& word, double weight, const string& tag) {
-        if (!DecodeRunesInString(word, node_info.word)) {
-            XLOG(ERROR) << "Decode " << word << " failed.";
-            return false;
-        }
-        node_info.weight = weight;
-        node_info.tag = tag;
         return true;
     }
 
-    void LoadDict(const string& filePath) {
+    static bool LoadDict(const string& filePath, Source& source, string& error) {
         ifstream ifs(filePath.c_str());
-        XCHECK(ifs.is_open()) << "open " << filePath << " failed.";
+        if (!ifs.is_open()) {
+            error = "open " + filePath + " failed";
+            return false;
+        }
         string line;
         vector<string> buf;
 
-        DictUnit node_info;
         for (size_t lineno = 0; getline(ifs, line); lineno++) {
             Split(line, buf, " ");
-            XCHECK(buf.size() == DICT_COLUMN_NUM) << "split result illegal, line:" << line;
-            MakeNodeInfo(node_info, buf[0], atof(buf[1].c_str()), buf[2]);
-            static_node_infos_.push_back(node_info);
+            if (buf.size() != DICT_COLUMN_NUM) {
+                error = "split result illegal, line:" + line;
+                return false;
+            }
+            if (!MakeNodeInfo(source, buf[0], atof(buf[1].c_str()), buf[2], error)) {
+                return false;
+            }
         }
+        return true;
     }
 
     static bool WeightCompare(const DictUnit& lhs, const DictUnit& rhs) {
         return lhs.weight < rhs.weight;
     }
 
-    void SetStaticWordWeights(UserWordWeightOption option) {
-        XCHECK(!static_node_infos_.empty());
-        vector<DictUnit> x = static_node_infos_;
+    // Returns the weight of the user words which have no frequency.
+    static double SetStaticWordWeights(Source& source, UserWordWeightOption option) {
+        vector<DictUnit> x = source.units;
         sort(x.begin(), x.end(), WeightCompare);
-        min_weight_ = x[0].weight;
-        max_weight_ = x[x.size() - 1].weight;
-        median_weight_ = x[x.size() / 2].weight;
+        source.min_weight = x[0].weight;
         switch (option) {
             case WordWeightMin:
-                user_word_default_weight_ = min_weight_;
-                break;
+                return x[0].weight;
             case WordWeightMedian:
-                user_word_default_weight_ = median_weight_;
-                break;
+                return x[x.size() / 2].weight;
             default:
-                user_word_default_weight_ = max_weight_;
-                break;
+                return x[x.size() - 1].weight;
         }
     }
 
-    double CalcFreqSum(const vector<DictUnit>& node_infos) const {
+    static double CalcFreqSum(const vector<DictUnit>& node_infos) {
         double sum = 0.0;
         for (size_t i = 0; i < node_infos.size(); i++) {
             sum += node_infos[i].weight;
@@ -234,7 +406,7 @@ private:
         return sum;
     }
 
-    void CalculateWeight(vector<DictUnit>& node_infos, double sum) const {
+    static void CalculateWeight(vector<DictUnit>& node_infos, double sum) {
         assert(sum > 0.0);
         for (size_t i = 0; i < node_infos.size(); i++) {
             DictUnit& node_info = node_infos[i];
@@ -243,20 +415,13 @@ private:
         }
     }
 
-    void Shrink(vector<DictUnit>& units) const {
-        vector<DictUnit>(units.begin(), units.end()).swap(units);
-    }
-
-    vector<DictUnit> static_node_infos_;
-    deque<DictUnit> active_node_infos_;  // must not be vector
-    Trie* trie_;
-
-    double freq_sum_;
+    shared_ptr<const void> owner_;
+    string owned_image_;
+    Trie trie_;
+    const Rune* singles_;
+    size_t single_count_;
+    const char* tags_;
     double min_weight_;
-    double max_weight_;
-    double median_weight_;
-    double user_word_default_weight_;
-    unordered_set<Rune> user_dict_single_chinese_word_;
 };
 }
 
@@ -70,7 +70,7 @@ public:
                         res.push_back(wr);
                     }
                 } else {
-                    wordLen = du->word.size();
+                    wordLen = du->length;
                     if (wordLen >= 2 || (dags[i].nexts.size() == 1 && maxIdx <= uIdx)) {
                         WordRange wr(begin + i, begin + nextoffset);
                         res.push_back(wr);
@@ -18,6 +18,31 @@ struct HMMModel {
     enum { B = 0, E = 1, M = 2, S = 3, STATUS_SUM = 4 };
 
     HMMModel(const string& modelPath) {
+        Init();
+        string error;
+        XCHECK(LoadModel(modelPath, error)) << error;
+    }
+    ~HMMModel() {}
+
+    // Returns false and sets 'error' if the constructor would fail to load 'modelPath'.
+    static bool Validate(const string& modelPath, string& error) {
+        HMMModel model;
+        return model.LoadModel(modelPath, error);
+    }
+
+    double GetEmitProb(const EmitProbMap* ptMp, Rune key, double defVal) const {
+        EmitProbMap::const_iterator cit = ptMp->find(key);
+        if (cit == ptMp->end()) {
+            return defVal;
+        }
+        return cit->second;
+    }
+
+private:
+    HMMModel() {
+        Init();
+    }
+    void Init() {
         memset(startProb, 0, sizeof(startProb));
         memset(transProb, 0, sizeof(transProb));
         statMap[0] = 'B';
@@ -28,55 +53,54 @@ struct HMMModel {
         emitProbVec.push_back(&emitProbE);
         emitProbVec.push_back(&emitProbM);
         emitProbVec.push_back(&emitProbS);
-        LoadModel(modelPath);
     }
-    ~HMMModel() {}
-    void LoadModel(const string& filePath) {
+    bool LoadModel(const string& filePath, string& error) {
         ifstream ifile(filePath.c_str());
-        XCHECK(ifile.is_open()) << "open " << filePath << " failed";
+        if (!ifile.is_open()) {
+            error = "open " + filePath + " failed";
+            return false;
+        }
         string line;
         vector<string> tmp;
         vector<string> tmp2;
         // Load startProb
-        XCHECK(GetLine(ifile, line));
+        if (!GetLine(ifile, line)) {
+            error = filePath + ": missing start probabilities";
+            return false;
+        }
         Split(line, tmp, " ");
-        XCHECK(tmp.size() == STATUS_SUM);
+        if (tmp.size() != STATUS_SUM) {
+            error = filePath + ": invalid start probabilities";
+            return false;
+        }
         for (size_t j = 0; j < tmp.size(); j++) {
             startProb[j] = atof(tmp[j].c_str());
         }
 
         // Load transProb
         for (size_t i = 0; i < STATUS_SUM; i++) {
-            XCHECK(GetLine(ifile, line));
+            if (!GetLine(ifile, line)) {
+                error = filePath + ": missing transition probabilities";
+                return false;
+            }
             Split(line, tmp, " ");
-            XCHECK(tmp.size() == STATUS_SUM);
+            if (tmp.size() != STATUS_SUM) {
+                error = filePath + ": invalid transition probabilities";
+                return false;
+            }
             for (size_t j = 0; j < STATUS_SUM; j++) {
                 transProb[i][j] = atof(tmp[j].c_str());
             }
         }
 
-        // Load emitProbB
-        XCHECK(GetLine(ifile, line));
-        XCHECK(LoadEmitProb(line, emitProbB));
-
-        // Load emitProbE
-        XCHECK(GetLine(ifile, line));
-        XCHECK(LoadEmitProb(line, emitProbE));
-
-        // Load emitProbM
-        XCHECK(GetLine(ifile, line));
-        XCHECK(LoadEmitProb(line, emitProbM));
-
-        // Load emitProbS
-        XCHECK(GetLine(ifile, line));
-        XCHECK(LoadEmitProb(line, emitProbS));
-    }
-    double GetEmitProb(const EmitProbMap* ptMp, Rune key, double defVal) const {
-        EmitProbMap::const_iterator cit = ptMp->find(key);
-        if (cit == ptMp->end()) {
-            return defVal;
+        // Load emitProbB, emitProbE, emitProbM and emitProbS
+        for (size_t i = 0; i < STATUS_SUM; i++) {
+            if (!GetLine(ifile, line) || !LoadEmitProb(line, *emitProbVec[i])) {
+                error = filePath + ": invalid emission probabilities of " + statMap[i];
+                return false;
+            }
         }
-        return cit->second;
+        return true;
     }
     bool GetLine(ifstream& ifile, string& line) {
         while (getline(ifile, line)) {
@@ -113,6 +137,7 @@ struct HMMModel {
         return true;
     }
 
+public:
     char statMap[STATUS_SUM];
     double startProb[STATUS_SUM];
     double transProb[STATUS_SUM][STATUS_SUM];
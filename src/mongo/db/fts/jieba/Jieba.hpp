@@ -21,8 +21,36 @@ public:
           full_seg_(&dict_trie_),
           query_seg_(&dict_trie_, &model_),
           extractor(&dict_trie_, &model_, idfPath, stopWordPath) {}
+    // Uses a compiled dictionary image (see DictTrie::Compile) in place of the text dictionaries.
+    Jieba(shared_ptr<const void> dict_owner,
+          const char* dict_image,
+          size_t dict_image_size,
+          const string& model_path,
+          const string& idfPath,
+          const string& stopWordPath)
+        : dict_trie_(dict_owner, dict_image, dict_image_size),
+          model_(model_path),
+          mp_seg_(&dict_trie_),
+          hmm_seg_(&model_),
+          mix_seg_(&dict_trie_, &model_),
+          full_seg_(&dict_trie_),
+          query_seg_(&dict_trie_, &model_),
+          extractor(&dict_trie_, &model_, idfPath, stopWordPath) {}
     ~Jieba() {}
 
+    // Returns false and sets 'error' if the constructor taking a compiled dictionary image would
+    // fail to load any of its arguments.
+    static bool Validate(const char* dict_image,
+                         size_t dict_image_size,
+                         const string& model_path,
+                         const string& idfPath,
+                         const string& stopWordPath,
+                         string& error) {
+        return DictTrie::CheckImage(dict_image, dict_image_size, error) &&
+            HMMModel::Validate(model_path, error) &&
+            KeywordExtractor::Validate(idfPath, stopWordPath, error);
+    }
+
     struct LocWord {
         string word;
         size_t begin;
@@ -47,6 +75,12 @@ public:
     void CutForSearch(const string& sentence, vector<Word>& words, bool hmm = true) const {
         query_seg_.Cut(sentence, words, hmm);
     }
+    void CutForSearch(const char* s,
+                      size_t len,
+                      vector<WordSpan>& spans,
+                      bool hmm = true) const {
+        query_seg_.CutSpans(s, len, spans, hmm);
+    }
     void CutHMM(const string& sentence, vector<string>& words) const {
         hmm_seg_.Cut(sentence, words);
     }
@@ -66,14 +100,6 @@ public:
     string LookupTag(const string& str) const {
         return mix_seg_.LookupTag(str);
     }
-    bool InsertUserWord(const string& word, const string& tag = UNKNOWN_TAG) {
-        return dict_trie_.InsertUserWord(word, tag);
-    }
-
-    bool InsertUserWord(const string& word, int freq, const string& tag = UNKNOWN_TAG) {
-        return dict_trie_.InsertUserWord(word, freq, tag);
-    }
-
     bool Find(const string& word) {
         return dict_trie_.Find(word);
     }
@@ -95,18 +121,6 @@ public:
         return &model_;
     }
 
-    void LoadUserDict(const vector<string>& buf) {
-        dict_trie_.LoadUserDict(buf);
-    }
-
-    void LoadUserDict(const set<string>& buf) {
-        dict_trie_.LoadUserDict(buf);
-    }
-
-    void LoadUserDict(const string& path) {
-        dict_trie_.LoadUserDict(path);
-    }
-
 private:
     DictTrie dict_trie_;
     HMMModel model_;
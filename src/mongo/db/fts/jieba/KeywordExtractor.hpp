@@ -38,6 +38,41 @@ public:
     }
     ~KeywordExtractor() {}
 
+    // Returns false and sets 'error' if the constructors would fail to load 'idfPath' or
+    // 'stopWordPath'.
+    static bool Validate(const string& idfPath, const string& stopWordPath, string& error) {
+        ifstream idf(idfPath.c_str());
+        if (!idf.is_open()) {
+            error = "open " + idfPath + " failed";
+            return false;
+        }
+        string line;
+        vector<string> buf;
+        double idfSum = 0.0;
+        size_t lineno = 0;
+        for (; getline(idf, line); lineno++) {
+            Split(line, buf, " ");
+            if (buf.size() == 2) {
+                idfSum += atof(buf[1].c_str());
+            }
+        }
+        if (lineno == 0 || !(idfSum / lineno > 0.0)) {
+            error = idfPath + ": the average idf must be positive";
+            return false;
+        }
+
+        ifstream stopWords(stopWordPath.c_str());
+        if (!stopWords.is_open()) {
+            error = "open " + stopWordPath + " failed";
+            return false;
+        }
+        if (!getline(stopWords, line)) {
+            error = stopWordPath + ": no stop words";
+            return false;
+        }
+        return true;
+    }
+
     void Extract(const string& sentence, vector<string>& keywords, size_t topN) const {
         vector<Word> topWords;
         Extract(sentence, topWords, topN);
@@ -110,10 +110,10 @@ private:
         while (i < dags.size()) {
             const DictUnit* p = dags[i].pInfo;
             if (p) {
-                assert(p->word.size() >= 1);
-                WordRange wr(begin + i, begin + i + p->word.size() - 1);
+                assert(p->length >= 1);
+                WordRange wr(begin + i, begin + i + p->length - 1);
                 words.push_back(wr);
-                i += p->word.size();
+                i += p->length;
             } else {  // single chinese word
                 WordRange wr(begin + i, begin + i);
                 words.push_back(wr);
@@ -39,10 +39,10 @@ public:
             return POS_X;
         }
         tmp = dict->Find(runes.begin(), runes.end());
-        if (tmp == NULL || tmp->tag.empty()) {
+        if (tmp == NULL || *dict->GetTag(tmp) == '\0') {
             return SpecialRule(runes);
         } else {
-            return tmp->tag;
+            return dict->GetTag(tmp);
         }
     }
 
@@ -20,6 +20,12 @@ public:
         }
         cursor_ = sentence_.begin();
     }
+    PreFilter(const unordered_set<Rune>& symbols, const char* s, size_t len) : symbols_(symbols) {
+        if (!DecodeRunesInString(s, len, sentence_)) {
+            XLOG(ERROR) << "decode failed. ";
+        }
+        cursor_ = sentence_.begin();
+    }
     ~PreFilter() {}
     bool HasNext() const {
         return cursor_ != sentence_.end();
@@ -42,6 +42,20 @@ public:
         words.reserve(wrs.size());
         GetWordsFromWordRanges(sentence, wrs, words);
     }
+    // Like Cut(), but reports the words as byte spans of 's' instead of copying them out.
+    void CutSpans(const char* s, size_t len, vector<WordSpan>& spans, bool hmm = true) const {
+        PreFilter pre_filter(symbols_, s, len);
+        PreFilter::Range range;
+        vector<WordRange> wrs;
+        wrs.reserve(len / 2);
+        while (pre_filter.HasNext()) {
+            range = pre_filter.Next();
+            Cut(range.begin, range.end, wrs, hmm);
+        }
+        spans.clear();
+        spans.reserve(wrs.size());
+        GetSpansFromWordRanges(wrs, spans);
+    }
     void Cut(RuneStrArray::const_iterator begin,
              RuneStrArray::const_iterator end,
              vector<WordRange>& res,
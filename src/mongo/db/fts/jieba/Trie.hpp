@@ -3,6 +3,7 @@
 
 #include "Unicode.hpp"
 #include "limonp/StdExtension.hpp"
+#include <algorithm>
 #include <queue>
 #include <vector>
 
@@ -12,19 +13,13 @@ using namespace std;
 
 const size_t MAX_WORD_LENGTH = 512;
 
+// Plain data so that it can be stored as is in a compiled dictionary image.
 struct DictUnit {
-    Unicode word;
     double weight;
-    string tag;
+    uint32_t length;  // in runes
+    uint32_t tag;     // offset of the NUL-terminated tag in the tag pool of the dictionary
 };  // struct DictUnit
 
-// for debugging
-// inline ostream & operator << (ostream& os, const DictUnit& unit) {
-//   string s;
-//   s << unit.word;
-//   return os << StringFormat("%s %s %.3lf", s.c_str(), unit.tag.c_str(), unit.weight);
-// }
-
 struct Dag {
     RuneStr runestr;
     // [offset, nexts.first]
@@ -37,25 +32,43 @@ struct Dag {
 
 typedef Rune TrieKey;
 
-class TrieNode {
-public:
-    TrieNode() : next(NULL), ptValue(NULL) {}
+// One state of a double-array trie over the UTF-8 bytes of the words. The transition from state s
+// on byte b goes to state t = s.base + b + 1, and exists if slots[t].check == s. 'value' is the
+// index of the DictUnit of the word ending at this state, or -1.
+struct TrieSlot {
+    int32_t base;
+    int32_t check;
+    int32_t value;
+};  // struct TrieSlot
 
-public:
-    typedef unordered_map<TrieKey, TrieNode*> NextMap;
-    NextMap* next;
-    const DictUnit* ptValue;
-};
+// Writes the UTF-8 encoding of 'rune' to 'out' and returns its length.
+inline size_t EncodeTrieKey(TrieKey rune, uint8_t* out) {
+    if (rune < 0x80) {
+        out[0] = uint8_t(rune);
+        return 1;
+    } else if (rune < 0x800) {
+        out[0] = uint8_t(0xc0 | (rune >> 6));
+        out[1] = uint8_t(0x80 | (rune & 0x3f));
+        return 2;
+    } else if (rune < 0x10000) {
+        out[0] = uint8_t(0xe0 | (rune >> 12));
+        out[1] = uint8_t(0x80 | ((rune >> 6) & 0x3f));
+        out[2] = uint8_t(0x80 | (rune & 0x3f));
+        return 3;
+    }
+    out[0] = uint8_t(0xf0 | ((rune >> 18) & 0x07));
+    out[1] = uint8_t(0x80 | ((rune >> 12) & 0x3f));
+    out[2] = uint8_t(0x80 | ((rune >> 6) & 0x3f));
+    out[3] = uint8_t(0x80 | (rune & 0x3f));
+    return 4;
+}
 
+// Read-only double-array trie over an array of slots which may live in a memory mapped file.
 class Trie {
 public:
-    Trie(const vector<Unicode>& keys, const vector<const DictUnit*>& valuePointers)
-        : root_(new TrieNode) {
-        CreateTrie(keys, valuePointers);
-    }
-    ~Trie() {
-        DeleteNode(root_);
-    }
+    Trie() : slots_(NULL), slotCount_(0), units_(NULL) {}
+    Trie(const TrieSlot* slots, size_t slotCount, const DictUnit* units)
+        : slots_(slots), slotCount_(slotCount), units_(units) {}
 
     const DictUnit* Find(RuneStrArray::const_iterator begin,
                          RuneStrArray::const_iterator end) const {
@@ -63,115 +76,210 @@ public:
             return NULL;
         }
 
-        const TrieNode* ptNode = root_;
-        TrieNode::NextMap::const_iterator citer;
+        int32_t state = 0;
         for (RuneStrArray::const_iterator it = begin; it != end; it++) {
-            if (NULL == ptNode->next) {
-                return NULL;
-            }
-            citer = ptNode->next->find(it->rune);
-            if (ptNode->next->end() == citer) {
+            if (!Next(state, it->rune, state)) {
                 return NULL;
             }
-            ptNode = citer->second;
         }
-        return ptNode->ptValue;
+        return Value(state);
     }
 
     void Find(RuneStrArray::const_iterator begin,
               RuneStrArray::const_iterator end,
               vector<struct Dag>& res,
               size_t max_word_len = MAX_WORD_LENGTH) const {
-        assert(root_ != NULL);
         res.resize(end - begin);
 
-        const TrieNode* ptNode = NULL;
-        TrieNode::NextMap::const_iterator citer;
+        int32_t state;
         for (size_t i = 0; i < size_t(end - begin); i++) {
             res[i].runestr = *(begin + i);
 
-            if (root_->next != NULL &&
-                root_->next->end() != (citer = root_->next->find(res[i].runestr.rune))) {
-                ptNode = citer->second;
-            } else {
-                ptNode = NULL;
-            }
-            if (ptNode != NULL) {
-                res[i].nexts.push_back(pair<size_t, const DictUnit*>(i, ptNode->ptValue));
+            if (Next(0, res[i].runestr.rune, state)) {
+                res[i].nexts.push_back(pair<size_t, const DictUnit*>(i, Value(state)));
             } else {
                 res[i].nexts.push_back(
                     pair<size_t, const DictUnit*>(i, static_cast<const DictUnit*>(NULL)));
+                continue;
             }
 
             for (size_t j = i + 1; j < size_t(end - begin) && (j - i + 1) <= max_word_len; j++) {
-                if (ptNode == NULL || ptNode->next == NULL) {
+                if (!Next(state, (begin + j)->rune, state)) {
                     break;
                 }
-                citer = ptNode->next->find((begin + j)->rune);
-                if (ptNode->next->end() == citer) {
-                    break;
-                }
-                ptNode = citer->second;
-                if (NULL != ptNode->ptValue) {
-                    res[i].nexts.push_back(pair<size_t, const DictUnit*>(j, ptNode->ptValue));
+                const DictUnit* value = Value(state);
+                if (NULL != value) {
+                    res[i].nexts.push_back(pair<size_t, const DictUnit*>(j, value));
                 }
             }
         }
     }
 
-    void InsertNode(const Unicode& key, const DictUnit* ptValue) {
-        if (key.begin() == key.end()) {
-            return;
+private:
+    // Follows the bytes of 'rune' from 'state'.
+    bool Next(int32_t state, TrieKey rune, int32_t& next) const {
+        uint8_t bytes[4];
+        size_t len = EncodeTrieKey(rune, bytes);
+        for (size_t i = 0; i < len; i++) {
+            size_t t = size_t(slots_[state].base) + bytes[i] + 1;
+            if (t >= slotCount_ || slots_[t].check != state) {
+                return false;
+            }
+            state = int32_t(t);
         }
+        next = state;
+        return true;
+    }
 
-        TrieNode::NextMap::const_iterator kmIter;
-        TrieNode* ptNode = root_;
-        for (Unicode::const_iterator citer = key.begin(); citer != key.end(); ++citer) {
-            if (NULL == ptNode->next) {
-                ptNode->next = new TrieNode::NextMap;
-            }
-            kmIter = ptNode->next->find(*citer);
-            if (ptNode->next->end() == kmIter) {
-                TrieNode* nextNode = new TrieNode;
+    const DictUnit* Value(int32_t state) const {
+        return slots_[state].value < 0 ? NULL : units_ + slots_[state].value;
+    }
 
-                ptNode->next->insert(make_pair(*citer, nextNode));
-                ptNode = nextNode;
-            } else {
-                ptNode = kmIter->second;
+    const TrieSlot* slots_;
+    size_t slotCount_;
+    const DictUnit* units_;
+};  // class Trie
+
+// Builds the slots of a Trie. When several keys are equal the value of the last one is kept.
+class TrieBuilder {
+public:
+    TrieBuilder(const vector<Unicode>& keys) : nextCheckPos_(1) {
+        vector<string> encoded(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            uint8_t bytes[4];
+            for (size_t j = 0; j < keys[i].size(); j++) {
+                encoded[i].append(reinterpret_cast<const char*>(bytes),
+                                  EncodeTrieKey(keys[i][j], bytes));
+            }
+        }
+        vector<size_t> order;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (!keys[i].empty()) {
+                order.push_back(i);
+            }
+        }
+        // The stable sort keeps the last of equal keys at the end of its run.
+        stable_sort(order.begin(), order.end(), KeyLess(encoded));
+        for (size_t i = 0; i < order.size(); i++) {
+            if (i + 1 < order.size() && encoded[order[i]] == encoded[order[i + 1]]) {
+                continue;
             }
+            keys_.push_back(encoded[order[i]]);
+            values_.push_back(int32_t(order[i]));
         }
-        assert(ptNode != NULL);
-        ptNode->ptValue = ptValue;
+
+        // The root is slot 0, and no other state can point back to it.
+        Use(0, -1);
+        if (!keys_.empty()) {
+            Insert(0, 0, keys_.size(), 0);
+        }
+    }
+
+    const vector<TrieSlot>& Slots() const {
+        return slots_;
     }
 
 private:
-    void CreateTrie(const vector<Unicode>& keys, const vector<const DictUnit*>& valuePointers) {
-        if (valuePointers.empty() || keys.empty()) {
-            return;
+    struct KeyLess {
+        KeyLess(const vector<string>& keys) : keys_(keys) {}
+        bool operator()(size_t lhs, size_t rhs) const {
+            return keys_[lhs] < keys_[rhs];
         }
-        assert(keys.size() == valuePointers.size());
+        const vector<string>& keys_;
+    };
 
-        for (size_t i = 0; i < keys.size(); i++) {
-            InsertNode(keys[i], valuePointers[i]);
+    static uint32_t Code(const string& key, size_t depth) {
+        return uint32_t(uint8_t(key[depth])) + 1;
+    }
+
+    bool IsFree(size_t pos) const {
+        return pos >= slots_.size() || slots_[pos].check < 0;
+    }
+
+    // Returns the first free slot at or after 'pos'. 'nextFree_' links every used slot towards
+    // the next one which might be free, and the links are shortened as they are followed.
+    size_t FirstFree(size_t pos) {
+        size_t free = pos;
+        while (free < nextFree_.size() && nextFree_[free] != free) {
+            free = nextFree_[free];
+        }
+        while (pos < nextFree_.size() && nextFree_[pos] != pos) {
+            size_t next = nextFree_[pos];
+            nextFree_[pos] = free;
+            pos = next;
         }
+        return free;
     }
 
-    void DeleteNode(TrieNode* node) {
-        if (NULL == node) {
+    void Use(size_t pos, int32_t state) {
+        if (pos >= slots_.size()) {
+            TrieSlot free = {0, -1, -1};
+            slots_.resize(pos + 1, free);
+            for (size_t i = nextFree_.size(); i <= pos; i++) {
+                nextFree_.push_back(i);
+            }
+        }
+        slots_[pos].check = state;
+        nextFree_[pos] = pos + 1;
+    }
+
+    // Places the children of 'state', which are at depth 'depth' of the sorted keys [lo, hi).
+    void Insert(int32_t state, size_t lo, size_t hi, size_t depth) {
+        if (keys_[lo].size() == depth) {
+            slots_[state].value = values_[lo];
+            lo++;
+        }
+        if (lo == hi) {
             return;
         }
-        if (NULL != node->next) {
-            for (TrieNode::NextMap::iterator it = node->next->begin(); it != node->next->end();
-                 ++it) {
-                DeleteNode(it->second);
+
+        vector<uint32_t> codes;
+        vector<size_t> starts;
+        for (size_t i = lo; i < hi; i++) {
+            if (codes.empty() || codes.back() != Code(keys_[i], depth)) {
+                codes.push_back(Code(keys_[i], depth));
+                starts.push_back(i);
             }
-            delete node->next;
         }
-        delete node;
+        starts.push_back(hi);
+
+        int32_t base = FindBase(codes);
+        slots_[state].base = base;
+        for (size_t i = 0; i < codes.size(); i++) {
+            Use(size_t(base) + codes[i], state);
+        }
+        for (size_t i = 0; i < codes.size(); i++) {
+            Insert(int32_t(base + codes[i]), starts[i], starts[i + 1], depth + 1);
+        }
     }
 
-    TrieNode* root_;
-};  // class Trie
+    // Finds a base at which every child slot is free. As in Darts, a scan from the start which
+    // finds it nearly full moves the start of later scans past it, leaving its few holes unused.
+    int32_t FindBase(const vector<uint32_t>& codes) {
+        size_t start = FirstFree(max<size_t>(nextCheckPos_, codes[0] + 1));
+        size_t tries = 1;
+        for (size_t pos = start;; pos = FirstFree(pos + 1), tries++) {
+            size_t base = pos - codes[0];
+            size_t i = 1;
+            while (i < codes.size() && IsFree(base + codes[i])) {
+                i++;
+            }
+            if (i < codes.size()) {
+                continue;
+            }
+            if (start == FirstFree(nextCheckPos_) && tries * 20 <= pos - start + 1) {
+                nextCheckPos_ = pos;
+            }
+            return int32_t(base);
+        }
+    }
+
+    vector<string> keys_;
+    vector<int32_t> values_;
+    vector<TrieSlot> slots_;
+    vector<size_t> nextFree_;
+    size_t nextCheckPos_;
+};  // class TrieBuilder
 }  // namespace cppjieba
 
 #endif  // CPPJIEBA_TRIE_HPP
@@ -3,6 +3,7 @@
 
 #include "limonp/LocalVector.hpp"
 #include <ostream>
+#include <utility>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string>
@@ -215,6 +216,17 @@ inline vector<Word> GetWordsFromWordRanges(const string& s, const vector<WordRan
     return result;
 }
 
+// Byte offset and byte length of a word within the sentence it was cut from.
+typedef std::pair<uint32_t, uint32_t> WordSpan;
+
+inline void GetSpansFromWordRanges(const vector<WordRange>& wrs, vector<WordSpan>& spans) {
+    for (size_t i = 0; i < wrs.size(); i++) {
+        assert(wrs[i].right->offset >= wrs[i].left->offset);
+        uint32_t len = wrs[i].right->offset - wrs[i].left->offset + wrs[i].right->len;
+        spans.push_back(WordSpan(wrs[i].left->offset, len));
+    }
+}
+
 inline void GetStringsFromWords(const vector<Word>& words, vector<string>& strs) {
     strs.resize(words.size());
     for (size_t i = 0; i < words.size(); ++i) {
@@ -47,6 +47,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/timestamp_block.h"
 #include "mongo/db/server_parameters.h"
@@ -431,7 +432,9 @@ IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
           SortOptions()
               .TempDir(storageGlobalParams.dbpath + "/_tmp")
               .ExtSortAllowed()
-              .MaxMemoryUsageBytes(maxMemoryUsageBytes),
+              .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+              .WorkerThreads(internalQueryExternalSortWorkerThreads.load())
+              .CompressionLevel(internalQueryExternalSortCompressionLevel.load()),
           BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
       _real(index) {}
 
@@ -480,6 +483,13 @@ Status IndexAccessMethod::commitBulk(OperationContext* opCtx,
 
     std::unique_ptr<BulkBuilder::Sorter::Iterator> it(bulk->_sorter->done());
 
+    const SorterSpillStats spillStats = bulk->_sorter->spillStats();
+    if (spillStats.bytes > 0) {
+        LOG(1) << "\t external sort spilled " << spillStats.bytes << " bytes to "
+               << bulk->_sorter->numFiles() << " files, " << spillStats.compressedBytes
+               << " bytes after compression";
+    }
+
     stdx::unique_lock<Client> lk(*opCtx->getClient());
     ProgressMeterHolder pm(
         CurOp::get(opCtx)->setMessage_inlock("Index Bulk Build: (2/3) btree bottom up",
@@ -55,6 +55,14 @@ bool MatchExpression::matchesBSON(const BSONObj& doc, MatchDetails* details) con
     return matches(&mydoc, details);
 }
 
+void MatchExpression::matchesBatch(const std::vector<const BSONObj*>& docs,
+                                   std::vector<bool>* results) const {
+    results->resize(docs.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        (*results)[i] = matchesBSON(*docs[i]);
+    }
+}
+
 bool MatchExpression::matchesBSONElement(BSONElement elem, MatchDetails* details) const {
     BSONElementViewMatchableDocument matchableDoc(elem);
     return matches(&matchableDoc, details);
@@ -208,6 +208,15 @@ public:
 
     virtual bool matchesBSON(const BSONObj& doc, MatchDetails* details = nullptr) const;
 
+    /**
+     * Sets (*results)[i] to whether *docs[i] matches, for every document in 'docs'. Gives the same
+     * answers as calling matchesBSON() on each document, which is what the default does;
+     * expressions which can check a whole batch more cheaply than one document at a time override
+     * it.
+     */
+    virtual void matchesBatch(const std::vector<const BSONObj*>& docs,
+                              std::vector<bool>* results) const;
+
     /**
      * Determines if 'elem' would satisfy the predicate if wrapped with the top-level field name of
      * the predicate. Does not check that the predicate has a single top-level field name. For
@@ -170,6 +170,28 @@ bool ComparisonMatchExpression::matchesSingleElement(const BSONElement& e,
     }
 }
 
+void ComparisonMatchExpression::matchesBatch(const std::vector<const BSONObj*>& docs,
+                                             std::vector<bool>* results) const {
+    const StringData fieldName = path();
+    if (fieldName.empty() || fieldName.find('.') != std::string::npos) {
+        MatchExpression::matchesBatch(docs, results);
+        return;
+    }
+
+    results->resize(docs.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        BSONElement e = docs[i]->getField(fieldName);
+
+        // Missing fields and arrays need the full path semantics, such as {a: null} matching a
+        // document without 'a', or {a: 1} matching {a: [1, 2]}.
+        if (e.eoo() || e.type() == BSONType::Array) {
+            (*results)[i] = matchesBSON(*docs[i]);
+        } else {
+            (*results)[i] = matchesSingleElement(e);
+        }
+    }
+}
+
 constexpr StringData EqualityMatchExpression::kName;
 constexpr StringData LTMatchExpression::kName;
 constexpr StringData LTEMatchExpression::kName;
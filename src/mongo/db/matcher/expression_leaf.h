@@ -167,6 +167,13 @@ public:
     virtual ~ComparisonMatchExpression() = default;
 
     bool matchesSingleElement(const BSONElement&, MatchDetails* details = nullptr) const final;
+
+    /**
+     * When the path is a top-level field, compares that field of each document directly rather
+     * than walking the path, unless it is missing or an array.
+     */
+    void matchesBatch(const std::vector<const BSONObj*>& docs,
+                      std::vector<bool>* results) const final;
 };
 
 class EqualityMatchExpression final : public ComparisonMatchExpression {
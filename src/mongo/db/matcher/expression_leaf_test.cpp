@@ -96,6 +96,60 @@ TEST(EqOp, MatchesElement) {
     ASSERT(eq.equivalent(&eq));
 }
 
+TEST(EqOp, MatchesBatchAgreesWithMatches) {
+    BSONObj operand = BSON("a" << 5);
+    std::vector<BSONObj> docs = {BSON("a" << 5),
+                                 BSON("a" << 5.0),
+                                 BSON("a" << 6),
+                                 BSON("b" << 5),
+                                 BSON("a" << BSON_ARRAY(4 << 5)),
+                                 BSON("a" << BSON_ARRAY(4 << 6)),
+                                 BSON("a" << BSONNULL),
+                                 BSONObj()};
+
+    EqualityMatchExpression eq("a", operand["a"]);
+    std::vector<const BSONObj*> batch;
+    for (auto&& doc : docs) {
+        batch.push_back(&doc);
+    }
+    std::vector<bool> results;
+    eq.matchesBatch(batch, &results);
+
+    ASSERT_EQ(docs.size(), results.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        ASSERT_EQ(eq.matchesBSON(docs[i]), results[i]) << docs[i];
+    }
+    ASSERT(results[0]);
+    ASSERT(results[4]);
+    ASSERT(!results[5]);
+}
+
+TEST(EqOp, MatchesBatchWithNullMatchesMissingField) {
+    BSONObj operand = BSON("a" << BSONNULL);
+    BSONObj missing = BSON("b" << 1);
+    BSONObj present = BSON("a" << 1);
+
+    EqualityMatchExpression eq("a", operand["a"]);
+    std::vector<bool> results;
+    eq.matchesBatch({&missing, &present}, &results);
+    ASSERT(results[0]);
+    ASSERT(!results[1]);
+}
+
+TEST(EqOp, MatchesBatchOnDottedPath) {
+    BSONObj operand = BSON("a.b" << 5);
+    BSONObj match = BSON("a" << BSON("b" << 5));
+    BSONObj arrayMatch = BSON("a" << BSON_ARRAY(BSON("b" << 6) << BSON("b" << 5)));
+    BSONObj notMatch = BSON("a" << BSON("b" << 6));
+
+    EqualityMatchExpression eq("a.b", operand["a.b"]);
+    std::vector<bool> results;
+    eq.matchesBatch({&match, &arrayMatch, &notMatch}, &results);
+    ASSERT(results[0]);
+    ASSERT(results[1]);
+    ASSERT(!results[2]);
+}
+
 DEATH_TEST(EqOp, InvalidEooOperand, "Invariant failure _rhs") {
     BSONObj operand;
     EqualityMatchExpression eq("", operand.firstElement());
@@ -204,6 +204,37 @@ bool AndMatchExpression::matches(const MatchableDocument* doc, MatchDetails* det
     return true;
 }
 
+void AndMatchExpression::matchesBatch(const std::vector<const BSONObj*>& docs,
+                                      std::vector<bool>* results) const {
+    results->assign(docs.size(), true);
+
+    // The positions in 'docs' of the documents which matched every clause so far.
+    std::vector<size_t> remaining(docs.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        remaining[i] = i;
+    }
+
+    std::vector<const BSONObj*> childDocs;
+    std::vector<bool> childResults;
+    for (size_t i = 0; i < numChildren() && !remaining.empty(); i++) {
+        childDocs.clear();
+        for (size_t pos : remaining) {
+            childDocs.push_back(docs[pos]);
+        }
+        getChild(i)->matchesBatch(childDocs, &childResults);
+
+        size_t nRemaining = 0;
+        for (size_t j = 0; j < remaining.size(); ++j) {
+            if (childResults[j]) {
+                remaining[nRemaining++] = remaining[j];
+            } else {
+                (*results)[remaining[j]] = false;
+            }
+        }
+        remaining.resize(nRemaining);
+    }
+}
+
 bool AndMatchExpression::matchesSingleElement(const BSONElement& e, MatchDetails* details) const {
     for (size_t i = 0; i < numChildren(); i++) {
         if (!getChild(i)->matchesSingleElement(e, details)) {
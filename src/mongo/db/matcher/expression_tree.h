@@ -115,6 +115,12 @@ public:
 
     bool matchesSingleElement(const BSONElement&, MatchDetails* details = nullptr) const final;
 
+    /**
+     * Checks each clause in turn against the documents which matched all the clauses before it.
+     */
+    void matchesBatch(const std::vector<const BSONObj*>& docs,
+                      std::vector<bool>* results) const final;
+
     virtual std::unique_ptr<MatchExpression> shallowClone() const {
         std::unique_ptr<AndMatchExpression> self = stdx::make_unique<AndMatchExpression>();
         for (size_t i = 0; i < numChildren(); ++i) {
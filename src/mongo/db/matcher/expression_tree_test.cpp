@@ -155,6 +155,48 @@ TEST(AndOp, MatchesThreeClauses) {
     ASSERT(!andOp.matchesBSON(BSON("a" << 10 << "b" << 6), NULL));
 }
 
+TEST(AndOp, MatchesBatchAgreesWithMatches) {
+    BSONObj baseOperand1 = BSON("$gt" << 1);
+    BSONObj baseOperand2 = BSON("$lt" << 10);
+    BSONObj baseOperand3 = BSON("$lt" << 100);
+
+    unique_ptr<ComparisonMatchExpression> sub1(new GTMatchExpression("a", baseOperand1["$gt"]));
+    unique_ptr<ComparisonMatchExpression> sub2(new LTMatchExpression("a", baseOperand2["$lt"]));
+    unique_ptr<ComparisonMatchExpression> sub3(new LTMatchExpression("b", baseOperand3["$lt"]));
+
+    AndMatchExpression andOp;
+    andOp.add(sub1.release());
+    andOp.add(sub2.release());
+    andOp.add(sub3.release());
+
+    std::vector<BSONObj> docs = {BSON("a" << 5 << "b" << 6),
+                                 BSON("a" << 5),
+                                 BSON("b" << 6),
+                                 BSON("a" << 1 << "b" << 6),
+                                 BSON("a" << 10 << "b" << 6),
+                                 BSON("a" << BSON_ARRAY(0 << 5) << "b" << 99)};
+    std::vector<const BSONObj*> batch;
+    for (auto&& doc : docs) {
+        batch.push_back(&doc);
+    }
+    std::vector<bool> results;
+    andOp.matchesBatch(batch, &results);
+
+    ASSERT_EQ(docs.size(), results.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        ASSERT_EQ(andOp.matchesBSON(docs[i]), results[i]) << docs[i];
+    }
+}
+
+TEST(AndOp, MatchesBatchEmpty) {
+    AndMatchExpression andOp;
+    BSONObj doc = BSON("a" << 1);
+    std::vector<bool> results;
+    andOp.matchesBatch({&doc}, &results);
+    ASSERT_EQ(1U, results.size());
+    ASSERT(results[0]);
+}
+
 TEST(AndOp, ElemMatchKey) {
     BSONObj baseOperand1 = BSON("a" << 1);
     BSONObj baseOperand2 = BSON("b" << 2);
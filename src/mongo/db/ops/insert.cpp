@@ -47,29 +47,51 @@ using namespace mongoutils;
 
 namespace {
 /**
- * Validates the nesting depth of 'obj', returning a non-OK status if it exceeds the limit.
+ * Checks a top level field of a document to insert, returning a non-OK status if it can't be
+ * stored. Records whether the field is an _id, and whether it is a Timestamp(0, 0) to replace.
  */
-Status validateDepth(const BSONObj& obj) {
-    std::vector<BSONObjIterator> frames;
-    frames.reserve(16);
-    frames.emplace_back(obj);
-
-    while (!frames.empty()) {
-        const auto elem = frames.back().next();
-        if (elem.type() == BSONType::Object || elem.type() == BSONType::Array) {
-            if (MONGO_unlikely(frames.size() == BSONDepth::getMaxDepthForUserStorage())) {
-                // We're exactly at the limit, so descending to the next level would exceed
-                // the maximum depth.
-                return {ErrorCodes::Overflow,
-                        str::stream() << "cannot insert document because it exceeds "
-                                      << BSONDepth::getMaxDepthForUserStorage()
-                                      << " levels of nesting"};
-            }
-            frames.emplace_back(elem.embeddedObject());
-        }
+Status checkTopLevelField(const BSONElement& e,
+                          bool isFirstElement,
+                          bool* hadId,
+                          bool* firstElementIsId,
+                          bool* hasTimestampToFix) {
+    if (e.type() == bsonTimestamp && e.timestampValue() == 0) {
+        // we replace Timestamp(0,0) at the top level with a correct value
+        // in the fast pass, we just mark that we want to swap
+        *hasTimestampToFix = true;
+    }
+
+    auto fieldName = e.fieldNameStringData();
+
+    if (fieldName[0] == '$') {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Document can't have $ prefixed field names: " << fieldName};
+    }
 
-        if (!frames.back().more()) {
-            frames.pop_back();
+    // check no regexp for _id (SERVER-9502)
+    // also, disallow undefined and arrays
+    // Make sure _id isn't duplicated (SERVER-19361).
+    if (fieldName == "_id") {
+        if (e.type() == RegEx) {
+            return {ErrorCodes::BadValue, "can't use a regex for _id"};
+        }
+        if (e.type() == Undefined) {
+            return {ErrorCodes::BadValue, "can't use a undefined for _id"};
+        }
+        if (e.type() == Array) {
+            return {ErrorCodes::BadValue, "can't use an array for _id"};
+        }
+        if (e.type() == Object) {
+            BSONObj o = e.Obj();
+            Status s = o.storageValidEmbedded();
+            if (!s.isOK())
+                return s;
+        }
+        if (*hadId) {
+            return {ErrorCodes::BadValue, "can't have multiple _id fields in one document"};
+        } else {
+            *hadId = true;
+            *firstElementIsId = isFirstElement;
         }
     }
 
@@ -86,62 +108,47 @@ StatusWith<BSONObj> fixDocumentForInsert(ServiceContext* service, const BSONObj&
                                                  << ", max size: "
                                                  << BSONObjMaxUserSize);
 
-    auto depthStatus = validateDepth(doc);
-    if (!depthStatus.isOK()) {
-        return depthStatus;
-    }
-
     bool firstElementIsId = false;
     bool hasTimestampToFix = false;
     bool hadId = false;
     {
-        BSONObjIterator i(doc);
-        for (bool isFirstElement = true; i.more(); isFirstElement = false) {
-            BSONElement e = i.next();
-
-            if (e.type() == bsonTimestamp && e.timestampValue() == 0) {
-                // we replace Timestamp(0,0) at the top level with a correct value
-                // in the fast pass, we just mark that we want to swap
-                hasTimestampToFix = true;
+        // Validate the nesting depth and the top level fields in a single walk over the document,
+        // which is usually a view of the request and not yet in cache. An invalid nesting depth is
+        // reported ahead of any invalid top level field.
+        Status topLevelStatus = Status::OK();
+        std::vector<BSONObjIterator> frames;
+        frames.reserve(16);
+        frames.emplace_back(doc);
+
+        bool isFirstElement = true;
+        while (!frames.empty()) {
+            const auto elem = frames.back().next();
+            if (frames.size() == 1 && !elem.eoo() && topLevelStatus.isOK()) {
+                topLevelStatus = checkTopLevelField(
+                    elem, isFirstElement, &hadId, &firstElementIsId, &hasTimestampToFix);
+                isFirstElement = false;
             }
 
-            auto fieldName = e.fieldNameStringData();
-
-            if (fieldName[0] == '$') {
-                return StatusWith<BSONObj>(
-                    ErrorCodes::BadValue,
-                    str::stream() << "Document can't have $ prefixed field names: " << fieldName);
+            if (elem.type() == BSONType::Object || elem.type() == BSONType::Array) {
+                if (MONGO_unlikely(frames.size() == BSONDepth::getMaxDepthForUserStorage())) {
+                    // We're exactly at the limit, so descending to the next level would exceed
+                    // the maximum depth.
+                    return {ErrorCodes::Overflow,
+                            str::stream() << "cannot insert document because it exceeds "
+                                          << BSONDepth::getMaxDepthForUserStorage()
+                                          << " levels of nesting"};
+                }
+                frames.emplace_back(elem.embeddedObject());
             }
 
-            // check no regexp for _id (SERVER-9502)
-            // also, disallow undefined and arrays
-            // Make sure _id isn't duplicated (SERVER-19361).
-            if (fieldName == "_id") {
-                if (e.type() == RegEx) {
-                    return StatusWith<BSONObj>(ErrorCodes::BadValue, "can't use a regex for _id");
-                }
-                if (e.type() == Undefined) {
-                    return StatusWith<BSONObj>(ErrorCodes::BadValue,
-                                               "can't use a undefined for _id");
-                }
-                if (e.type() == Array) {
-                    return StatusWith<BSONObj>(ErrorCodes::BadValue, "can't use an array for _id");
-                }
-                if (e.type() == Object) {
-                    BSONObj o = e.Obj();
-                    Status s = o.storageValidEmbedded();
-                    if (!s.isOK())
-                        return StatusWith<BSONObj>(s);
-                }
-                if (hadId) {
-                    return StatusWith<BSONObj>(ErrorCodes::BadValue,
-                                               "can't have multiple _id fields in one document");
-                } else {
-                    hadId = true;
-                    firstElementIsId = isFirstElement;
-                }
+            if (!frames.back().more()) {
+                frames.pop_back();
             }
         }
+
+        if (!topLevelStatus.isOK()) {
+            return topLevelStatus;
+        }
     }
 
     if (firstElementIsId && !hasTimestampToFix)
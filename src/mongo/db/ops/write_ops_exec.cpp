@@ -558,8 +558,13 @@ WriteResult performInserts(OperationContext* opCtx,
                 }
             }
 
-            BSONObj toInsert = fixedDoc.getValue().isEmpty() ? doc : std::move(fixedDoc.getValue());
-            batch.emplace_back(stmtId, toInsert);
+            // Documents which didn't need fixing are inserted as they are, which for OP_MSG
+            // requests is a view sharing ownership of the request's message buffer.
+            if (fixedDoc.getValue().isEmpty()) {
+                batch.emplace_back(stmtId, doc);
+            } else {
+                batch.emplace_back(stmtId, std::move(fixedDoc.getValue()));
+            }
             bytesInBatch += batch.back().doc.objsize();
             if (!isLastDoc && batch.size() < maxBatchSize && bytesInBatch < insertVectorMaxBytes)
                 continue;  // Add more to batch before inserting.
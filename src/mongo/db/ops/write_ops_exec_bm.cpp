@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/client.h"
+#include "mongo/db/ops/write_ops_exec.h"
+#include "mongo/db/ops/write_ops_parsers.h"
+#include "mongo/db/repl/replication_coordinator_mock.h"
+#include "mongo/db/service_context_d_test_fixture.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Builds an OP_MSG insert command with the documents in a document sequence, the way drivers send
+ * bulk inserts. The documents carry an _id as their first field unless 'withIds' is false, in
+ * which case the server has to add one.
+ */
+Message makeInsertMessage(const NamespaceString& nss,
+                          int numDocuments,
+                          bool withIds,
+                          int* nextId) {
+    const std::string padding(64, 'x');
+    OpMsgBuilder builder;
+    {
+        auto documents = builder.beginDocSequence("documents");
+        for (int i = 0; i < numDocuments; i++) {
+            auto doc = documents.appendBuilder();
+            if (withIds) {
+                doc.append("_id", (*nextId)++);
+            }
+            doc.append("x", i);
+            doc.append("padding", padding);
+        }
+    }
+    builder.setBody(BSON("insert" << nss.coll() << "$db" << nss.db()));
+    return builder.finish();
+}
+
+/**
+ * Inserts batches of documents into a WiredTiger collection from OP_MSG requests, through the same
+ * parsing and write path as the insert command. The first argument is the number of documents in
+ * a batch, and the second whether they come with an _id.
+ */
+class PerformInsertsBenchmark : public ServiceContextMongoDTest {
+public:
+    explicit PerformInsertsBenchmark(benchmark::State& state)
+        : ServiceContextMongoDTest("wiredTiger"), _state(state) {}
+
+private:
+    void setUp() override {
+        ServiceContextMongoDTest::setUp();
+
+        auto service = getServiceContext();
+        auto replCoord = stdx::make_unique<repl::ReplicationCoordinatorMock>(service);
+        ASSERT_OK(replCoord->setFollowerMode(repl::MemberState::RS_PRIMARY));
+        repl::ReplicationCoordinator::set(service, std::move(replCoord));
+    }
+
+    void _doTest() override {
+        const NamespaceString nss("test.t");
+        const int numDocuments = _state.range(0);
+        const bool withIds = _state.range(1);
+        auto opCtx = cc().makeOperationContext();
+
+        int nextId = 0;
+        size_t bytes = 0;
+        for (auto keepRunning : _state) {
+            _state.PauseTiming();
+            auto message = makeInsertMessage(nss, numDocuments, withIds, &nextId);
+            bytes += message.size();
+            _state.ResumeTiming();
+
+            auto result =
+                performInserts(opCtx.get(), InsertOp::parse(OpMsgRequest::parse(message)));
+            benchmark::DoNotOptimize(result.results.data());
+        }
+        _state.SetItemsProcessed(_state.iterations() * numDocuments);
+        _state.SetBytesProcessed(bytes);
+    }
+
+    benchmark::State& _state;
+};
+
+void BM_PerformInserts(benchmark::State& state) {
+    PerformInsertsBenchmark(state).run();
+}
+
+BENCHMARK(BM_PerformInserts)
+    ->Args({1, 1})
+    ->Args({100, 1})
+    ->Args({1000, 1})
+    ->Args({1000, 0})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace mongo
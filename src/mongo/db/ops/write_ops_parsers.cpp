@@ -159,9 +159,11 @@ write_ops::Insert InsertOp::parseLegacy(const Message& msgRaw) {
     uassert(ErrorCodes::InvalidLength, "Need at least one object to insert", msg.moreJSObjs());
 
     op.setDocuments([&] {
+        // Like the documents of an OP_MSG, these share ownership of the message's buffer, so
+        // holding on to them past the message doesn't require copying them.
         std::vector<BSONObj> documents;
         while (msg.moreJSObjs()) {
-            documents.push_back(msg.nextJsObj());
+            documents.push_back(msg.nextJsObj().shareOwnershipWith(msgRaw.sharedBuffer()));
         }
 
         return documents;
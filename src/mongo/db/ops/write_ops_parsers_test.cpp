@@ -271,6 +271,22 @@ TEST(CommandWriteOpsParsers, RealMultiInsert) {
     }
 }
 
+TEST(CommandWriteOpsParsers, DocSequenceInsertDocumentsAreViewsOfTheMessage) {
+    const auto ns = NamespaceString("test", "foo");
+    const BSONObj obj0 = BSON("_id" << 0);
+    const BSONObj obj1 = BSON("_id" << 1);
+    auto cmd = BSON("insert" << ns.coll() << "documents" << BSON_ARRAY(obj0 << obj1));
+    auto message = toOpMsg(ns.db(), cmd, true).serialize();
+    const auto op = InsertOp::parse(OpMsgRequest::parse(message));
+    ASSERT_EQ(op.getDocuments().size(), 2u);
+    for (auto&& doc : op.getDocuments()) {
+        ASSERT(doc.isOwned());
+        ASSERT_EQ(doc.sharedBuffer().get(), message.sharedBuffer().get());
+    }
+    ASSERT_BSONOBJ_EQ(op.getDocuments()[0], obj0);
+    ASSERT_BSONOBJ_EQ(op.getDocuments()[1], obj1);
+}
+
 TEST(CommandWriteOpsParsers, MultiInsertWithStmtId) {
     const auto ns = NamespaceString("test", "foo");
     const BSONObj obj0 = BSON("x" << 0);
@@ -433,6 +449,20 @@ TEST(LegacyWriteOpsParsers, RealMultiInsert) {
     }
 }
 
+TEST(LegacyWriteOpsParsers, MultiInsertDocumentsAreViewsOfTheMessage) {
+    const std::string ns = "test.foo";
+    auto objs = std::vector<BSONObj>{BSON("_id" << 0), BSON("_id" << 1)};
+    auto message = makeInsertMessage(ns, objs.data(), objs.size(), 0);
+    const auto op = InsertOp::parseLegacy(message);
+    ASSERT_EQ(op.getDocuments().size(), 2u);
+    for (auto&& doc : op.getDocuments()) {
+        ASSERT(doc.isOwned());
+        ASSERT_EQ(doc.sharedBuffer().get(), message.sharedBuffer().get());
+    }
+    ASSERT_BSONOBJ_EQ(op.getDocuments()[0], objs[0]);
+    ASSERT_BSONOBJ_EQ(op.getDocuments()[1], objs[1]);
+}
+
 TEST(LegacyWriteOpsParsers, Update) {
     const std::string ns = "test.foo";
     const BSONObj query = BSON("x" << 1);
@@ -40,6 +40,7 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/collation/collation_index_key.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -326,6 +327,8 @@ SortOptions DocumentSourceSort::makeSortOptions() const {
     if (pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
         opts.extSortAllowed = true;
         opts.tempDir = pExpCtx->tempDir;
+        opts.workerThreads = internalQueryExternalSortWorkerThreads.load();
+        opts.compressionLevel = internalQueryExternalSortCompressionLevel.load();
     }
 
     return opts;
@@ -33,6 +33,7 @@
 #include "mongo/db/prefetch.h"
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog_raii.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/commands/server_status_metric.h"
@@ -45,6 +46,7 @@
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
+#include "mongo/db/storage/recovery_unit.h"
 #include "mongo/db/storage/mmap_v1/mmap.h"
 #include "mongo/util/log.h"
 
@@ -208,6 +210,48 @@ void prefetchPagesForReplicatedOp(OperationContext* opCtx,
     }
 }
 
+void prefetchDocumentForReplicatedOp(OperationContext* opCtx, const BSONObj& op) {
+    try {
+        OplogEntry oplogEntry(op);
+        const auto opType = oplogEntry.getOpType();
+        if (opType != OpTypeEnum::kDelete &&
+            (opType != OpTypeEnum::kUpdate || !oplogEntry.getObject2())) {
+            return;
+        }
+        const auto idField = oplogEntry.getIdElement();
+        if (idField.eoo()) {
+            return;
+        }
+
+        ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
+            opCtx->lockState());
+        opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kNoTimestamp);
+
+        const auto& nss = oplogEntry.getNamespace();
+        const auto uuid = oplogEntry.getUuid();
+        const auto nsOrUUID =
+            uuid ? NamespaceStringOrUUID(nss.db().toString(), *uuid) : NamespaceStringOrUUID(nss);
+
+        // The op is about to be applied anyway, so it is not worth waiting behind a command.
+        AutoGetCollection autoColl(
+            opCtx, nsOrUUID, MODE_IS, AutoGetCollection::kViewsForbidden, Date_t::now());
+        Collection* collection = autoColl.getCollection();
+
+        // Capped collections typically do not have an _id index for findById() to use.
+        if (!collection || collection->isCapped()) {
+            return;
+        }
+
+        TimerHolder timer(&prefetchDocStats);
+        const RecordId rid = Helpers::findById(opCtx, collection, idField.wrap());
+        if (!rid.isNull()) {
+            collection->docFor(opCtx, rid);
+        }
+    } catch (const DBException& e) {
+        LOG(2) << "ignoring exception in prefetchDocumentForReplicatedOp(): " << redact(e);
+    }
+}
+
 class ReplIndexPrefetch : public ServerParameter {
 public:
     ReplIndexPrefetch() : ServerParameter(ServerParameterSet::getGlobal(), "replIndexPrefetch") {}
@@ -42,5 +42,13 @@ void prefetchPagesForReplicatedOp(OperationContext* opCtx,
                                   Database* db,
                                   const OplogEntry& oplogEntry);
 
+/**
+ * Warms the storage engine cache with the _id index entry and the document which the update or
+ * delete 'op' will touch, ahead of its application. Unlike prefetchPagesForReplicatedOp(), this
+ * does not conflict with secondary batch application, and gives up instead of waiting for locks.
+ * Errors are ignored.
+ */
+void prefetchDocumentForReplicatedOp(OperationContext* opCtx, const BSONObj& op);
+
 }  // namespace repl
 }  // namespace mongo
@@ -34,6 +34,7 @@
 
 #include "mongo/bson/bsontypes.h"
 #include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/transport/message_compressor_batch.h"
 
 namespace mongo {
 
@@ -44,6 +45,7 @@ const char kIdField[] = "id";
 const char kNsField[] = "ns";
 const char kBatchField[] = "nextBatch";
 const char kBatchFieldInitial[] = "firstBatch";
+const char kCompressedBatchField[] = "compressedBatch";
 const char kInternalLatestOplogTimestampField[] = "$_internalLatestOplogTimestamp";
 
 }  // namespace
@@ -58,6 +60,13 @@ CursorResponseBuilder::CursorResponseBuilder(bool isInitialResponse,
 void CursorResponseBuilder::done(CursorId cursorId, StringData cursorNamespace) {
     invariant(_active);
     _batch.doneFast();
+    if (_batchCompressor && _numDocs) {
+        CompressedBatch::append(_batchCompressor,
+                                ConstDataRange(_compressedBatch.buf(), _compressedBatch.len()),
+                                _numDocs,
+                                kCompressedBatchField,
+                                &_cursorObject);
+    }
     _cursorObject.append(kIdField, cursorId);
     _cursorObject.append(kNsField, cursorNamespace);
     _cursorObject.doneFast();
@@ -174,6 +183,24 @@ StatusWith<CursorResponse> CursorResponse::parseFromBSON(const BSONObj& cmdRespo
         doc.shareOwnershipWith(cmdResponse);
     }
 
+    BSONElement compressedBatchElt = cursorObj[kCompressedBatchField];
+    if (!compressedBatchElt.eoo()) {
+        if (compressedBatchElt.type() != BSONType::Object) {
+            return {ErrorCodes::TypeMismatch,
+                    str::stream() << "Field '" << kCompressedBatchField
+                                  << "' must be a nested object in: "
+                                  << cmdResponse};
+        }
+        auto compressedBatch = CompressedBatch::parse(compressedBatchElt.Obj());
+        if (!compressedBatch.isOK()) {
+            return compressedBatch.getStatus();
+        }
+        auto& documents = compressedBatch.getValue().documents;
+        batch.insert(batch.end(),
+                     std::make_move_iterator(documents.begin()),
+                     std::make_move_iterator(documents.end()));
+    }
+
     auto latestOplogTimestampElem = cmdResponse[kInternalLatestOplogTimestampField];
     if (latestOplogTimestampElem && latestOplogTimestampElem.type() != BSONType::bsonTimestamp) {
         return {
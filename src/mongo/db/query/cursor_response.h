@@ -38,6 +38,8 @@
 
 namespace mongo {
 
+class MessageCompressorBase;
+
 /**
  * Builds the cursor field and the _latestOplogTimestamp field for a reply to a cursor-generating
  * command in place.
@@ -63,15 +65,32 @@ public:
 
     size_t bytesUsed() const {
         invariant(_active);
-        return _batch.len();
+        return _batchCompressor ? _compressedBatch.len() : _batch.len();
     }
 
     void append(const BSONObj& obj) {
         invariant(_active);
-        _batch.append(obj);
+        if (_batchCompressor) {
+            obj.appendSelfToBufBuilder(_compressedBatch);
+        } else {
+            _batch.append(obj);
+        }
         _numDocs++;
     }
 
+    /**
+     * Packs the documents appended from now on into one block compressed with 'compressor', which
+     * done() adds to the cursor field as 'compressedBatch', leaving the batch array empty. An empty
+     * batch gets no block. The byte limits of the batch still apply to the documents before they
+     * are compressed.
+     *
+     * Must be called before any documents are appended.
+     */
+    void compressBatchWith(MessageCompressorBase* compressor) {
+        invariant(_active && _numDocs == 0);
+        _batchCompressor = compressor;
+    }
+
     void setLatestOplogTimestamp(Timestamp ts) {
         _latestOplogTimestamp = ts;
     }
@@ -99,6 +118,8 @@ private:
     BSONObjBuilder* const _commandResponse;
     BSONObjBuilder _cursorObject;
     BSONArrayBuilder _batch;
+    MessageCompressorBase* _batchCompressor = nullptr;
+    BufBuilder _compressedBatch{0};
     long long _numDocs = 0;
     Timestamp _latestOplogTimestamp;
 };
@@ -30,6 +30,9 @@
 
 #include "mongo/db/query/cursor_response.h"
 
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_snappy.h"
 #include "mongo/unittest/unittest.h"
 
 namespace mongo {
@@ -330,6 +333,36 @@ TEST(CursorResponseTest, serializeLatestOplogEntry) {
     ASSERT_EQ(*reparsedResponse.getLastOplogTimestamp(), Timestamp(1, 2));
 }
 
+TEST(CursorResponseTest, builderCompressesBatchIntoOneBlock) {
+    auto& registry = MessageCompressorRegistry::get();
+    if (!registry.getCompressor("snappy")) {
+        registry.setSupportedCompressors({"snappy"});
+        registry.registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+    }
+
+    BSONObjBuilder bob;
+    CursorResponseBuilder builder(/*isInitialResponse*/ false, &bob);
+    builder.compressBatchWith(registry.getCompressor("snappy"));
+    for (int i = 0; i < 10; i++) {
+        builder.append(BSON("_id" << i));
+    }
+    ASSERT_EQ(10 * BSON("_id" << 0).objsize(), static_cast<int>(builder.bytesUsed()));
+    builder.done(CursorId(123), "local.oplog.rs");
+    bob.append("ok", 1);
+    BSONObj responseObj = bob.obj();
+
+    ASSERT_TRUE(responseObj["cursor"]["nextBatch"].Obj().isEmpty());
+    ASSERT_EQ("snappy", responseObj["cursor"]["compressedBatch"]["compressor"].str());
+
+    auto parsed = CursorResponse::parseFromBSON(responseObj);
+    ASSERT_OK(parsed.getStatus());
+    const auto& batch = parsed.getValue().getBatch();
+    ASSERT_EQ(10U, batch.size());
+    for (int i = 0; i < 10; i++) {
+        ASSERT_BSONOBJ_EQ(BSON("_id" << i), batch[i]);
+    }
+}
+
 }  // namespace
 
 }  // namespace mongo
@@ -172,6 +172,10 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_PARALLEL_COLLSCAN == type) {
+        const ParallelCollectionScanStats* spec =
+            static_cast<const ParallelCollectionScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -516,6 +520,14 @@ void Explain::statsToBSON(const PlanStageStats& stats,
             bob->appendNumber("dupsDropped", spec->dupsDropped);
             bob->appendNumber("recordIdsForgotten", spec->recordIdsForgotten);
         }
+    } else if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+        ParallelCollectionScanStats* spec =
+            static_cast<ParallelCollectionScanStats*>(stats.specific.get());
+        bob->appendNumber("workers", spec->workers);
+        bob->appendNumber("ranges", spec->ranges);
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("docsExamined", spec->docsTested);
+        }
     } else if (STAGE_LIMIT == stats.stageType) {
         LimitStats* spec = static_cast<LimitStats*>(stats.specific.get());
         bob->appendNumber("limitAmount", spec->limit);
@@ -538,6 +550,12 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            if (spec->usedDisk) {
+                bob->appendBool("usedDisk", true);
+                bob->appendNumber("spills", spec->spills);
+                bob->appendNumber("spilledBytes", spec->spilledBytes);
+                bob->appendNumber("spilledCompressedBytes", spec->spilledCompressedBytes);
+            }
         }
 
         if (spec->limit > 0) {
@@ -32,7 +32,9 @@
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/query/query_request.h"
+#include "mongo/transport/message_compressor_registry.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -86,4 +88,18 @@ BSONObj FindCommon::transformSortSpec(const BSONObj& sortSpec) {
 
     return comparatorBob.obj();
 }
+
+MessageCompressorBase* FindCommon::getBatchCompressor(const NamespaceString& nss,
+                                                      StringData compressorName) {
+    uassert(ErrorCodes::InvalidOptions,
+            str::stream() << "Only the oplog can be read in compressed batches, not " << nss.ns(),
+            nss.isOplog());
+    auto compressor = MessageCompressorRegistry::get().getCompressor(compressorName);
+    uassert(ErrorCodes::BadValue,
+            str::stream() << "Cannot compress batches with '" << compressorName
+                          << "', which is not among the enabled network message compressors",
+            compressor);
+    return compressor;
+}
+
 }  // namespace mongo
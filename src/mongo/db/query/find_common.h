@@ -52,6 +52,8 @@ struct AwaitDataState {
 extern const OperationContext::Decoration<AwaitDataState> awaitDataState;
 
 class BSONObj;
+class MessageCompressorBase;
+class NamespaceString;
 class QueryRequest;
 
 // Failpoint for making find hang.
@@ -120,6 +122,14 @@ public:
      * meta-sort specification).
      */
     static BSONObj transformSortSpec(const BSONObj& sortSpec);
+
+    /**
+     * Returns the network message compressor named 'compressorName', with which batches of results
+     * from 'nss' are to be packed into single compressed blocks. Throws if 'nss' is not the oplog
+     * or if the compressor is not enabled on this server.
+     */
+    static MessageCompressorBase* getBatchCompressor(const NamespaceString& nss,
+                                                     StringData compressorName);
 };
 
 }  // namespace mongo
@@ -662,11 +662,21 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getOplogStartHack(
     }
 
     unique_ptr<WorkingSet> ws = make_unique<WorkingSet>();
-    unique_ptr<CollectionScan> cs =
-        make_unique<CollectionScan>(opCtx, params, ws.get(), cq->root());
-    // Takes ownership of 'ws', 'cs', and 'cq'.
+    unique_ptr<PlanStage> root = make_unique<CollectionScan>(opCtx, params, ws.get(), cq->root());
+
+    // The query planner is bypassed, so the projection, if any, goes on top of the scan here.
+    const BSONObj& proj = cq->getQueryRequest().getProj();
+    if (!proj.isEmpty()) {
+        ProjectionStageParams projParams;
+        projParams.projObj = proj;
+        projParams.collator = cq->getCollator();
+        projParams.fullExpression = cq->root();
+        root = make_unique<ProjectionStage>(opCtx, projParams, ws.get(), root.release());
+    }
+
+    // Takes ownership of 'ws', 'root', and 'cq'.
     return PlanExecutor::make(
-        opCtx, std::move(ws), std::move(cs), std::move(cq), collection, PlanExecutor::YIELD_AUTO);
+        opCtx, std::move(ws), std::move(root), std::move(cq), collection, PlanExecutor::YIELD_AUTO);
 }
 
 StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> _getExecutorFind(
@@ -688,6 +698,13 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> _getExecutorFind(
     if (ShardingState::get(opCtx)->needCollectionMetadata(opCtx, nss.ns())) {
         plannerOptions |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
     }
+
+    // The workers of a parallel collection scan read from their own snapshots, which can't be
+    // reconciled with a read that must not yield.
+    if (yieldPolicy == PlanExecutor::YIELD_AUTO &&
+        internalQueryParallelCollScanThreads.load() > 1) {
+        plannerOptions |= QueryPlannerParams::PARALLEL_COLLSCAN;
+    }
     return getExecutor(opCtx, collection, std::move(canonicalQuery), yieldPolicy, plannerOptions);
 }
 
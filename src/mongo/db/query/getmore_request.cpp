@@ -50,6 +50,7 @@ const char kBatchSizeField[] = "batchSize";
 const char kAwaitDataTimeoutField[] = "maxTimeMS";
 const char kTermField[] = "term";
 const char kLastKnownCommittedOpTimeField[] = "lastKnownCommittedOpTime";
+const char kBatchCompressorField[] = "batchCompressor";
 
 }  // namespace
 
@@ -62,13 +63,15 @@ GetMoreRequest::GetMoreRequest(NamespaceString namespaceString,
                                boost::optional<std::int64_t> sizeOfBatch,
                                boost::optional<Milliseconds> awaitDataTimeout,
                                boost::optional<long long> term,
-                               boost::optional<repl::OpTime> lastKnownCommittedOpTime)
+                               boost::optional<repl::OpTime> lastKnownCommittedOpTime,
+                               boost::optional<std::string> batchCompressor)
     : nss(std::move(namespaceString)),
       cursorid(id),
       batchSize(sizeOfBatch),
       awaitDataTimeout(awaitDataTimeout),
       term(term),
-      lastKnownCommittedOpTime(lastKnownCommittedOpTime) {}
+      lastKnownCommittedOpTime(lastKnownCommittedOpTime),
+      batchCompressor(std::move(batchCompressor)) {}
 
 Status GetMoreRequest::isValid() const {
     if (!nss.isValid()) {
@@ -112,6 +115,7 @@ StatusWith<GetMoreRequest> GetMoreRequest::parseFromBSON(const std::string& dbna
     boost::optional<Milliseconds> awaitDataTimeout;
     boost::optional<long long> term;
     boost::optional<repl::OpTime> lastKnownCommittedOpTime;
+    boost::optional<std::string> batchCompressor;
 
     for (BSONElement el : cmdObj) {
         const auto fieldName = el.fieldNameStringData();
@@ -159,6 +163,13 @@ StatusWith<GetMoreRequest> GetMoreRequest::parseFromBSON(const std::string& dbna
                 return status;
             }
             lastKnownCommittedOpTime = ot;
+        } else if (fieldName == kBatchCompressorField) {
+            if (el.type() != BSONType::String) {
+                return {ErrorCodes::TypeMismatch,
+                        str::stream() << "Field 'batchCompressor' must be of type string in: "
+                                      << cmdObj};
+            }
+            batchCompressor = el.str();
         } else if (!isGenericArgument(fieldName)) {
             return {ErrorCodes::FailedToParse,
                     str::stream() << "Failed to parse: " << cmdObj << ". "
@@ -178,8 +189,13 @@ StatusWith<GetMoreRequest> GetMoreRequest::parseFromBSON(const std::string& dbna
                 str::stream() << "Field 'collection' missing in: " << cmdObj};
     }
 
-    GetMoreRequest request(
-        std::move(*nss), *cursorid, batchSize, awaitDataTimeout, term, lastKnownCommittedOpTime);
+    GetMoreRequest request(std::move(*nss),
+                           *cursorid,
+                           batchSize,
+                           awaitDataTimeout,
+                           term,
+                           lastKnownCommittedOpTime,
+                           std::move(batchCompressor));
     Status validStatus = request.isValid();
     if (!validStatus.isOK()) {
         return validStatus;
@@ -210,6 +226,10 @@ BSONObj GetMoreRequest::toBSON() const {
         lastKnownCommittedOpTime->append(&builder, kLastKnownCommittedOpTimeField);
     }
 
+    if (batchCompressor) {
+        builder.append(kBatchCompressorField, *batchCompressor);
+    }
+
     return builder.obj();
 }
 
@@ -55,7 +55,8 @@ struct GetMoreRequest {
                    boost::optional<std::int64_t> sizeOfBatch,
                    boost::optional<Milliseconds> awaitDataTimeout,
                    boost::optional<long long> term,
-                   boost::optional<repl::OpTime> lastKnownCommittedOpTime);
+                   boost::optional<repl::OpTime> lastKnownCommittedOpTime,
+                   boost::optional<std::string> batchCompressor = boost::none);
 
     /**
      * Construct a GetMoreRequest from the command specification and db name.
@@ -87,6 +88,10 @@ struct GetMoreRequest {
     // Only internal queries from replication will have a last known committed optime.
     const boost::optional<repl::OpTime> lastKnownCommittedOpTime;
 
+    // Only the oplog fetcher asks for the batch to be packed into a block compressed with the
+    // network message compressor of this name.
+    const boost::optional<std::string> batchCompressor;
+
 private:
     /**
      * Returns a non-OK status if there are semantic errors in the parsed request
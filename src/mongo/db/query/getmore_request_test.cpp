@@ -265,6 +265,38 @@ TEST(GetMoreRequestTest, toBSONHasCommitLevel) {
     ASSERT_BSONOBJ_EQ(requestObj, expectedRequest);
 }
 
+TEST(GetMoreRequestTest, parseFromBSONBatchCompressorNotString) {
+    StatusWith<GetMoreRequest> result =
+        GetMoreRequest::parseFromBSON("db",
+                                      BSON("getMore" << CursorId(123) << "collection"
+                                                     << "coll"
+                                                     << "batchCompressor"
+                                                     << 1));
+    ASSERT_EQUALS(ErrorCodes::TypeMismatch, result.getStatus().code());
+}
+
+TEST(GetMoreRequestTest, toBSONHasBatchCompressor) {
+    GetMoreRequest request(NamespaceString("local.oplog.rs"),
+                           123,
+                           99,
+                           boost::none,
+                           boost::none,
+                           boost::none,
+                           std::string("snappy"));
+    BSONObj requestObj = request.toBSON();
+    BSONObj expectedRequest = BSON("getMore" << CursorId(123) << "collection"
+                                             << "oplog.rs"
+                                             << "batchSize"
+                                             << 99
+                                             << "batchCompressor"
+                                             << "snappy");
+    ASSERT_BSONOBJ_EQ(requestObj, expectedRequest);
+
+    auto parsed = unittest::assertGet(GetMoreRequest::parseFromBSON("local", requestObj));
+    ASSERT(parsed.batchCompressor);
+    ASSERT_EQUALS("snappy", *parsed.batchCompressor);
+}
+
 TEST(GetMoreRequestTest, toBSONHasMaxTimeMS) {
     GetMoreRequest request(NamespaceString("testdb.testcoll"),
                            123,
@@ -44,12 +44,14 @@
 #include "mongo/db/exec/pipeline_proxy.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/exec/stage_memory_admission.h"
 #include "mongo/db/exec/subplan.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
@@ -277,6 +279,60 @@ Status PlanExecutor::pickBestPlan(const Collection* collection) {
     return Status::OK();
 }
 
+/**
+ * Results of a PlanStage::workBatch() call on the root stage, which are returned one at a time
+ * before the stage is worked again.
+ */
+struct PlanExecutor::BatchedResults {
+    bool empty() const {
+        return ids.empty() && !endState;
+    }
+
+    /**
+     * Returns the next result of the batch, or the state which ended it once there are none left.
+     */
+    PlanStage::StageState next(WorkingSetID* out) {
+        if (!ids.empty()) {
+            *out = ids.front();
+            ids.pop_front();
+            return PlanStage::ADVANCED;
+        }
+
+        invariant(endState);
+        PlanStage::StageState state = endState->first;
+        *out = endState->second;
+        endState = boost::none;
+        return state;
+    }
+
+    /**
+     * Works 'root' for a batch of up to 'batchSize' units of work and returns its first result,
+     * or the state of the batch if it has none.
+     */
+    PlanStage::StageState work(PlanStage* root, size_t batchSize, WorkingSetID* out) {
+        invariant(empty());
+        buffer.clear();
+        PlanStage::StageState state = root->workBatch(batchSize, &buffer, out);
+        if (buffer.empty()) {
+            return state;
+        }
+
+        if (PlanStage::ADVANCED != state && PlanStage::NEED_TIME != state) {
+            endState = std::make_pair(state, *out);
+        }
+        ids.assign(buffer.begin(), buffer.end());
+        return next(out);
+    }
+
+    std::deque<WorkingSetID> ids;
+
+    // The state which ended the batch early, along with its WorkingSetID. Returned after 'ids'.
+    boost::optional<std::pair<PlanStage::StageState, WorkingSetID>> endState;
+
+    // Reused for every batch.
+    std::vector<WorkingSetID> buffer;
+};
+
 PlanExecutor::~PlanExecutor() {
     invariant(_currentState == kDisposed);
 }
@@ -348,6 +404,13 @@ void PlanExecutor::saveState() {
     // boundaries.
     WorkingSetCommon::prepareForSnapshotChange(_workingSet.get());
 
+    // Results left from a batch outlive the snapshot they were read from.
+    if (_batchedResults) {
+        for (auto id : _batchedResults->ids) {
+            _workingSet->get(id)->makeObjOwnedIfNeeded();
+        }
+    }
+
     if (!isMarkedAsKilled()) {
         _root->saveState();
     }
@@ -560,7 +623,20 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         fetcher.reset();
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code;
+        const size_t batchSize = internalQueryExecBatchSize.load();
+        if (_batchedResults && !_batchedResults->empty()) {
+            code = _batchedResults->next(&id);
+        } else if (batchSize > 1 && supportsDocLocking() && _root->canWorkBatch()) {
+            // Batched results are only safe to hold on to without invalidations, which storage
+            // engines with document-level locking do not send.
+            if (!_batchedResults) {
+                _batchedResults = stdx::make_unique<BatchedResults>();
+            }
+            code = _batchedResults->work(_root.get(), batchSize, &id);
+        } else {
+            code = _root->work(&id);
+        }
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -602,7 +678,9 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
             }
             // This result didn't have the data the caller wanted, try again.
         } else if (PlanStage::NEED_YIELD == code) {
-            if (id == WorkingSet::INVALID_ID) {
+            if (id == WorkingSet::INVALID_ID && StageMemoryReservation::isWaitPending(_opCtx)) {
+                // A stage is waiting for memory, which the yield below waits for.
+            } else if (id == WorkingSet::INVALID_ID) {
                 if (!_yieldPolicy->canAutoYield())
                     throw WriteConflictException();
                 CurOp::get(_opCtx)->debug().additiveMetrics.incrementWriteConflicts(1);
@@ -655,7 +733,8 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
 
 bool PlanExecutor::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && (!_batchedResults || _batchedResults->empty()) && _root->isEOF());
 }
 
 void PlanExecutor::markAsKilled(Status killStatus) {
@@ -576,6 +576,11 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Results of the last PlanStage::workBatch() call on the root stage which have not been
+    // returned yet. Emptied before working the plan again.
+    struct BatchedResults;
+    std::unique_ptr<BatchedResults> _batchedResults;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     // Set if this PlanExecutor is registered with the CursorManager.
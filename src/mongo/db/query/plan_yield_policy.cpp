@@ -33,6 +33,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/curop_failpoint_helpers.h"
+#include "mongo/db/exec/stage_memory_admission.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_yield.h"
@@ -156,10 +157,17 @@ Status PlanYieldPolicy::yield(stdx::function<void()> beforeYieldingFn,
                 // Just reset the snapshot. Leave all LockManager locks alone.
                 opCtx->recoveryUnit()->abandonSnapshot();
             } else {
-                // Release and reacquire locks.
+                // Release and reacquire locks. A stage waiting for memory waits while they are
+                // released.
                 if (beforeYieldingFn)
                     beforeYieldingFn();
-                QueryYield::yieldAllLocks(opCtx, whileYieldingFn, _planYielding->nss());
+                QueryYield::yieldAllLocks(opCtx,
+                                          [opCtx, whileYieldingFn] {
+                                              if (whileYieldingFn)
+                                                  whileYieldingFn();
+                                              StageMemoryReservation::waitWhileYielded(opCtx);
+                                          },
+                                          _planYielding->nss());
             }
 
             return _planYielding->restoreStateWithoutRetrying();
@@ -66,6 +66,15 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryExecBatchSize must be between 1 and 1024");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetBufferSizeBytes, int, 100 * 1024 * 1024);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalInsertMaxBatchSize,
@@ -82,10 +91,63 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryIgnoreUnknownJSONSchemaKeywords, bool
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryProhibitBlockingMergeOnMongoS, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExternalSortWorkerThreads, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryExternalSortWorkerThreads must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExternalSortCompressionLevel, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 1) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryExternalSortCompressionLevel must be 0 or 1");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollScanThreads, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollScanThreads must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollScanMinRecords, long long, 100 * 1000)
+    ->withValidator([](const long long& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollScanMinRecords must be non-negative");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageSwitch, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageMAX, long long, 0x7ffffffff);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageMIN, long long, 3 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageSpill, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageSpillSortBytes, long long, 1024 * 1024);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemAdmissionControl, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemAdmissionChunkBytes, long long, 1024 * 1024)
+    ->withValidator([](const long long& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryStageMemAdmissionChunkBytes must be positive");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemAdmissionByUser, bool, false);
+
 }  // namespace mongo
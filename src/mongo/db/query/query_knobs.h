@@ -110,6 +110,10 @@ extern AtomicInt32 internalQueryExecYieldIterations;
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern AtomicInt32 internalQueryExecYieldPeriodMS;
 
+// If above one, PlanExecutor asks plans whose root stage supports it for up to this many units of
+// work at a time with PlanStage::workBatch(), rather than one at a time.
+extern AtomicInt32 internalQueryExecBatchSize;
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -124,9 +128,42 @@ extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
 
+// Number of threads that sort and spill runs of an external sort without a limit, for blocking
+// sorts, $sort and index builds. 1 does it all on the thread of the operation.
+extern AtomicInt32 internalQueryExternalSortWorkerThreads;
+
+// How the blocks spilled by an external sort are compressed. 0 writes them uncompressed, 1
+// compresses them with snappy.
+extern AtomicInt32 internalQueryExternalSortCompressionLevel;
+
+// Number of threads that scan the RecordId ranges of a collection concurrently for a find or
+// aggregate that does a collection scan. 1 disables parallel collection scans.
+extern AtomicInt32 internalQueryParallelCollScanThreads;
+
+// Collections with fewer records than this are always scanned on the thread of the operation.
+extern AtomicInt64 internalQueryParallelCollScanMinRecords;
+
 extern AtomicBool internalQueryStageMemUsageSwitch;  // NOLINT
 
 extern AtomicInt64 internalQueryStageMemUsageMAX;  // NOLINT
 
 extern AtomicInt64 internalQueryStageMemUsageMIN;  // NOLINT
+
+// When set, stages that hit the stage memory limit move their buffered data to disk instead of
+// failing the query.
+extern AtomicBool internalQueryStageMemUsageSpill;  // NOLINT
+
+// The amount of memory a blocking sort may keep in its external sorter once it has been forced to
+// spill by the stage memory limit.
+extern AtomicInt64 internalQueryStageMemUsageSpillSortBytes;  // NOLINT
+
+// When set, stages reserve memory with the stage memory admission controller before buffering, and
+// wait for other queries to release memory rather than go over internalQueryStageMemUsageMAX.
+extern AtomicBool internalQueryStageMemAdmissionControl;  // NOLINT
+
+// The granularity in which stages reserve memory from the admission controller.
+extern AtomicInt64 internalQueryStageMemAdmissionChunkBytes;  // NOLINT
+
+// When set, memory is shared out between authenticated users rather than between databases.
+extern AtomicBool internalQueryStageMemAdmissionByUser;  // NOLINT
 }  // namespace mongo
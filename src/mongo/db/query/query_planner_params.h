@@ -99,6 +99,10 @@ struct QueryPlannerParams {
 
         // Set this so that collection scans on the oplog wait for visibility before reading.
         OPLOG_SCAN_WAIT_FOR_VISIBLE = 1 << 13,
+
+        // Set this to allow collection scans to be split into RecordId ranges which are scanned
+        // concurrently, returning documents out of RecordId order.
+        PARALLEL_COLLSCAN = 1 << 14,
     };
 
     // See Options enum above.
@@ -99,7 +99,9 @@ const char kOplogReplayField[] = "oplogReplay";
 const char kNoCursorTimeoutField[] = "noCursorTimeout";
 const char kAwaitDataField[] = "awaitData";
 const char kPartialResultsField[] = "allowPartialResults";
+const char kAllowDiskUseField[] = "allowDiskUse";
 const char kTermField[] = "term";
+const char kBatchCompressorField[] = "batchCompressor";
 const char kOptionsField[] = "options";
 
 // Field names for sorting options.
@@ -344,6 +346,13 @@ StatusWith<unique_ptr<QueryRequest>> QueryRequest::parseFromFindCommand(unique_p
             }
 
             qr->_allowPartialResults = el.boolean();
+        } else if (fieldName == kAllowDiskUseField) {
+            Status status = checkFieldType(el, Bool);
+            if (!status.isOK()) {
+                return status;
+            }
+
+            qr->_allowDiskUse = el.boolean();
         } else if (fieldName == kOptionsField) {
             // 3.0.x versions of the shell may generate an explain of a find command with an
             // 'options' field. We accept this only if the 'options' field is empty so that
@@ -375,6 +384,12 @@ StatusWith<unique_ptr<QueryRequest>> QueryRequest::parseFromFindCommand(unique_p
                 return status;
             }
             qr->_replicationTerm = el._numberLong();
+        } else if (fieldName == kBatchCompressorField) {
+            Status status = checkFieldType(el, String);
+            if (!status.isOK()) {
+                return status;
+            }
+            qr->_batchCompressor = el.str();
         } else if (!isGenericArgument(fieldName)) {
             return Status(ErrorCodes::FailedToParse,
                           str::stream() << "Failed to parse: " << cmdObj.toString() << ". "
@@ -521,9 +536,17 @@ void QueryRequest::asFindCommand(BSONObjBuilder* cmdBuilder) const {
         cmdBuilder->append(kPartialResultsField, true);
     }
 
+    if (_allowDiskUse) {
+        cmdBuilder->append(kAllowDiskUseField, true);
+    }
+
     if (_replicationTerm) {
         cmdBuilder->append(kTermField, *_replicationTerm);
     }
+
+    if (_batchCompressor) {
+        cmdBuilder->append(kBatchCompressorField, *_batchCompressor);
+    }
 }
 
 void QueryRequest::addReturnKeyMetaProj() {
@@ -888,6 +911,9 @@ Status QueryRequest::initFullQuery(const BSONObj& top) {
                     _showRecordId = true;
                     addShowRecordIdMetaProj();
                 }
+            } else if (str::equals("allowDiskUse", name)) {
+                // Won't throw.
+                _allowDiskUse = e.trueValue();
             } else if (str::equals("maxTimeMS", name)) {
                 StatusWith<int> maxTimeMS = parseMaxTimeMS(e);
                 if (!maxTimeMS.isOK()) {
@@ -995,6 +1021,11 @@ StatusWith<BSONObj> QueryRequest::asAggregationCommand() const {
                 str::stream() << "Option " << kOplogReplayField
                               << " not supported in aggregation."};
     }
+    if (_batchCompressor) {
+        return {ErrorCodes::InvalidPipelineOperator,
+                str::stream() << "Option " << kBatchCompressorField
+                              << " not supported in aggregation."};
+    }
     if (_noCursorTimeout) {
         return {ErrorCodes::InvalidPipelineOperator,
                 str::stream() << "Option " << kNoCursorTimeoutField
@@ -1072,6 +1103,9 @@ StatusWith<BSONObj> QueryRequest::asAggregationCommand() const {
     if (!_comment.empty()) {
         aggregationBuilder.append("comment", _comment);
     }
+    if (_allowDiskUse) {
+        aggregationBuilder.append(kAllowDiskUseField, true);
+    }
     if (!_readConcern.isEmpty()) {
         aggregationBuilder.append("readConcern", _readConcern);
     }
@@ -367,6 +367,14 @@ public:
         _exhaust = exhaust;
     }
 
+    bool allowDiskUse() const {
+        return _allowDiskUse;
+    }
+
+    void setAllowDiskUse(bool allowDiskUse) {
+        _allowDiskUse = allowDiskUse;
+    }
+
     bool isAllowPartialResults() const {
         return _allowPartialResults;
     }
@@ -383,6 +391,18 @@ public:
         _replicationTerm = replicationTerm;
     }
 
+    /**
+     * Name of the network message compressor with which the server should pack each batch of
+     * results into a single block. Only the oplog can be read this way.
+     */
+    const boost::optional<std::string>& getBatchCompressor() const {
+        return _batchCompressor;
+    }
+
+    void setBatchCompressor(boost::optional<std::string> batchCompressor) {
+        _batchCompressor = std::move(batchCompressor);
+    }
+
     /**
      * Return options as a bit vector.
      */
@@ -497,6 +517,9 @@ private:
     bool _showRecordId = false;
     bool _hasReadPref = false;
 
+    // Whether blocking sorts may spill to disk instead of failing at their memory limit.
+    bool _allowDiskUse = false;
+
     // Options that can be specified in the OP_QUERY 'flags' header.
     TailableModeEnum _tailableMode = TailableModeEnum::kNormal;
     bool _slaveOk = false;
@@ -506,6 +529,7 @@ private:
     bool _allowPartialResults = false;
 
     boost::optional<long long> _replicationTerm;
+    boost::optional<std::string> _batchCompressor;
 };
 
 }  // namespace mongo
@@ -435,6 +435,44 @@ TEST(QueryRequestTest, ParseFromCommandAllFlagsTrue) {
     ASSERT(qr->isAllowPartialResults());
 }
 
+TEST(QueryRequestTest, ParseFromCommandAllowDiskUse) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "sort: {a: 1},"
+        "allowDiskUse: true}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    unique_ptr<QueryRequest> qr(
+        assertGet(QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain)));
+
+    ASSERT(qr->allowDiskUse());
+    ASSERT_BSONOBJ_EQ(cmdObj, qr->asFindCommand());
+}
+
+TEST(QueryRequestTest, ParseFromCommandBatchCompressor) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'oplog.rs',"
+        "batchCompressor: 'snappy'}");
+    const NamespaceString nss("local.oplog.rs");
+    bool isExplain = false;
+    unique_ptr<QueryRequest> qr(
+        assertGet(QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain)));
+
+    ASSERT(qr->getBatchCompressor());
+    ASSERT_EQ("snappy", *qr->getBatchCompressor());
+    ASSERT_BSONOBJ_EQ(cmdObj, qr->asFindCommand());
+}
+
+TEST(QueryRequestTest, ParseFromCommandBatchCompressorWrongType) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'oplog.rs',"
+        "batchCompressor: 1}");
+    const NamespaceString nss("local.oplog.rs");
+    bool isExplain = false;
+    auto result = QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain);
+    ASSERT_NOT_OK(result.getStatus());
+}
+
 TEST(QueryRequestTest, ParseFromCommandCommentWithValidMinMax) {
     BSONObj cmdObj = fromjson(
         "{find: 'testns',"
@@ -774,6 +812,17 @@ TEST(QueryRequestTest, ParseFromCommandPartialWrongType) {
     ASSERT_NOT_OK(result.getStatus());
 }
 
+TEST(QueryRequestTest, ParseFromCommandAllowDiskUseWrongType) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "filter:  {a: 1},"
+        "allowDiskUse: 1}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    auto result = QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain);
+    ASSERT_NOT_OK(result.getStatus());
+}
+
 TEST(QueryRequestTest, ParseFromCommandReadConcernWrongType) {
     BSONObj cmdObj = fromjson(
         "{find: 'testns',"
@@ -1193,6 +1242,18 @@ TEST(QueryRequestTest, ConvertToAggregationWithAllowPartialResultsFails) {
     ASSERT_NOT_OK(qr.asAggregationCommand());
 }
 
+TEST(QueryRequestTest, ConvertToAggregationWithAllowDiskUse) {
+    QueryRequest qr(testns);
+    qr.setAllowDiskUse(true);
+
+    auto agg = qr.asAggregationCommand();
+    ASSERT_OK(agg);
+
+    auto ar = AggregationRequest::parseFromBSON(testns, agg.getValue());
+    ASSERT_OK(ar.getStatus());
+    ASSERT(ar.getValue().shouldAllowDiskUse());
+}
+
 TEST(QueryRequestTest, ConvertToAggregationWithNToReturnFails) {
     QueryRequest qr(testns);
     qr.setNToReturn(7);
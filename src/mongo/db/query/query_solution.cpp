@@ -231,6 +231,10 @@ void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent)
     *ss << "COLLSCAN\n";
     addIndent(ss, indent + 1);
     *ss << "ns = " << name << '\n';
+    if (parallel) {
+        addIndent(ss, indent + 1);
+        *ss << "parallel = true\n";
+    }
     if (NULL != filter) {
         addIndent(ss, indent + 1);
         *ss << "filter = " << filter->toString();
@@ -249,6 +253,7 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->maxScan = this->maxScan;
     copy->shouldTrackLatestOplogTimestamp = this->shouldTrackLatestOplogTimestamp;
     copy->shouldWaitForOplogVisibility = this->shouldWaitForOplogVisibility;
+    copy->parallel = this->parallel;
 
     return copy;
 }
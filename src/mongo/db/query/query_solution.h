@@ -308,6 +308,10 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // Whether or not to wait for oplog visibility on oplog collection scans.
     bool shouldWaitForOplogVisibility = false;
+
+    // Whether the scan may return documents out of RecordId order, so that it can be run as a
+    // ParallelCollectionScan.
+    bool parallel = false;
 };
 
 struct AndHashNode : public QuerySolutionNode {
@@ -49,6 +49,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/skip.h"
@@ -83,6 +84,10 @@ PlanStage* buildStages(OperationContext* opCtx,
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
             params.shouldWaitForOplogVisibility = csn->shouldWaitForOplogVisibility;
+            if (csn->parallel &&
+                ParallelCollectionScan::canScan(opCtx, collection, csn->filter.get())) {
+                return new ParallelCollectionScan(opCtx, collection, ws, csn->filter.get());
+            }
             return new CollectionScan(opCtx, params, ws, csn->filter.get());
         }
         case STAGE_IXSCAN: {
@@ -123,6 +128,7 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.collection = collection;
             params.pattern = sn->pattern;
             params.limit = sn->limit;
+            params.allowDiskUse = cq.getQueryRequest().allowDiskUse();
             return new SortStage(opCtx, params, ws, childStage);
         }
         case STAGE_SORT_KEY_GENERATOR: {
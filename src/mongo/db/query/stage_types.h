@@ -87,6 +87,10 @@ enum StageType {
     STAGE_MULTI_PLAN,
     STAGE_OPLOG_START,
     STAGE_OR,
+
+    // A collection scan which splits the collection into RecordId ranges scanned concurrently.
+    STAGE_PARALLEL_COLLSCAN,
+
     STAGE_PROJECTION,
 
     // Stage for running aggregation pipelines.
@@ -219,20 +219,23 @@ void AbstractOplogFetcher::_callback(const Fetcher::QueryResponseStatus& result,
     // If target cut connections between connecting and querying (for
     // example, because it stepped down) we might not have a cursor.
     if (!responseStatus.isOK()) {
+        const bool queryAdjusted = _adjustQueryAfterError(responseStatus);
 
         BSONObj findCommandObj = _makeFindCommandObject(
             _nss, _getLastOpTimeWithHashFetched().opTime, _getRetriedFindMaxTime());
         BSONObj metadataObj = _makeMetadataObject();
         {
             stdx::lock_guard<stdx::mutex> lock(_mutex);
-            if (_fetcherRestarts == _maxFetcherRestarts) {
+            if (_fetcherRestarts == _maxFetcherRestarts && !queryAdjusted) {
                 log() << "Error returned from oplog query (no more query restarts left): "
                       << redact(responseStatus);
             } else {
                 log() << "Restarting oplog query due to error: " << redact(responseStatus)
                       << ". Last fetched optime (with hash): " << _lastFetched
                       << ". Restarts remaining: " << (_maxFetcherRestarts - _fetcherRestarts);
-                _fetcherRestarts++;
+                if (!queryAdjusted) {
+                    _fetcherRestarts++;
+                }
                 // Destroying current instance in _shuttingDownFetcher will possibly block.
                 _shuttingDownFetcher.reset();
                 // Move the old fetcher into the shutting down instance.
@@ -182,6 +182,17 @@ private:
      */
     virtual StatusWith<BSONObj> _onSuccessfulBatch(const Fetcher::QueryResponse& queryResponse) = 0;
 
+    /**
+     * Function called by the abstract oplog fetcher when the `find` or `getMore` command fails,
+     * before the `find` command is restarted.
+     *
+     * Returns true if the subclass changed its query in response to 'status', in which case the
+     * query is restarted without counting against the restart limit.
+     */
+    virtual bool _adjustQueryAfterError(const Status& status) {
+        return false;
+    }
+
     /**
      * This function creates a Fetcher with the given `find` command and metadata.
      */
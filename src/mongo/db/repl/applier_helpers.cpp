@@ -35,10 +35,15 @@
 #include <algorithm>
 #include <iterator>
 
+#include "mongo/base/counter.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_entry.h"
 #include "mongo/db/repl/sync_tail.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/write_unit_of_work.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -53,6 +58,40 @@ const auto kInsertGroupMaxBatchSize = insertVectorMaxBytes;
 // Limit number of ops in a single group.
 constexpr auto kInsertGroupMaxBatchCount = 64;
 
+// Limit the size of the oplog entries applied in a single storage transaction.
+const auto kCommitGroupMaxBatchSize = insertVectorMaxBytes;
+
+// Limit number of ops applied in a single storage transaction. A value of 1 disables the grouping.
+MONGO_EXPORT_SERVER_PARAMETER(replGroupCommitMaxOps, int, 64)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 1 && newVal <= 1000) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "replGroupCommitMaxOps must be between 1 and 1000, inclusive");
+    });
+
+// Number of groups of more than one operation which were committed in a single storage
+// transaction, and number of groups which failed and were applied one operation at a time.
+Counter64 groupCommitsStats;
+ServerStatusMetricField<Counter64> displayGroupCommits("repl.apply.groupCommits",
+                                                       &groupCommitsStats);
+Counter64 failedGroupCommitsStats;
+ServerStatusMetricField<Counter64> displayFailedGroupCommits("repl.apply.failedGroupCommits",
+                                                             &failedGroupCommitsStats);
+
+/**
+ * Returns true if 'entry' may share a storage transaction with other operations. Commands and
+ * index builds take stronger locks, and writes to capped collections are kept out of groups as
+ * they are out of grouped inserts.
+ */
+bool canJoinCommitGroup(const OplogEntry& entry) {
+    if (!entry.isCrudOpType() || entry.isForCappedCollection) {
+        return false;
+    }
+    return entry.getOpType() != OpTypeEnum::kInsert || !entry.getNamespace().isSystemDotIndexes();
+}
+
 }  // namespace
 
 // static
@@ -211,5 +250,75 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
     MONGO_UNREACHABLE;
 }
 
+using CommitGroup = ApplierHelpers::CommitGroup;
+
+CommitGroup::CommitGroup(ApplierHelpers::OperationPtrs* ops,
+                         OperationContext* opCtx,
+                         CommitGroup::Mode mode)
+    : _end(ops->cend()), _opCtx(opCtx), _mode(mode) {}
+
+StatusWith<CommitGroup::ConstIterator> CommitGroup::groupAndApplyOps(ConstIterator it) {
+    const auto& entry = **it;
+
+    if (!canJoinCommitGroup(entry)) {
+        return Status(ErrorCodes::TypeMismatch,
+                      "Can only group CRUD operations on collections which are not capped.");
+    }
+    if (_doNotGroupBeforePoint && it <= *_doNotGroupBeforePoint) {
+        return Status(ErrorCodes::InvalidPath,
+                      "Cannot group an operation that we previously attempted to group.");
+    }
+
+    // Make sure to include the first op in the group size.
+    const auto maxCount = replGroupCommitMaxOps.load();
+    const auto firstTimestamp = entry.getTimestamp();
+    auto groupSize = entry.raw.objsize();
+    auto groupCount = 1;
+
+    // Find the first op that *can't* be added to the group. Since the ops of a writer vector are
+    // sorted by namespace, a later op can be older than the first op of the group, and WiredTiger
+    // does not allow a transaction to be timestamped before the first timestamp it was given.
+    auto endOfGroupIterator = std::find_if(it + 1, _end, [&](const OplogEntry* nextEntry) {
+        groupSize += nextEntry->raw.objsize();
+        groupCount += 1;
+
+        return !canJoinCommitGroup(*nextEntry)              // Must be a groupable CRUD op.
+            || nextEntry->getTimestamp() < firstTimestamp  // Must not go back in time.
+            || groupSize > kCommitGroupMaxBatchSize        // Must not hold too much in the cache.
+            || groupCount > maxCount;                      // Limit number of ops in a group.
+    });
+
+    if (std::distance(it, endOfGroupIterator) == 1) {
+        return Status(ErrorCodes::NoSuchKey,
+                      "Not able to create a group with more than a single operation");
+    }
+
+    try {
+        OplogApplicationGroupBlock groupBlock(_opCtx);
+        WriteUnitOfWork wuow(_opCtx);
+        for (auto groupingIt = it; groupingIt != endOfGroupIterator; ++groupingIt) {
+            uassertStatusOK(SyncTail::syncApply(_opCtx, (*groupingIt)->raw, _mode));
+        }
+        wuow.commit();
+        groupCommitsStats.increment();
+        return endOfGroupIterator - 1;
+    } catch (...) {
+        // The whole group was rolled back. Failures are expected here, for instance when an insert
+        // is replayed, so the ops are simply applied one by one.
+        auto status = mongo::exceptionToStatus();
+        LOG(1) << "Error applying a group of " << std::distance(it, endOfGroupIterator)
+               << " operations " << causedBy(redact(status))
+               << ". Trying first operation alone: " << redact(entry.raw);
+        failedGroupCommitsStats.increment();
+
+        // Avoid quadratic run time from a failed group by not retrying until we are beyond it.
+        _doNotGroupBeforePoint = endOfGroupIterator - 1;
+
+        return status.withContext("Error applying a group of operations");
+    }
+
+    MONGO_UNREACHABLE;
+}
+
 }  // namespace repl
 }  // namespace mongo
@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status_with.h"
 #include "mongo/db/repl/multiapplier.h"
@@ -51,6 +53,7 @@ public:
     static void stableSortByNamespace(OperationPtrs* oplogEntryPointers);
 
     class InsertGroup;
+    class CommitGroup;
 };
 
 /**
@@ -88,5 +91,44 @@ private:
     Mode _mode;
 };
 
+/**
+ * Applies consecutive CRUD operations, whichever collections they are on, in a single
+ * WriteUnitOfWork, so that the storage engine begins and commits one transaction for the group
+ * instead of one per operation. The size of a group is bounded by the 'replGroupCommitMaxOps'
+ * server parameter and by the size of its oplog entries.
+ */
+class ApplierHelpers::CommitGroup {
+    MONGO_DISALLOW_COPYING(CommitGroup);
+
+public:
+    using ConstIterator = OperationPtrs::const_iterator;
+    using Mode = OplogApplication::Mode;
+
+    CommitGroup(OperationPtrs* ops, OperationContext* opCtx, Mode mode);
+
+    /**
+     * Attempts to group operations starting at 'iter'.
+     * If the group is applied successfully, returns the iterator to the last operation included in
+     * the group.
+     * If the group cannot be formed, or any of its operations fails, returns a non-OK status. None
+     * of the operations of a failed group remain applied, and the caller should apply them one by
+     * one.
+     */
+    StatusWith<ConstIterator> groupAndApplyOps(ConstIterator oplogEntriesIterator);
+
+private:
+    // Prevents retrying a failed group by marking its final op and not allowing further groups
+    // until that op has been processed. Unset until a group fails, so that the first op of the
+    // writer vector may start a group.
+    boost::optional<ConstIterator> _doNotGroupBeforePoint;
+
+    // Used for constructing search bounds when grouping operations.
+    ConstIterator _end;
+
+    // Passed to _syncApply when applying each operation of a group.
+    OperationContext* _opCtx;
+    Mode _mode;
+};
+
 }  // namespace repl
 }  // namespace mongo
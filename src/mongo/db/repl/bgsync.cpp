@@ -54,6 +54,7 @@
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/s/shard_identity_rollback_notifier.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/rpc/metadata/repl_set_metadata.h"
 #include "mongo/stdx/memory.h"
@@ -156,6 +157,11 @@ static ServerStatusMetricField<Counter64> displayBufferSize("repl.buffer.sizeByt
 static Counter64 bufferMaxSizeGauge;
 static ServerStatusMetricField<Counter64> displayBufferMaxSize("repl.buffer.maxSizeBytes",
                                                                &bufferMaxSizeGauge);
+// The time taken to push each batch of fetched oplog entries into the buffer, which includes
+// waiting for the applier to make space for them.
+static TimerHistogramStats bufferPushLatencyStats;
+static ServerStatusMetricField<TimerHistogramStats> displayBufferPushLatency(
+    "repl.buffer.latency.push", &bufferPushLatencyStats);
 
 
 BackgroundSync::BackgroundSync(
@@ -540,6 +546,7 @@ Status BackgroundSync::_enqueueDocuments(Fetcher::Documents::const_iterator begi
     auto opCtx = cc().makeOperationContext();
 
     // Wait for enough space.
+    Timer pushTimer;
     _oplogBuffer->waitForSpace(opCtx.get(), info.toApplyDocumentBytes);
 
     {
@@ -564,6 +571,7 @@ Status BackgroundSync::_enqueueDocuments(Fetcher::Documents::const_iterator begi
         _lastOpTimeFetched = info.lastDocument.opTime;
         LOG(3) << "batch resetting _lastOpTimeFetched: " << _lastOpTimeFetched;
     }
+    bufferPushLatencyStats.record(pushTimer);
 
     bufferCountGauge.increment(info.toApplyDocumentCount);
     bufferSizeGauge.increment(info.toApplyDocumentBytes);
@@ -43,6 +43,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/collection_bulk_loader_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -50,6 +51,22 @@
 
 namespace mongo {
 namespace repl {
+namespace {
+
+// The number of threads generating the keys of the secondary indexes of a collection being loaded,
+// on top of one for its _id index. The keys are generated on the thread inserting the documents
+// when this is 0.
+MONGO_EXPORT_SERVER_PARAMETER(collectionBulkLoaderKeyGenerationThreads, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 0 && newVal <= 64) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "collectionBulkLoaderKeyGenerationThreads must be between 0 and 64, "
+                      "inclusive");
+    });
+
+}  // namespace
 
 CollectionBulkLoaderImpl::CollectionBulkLoaderImpl(ServiceContext::UniqueClient&& client,
                                                    ServiceContext::UniqueOperationContext&& opCtx,
@@ -79,6 +96,11 @@ Status CollectionBulkLoaderImpl::init(const std::vector<BSONObj>& secondaryIndex
             // All writes in CollectionBulkLoaderImpl should be unreplicated.
             // The opCtx is accessed indirectly through _secondaryIndexesBlock.
             UnreplicatedWritesBlock uwb(_opCtx.get());
+            const auto keyGenerationThreads = collectionBulkLoaderKeyGenerationThreads.load();
+            if (keyGenerationThreads > 0) {
+                _secondaryIndexesBlock->allowParallelKeyGeneration(keyGenerationThreads);
+                _idIndexBlock->allowParallelKeyGeneration(1);
+            }
             std::vector<BSONObj> specs(secondaryIndexSpecs);
             // This enforces the buildIndexes setting in the replica set configuration.
             _secondaryIndexesBlock->removeExistingIndexes(&specs);
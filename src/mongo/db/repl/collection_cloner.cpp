@@ -32,9 +32,11 @@
 
 #include "mongo/db/repl/collection_cloner.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/client/remote_command_retry_scheduler.h"
 #include "mongo/db/catalog/collection_options.h"
@@ -68,6 +70,20 @@ MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionCountAttempts, int, 3);
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncListIndexesAttempts, int, 3);
 // The number of attempts for the find command, which gets the data.
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionFindAttempts, int, 3);
+
+// The minimum number of documents in each range of '_id' when a collection is cloned in ranges.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionClonerMinDocumentsPerIdRange, int, 100000)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 1) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "initialSyncCollectionClonerMinDocumentsPerIdRange must be at least 1");
+    });
+
+// The number of '_id's sampled for each range, so that the ranges hold similar numbers of
+// documents.
+const int kSampledIdsPerRange = 10;
 }  // namespace
 
 // Failpoint which causes initial sync to hang before establishing its cursor to clone the
@@ -105,7 +121,8 @@ CollectionCloner::CollectionCloner(executor::TaskExecutor* executor,
                                    const CallbackFn& onCompletion,
                                    StorageInterface* storageInterface,
                                    const int batchSize,
-                                   const int maxNumClonerCursors)
+                                   const int maxNumClonerCursors,
+                                   const int maxNumIdRangeCursors)
     : _executor(executor),
       _dbWorkThreadPool(dbWorkThreadPool),
       _source(source),
@@ -168,7 +185,8 @@ CollectionCloner::CollectionCloner(executor::TaskExecutor* executor,
                      "documents copied",
                      str::stream() << _sourceNss.toString() << " collection clone progress"),
       _collectionCloningBatchSize(batchSize),
-      _maxNumClonerCursors(maxNumClonerCursors) {
+      _maxNumClonerCursors(maxNumClonerCursors),
+      _maxNumIdRangeCursors(maxNumIdRangeCursors) {
     // Fetcher throws an exception on null executor.
     invariant(executor);
     uassert(ErrorCodes::BadValue,
@@ -265,6 +283,12 @@ void CollectionCloner::_cancelRemainingWork_inlock() {
     if (_establishCollectionCursorsScheduler) {
         _establishCollectionCursorsScheduler->shutdown();
     }
+    if (_sampleIdsFetcher) {
+        _sampleIdsFetcher->shutdown();
+    }
+    for (auto&& scheduler : _establishIdRangeCursorSchedulers) {
+        scheduler->shutdown();
+    }
     if (_verifyCollectionDroppedScheduler) {
         _verifyCollectionDroppedScheduler->shutdown();
     }
@@ -511,6 +535,19 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
         }
     }
 
+    {
+        UniqueLock lk(_mutex);
+        const int numIdRanges = _getNumIdRanges_inlock();
+        if (numIdRanges > 1) {
+            auto scheduleStatus = _scheduleSampleIdsFetcher_inlock(numIdRanges);
+            lk.unlock();
+            if (!scheduleStatus.isOK()) {
+                _finishCallback(scheduleStatus);
+            }
+            return;
+        }
+    }
+
     _establishCollectionCursorsScheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
         _executor,
         RemoteCommandRequest(_source,
@@ -536,11 +573,169 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
     }
 }
 
+int CollectionCloner::_getNumIdRanges_inlock() const {
+    // Ranges can only be inserted out of order if the '_id' index sorts them by their BSON order,
+    // which is the order of the boundaries. Capped collections must keep their insertion order.
+    if (_maxNumIdRangeCursors <= 1 || _idIndexSpec.isEmpty() || _options.capped ||
+        _idIndexSpec.hasField("collation")) {
+        return 1;
+    }
+    const size_t minDocumentsPerRange = initialSyncCollectionClonerMinDocumentsPerIdRange.load();
+    return static_cast<int>(std::min(static_cast<size_t>(_maxNumIdRangeCursors),
+                                     _stats.documentToCopy / minDocumentsPerRange));
+}
+
+Status CollectionCloner::_scheduleSampleIdsFetcher_inlock(int numRanges) {
+    if (State::kShuttingDown == _state) {
+        return Status(ErrorCodes::CallbackCanceled, "Cloner shutting down.");
+    }
+
+    // Aggregations cannot be run by UUID. The sampled '_id's only balance the ranges, which cover
+    // every '_id' whatever their boundaries, so sampling a renamed collection is harmless.
+    const auto cmdObj =
+        BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                         << BSON_ARRAY(BSON("$sample" << BSON("size" << numRanges *
+                                                                  kSampledIdsPerRange))
+                                       << BSON("$project" << BSON("_id" << 1)))
+                         << "cursor"
+                         << BSONObj());
+    _sampleIdsFetcher = stdx::make_unique<Fetcher>(
+        _executor,
+        _source,
+        _sourceNss.db().toString(),
+        cmdObj,
+        [this, numRanges](const Fetcher::QueryResponseStatus& fetchResult,
+                          Fetcher::NextAction * nextAction,
+                          BSONObjBuilder * getMoreBob) {
+            _sampleIdsCallback(fetchResult, nextAction, getMoreBob, numRanges);
+        },
+        ReadPreferenceSetting::secondaryPreferredMetadata(),
+        RemoteCommandRequest::kNoTimeout /* aggregate network timeout */,
+        RemoteCommandRequest::kNoTimeout /* getMore network timeout */,
+        RemoteCommandRetryScheduler::makeRetryPolicy(
+            numInitialSyncCollectionFindAttempts.load(),
+            executor::RemoteCommandRequest::kNoTimeout,
+            RemoteCommandRetryScheduler::kAllRetriableErrors));
+    LOG(1) << "Sampling '_id's to clone " << _sourceNss.ns() << " in " << numRanges << " ranges";
+    return _sampleIdsFetcher->schedule();
+}
+
+void CollectionCloner::_sampleIdsCallback(const Fetcher::QueryResponseStatus& fetchResult,
+                                          Fetcher::NextAction* nextAction,
+                                          BSONObjBuilder* getMoreBob,
+                                          int numRanges) {
+    if (ErrorCodes::CallbackCanceled == fetchResult.getStatus() || _isShuttingDown()) {
+        _finishCallback(Status(ErrorCodes::CallbackCanceled, "Cloner shutting down."));
+        return;
+    }
+
+    UniqueLock lk(_mutex);
+    if (!fetchResult.isOK()) {
+        warning() << "Failed to sample the '_id's of collection '" << _sourceNss.ns()
+                  << "', cloning it through a single cursor: " << redact(fetchResult.getStatus());
+        _sampledIds.clear();
+    } else {
+        const auto& batchData = fetchResult.getValue();
+        for (auto&& doc : batchData.documents) {
+            auto id = doc["_id"];
+            if (!id.eoo()) {
+                _sampledIds.push_back(id.wrap());
+            }
+        }
+
+        // The fetcher will continue to call with kGetMore until an error or the last batch.
+        if (*nextAction == Fetcher::NextAction::kGetMore) {
+            invariant(getMoreBob);
+            getMoreBob->append("getMore", batchData.cursorId);
+            getMoreBob->append("collection", batchData.nss.coll());
+            return;
+        }
+    }
+
+    std::sort(_sampledIds.begin(),
+              _sampledIds.end(),
+              SimpleBSONObjComparator::kInstance.makeLessThan());
+    for (int range = 1; range < numRanges && !_sampledIds.empty(); ++range) {
+        const auto& boundary = _sampledIds[range * _sampledIds.size() / numRanges];
+        if (_idRangeBoundaries.empty() ||
+            SimpleBSONObjComparator::kInstance.evaluate(_idRangeBoundaries.back() < boundary)) {
+            _idRangeBoundaries.push_back(boundary);
+        }
+    }
+    _sampledIds.clear();
+    log() << "Cloning collection " << _sourceNss.ns() << " in " << _idRangeBoundaries.size() + 1
+          << " ranges of _id";
+
+    auto scheduleStatus = _scheduleNextIdRangeCursor_inlock();
+    if (!scheduleStatus.isOK()) {
+        lk.unlock();
+        _finishCallback(scheduleStatus);
+    }
+}
+
+Status CollectionCloner::_scheduleNextIdRangeCursor_inlock() {
+    if (State::kShuttingDown == _state) {
+        return Status(ErrorCodes::CallbackCanceled, "Cloner shutting down.");
+    }
+
+    // The bounds of 'find' are those of the index scan, so unlike a filter on '_id' they do not
+    // depend on the types of the boundaries. 'min' is inclusive and 'max' exclusive.
+    const size_t range = _idRangeCursors.size();
+    BSONObjBuilder cmdObj;
+    cmdObj.appendElements(makeCommandWithUUIDorCollectionName("find", _options.uuid, _sourceNss));
+    cmdObj.append("hint", _idIndexSpec.getObjectField("key"));
+    if (range > 0) {
+        cmdObj.append("min", _idRangeBoundaries[range - 1]);
+    }
+    if (range < _idRangeBoundaries.size()) {
+        cmdObj.append("max", _idRangeBoundaries[range]);
+    }
+    cmdObj.append("noCursorTimeout", true);
+    cmdObj.append("batchSize", 0);
+
+    _establishIdRangeCursorSchedulers.push_back(stdx::make_unique<RemoteCommandRetryScheduler>(
+        _executor,
+        RemoteCommandRequest(_source,
+                             _sourceNss.db().toString(),
+                             cmdObj.obj(),
+                             ReadPreferenceSetting::secondaryPreferredMetadata(),
+                             nullptr,
+                             RemoteCommandRequest::kNoTimeout),
+        [this](const RemoteCommandCallbackArgs& rcbd) {
+            _establishCollectionCursorsCallback(rcbd, IdRangeFind);
+        },
+        RemoteCommandRetryScheduler::makeRetryPolicy(
+            numInitialSyncCollectionFindAttempts.load(),
+            executor::RemoteCommandRequest::kNoTimeout,
+            RemoteCommandRetryScheduler::kAllRetriableErrors)));
+    return _establishIdRangeCursorSchedulers.back()->startup();
+}
+
+void CollectionCloner::_killIdRangeCursors_inlock() {
+    for (auto&& cursor : _idRangeCursors) {
+        if (!cursor.getCursorId()) {
+            continue;
+        }
+        const auto& nss = cursor.getNSS();
+        auto cmdObj =
+            BSON("killCursors" << nss.coll() << "cursors" << BSON_ARRAY(cursor.getCursorId()));
+        auto scheduleResult = _executor->scheduleRemoteCommand(
+            RemoteCommandRequest(_source, nss.db().toString(), cmdObj, nullptr),
+            [](const RemoteCommandCallbackArgs&) {});
+        if (!scheduleResult.isOK()) {
+            LOG(1) << "Failed to kill cursor " << cursor.getCursorId() << " on " << _source
+                   << ": " << scheduleResult.getStatus();
+        }
+    }
+    _idRangeCursors.clear();
+}
+
 Status CollectionCloner::_parseCursorResponse(BSONObj response,
                                               std::vector<CursorResponse>* cursors,
                                               EstablishCursorsCommand cursorCommand) {
     switch (cursorCommand) {
-        case Find: {
+        case Find:
+        case IdRangeFind: {
             StatusWith<CursorResponse> findResponse = CursorResponse::parseFromBSON(response);
             if (!findResponse.isOK()) {
                 return findResponse.getStatus().withContext(
@@ -617,6 +812,23 @@ void CollectionCloner::_establishCollectionCursorsCallback(const RemoteCommandCa
         _finishCallback(parseResponseStatus);
         return;
     }
+
+    if (cursorCommand == IdRangeFind) {
+        UniqueLock lk(_mutex);
+        std::move(cursorResponses.begin(),
+                  cursorResponses.end(),
+                  std::back_inserter(_idRangeCursors));
+        if (_idRangeCursors.size() <= _idRangeBoundaries.size()) {
+            auto scheduleStatus = _scheduleNextIdRangeCursor_inlock();
+            if (!scheduleStatus.isOK()) {
+                lk.unlock();
+                _finishCallback(scheduleStatus);
+            }
+            return;
+        }
+        cursorResponses.swap(_idRangeCursors);
+        _idRangeCursors.clear();
+    }
     LOG(1) << "Collection cloner running with " << cursorResponses.size()
            << " cursors established.";
 
@@ -920,6 +1132,7 @@ void CollectionCloner::_finishCallback(const Status& status) {
         invariant(_state != State::kComplete);
 
         callCollectionLoader = _collLoader.operator bool();
+        _killIdRangeCursors_inlock();
 
         invariant(_onCompletion);
         std::swap(_onCompletion, onCompletion);
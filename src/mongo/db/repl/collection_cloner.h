@@ -101,6 +101,9 @@ public:
      * 'onCompletion' will be called exactly once.
      *
      * Takes ownership of the passed StorageInterface object.
+     *
+     * When 'maxNumIdRangeCursors' is greater than 1, a large collection is split into up to that
+     * many ranges of '_id', each cloned through its own cursor.
      */
     CollectionCloner(executor::TaskExecutor* executor,
                      ThreadPool* dbWorkThreadPool,
@@ -110,7 +113,8 @@ public:
                      const CallbackFn& onCompletion,
                      StorageInterface* storageInterface,
                      const int batchSize,
-                     const int maxNumClonerCursors);
+                     const int maxNumClonerCursors,
+                     const int maxNumIdRangeCursors = 1);
 
     virtual ~CollectionCloner();
 
@@ -194,7 +198,41 @@ private:
      * The possible command types that can be used to establish the initial cursors on the
      * remote collection.
      */
-    enum EstablishCursorsCommand { Find, ParallelCollScan };
+    enum EstablishCursorsCommand { Find, ParallelCollScan, IdRangeFind };
+
+    /**
+     * Returns the number of ranges of '_id' to clone the collection in, or 1 if the collection
+     * should be cloned through a single cursor.
+     */
+    int _getNumIdRanges_inlock() const;
+
+    /**
+     * Schedules the sampling of the '_id's of the collection, which are used to split it into
+     * 'numRanges' ranges.
+     */
+    Status _scheduleSampleIdsFetcher_inlock(int numRanges);
+
+    /**
+     * Computes the boundaries of the ranges from the sampled '_id's and starts establishing the
+     * cursors over them. Falls back on a single range if the sync source could not sample them.
+     */
+    void _sampleIdsCallback(const StatusWith<Fetcher::QueryResponse>& fetchResult,
+                            Fetcher::NextAction* nextAction,
+                            BSONObjBuilder* getMoreBob,
+                            int numRanges);
+
+    /**
+     * Schedules the 'find' command establishing the cursor over the next range of '_id'. The
+     * cursors are established one after the other, and only passed into the
+     * 'AsyncResultsMerger' once the cursor over the last range has been established.
+     */
+    Status _scheduleNextIdRangeCursor_inlock();
+
+    /**
+     * Kills the cursors over ranges of '_id' which were not passed into the
+     * 'AsyncResultsMerger', since they would otherwise never time out on the sync source.
+     */
+    void _killIdRangeCursors_inlock();
 
     /**
      * Parses the cursor responses from the 'find' or 'parallelCollectionScan' command
@@ -299,6 +337,24 @@ private:
 
     // (R) The maximum number of cursors to use in the collection cloning process.
     const int _maxNumClonerCursors;
+    // (R) The maximum number of ranges of '_id' to clone the collection in.
+    const int _maxNumIdRangeCursors;
+
+    // (M) Fetcher used to sample the '_id's of the collection.
+    std::unique_ptr<Fetcher> _sampleIdsFetcher;
+
+    // (M) The sampled '_id's, as documents of the form {_id: <value>}.
+    std::vector<BSONObj> _sampledIds;
+
+    // (M) The boundaries between consecutive ranges of '_id', in the same form and ascending.
+    std::vector<BSONObj> _idRangeBoundaries;
+
+    // (M) The cursors established so far over the ranges of '_id', in order.
+    std::vector<CursorResponse> _idRangeCursors;
+
+    // (M) Schedulers used to establish the cursor over each range of '_id'.
+    std::vector<std::unique_ptr<RemoteCommandRetryScheduler>> _establishIdRangeCursorSchedulers;
+
     // (M) Component responsible for fetching the documents from the collection cloner cursor(s).
     std::unique_ptr<AsyncResultsMerger> _arm;
 
@@ -1343,6 +1343,131 @@ TEST_F(CollectionClonerTest,
     ASSERT_EQUALS(ErrorCodes::OperationFailed, getStatus());
 }
 
+class IdRangeCollectionClonerTest : public CollectionClonerTest {
+protected:
+    void setUp() override {
+        CollectionClonerTest::setUp();
+        collectionCloner = stdx::make_unique<CollectionCloner>(&getExecutor(),
+                                                               dbWorkThreadPool.get(),
+                                                               target,
+                                                               nss,
+                                                               options,
+                                                               setStatusCallback(),
+                                                               storageInterface.get(),
+                                                               defaultBatchSize,
+                                                               defaultNumCloningCursors,
+                                                               maxNumIdRanges);
+    }
+
+    /**
+     * Starts the cloner on a collection with 'count' documents, up to the creation of the
+     * collection.
+     */
+    void startupAndCreateCollection(int count) {
+        ASSERT_OK(collectionCloner->startup());
+        {
+            executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+            processNetworkResponse(createCountResponse(count));
+            processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+        }
+        collectionCloner->waitForDbWorker();
+        ASSERT_TRUE(collectionCloner->isActive());
+        ASSERT_TRUE(collectionStats.initCalled);
+    }
+
+    /**
+     * Responds to the 'find' command establishing a cursor, and checks its bounds.
+     */
+    void establishCursor(CursorId cursorId, const BSONObj& min, const BSONObj& max) {
+        auto net = getNet();
+        executor::NetworkInterfaceMock::InNetworkGuard guard(net);
+        auto request = assertRemoteCommandNameEquals(
+            "find", net->scheduleSuccessfulResponse(createCursorResponse(cursorId, BSONArray())));
+        net->runReadyNetworkOperations();
+        ASSERT_BSONOBJ_EQ(BSON("_id" << 1), request.cmdObj.getObjectField("hint"));
+        ASSERT_BSONOBJ_EQ(min, request.cmdObj.getObjectField("min"));
+        ASSERT_BSONOBJ_EQ(max, request.cmdObj.getObjectField("max"));
+    }
+
+    // With the default of 100000 documents per range, this many ranges need 300000 documents.
+    const int maxNumIdRanges = 3;
+};
+
+TEST_F(IdRangeCollectionClonerTest, ClonesLargeCollectionThroughOneCursorPerRangeOfId) {
+    startupAndCreateCollection(300000);
+
+    // Sample the '_id's 0 to 29 in no particular order. They split the collection at 10 and 20.
+    BSONArrayBuilder sampledIds;
+    for (int i = 0; i < 30; ++i) {
+        sampledIds.append(BSON("_id" << (i * 7) % 30));
+    }
+    {
+        auto net = getNet();
+        executor::NetworkInterfaceMock::InNetworkGuard guard(net);
+        auto request = assertRemoteCommandNameEquals(
+            "aggregate",
+            net->scheduleSuccessfulResponse(createCursorResponse(0, sampledIds.arr())));
+        net->runReadyNetworkOperations();
+        auto sampleStage = request.cmdObj["pipeline"].Array()[0].Obj();
+        ASSERT_EQUALS(30, sampleStage["$sample"]["size"].numberInt());
+    }
+
+    establishCursor(1, BSONObj(), BSON("_id" << 10));
+    establishCursor(2, BSON("_id" << 10), BSON("_id" << 20));
+    establishCursor(3, BSON("_id" << 20), BSONObj());
+    collectionCloner->waitForDbWorker();
+    ASSERT_TRUE(collectionCloner->isActive());
+
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createFinalCursorResponse(BSON_ARRAY(BSON("_id" << 0))));
+        processNetworkResponse(createFinalCursorResponse(BSON_ARRAY(BSON("_id" << 10))));
+        processNetworkResponse(createFinalCursorResponse(BSON_ARRAY(BSON("_id" << 20))));
+    }
+
+    collectionCloner->join();
+    ASSERT_EQUALS(3, collectionStats.insertCount);
+    ASSERT_TRUE(collectionStats.commitCalled);
+    ASSERT_OK(getStatus());
+    ASSERT_FALSE(collectionCloner->isActive());
+}
+
+TEST_F(IdRangeCollectionClonerTest, ClonesCollectionThroughSingleRangeIfSamplingFails) {
+    startupAndCreateCollection(300000);
+
+    {
+        auto net = getNet();
+        executor::NetworkInterfaceMock::InNetworkGuard guard(net);
+        assertRemoteCommandNameEquals(
+            "aggregate",
+            net->scheduleErrorResponse(Status(ErrorCodes::OperationFailed, "sampling failed")));
+        net->runReadyNetworkOperations();
+    }
+
+    establishCursor(1, BSONObj(), BSONObj());
+    collectionCloner->waitForDbWorker();
+
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createFinalCursorResponse(BSON_ARRAY(BSON("_id" << 0))));
+    }
+
+    collectionCloner->join();
+    ASSERT_EQUALS(1, collectionStats.insertCount);
+    ASSERT_TRUE(collectionStats.commitCalled);
+    ASSERT_OK(getStatus());
+}
+
+TEST_F(IdRangeCollectionClonerTest, DoesNotSplitCollectionTooSmallForSeveralRanges) {
+    startupAndCreateCollection(100000);
+
+    auto net = getNet();
+    executor::NetworkInterfaceMock::InNetworkGuard guard(net);
+    ASSERT_TRUE(net->hasReadyRequests());
+    auto request = assertRemoteCommandNameEquals("find", net->getNextReadyRequest()->getRequest());
+    ASSERT_FALSE(request.cmdObj.hasField("hint"));
+}
+
 class CollectionClonerUUIDTest : public CollectionClonerTest {
 protected:
     // The UUID tests should deal gracefully with renamed collections, so start the cloner with
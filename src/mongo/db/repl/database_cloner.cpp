@@ -75,6 +75,19 @@ MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncListCollectionsAttempts, int, 3);
 // The number of cursors to use in the collection cloning process.
 MONGO_EXPORT_SERVER_PARAMETER(maxNumInitialSyncCollectionClonerCursors, int, 1);
 
+// The maximum number of ranges of '_id' to clone each large collection in, through one cursor per
+// range. Collections are cloned through 'maxNumInitialSyncCollectionClonerCursors' cursors when
+// this is 1.
+MONGO_EXPORT_SERVER_PARAMETER(maxNumInitialSyncCollectionClonerIdRanges, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 1 && newVal <= 64) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "maxNumInitialSyncCollectionClonerIdRanges must be between 1 and 64, "
+                      "inclusive");
+    });
+
 // Failpoint which causes initial sync to hang right after listCollections, but before cloning
 // any colelctions in the 'database' database.
 MONGO_FAIL_POINT_DEFINE(initialSyncHangAfterListCollections);
@@ -403,7 +416,8 @@ void DatabaseCloner::_listCollectionsCallback(const StatusWith<Fetcher::QueryRes
                 [=](const Status& status) { return _collectionClonerCallback(status, nss); },
                 _storageInterface,
                 collectionClonerBatchSize,
-                maxNumInitialSyncCollectionClonerCursors.load());
+                maxNumInitialSyncCollectionClonerCursors.load(),
+                maxNumInitialSyncCollectionClonerIdRanges.load());
         } catch (const AssertionException& ex) {
             _finishCallback_inlock(lk, ex.toStatus());
             return;
@@ -69,6 +69,7 @@
 #include "mongo/db/logical_time.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/op_observer.h"
+#include "mongo/db/operation_context.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/ops/update_lifecycle_impl.h"
@@ -114,6 +115,9 @@ namespace {
 
 MONGO_FAIL_POINT_DEFINE(sleepBetweenInsertOpTimeGenerationAndLogOp);
 
+// Set while an OplogApplicationGroupBlock is in scope on the operation.
+const auto inOplogApplicationGroup = OperationContext::declareDecoration<bool>();
+
 /**
  * The `_localOplogCollection` pointer is always valid (or null) because an
  * operation must take the global exclusive lock to set the pointer to null when
@@ -985,6 +989,19 @@ StatusWith<OplogApplication::Mode> OplogApplication::parseMode(const std::string
     MONGO_UNREACHABLE;
 }
 
+OplogApplicationGroupBlock::OplogApplicationGroupBlock(OperationContext* opCtx) : _opCtx(opCtx) {
+    invariant(!inOplogApplicationGroup(_opCtx));
+    inOplogApplicationGroup(_opCtx) = true;
+}
+
+OplogApplicationGroupBlock::~OplogApplicationGroupBlock() {
+    inOplogApplicationGroup(_opCtx) = false;
+}
+
+bool OplogApplicationGroupBlock::isActive(OperationContext* opCtx) {
+    return inOplogApplicationGroup(opCtx);
+}
+
 std::pair<BSONObj, NamespaceString> prepForApplyOpsIndexInsert(const BSONElement& fieldO,
                                                                const BSONObj& op,
                                                                const NamespaceString& requestNss) {
@@ -1122,7 +1139,11 @@ Status applyOperation_inlock(OperationContext* opCtx,
     bool valueB = fieldB.booleanSafe();
 
     IndexCatalog* indexCatalog = collection == nullptr ? nullptr : collection->getIndexCatalog();
-    const bool haveWrappingWriteUnitOfWork = opCtx->lockState()->inAWriteUnitOfWork();
+    // The WUOW wrapping the operations of an OplogApplicationGroupBlock only commits them
+    // together, so they are applied as if each of them had its own.
+    const bool inApplicationGroup = OplogApplicationGroupBlock::isActive(opCtx);
+    const bool haveWrappingWriteUnitOfWork =
+        !inApplicationGroup && opCtx->lockState()->inAWriteUnitOfWork();
     uassert(ErrorCodes::CommandNotSupportedOnView,
             str::stream() << "applyOps not supported on view: " << requestNss.ns(),
             collection || !db->getViewCatalog()->lookup(opCtx, requestNss.ns()));
@@ -1313,9 +1334,11 @@ Status applyOperation_inlock(OperationContext* opCtx,
 
                 if (status.isOK()) {
                     wuow.commit();
-                } else if (status == ErrorCodes::DuplicateKey) {
+                } else if (status == ErrorCodes::DuplicateKey && !inApplicationGroup) {
                     needToDoUpsert = true;
                 } else {
+                    // In a group, the failed insert has left the wrapping WUOW unable to commit,
+                    // so even a DuplicateKey error is returned for the group to be aborted.
                     return status;
                 }
             }
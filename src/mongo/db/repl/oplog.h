@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 
+#include "mongo/base/disallow_copying.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/timestamp.h"
@@ -58,13 +59,14 @@ struct OplogSlot {
 struct InsertStatement {
 public:
     InsertStatement() = default;
-    explicit InsertStatement(BSONObj toInsert) : doc(toInsert) {}
+    explicit InsertStatement(BSONObj toInsert) : doc(std::move(toInsert)) {}
 
-    InsertStatement(StmtId statementId, BSONObj toInsert) : stmtId(statementId), doc(toInsert) {}
+    InsertStatement(StmtId statementId, BSONObj toInsert)
+        : stmtId(statementId), doc(std::move(toInsert)) {}
     InsertStatement(StmtId statementId, BSONObj toInsert, OplogSlot os)
-        : stmtId(statementId), oplogSlot(os), doc(toInsert) {}
+        : stmtId(statementId), oplogSlot(os), doc(std::move(toInsert)) {}
     InsertStatement(BSONObj toInsert, Timestamp ts, long long term)
-        : oplogSlot(repl::OpTime(ts, term), 0), doc(toInsert) {}
+        : oplogSlot(repl::OpTime(ts, term), 0), doc(std::move(toInsert)) {}
 
     StmtId stmtId = kUninitializedStmtId;
     OplogSlot oplogSlot;
@@ -212,6 +214,26 @@ inline std::ostream& operator<<(std::ostream& s, OplogApplication::Mode mode) {
     return (s << OplogApplication::modeToString(mode));
 }
 
+/**
+ * While in scope, a WriteUnitOfWork wrapping applyOperation_inlock() calls on 'opCtx' only commits
+ * a group of unrelated operations together, which saves secondaries a storage transaction per
+ * operation. Unlike in an atomic 'applyOps', each operation is timestamped with its own oplog
+ * entry. An operation which fails is not retried within the wrapping WriteUnitOfWork: its error is
+ * returned or thrown, and the caller must abort the whole group.
+ */
+class OplogApplicationGroupBlock {
+    MONGO_DISALLOW_COPYING(OplogApplicationGroupBlock);
+
+public:
+    explicit OplogApplicationGroupBlock(OperationContext* opCtx);
+    ~OplogApplicationGroupBlock();
+
+    static bool isActive(OperationContext* opCtx);
+
+private:
+    OperationContext* const _opCtx;
+};
+
 /**
  * Take a non-command op and apply it locally
  * Used for applying from an oplog
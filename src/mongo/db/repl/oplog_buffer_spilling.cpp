@@ -0,0 +1,324 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplication
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_buffer_spilling.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+
+#include "mongo/base/counter.h"
+#include "mongo/base/data_view.h"
+#include "mongo/bson/oid.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+// Entries are read back from the spill file in chunks of about this size, to bound the time the
+// pushing thread may wait behind a refill.
+const std::size_t kUnspillChunkSize = 16 * 1024 * 1024;
+
+// Number of times a buffer started to spill, and total size of the spilled entries.
+Counter64 spillsStats;
+ServerStatusMetricField<Counter64> displaySpills("repl.buffer.spills", &spillsStats);
+Counter64 spilledBytesStats;
+ServerStatusMetricField<Counter64> displaySpilledBytes("repl.buffer.spilledBytes",
+                                                       &spilledBytesStats);
+
+std::size_t getDocumentSize(const BSONObj& o) {
+    // SERVER-9808 Avoid Fortify complaint about implicit signed->unsigned conversion
+    return static_cast<std::size_t>(o.objsize());
+}
+
+}  // namespace
+
+OplogBufferSpilling::OplogBufferSpilling(Options options) : _options(std::move(options)) {
+    invariant(_options.maxMemorySize <= _options.maxSize);
+}
+
+OplogBufferSpilling::~OplogBufferSpilling() {
+    shutdown(nullptr);
+}
+
+void OplogBufferSpilling::startup(OperationContext*) {
+    if (_options.prefetchFn) {
+        _prefetcher = stdx::thread([this] { _runPrefetcher(); });
+    }
+}
+
+void OplogBufferSpilling::shutdown(OperationContext*) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _inShutdown = true;
+        _clear_inlock();
+    }
+    _prefetchCV.notify_all();
+    if (_prefetcher.joinable()) {
+        _prefetcher.join();
+    }
+}
+
+void OplogBufferSpilling::pushEvenIfFull(OperationContext*, const Value& value) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _push_inlock(value);
+}
+
+void OplogBufferSpilling::push(OperationContext*, const Value& value) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _notFullCV.wait(lk, [&] { return _hasSpace_inlock(getDocumentSize(value)); });
+    _push_inlock(value);
+}
+
+void OplogBufferSpilling::pushAllNonBlocking(OperationContext*,
+                                             Batch::const_iterator begin,
+                                             Batch::const_iterator end) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    for (auto it = begin; it != end; ++it) {
+        _push_inlock(*it);
+    }
+}
+
+void OplogBufferSpilling::waitForSpace(OperationContext*, std::size_t size) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _notFullCV.wait(lk, [&] { return _hasSpace_inlock(size); });
+}
+
+bool OplogBufferSpilling::isEmpty() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _memory.empty() && _spilledCount == 0;
+}
+
+std::size_t OplogBufferSpilling::getMaxSize() const {
+    return _options.maxSize;
+}
+
+std::size_t OplogBufferSpilling::getSize() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _memorySize + _spilledSize;
+}
+
+std::size_t OplogBufferSpilling::getCount() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _memory.size() + _spilledCount;
+}
+
+void OplogBufferSpilling::clear(OperationContext*) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _clear_inlock();
+}
+
+bool OplogBufferSpilling::tryPop(OperationContext*, Value* value) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _unspill_inlock();
+    if (_memory.empty()) {
+        return false;
+    }
+    *value = std::move(_memory.front());
+    _memory.pop_front();
+    _memorySize -= getDocumentSize(*value);
+    if (_numPrefetched > 0) {
+        --_numPrefetched;
+    }
+    _notFullCV.notify_all();
+    _prefetchCV.notify_one();
+    return true;
+}
+
+bool OplogBufferSpilling::waitForData(Seconds waitDuration) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    return _notEmptyCV.wait_for(lk, waitDuration.toSystemDuration(), [&] {
+        return !_memory.empty() || _spilledCount > 0;
+    });
+}
+
+bool OplogBufferSpilling::peek(OperationContext*, Value* value) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _unspill_inlock();
+    if (_memory.empty()) {
+        return false;
+    }
+    *value = _memory.front();
+    return true;
+}
+
+boost::optional<OplogBuffer::Value> OplogBufferSpilling::lastObjectPushed(
+    OperationContext*) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_memory.empty() && _spilledCount == 0) {
+        return boost::none;
+    }
+    return _lastPushed;
+}
+
+std::size_t OplogBufferSpilling::getSpilledCount() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _spilledCount;
+}
+
+bool OplogBufferSpilling::_hasSpace_inlock(std::size_t size) const {
+    // An empty buffer accepts an entry of any size.
+    const auto currentSize = _memorySize + _spilledSize;
+    return currentSize == 0 || currentSize + size <= _options.maxSize;
+}
+
+void OplogBufferSpilling::_push_inlock(const Value& value) {
+    const auto size = getDocumentSize(value);
+    if (_spilledCount == 0 &&
+        (_memory.empty() || _memorySize + size <= _options.maxMemorySize)) {
+        _memory.push_back(value);
+        _memorySize += size;
+        _prefetchCV.notify_one();
+    } else {
+        _spill_inlock(value);
+    }
+    _lastPushed = value;
+    _notEmptyCV.notify_all();
+}
+
+void OplogBufferSpilling::_spill_inlock(const Value& value) {
+    if (!_spillOut.is_open()) {
+        boost::filesystem::create_directories(_options.spillDirectory);
+        _spillFilePath = _options.spillDirectory + "/oplogBuffer." + OID::gen().toString();
+        _spillOut.open(_spillFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+        _spillIn.open(_spillFilePath, std::ios::binary | std::ios::in);
+        if (!_spillOut.is_open() || !_spillIn.is_open()) {
+            severe() << "Failed to open the oplog buffer spill file " << _spillFilePath << ": "
+                     << errnoWithDescription();
+            fassertFailedNoTrace(51008);
+        }
+        log() << "Oplog buffer holds " << _memorySize << " bytes of entries in memory, spilling "
+              << "newer entries to " << _spillFilePath;
+        spillsStats.increment();
+    }
+
+    const auto size = getDocumentSize(value);
+    _spillOut.write(value.objdata(), size);
+    if (!_spillOut) {
+        severe() << "Failed to write to the oplog buffer spill file " << _spillFilePath << ": "
+                 << errnoWithDescription();
+        fassertFailedNoTrace(51009);
+    }
+    _spilledSize += size;
+    _spilledCount++;
+    spilledBytesStats.increment(size);
+}
+
+void OplogBufferSpilling::_unspill_inlock() {
+    if (!_memory.empty() || _spilledCount == 0) {
+        return;
+    }
+
+    _spillOut.flush();
+    const auto chunkSize = std::min(kUnspillChunkSize, _options.maxMemorySize);
+    while (_spilledCount > 0 && _memorySize < chunkSize) {
+        char sizeBytes[sizeof(int32_t)];
+        _spillIn.read(sizeBytes, sizeof(sizeBytes));
+        const auto size = ConstDataView(sizeBytes).read<LittleEndian<int32_t>>();
+        if (_spillIn && size >= BSONObj::kMinBSONLength) {
+            auto buffer = SharedBuffer::allocate(size);
+            std::memcpy(buffer.get(), sizeBytes, sizeof(sizeBytes));
+            _spillIn.read(buffer.get() + sizeof(sizeBytes), size - sizeof(sizeBytes));
+            if (_spillIn) {
+                _memory.emplace_back(std::move(buffer));
+                _memorySize += size;
+                _spilledSize -= size;
+                _spilledCount--;
+                continue;
+            }
+        }
+        severe() << "Failed to read from the oplog buffer spill file " << _spillFilePath << ": "
+                 << errnoWithDescription();
+        fassertFailedNoTrace(51010);
+    }
+
+    // Go back to holding new entries in memory once every spilled entry has been read back.
+    if (_spilledCount == 0) {
+        _removeSpillFile_inlock();
+    }
+    _prefetchCV.notify_one();
+}
+
+void OplogBufferSpilling::_clear_inlock() {
+    _memory.clear();
+    _memorySize = 0;
+    _numPrefetched = 0;
+    _removeSpillFile_inlock();
+    _spilledSize = 0;
+    _spilledCount = 0;
+    _lastPushed = boost::none;
+    _notFullCV.notify_all();
+}
+
+void OplogBufferSpilling::_removeSpillFile_inlock() {
+    if (!_spillOut.is_open()) {
+        return;
+    }
+    _spillOut.close();
+    _spillIn.close();
+    boost::system::error_code ec;
+    boost::filesystem::remove(_spillFilePath, ec);
+    if (ec) {
+        warning() << "Failed to remove the oplog buffer spill file " << _spillFilePath << ": "
+                  << ec.message();
+    }
+    _spillFilePath.clear();
+}
+
+void OplogBufferSpilling::_runPrefetcher() {
+    setThreadName("ReplBufferPrefetcher");
+
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    while (true) {
+        _prefetchCV.wait(lk, [&] {
+            return _inShutdown ||
+                _numPrefetched < std::min(_memory.size(), _options.maxPrefetchCount);
+        });
+        if (_inShutdown) {
+            return;
+        }
+
+        // The entry is shared with the buffer, so it stays valid even if it is popped meanwhile.
+        const auto value = _memory[_numPrefetched++];
+        lk.unlock();
+        _options.prefetchFn(value);
+        lk.lock();
+    }
+}
+
+}  // namespace repl
+}  // namespace mongo
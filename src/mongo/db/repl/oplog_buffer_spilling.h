@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <string>
+
+#include "mongo/db/repl/oplog_buffer.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Oplog buffer which holds oplog entries in memory up to a size limit, and beyond it appends them
+ * to a local spill file until they are popped, so that a lagging secondary can keep fetching
+ * without holding the whole backlog in memory. Entries are read back from the spill file once the
+ * ones in memory have been popped.
+ *
+ * If a prefetch function is provided, it is called on a background thread for the entries in
+ * memory ahead of the next one to be popped, to warm the storage engine cache before they are
+ * applied.
+ */
+class OplogBufferSpilling final : public OplogBuffer {
+public:
+    using PrefetchFn = stdx::function<void(const Value&)>;
+
+    struct Options {
+        // Maximum size of the oplog entries held in memory.
+        std::size_t maxMemorySize = 256 * 1024 * 1024;
+
+        // Maximum size of all the oplog entries in the buffer, in memory and spilled.
+        std::size_t maxSize = 1024 * 1024 * 1024;
+
+        // Directory in which the spill file is created, only once the buffer spills.
+        std::string spillDirectory;
+
+        // Called on the prefetcher thread for each entry held in memory. No prefetcher thread is
+        // started if empty.
+        PrefetchFn prefetchFn;
+
+        // Maximum number of entries ahead of the next one to be popped which are prefetched.
+        std::size_t maxPrefetchCount = 10000;
+    };
+
+    explicit OplogBufferSpilling(Options options);
+    ~OplogBufferSpilling();
+
+    void startup(OperationContext* opCtx) override;
+    void shutdown(OperationContext* opCtx) override;
+    void pushEvenIfFull(OperationContext* opCtx, const Value& value) override;
+    void push(OperationContext* opCtx, const Value& value) override;
+    void pushAllNonBlocking(OperationContext* opCtx,
+                            Batch::const_iterator begin,
+                            Batch::const_iterator end) override;
+    void waitForSpace(OperationContext* opCtx, std::size_t size) override;
+    bool isEmpty() const override;
+    std::size_t getMaxSize() const override;
+    std::size_t getSize() const override;
+    std::size_t getCount() const override;
+    void clear(OperationContext* opCtx) override;
+    bool tryPop(OperationContext* opCtx, Value* value) override;
+    bool waitForData(Seconds waitDuration) override;
+    bool peek(OperationContext* opCtx, Value* value) override;
+    boost::optional<Value> lastObjectPushed(OperationContext* opCtx) const override;
+
+    /**
+     * Returns the number of entries currently in the spill file.
+     */
+    std::size_t getSpilledCount() const;
+
+private:
+    bool _hasSpace_inlock(std::size_t size) const;
+    void _push_inlock(const Value& value);
+    void _spill_inlock(const Value& value);
+
+    /**
+     * Moves entries from the spill file to memory if there are none left in memory.
+     */
+    void _unspill_inlock();
+    void _clear_inlock();
+    void _removeSpillFile_inlock();
+    void _runPrefetcher();
+
+    const Options _options;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _notEmptyCV;
+    stdx::condition_variable _notFullCV;
+    stdx::condition_variable _prefetchCV;
+
+    // The oldest entries of the buffer. While there are spilled entries, newer entries are only
+    // appended to the spill file, so that entries are popped in the order they were pushed.
+    std::deque<Value> _memory;
+    std::size_t _memorySize = 0;
+
+    // Spilled entries are appended through '_spillOut' and read back in order through '_spillIn'.
+    std::string _spillFilePath;
+    std::ofstream _spillOut;
+    std::ifstream _spillIn;
+    std::size_t _spilledSize = 0;
+    std::size_t _spilledCount = 0;
+
+    boost::optional<Value> _lastPushed;
+
+    // Number of entries at the front of '_memory' which were already handed to the prefetcher.
+    std::size_t _numPrefetched = 0;
+    bool _inShutdown = false;
+    stdx::thread _prefetcher;
+};
+
+}  // namespace repl
+}  // namespace mongo
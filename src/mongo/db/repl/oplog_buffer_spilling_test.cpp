@@ -0,0 +1,276 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/optional/optional_io.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/oplog_buffer_spilling.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+using namespace mongo;
+using namespace mongo::repl;
+
+const std::size_t kValueSize = 1024;
+
+/**
+ * Returns a value of 'kValueSize' bytes.
+ */
+OplogBuffer::Value makeValue(int i) {
+    auto filler = std::string(kValueSize - BSON("_id" << i << "x"
+                                                      << "")
+                                               .objsize(),
+                              'x');
+    auto value = BSON("_id" << i << "x" << filler);
+    ASSERT_EQUALS(kValueSize, std::size_t(value.objsize()));
+    return value;
+}
+
+class OplogBufferSpillingTest : public unittest::Test {
+private:
+    void setUp() override;
+    void tearDown() override;
+
+protected:
+    /**
+     * Creates a buffer which holds 'memoryCount' values in memory and 'maxCount' values in total.
+     */
+    void makeBuffer(std::size_t memoryCount,
+                    std::size_t maxCount,
+                    OplogBufferSpilling::PrefetchFn prefetchFn = {},
+                    std::size_t maxPrefetchCount = 10000);
+
+    /**
+     * Returns the number of files in the spill directory.
+     */
+    std::size_t countSpillFiles();
+
+    std::unique_ptr<unittest::TempDir> _tempDir;
+    std::unique_ptr<OplogBufferSpilling> _buffer;
+    OperationContext* _opCtx = nullptr;  // Not dereferenced.
+};
+
+void OplogBufferSpillingTest::setUp() {
+    _tempDir = stdx::make_unique<unittest::TempDir>("oplog_buffer_spilling_test");
+}
+
+void OplogBufferSpillingTest::tearDown() {
+    _buffer.reset();
+    _tempDir.reset();
+}
+
+void OplogBufferSpillingTest::makeBuffer(std::size_t memoryCount,
+                                         std::size_t maxCount,
+                                         OplogBufferSpilling::PrefetchFn prefetchFn,
+                                         std::size_t maxPrefetchCount) {
+    OplogBufferSpilling::Options options;
+    options.maxMemorySize = memoryCount * kValueSize;
+    options.maxSize = maxCount * kValueSize;
+    options.spillDirectory = _tempDir->path() + "/_tmp";
+    options.prefetchFn = std::move(prefetchFn);
+    options.maxPrefetchCount = maxPrefetchCount;
+    _buffer = stdx::make_unique<OplogBufferSpilling>(std::move(options));
+    _buffer->startup(_opCtx);
+}
+
+std::size_t OplogBufferSpillingTest::countSpillFiles() {
+    const auto spillDirectory = _tempDir->path() + "/_tmp";
+    if (!boost::filesystem::exists(spillDirectory)) {
+        return 0;
+    }
+    return std::distance(boost::filesystem::directory_iterator(spillDirectory),
+                         boost::filesystem::directory_iterator());
+}
+
+TEST_F(OplogBufferSpillingTest, HoldsValuesInMemoryUpToTheMemoryLimit) {
+    makeBuffer(4, 16);
+    for (int i = 0; i < 4; ++i) {
+        _buffer->push(_opCtx, makeValue(i));
+    }
+    ASSERT_EQUALS(4U, _buffer->getCount());
+    ASSERT_EQUALS(4 * kValueSize, _buffer->getSize());
+    ASSERT_EQUALS(0U, _buffer->getSpilledCount());
+    ASSERT_EQUALS(0U, countSpillFiles());
+}
+
+TEST_F(OplogBufferSpillingTest, PopsSpilledValuesInTheOrderTheyWerePushed) {
+    makeBuffer(4, 64);
+    int nextToPush = 0;
+    int nextToPop = 0;
+    auto pushValues = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            _buffer->push(_opCtx, makeValue(nextToPush++));
+        }
+    };
+    auto popValues = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            OplogBuffer::Value value;
+            ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+            ASSERT_BSONOBJ_EQ(makeValue(nextToPop++), value);
+        }
+    };
+
+    pushValues(10);
+    ASSERT_EQUALS(6U, _buffer->getSpilledCount());
+    ASSERT_EQUALS(10U, _buffer->getCount());
+    ASSERT_EQUALS(10 * kValueSize, _buffer->getSize());
+    ASSERT_EQUALS(1U, countSpillFiles());
+
+    // Values pushed while there are spilled values are spilled too, even if there is room left in
+    // memory, so that they are not popped before the spilled ones.
+    popValues(3);
+    pushValues(2);
+    ASSERT_EQUALS(8U, _buffer->getSpilledCount());
+
+    popValues(9);
+    ASSERT_EQUALS(0U, _buffer->getSpilledCount());
+    ASSERT_EQUALS(0U, _buffer->getCount());
+    ASSERT_EQUALS(0U, _buffer->getSize());
+    ASSERT_TRUE(_buffer->isEmpty());
+
+    // The spill file is removed once every spilled value was read back.
+    ASSERT_EQUALS(0U, countSpillFiles());
+    pushValues(2);
+    ASSERT_EQUALS(0U, _buffer->getSpilledCount());
+    popValues(2);
+}
+
+TEST_F(OplogBufferSpillingTest, PeekAndWaitForDataSeeSpilledValues) {
+    makeBuffer(1, 8);
+    _buffer->push(_opCtx, makeValue(0));
+    _buffer->push(_opCtx, makeValue(1));
+
+    OplogBuffer::Value value;
+    ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+    ASSERT_EQUALS(1U, _buffer->getSpilledCount());
+    ASSERT_TRUE(_buffer->waitForData(Seconds(0)));
+    ASSERT_BSONOBJ_EQ(makeValue(1), *_buffer->lastObjectPushed(_opCtx));
+    ASSERT_TRUE(_buffer->peek(_opCtx, &value));
+    ASSERT_BSONOBJ_EQ(makeValue(1), value);
+    ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+    ASSERT_BSONOBJ_EQ(makeValue(1), value);
+
+    ASSERT_FALSE(_buffer->peek(_opCtx, &value));
+    ASSERT_FALSE(_buffer->waitForData(Seconds(0)));
+    ASSERT_EQUALS(boost::none, _buffer->lastObjectPushed(_opCtx));
+}
+
+TEST_F(OplogBufferSpillingTest, ClearRemovesTheSpillFile) {
+    makeBuffer(2, 8);
+    for (int i = 0; i < 5; ++i) {
+        _buffer->push(_opCtx, makeValue(i));
+    }
+    ASSERT_EQUALS(1U, countSpillFiles());
+
+    _buffer->clear(_opCtx);
+    ASSERT_TRUE(_buffer->isEmpty());
+    ASSERT_EQUALS(0U, _buffer->getSpilledCount());
+    ASSERT_EQUALS(0U, countSpillFiles());
+
+    _buffer->push(_opCtx, makeValue(5));
+    OplogBuffer::Value value;
+    ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+    ASSERT_BSONOBJ_EQ(makeValue(5), value);
+}
+
+TEST_F(OplogBufferSpillingTest, MaxSizeBoundsValuesInMemoryAndSpilled) {
+    makeBuffer(2, 4);
+    ASSERT_EQUALS(4 * kValueSize, _buffer->getMaxSize());
+    std::vector<OplogBuffer::Value> values;
+    for (int i = 0; i < 4; ++i) {
+        values.push_back(makeValue(i));
+    }
+    _buffer->pushAllNonBlocking(_opCtx, values.cbegin(), values.cend());
+    ASSERT_EQUALS(2U, _buffer->getSpilledCount());
+
+    // There is room for one more value once a value is popped.
+    OplogBuffer::Value value;
+    ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+    _buffer->waitForSpace(_opCtx, kValueSize);
+    _buffer->push(_opCtx, makeValue(4));
+
+    _buffer->pushEvenIfFull(_opCtx, makeValue(5));
+    ASSERT_EQUALS(5U, _buffer->getCount());
+    for (int i = 1; i < 6; ++i) {
+        ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+        ASSERT_BSONOBJ_EQ(makeValue(i), value);
+    }
+}
+
+TEST_F(OplogBufferSpillingTest, PrefetchesValuesInMemoryAheadOfThePoppedOnes) {
+    stdx::mutex mutex;
+    stdx::condition_variable prefetchedCV;
+    std::vector<int> prefetched;
+    auto prefetchFn = [&](const OplogBuffer::Value& value) {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        prefetched.push_back(value["_id"].numberInt());
+        prefetchedCV.notify_all();
+    };
+    auto waitForPrefetched = [&](std::size_t count) {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        prefetchedCV.wait(lk, [&] { return prefetched.size() >= count; });
+    };
+    makeBuffer(4, 16, prefetchFn, 3);
+
+    // Only the values in memory, up to 'maxPrefetchCount' of them, are prefetched.
+    for (int i = 0; i < 6; ++i) {
+        _buffer->push(_opCtx, makeValue(i));
+    }
+    waitForPrefetched(3);
+
+    // Popping values lets the prefetcher move on, and spilled values are prefetched once they are
+    // read back in memory.
+    OplogBuffer::Value value;
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(_buffer->tryPop(_opCtx, &value));
+    }
+    _buffer->shutdown(_opCtx);
+
+    // Values popped before the prefetcher got to them are skipped.
+    stdx::lock_guard<stdx::mutex> lk(mutex);
+    ASSERT_LESS_THAN_OR_EQUALS(3U, prefetched.size());
+    for (std::size_t i = 0; i < 3; ++i) {
+        ASSERT_EQUALS(int(i), prefetched[i]);
+    }
+    for (std::size_t i = 3; i < prefetched.size(); ++i) {
+        ASSERT_LESS_THAN(prefetched[i - 1], prefetched[i]);
+        ASSERT_LESS_THAN(prefetched[i], 6);
+    }
+}
+
+}  // namespace
@@ -40,6 +40,18 @@ namespace repl {
 
 namespace {
 
+/**
+ * Returns a document which can be held on to for as long as a transaction runs. A document sharing
+ * a buffer more than twice its size, such as one from a request message of many documents or in a
+ * registered network buffer, is copied so that it doesn't keep the rest of the buffer alive.
+ */
+BSONObj retainableDocument(const BSONObj& doc) {
+    if (doc.isOwned() && doc.sharedBuffer().capacity() > 2 * size_t(doc.objsize())) {
+        return doc.copy();
+    }
+    return doc.getOwned();
+}
+
 OplogEntry::CommandType parseCommandType(const BSONObj& objectField) {
     StringData commandString(objectField.firstElementFieldName());
     if (commandString == "create") {
@@ -148,7 +160,7 @@ ReplOperation OplogEntry::makeInsertOperation(const NamespaceString& nss,
     op.setOpType(OpTypeEnum::kInsert);
     op.setNamespace(nss);
     op.setUuid(uuid);
-    op.setObject(docToInsert.getOwned());
+    op.setObject(retainableDocument(docToInsert));
     return op;
 }
 
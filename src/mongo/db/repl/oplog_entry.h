@@ -100,9 +100,13 @@ public:
 
     OplogEntry() = delete;
 
-    // This member is not parsed from the BSON and is instead populated by fillWriterVectors.
+    // These members are not parsed from the BSON and are instead populated by fillWriterVectors.
     bool isForCappedCollection = false;
 
+    // The hash which decided the writer thread of this op. Ops with the same hash, such as the ops
+    // on one document or on one capped collection, must be applied in order by a single thread.
+    uint32_t writerHash = 0;
+
     /**
      * Returns if the oplog entry is for a command operation.
      */
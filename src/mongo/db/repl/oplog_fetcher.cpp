@@ -36,8 +36,10 @@
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/rpc/metadata/oplog_query_metadata.h"
+#include "mongo/transport/message_compressor_registry.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -56,12 +58,31 @@ namespace {
 TimerStats getmoreReplStats;
 ServerStatusMetricField<TimerStats> displayBatchesRecieved("repl.network.getmores",
                                                            &getmoreReplStats);
+TimerHistogramStats getmoreLatencyStats;
+ServerStatusMetricField<TimerHistogramStats> displayGetmoreLatency("repl.network.latency.getmores",
+                                                                   &getmoreLatencyStats);
 // The oplog entries read via the oplog reader
 Counter64 opsReadStats;
 ServerStatusMetricField<Counter64> displayOpsRead("repl.network.ops", &opsReadStats);
 // The bytes read via the oplog reader
 Counter64 networkByteStats;
 ServerStatusMetricField<Counter64> displayBytesRead("repl.network.bytes", &networkByteStats);
+// The bytes of the compressed blocks read via the oplog reader, and the bytes by which packing
+// batches into those blocks shrank them
+Counter64 compressedByteStats;
+ServerStatusMetricField<Counter64> displayCompressedBytesRead("repl.network.compressedBytes",
+                                                              &compressedByteStats);
+Counter64 compressedBytesSavedStats;
+ServerStatusMetricField<Counter64> displayCompressedBytesSaved(
+    "repl.network.compressedBytesSaved", &compressedBytesSavedStats);
+
+// Name of a network message compressor, enabled on the sync source as well as on this node, with
+// which the sync source should pack each batch of oplog entries into a single compressed block.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(oplogFetcherBatchCompressor, std::string, "");
+
+// Whether to leave out of the fetched oplog entries their wall clock times, which secondaries do
+// not need to apply them.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(oplogFetcherExcludeWallClockTime, bool, false);
 
 const Milliseconds maximumAwaitDataTimeoutMS(30 * 1000);
 
@@ -79,6 +100,23 @@ Milliseconds calculateAwaitDataTimeout(const ReplSetConfig& config) {
     return OplogFetcher::kDefaultProtocolZeroAwaitDataTimeout;
 }
 
+/**
+ * Returns the name of the compressor the sync source should pack batches with, or boost::none if
+ * they are to be sent uncompressed.
+ */
+boost::optional<std::string> getBatchCompressor() {
+    if (oplogFetcherBatchCompressor.empty()) {
+        return boost::none;
+    }
+    if (!MessageCompressorRegistry::get().getCompressor(oplogFetcherBatchCompressor)) {
+        warning() << "Not asking the sync source to compress batches of oplog entries with '"
+                  << oplogFetcherBatchCompressor
+                  << "', which is not among the enabled network message compressors";
+        return boost::none;
+    }
+    return oplogFetcherBatchCompressor;
+}
+
 /**
  * Returns getMore command object suitable for tailing remote oplog.
  */
@@ -86,7 +124,8 @@ BSONObj makeGetMoreCommandObject(const NamespaceString& nss,
                                  CursorId cursorId,
                                  OpTimeWithTerm lastCommittedWithCurrentTerm,
                                  Milliseconds fetcherMaxTimeMS,
-                                 int batchSize) {
+                                 int batchSize,
+                                 const boost::optional<std::string>& batchCompressor) {
     BSONObjBuilder cmdBob;
     cmdBob.append("getMore", cursorId);
     cmdBob.append("collection", nss.coll());
@@ -96,6 +135,9 @@ BSONObj makeGetMoreCommandObject(const NamespaceString& nss,
         cmdBob.append("term", lastCommittedWithCurrentTerm.value);
         lastCommittedWithCurrentTerm.opTime.append(&cmdBob, "lastKnownCommittedOpTime");
     }
+    if (batchCompressor) {
+        cmdBob.append("batchCompressor", *batchCompressor);
+    }
     return cmdBob.obj();
 }
 
@@ -359,7 +401,8 @@ OplogFetcher::OplogFetcher(executor::TaskExecutor* executor,
       _dataReplicatorExternalState(dataReplicatorExternalState),
       _enqueueDocumentsFn(enqueueDocumentsFn),
       _awaitDataTimeout(calculateAwaitDataTimeout(config)),
-      _batchSize(batchSize) {
+      _batchSize(batchSize),
+      _batchCompressor(getBatchCompressor()) {
 
     invariant(config.isInitialized());
     invariant(enqueueDocumentsFn);
@@ -384,6 +427,12 @@ BSONObj OplogFetcher::_makeFindCommandObject(const NamespaceString& nss,
     cmdBob.append("awaitData", true);
     cmdBob.append("maxTimeMS", durationCount<Milliseconds>(findMaxTime));
     cmdBob.append("batchSize", _batchSize);
+    if (oplogFetcherExcludeWallClockTime) {
+        cmdBob.append("projection", BSON("wall" << 0));
+    }
+    if (auto batchCompressor = _getBatchCompressor()) {
+        cmdBob.append("batchCompressor", *batchCompressor);
+    }
 
     if (term != OpTime::kUninitializedTerm) {
         cmdBob.append("term", term);
@@ -501,9 +550,17 @@ StatusWith<BSONObj> OplogFetcher::_onSuccessfulBatch(const Fetcher::QueryRespons
     // Increment stats. We read all of the docs in the query.
     opsReadStats.increment(info.networkDocumentCount);
     networkByteStats.increment(info.networkDocumentBytes);
+    if (queryResponse.compressedBatchBytes) {
+        compressedByteStats.increment(queryResponse.compressedBatchBytes);
+        if (queryResponse.uncompressedBatchBytes > queryResponse.compressedBatchBytes) {
+            compressedBytesSavedStats.increment(queryResponse.uncompressedBatchBytes -
+                                                queryResponse.compressedBatchBytes);
+        }
+    }
 
     // Record time for each batch.
     getmoreReplStats.recordMillis(durationCount<Milliseconds>(queryResponse.elapsedMillis));
+    getmoreLatencyStats.recordMicros(durationCount<Microseconds>(queryResponse.elapsedMillis));
 
     // TODO: back pressure handling will be added in SERVER-23499.
     auto status = _enqueueDocumentsFn(firstDocToApply, documents.cend(), info);
@@ -537,7 +594,29 @@ StatusWith<BSONObj> OplogFetcher::_onSuccessfulBatch(const Fetcher::QueryRespons
                                     queryResponse.cursorId,
                                     lastCommittedWithCurrentTerm,
                                     _getGetMoreMaxTime(),
-                                    _batchSize);
+                                    _batchSize,
+                                    _getBatchCompressor());
+}
+
+bool OplogFetcher::_adjustQueryAfterError(const Status& status) {
+    // Sync sources which don't know the field fail to parse the command, and those without the
+    // compressor enabled reject it as a bad value. Either way, fall back to plain batches.
+    if (!_getBatchCompressor() ||
+        (status != ErrorCodes::FailedToParse && status != ErrorCodes::BadValue)) {
+        return false;
+    }
+    warning() << "Asking " << _getSource() << " for uncompressed batches of oplog entries after "
+              << "it failed a query for batches compressed with '" << *_batchCompressor
+              << "': " << redact(status);
+    _batchCompressorRejected.store(true);
+    return true;
+}
+
+boost::optional<std::string> OplogFetcher::_getBatchCompressor() const {
+    if (_batchCompressorRejected.load()) {
+        return boost::none;
+    }
+    return _batchCompressor;
 }
 }  // namespace repl
 }  // namespace mongo
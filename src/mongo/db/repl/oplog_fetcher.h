@@ -28,7 +28,9 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <cstddef>
+#include <string>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status_with.h"
@@ -38,6 +40,7 @@
 #include "mongo/db/repl/abstract_oplog_fetcher.h"
 #include "mongo/db/repl/data_replicator_external_state.h"
 #include "mongo/db/repl/repl_set_config.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/fail_point_service.h"
 
@@ -158,6 +161,16 @@ private:
      */
     StatusWith<BSONObj> _onSuccessfulBatch(const Fetcher::QueryResponse& queryResponse) override;
 
+    /**
+     * Stops asking for compressed batches if the sync source rejected the request for them.
+     */
+    bool _adjustQueryAfterError(const Status& status) override;
+
+    /**
+     * Returns the compressor to ask the sync source for compressed batches with, if any.
+     */
+    boost::optional<std::string> _getBatchCompressor() const;
+
     // The metadata object sent with the Fetcher queries.
     const BSONObj _metadataObject;
 
@@ -174,6 +187,14 @@ private:
     const EnqueueDocumentsFn _enqueueDocumentsFn;
     const Milliseconds _awaitDataTimeout;
     const int _batchSize;
+
+    // Name of the network message compressor with which the sync source packs each batch into a
+    // single compressed block, if any.
+    const boost::optional<std::string> _batchCompressor;
+
+    // Set once the sync source rejected '_batchCompressor', after which batches are requested
+    // uncompressed.
+    AtomicWord<bool> _batchCompressorRejected{false};
 };
 
 }  // namespace repl
@@ -33,10 +33,13 @@
 #include "mongo/db/repl/abstract_oplog_fetcher_test_fixture.h"
 #include "mongo/db/repl/data_replicator_external_state_mock.h"
 #include "mongo/db/repl/oplog_fetcher.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/rpc/metadata.h"
 #include "mongo/rpc/metadata/oplog_query_metadata.h"
 #include "mongo/rpc/metadata/repl_set_metadata.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_snappy.h"
 #include "mongo/unittest/ensure_fcv.h"
 #include "mongo/unittest/task_executor_proxy.h"
 #include "mongo/unittest/unittest.h"
@@ -580,6 +583,45 @@ TEST_F(OplogFetcherTest, OplogFetcherShouldReportErrorsThrownFromCallback) {
     ASSERT_EQ(shutdownState->getStatus(), Status(ErrorCodes::InternalError, "my custom error"));
 }
 
+TEST_F(OplogFetcherTest, OplogFetcherFallsBackToPlainBatchesIfSyncSourceRejectsBatchCompressor) {
+    auto& registry = MessageCompressorRegistry::get();
+    if (!registry.getCompressor("snappy")) {
+        registry.setSupportedCompressors({"snappy"});
+        registry.registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+    }
+    auto batchCompressorParameter =
+        ServerParameterSet::getGlobal()->getMap().find("oplogFetcherBatchCompressor")->second;
+    ASSERT_OK(batchCompressorParameter->setFromString("snappy"));
+    ON_BLOCK_EXIT([&] { ASSERT_OK(batchCompressorParameter->setFromString("")); });
+
+    auto shutdownState = stdx::make_unique<ShutdownState>();
+    OplogFetcher oplogFetcher(&getExecutor(),
+                              lastFetched,
+                              source,
+                              nss,
+                              _createConfig(),
+                              0,
+                              rbid,
+                              true,
+                              dataReplicatorExternalState.get(),
+                              enqueueDocumentsFn,
+                              stdx::ref(*shutdownState),
+                              defaultBatchSize);
+    ASSERT_OK(oplogFetcher.startup());
+
+    // The retried query does not count against the restart limit of 0.
+    auto request = processNetworkResponse(
+        {ErrorCodes::FailedToParse, "Unrecognized field 'batchCompressor'"}, true);
+    ASSERT_EQUALS("snappy", request.cmdObj["batchCompressor"].str());
+
+    request = processNetworkResponse({ErrorCodes::OperationFailed, "fail"}, false);
+    ASSERT_EQUALS(std::string("find"), request.cmdObj.firstElementFieldName());
+    ASSERT_FALSE(request.cmdObj.hasField("batchCompressor"));
+
+    oplogFetcher.join();
+    ASSERT_EQUALS(ErrorCodes::OperationFailed, shutdownState->getStatus());
+}
+
 void OplogFetcherTest::testSyncSourceChecking(rpc::ReplSetMetadata* replMetadata,
                                               rpc::OplogQueryMetadata* oqMetadata) {
     auto firstEntry = makeNoopOplogEntry(lastFetched);
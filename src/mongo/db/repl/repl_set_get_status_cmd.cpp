@@ -29,6 +29,7 @@
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/repl/repl_set_command.h"
+#include "mongo/db/repl/rollback_refetch_progress.h"
 
 namespace mongo {
 namespace repl {
@@ -65,6 +66,7 @@ public:
         status =
             ReplicationCoordinator::get(opCtx)->processReplSetGetStatus(&result, responseStyle);
         uassertStatusOK(status);
+        RollbackRefetchProgress::get(opCtx->getServiceContext())->append(&result);
         return true;
     }
 
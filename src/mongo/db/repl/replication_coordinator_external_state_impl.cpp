@@ -32,6 +32,7 @@
 
 #include "mongo/db/repl/replication_coordinator_external_state_impl.h"
 
+#include <algorithm>
 #include <string>
 
 #include "mongo/base/status_with.h"
@@ -54,6 +55,7 @@
 #include "mongo/db/logical_time_metadata_hook.h"
 #include "mongo/db/logical_time_validator.h"
 #include "mongo/db/op_observer.h"
+#include "mongo/db/prefetch.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/drop_pending_collection_reaper.h"
@@ -63,6 +65,7 @@
 #include "mongo/db/repl/noop_writer.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_buffer_blocking_queue.h"
+#include "mongo/db/repl/oplog_buffer_spilling.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/replication_process.h"
@@ -78,6 +81,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/session_catalog.h"
 #include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/system_index.h"
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/network_interface.h"
@@ -145,6 +149,58 @@ MONGO_EXPORT_SERVER_PARAMETER(oplogFetcherInitialSyncMaxFetcherRestarts, int, 10
         return Status::OK();
     });
 
+// If true, the steady state oplog buffer spills the oplog entries beyond
+// 'replOplogBufferMaxMemoryMB' to a file under the dbpath, instead of blocking the oplog fetcher
+// once 256MB of entries are buffered.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replOplogBufferSpillToDisk, bool, false);
+
+// Maximum size of the oplog entries which a spilling oplog buffer holds in memory.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replOplogBufferMaxMemoryMB, int, 256)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1) {
+            return Status(ErrorCodes::BadValue, "replOplogBufferMaxMemoryMB must be positive");
+        }
+        return Status::OK();
+    });
+
+// Maximum size of the oplog entries in a spilling oplog buffer, in memory and on disk.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replOplogBufferMaxSizeMB, int, 4096)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1) {
+            return Status(ErrorCodes::BadValue, "replOplogBufferMaxSizeMB must be positive");
+        }
+        return Status::OK();
+    });
+
+// If true, a spilling oplog buffer warms the cache for the documents which the buffered updates
+// and deletes will touch. Only used with storage engines that support document level locking, as
+// the batches applied on MMAPv1 are already prefetched.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replOplogBufferPrefetch, bool, true);
+
+/**
+ * Returns the buffer of the oplog entries fetched during steady state replication.
+ */
+std::unique_ptr<OplogBuffer> makeSteadyStateOplogBuffer(OperationContext* opCtx) {
+    if (!replOplogBufferSpillToDisk) {
+        return stdx::make_unique<OplogBufferBlockingQueue>();
+    }
+
+    OplogBufferSpilling::Options options;
+    options.maxMemorySize = std::size_t(replOplogBufferMaxMemoryMB) * 1024 * 1024;
+    options.maxSize =
+        std::max(options.maxMemorySize, std::size_t(replOplogBufferMaxSizeMB) * 1024 * 1024);
+    options.spillDirectory = storageGlobalParams.dbpath + "/_tmp";
+    if (replOplogBufferPrefetch &&
+        opCtx->getServiceContext()->getStorageEngine()->supportsDocLocking()) {
+        options.prefetchFn = [](const BSONObj& op) {
+            Client::initThreadIfNotAlready("ReplBufferPrefetcher");
+            const auto prefetchOpCtx = cc().makeOperationContext();
+            prefetchDocumentForReplicatedOp(prefetchOpCtx.get(), op);
+        };
+    }
+    return stdx::make_unique<OplogBufferSpilling>(std::move(options));
+}
+
 /**
  * Returns new thread pool for thread pool task executor.
  */
@@ -223,7 +279,7 @@ void ReplicationCoordinatorExternalStateImpl::startSteadyStateReplication(
     invariant(replCoord);
     invariant(!_bgSync);
     log() << "Starting replication fetcher thread";
-    _oplogBuffer = stdx::make_unique<OplogBufferBlockingQueue>();
+    _oplogBuffer = makeSteadyStateOplogBuffer(opCtx);
     _oplogBuffer->startup(opCtx);
 
     _bgSync =
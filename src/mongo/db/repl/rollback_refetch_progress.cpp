@@ -0,0 +1,102 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/rollback_refetch_progress.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/service_context.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+const auto getRollbackRefetchProgress =
+    ServiceContext::declareDecoration<RollbackRefetchProgress>();
+
+}  // namespace
+
+RollbackRefetchProgress* RollbackRefetchProgress::get(ServiceContext* service) {
+    return &getRollbackRefetchProgress(service);
+}
+
+void RollbackRefetchProgress::start(long long docsToRefetch, long long docsRestoredLocally) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _started = true;
+    _active = true;
+    _docsToRefetch = docsToRefetch;
+    _docsRestoredLocally = docsRestoredLocally;
+    _docsRefetched = 0;
+    _batchesRefetched = 0;
+    _bytesRefetched = 0;
+    _startDate = Date_t::now();
+    _endDate = Date_t();
+}
+
+void RollbackRefetchProgress::onBatchRefetched(long long numDocs, long long numBytes) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _docsRefetched += numDocs;
+    _batchesRefetched++;
+    _bytesRefetched += numBytes;
+}
+
+void RollbackRefetchProgress::finish() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _active = false;
+    _endDate = Date_t::now();
+}
+
+void RollbackRefetchProgress::append(BSONObjBuilder* builder) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (!_started) {
+        return;
+    }
+
+    const auto elapsed = (_active ? Date_t::now() : _endDate) - _startDate;
+    BSONObjBuilder progress(builder->subobjStart("rollbackRefetch"));
+    progress.append("active", _active);
+    progress.append("docsToRefetch", _docsToRefetch);
+    progress.append("docsRefetched", _docsRefetched);
+    progress.append("docsRestoredLocally", _docsRestoredLocally);
+    progress.append("batchesRefetched", _batchesRefetched);
+    progress.append("bytesRefetched", _bytesRefetched);
+    progress.append("startDate", _startDate);
+    if (!_active) {
+        progress.append("endDate", _endDate);
+    }
+    progress.append("elapsedMillis", durationCount<Milliseconds>(elapsed));
+    progress.append("docsPerSecond",
+                    elapsed > Milliseconds(0)
+                        ? _docsRefetched * 1000.0 / durationCount<Milliseconds>(elapsed)
+                        : 0.0);
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,89 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class ServiceContext;
+
+namespace repl {
+
+/**
+ * Progress of the refetch phase of the last rollback via refetch, for replSetGetStatus. The
+ * documents to roll back are either restored from pre-images in our own oplog, or refetched from
+ * the sync source in batches.
+ */
+class RollbackRefetchProgress {
+    MONGO_DISALLOW_COPYING(RollbackRefetchProgress);
+
+public:
+    RollbackRefetchProgress() = default;
+
+    static RollbackRefetchProgress* get(ServiceContext* service);
+
+    /**
+     * Resets the progress for a new refetch phase.
+     */
+    void start(long long docsToRefetch, long long docsRestoredLocally);
+
+    /**
+     * Accounts for a batch of 'numDocs' documents taking 'numBytes' bytes refetched from the sync
+     * source. May be called concurrently by the fetching threads.
+     */
+    void onBatchRefetched(long long numDocs, long long numBytes);
+
+    void finish();
+
+    /**
+     * Appends a "rollbackRefetch" subobject to 'builder', unless no rollback refetched documents
+     * since startup.
+     */
+    void append(BSONObjBuilder* builder) const;
+
+private:
+    mutable stdx::mutex _mutex;
+
+    bool _started = false;
+    bool _active = false;
+    long long _docsToRefetch = 0;
+    long long _docsRestoredLocally = 0;
+    long long _docsRefetched = 0;
+    long long _batchesRefetched = 0;
+    long long _bytesRefetched = 0;
+    Date_t _startDate;
+    Date_t _endDate;
+};
+
+}  // namespace repl
+}  // namespace mongo
@@ -28,15 +28,18 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status_with.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/uuid.h"
 
 namespace mongo {
 
-class NamespaceString;
 class OperationContext;
 
 namespace repl {
@@ -88,6 +91,17 @@ public:
                                                               UUID uuid,
                                                               const BSONObj& filter) const = 0;
 
+    /**
+     * Fetches the documents with the given _ids from the collection with the UUID on the sync
+     * source. Returns one document per _id, in the same order, which is empty if there is no
+     * document with that _id, and the namespace matching the UUID on the sync source.
+     *
+     * May be called concurrently from several threads. The default implementation fetches the
+     * documents one by one through findOneByUUID().
+     */
+    virtual std::pair<std::vector<BSONObj>, NamespaceString> findManyByUUID(
+        const std::string& db, UUID uuid, const std::vector<BSONElement>& ids) const;
+
     /**
      * Clones a single collection from the sync source.
      */
@@ -108,5 +122,16 @@ public:
     virtual StatusWith<BSONObj> getCollectionInfo(const NamespaceString& nss) const = 0;
 };
 
+inline std::pair<std::vector<BSONObj>, NamespaceString> RollbackSource::findManyByUUID(
+    const std::string& db, UUID uuid, const std::vector<BSONElement>& ids) const {
+    std::pair<std::vector<BSONObj>, NamespaceString> result;
+    for (const auto& id : ids) {
+        auto docAndNss = findOneByUUID(db, uuid, id.wrap());
+        result.first.push_back(std::move(docAndNss.first));
+        result.second = std::move(docAndNss.second);
+    }
+    return result;
+}
+
 }  // namespace repl
 }  // namespace mongo
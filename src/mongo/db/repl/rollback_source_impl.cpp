@@ -30,13 +30,19 @@
 
 #include "mongo/db/repl/rollback_source_impl.h"
 
+#include "mongo/bson/bsonelement_comparator.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/cloner.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/query/cursor_response.h"
+#include "mongo/db/query/getmore_request.h"
 #include "mongo/db/repl/oplogreader.h"
+#include "mongo/logger/redaction.h"
+#include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace repl {
@@ -50,6 +56,8 @@ RollbackSourceImpl::RollbackSourceImpl(GetConnectionFn getConnection,
       _collectionName(collectionName),
       _oplog(source, getConnection, collectionName, batchSize) {}
 
+RollbackSourceImpl::~RollbackSourceImpl() = default;
+
 const OplogInterface& RollbackSourceImpl::getOplog() const {
     return _oplog;
 }
@@ -80,6 +88,111 @@ std::pair<BSONObj, NamespaceString> RollbackSourceImpl::findOneByUUID(const std:
     return _getConnection()->findOneByUUID(db, uuid, filter);
 }
 
+std::pair<std::vector<BSONObj>, NamespaceString> RollbackSourceImpl::findManyByUUID(
+    const std::string& db, UUID uuid, const std::vector<BSONElement>& ids) const {
+    auto conn = _acquireRefetchConnection();
+    // Hands the connection back on every exit, including a failed command or a network error.
+    ON_BLOCK_EXIT([&] { _releaseRefetchConnection(std::move(conn)); });
+
+    BSONObjBuilder cmdBuilder;
+    uuid.appendToBuilder(&cmdBuilder, "find");
+    {
+        BSONObjBuilder filter(cmdBuilder.subobjStart("filter"));
+        BSONObjBuilder idFilter(filter.subobjStart("_id"));
+        BSONArrayBuilder in(idFilter.subarrayStart("$in"));
+        for (const auto& id : ids) {
+            in.append(id);
+        }
+    }
+    cmdBuilder.append("batchSize", static_cast<long long>(ids.size()));
+    BSONObj cmd = cmdBuilder.obj();
+
+    auto runCursorCommand = [&](const BSONObj& cmd) {
+        BSONObj res;
+        if (!conn->runCommand(db, cmd, res, QueryOption_SlaveOk)) {
+            uassertStatusOKWithContext(getStatusFromCommandResult(res),
+                                       str::stream() << "find command using UUID failed. Command: "
+                                                     << redact(cmd));
+        }
+        return uassertStatusOK(CursorResponse::parseFromBSON(res));
+    };
+
+    std::vector<BSONObj> docs;
+    auto response = runCursorCommand(cmd);
+    const NamespaceString nss = response.getNSS();
+    while (true) {
+        for (const auto& doc : response.getBatch()) {
+            docs.push_back(doc.getOwned());
+        }
+        if (response.getCursorId() == 0) {
+            break;
+        }
+        response = runCursorCommand(
+            GetMoreRequest(nss, response.getCursorId(), boost::none, boost::none, boost::none, {})
+                .toBSON());
+    }
+
+    // Matches the documents to the _ids they were fetched for, by value as a find on a single _id
+    // would. A document matching none of them, such as one whose _id only equals one of the ids
+    // under the collation of the collection, leaves the ids without a document to be fetched one
+    // by one.
+    BSONElementComparator eltCmp(BSONElementComparator::FieldNamesMode::kIgnore, nullptr);
+    auto idToIndex = eltCmp.makeBSONEltIndexedMap<size_t>();
+    for (size_t i = 0; i < ids.size(); ++i) {
+        idToIndex.emplace(ids[i], i);
+    }
+    std::vector<BSONObj> results(ids.size());
+    std::vector<bool> matched(ids.size(), false);
+    bool unmatchedDocs = false;
+    for (auto& doc : docs) {
+        auto it = idToIndex.find(doc["_id"]);
+        if (it == idToIndex.end()) {
+            unmatchedDocs = true;
+            continue;
+        }
+        matched[it->second] = true;
+        results[it->second] = std::move(doc);
+    }
+    if (unmatchedDocs) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (!matched[i]) {
+                results[i] = conn->findOneByUUID(db, uuid, ids[i].wrap()).first;
+            }
+        }
+    }
+
+    return {std::move(results), nss};
+}
+
+std::unique_ptr<DBClientConnection> RollbackSourceImpl::_acquireRefetchConnection() const {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_refetchConnectionsMutex);
+        if (!_refetchConnections.empty()) {
+            auto conn = std::move(_refetchConnections.back());
+            _refetchConnections.pop_back();
+            return conn;
+        }
+    }
+
+    std::string errmsg;
+    auto conn = stdx::make_unique<DBClientConnection>();
+    uassert(51011,
+            str::stream() << "replSet rollback error connecting to " << _source
+                          << " to refetch documents: "
+                          << errmsg,
+            conn->connect(_source, StringData(), errmsg) && replAuthenticate(conn.get()));
+    return conn;
+}
+
+void RollbackSourceImpl::_releaseRefetchConnection(std::unique_ptr<DBClientConnection> conn) const {
+    // A connection that saw a network error is closed rather than pooled.
+    if (conn->isFailed()) {
+        return;
+    }
+    stdx::lock_guard<stdx::mutex> lk(_refetchConnectionsMutex);
+    _refetchConnections.push_back(std::move(conn));
+}
+
 void RollbackSourceImpl::copyCollectionFromRemote(OperationContext* opCtx,
                                                   const NamespaceString& nss) const {
     std::string errmsg;
@@ -28,16 +28,20 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "mongo/db/repl/oplog_interface_remote.h"
 #include "mongo/db/repl/rollback_source.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/net/hostandport.h"
 
 namespace mongo {
 
 class DBClientBase;
+class DBClientConnection;
 
 namespace repl {
 
@@ -71,6 +75,13 @@ public:
                                                       UUID uuid,
                                                       const BSONObj& filter) const override;
 
+    /**
+     * Fetches the documents with a single find on {_id: {$in: ids}} and the getMores following it,
+     * over a connection of its own so that several threads may refetch at once.
+     */
+    std::pair<std::vector<BSONObj>, NamespaceString> findManyByUUID(
+        const std::string& db, UUID uuid, const std::vector<BSONElement>& ids) const override;
+
     void copyCollectionFromRemote(OperationContext* opCtx,
                                   const NamespaceString& nss) const override;
 
@@ -79,11 +90,20 @@ public:
 
     StatusWith<BSONObj> getCollectionInfo(const NamespaceString& nss) const override;
 
+    ~RollbackSourceImpl();
+
 private:
+    std::unique_ptr<DBClientConnection> _acquireRefetchConnection() const;
+    void _releaseRefetchConnection(std::unique_ptr<DBClientConnection> conn) const;
+
     GetConnectionFn _getConnection;
     HostAndPort _source;
     std::string _collectionName;
     OplogInterfaceRemote _oplog;
+
+    // Idle connections to the sync source used by findManyByUUID().
+    mutable stdx::mutex _refetchConnectionsMutex;
+    mutable std::vector<std::unique_ptr<DBClientConnection>> _refetchConnections;
 };
 
 
@@ -67,10 +67,13 @@
 #include "mongo/db/repl/replication_coordinator_impl.h"
 #include "mongo/db/repl/replication_process.h"
 #include "mongo/db/repl/roll_back_local_operations.h"
+#include "mongo/db/repl/rollback_refetch_progress.h"
 #include "mongo/db/repl/rollback_source.h"
 #include "mongo/db/repl/rslog.h"
 #include "mongo/db/s/shard_identity_rollback_notifier.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/session_catalog.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -248,8 +251,20 @@ Status rollback_internal::updateFixUpInfoFromLocalOplogEntry(FixUpInfo& fixUpInf
     NamespaceString nss = oplogEntry.getNamespace();
     auto uuid = oplogEntry.getUuid();
 
-    if (oplogEntry.getOpType() == OpTypeEnum::kNoop)
+    if (oplogEntry.getOpType() == OpTypeEnum::kNoop) {
+        // The pre-image of an update or delete is written to the oplog just before it, so if the
+        // operation is the oldest one on its document after the common point, the pre-image is the
+        // version of the document at the common point.
+        if (!isNestedApplyOpsCommand) {
+            auto preImageFor = fixUpInfo.pendingPreImages.find(oplogEntry.getOpTime());
+            if (preImageFor != fixUpInfo.pendingPreImages.end()) {
+                fixUpInfo.commonPointVersions[preImageFor->second] =
+                    oplogEntry.getObject().getOwned();
+                fixUpInfo.pendingPreImages.erase(preImageFor);
+            }
+        }
         return Status::OK();
+    }
 
     if (oplogEntry.getNamespace().isEmpty()) {
         throw RSFatalException(str::stream() << "Local op on rollback has no ns: "
@@ -575,6 +590,19 @@ Status rollback_internal::updateFixUpInfoFromLocalOplogEntry(FixUpInfo& fixUpInf
         throw RSFatalException(message);
     }
     fixUpInfo.docsToRefetch.insert(doc);
+
+    // We walk our oplog backwards, so the oldest operation on a document decides its version at
+    // the common point: none before an insert, and the pre-image recorded by an update or delete
+    // which stored one. Operations nested in applyOps are left to the refetch, since they may be
+    // missing their optimes and their inserts are applied as upserts.
+    fixUpInfo.commonPointVersions.erase(doc);
+    if (!isNestedApplyOpsCommand) {
+        if (oplogEntry.getOpType() == OpTypeEnum::kInsert) {
+            fixUpInfo.commonPointVersions.emplace(doc, BSONObj());
+        } else if (auto preImageOpTime = oplogEntry.getPreImageOpTime()) {
+            fixUpInfo.pendingPreImages.emplace(*preImageOpTime, doc);
+        }
+    }
     return Status::OK();
 }
 
@@ -965,6 +993,150 @@ Status _syncRollback(OperationContext* opCtx,
     return Status::OK();
 }
 
+// The number of documents of a collection refetched from the sync source by a single find.
+MONGO_EXPORT_SERVER_PARAMETER(rollbackRefetchBatchSize, int, 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 1 && newVal <= 100 * 1000) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "rollbackRefetchBatchSize must be between 1 and 100000, inclusive");
+    });
+
+// The number of threads refetching batches of documents from the sync source at once.
+MONGO_EXPORT_SERVER_PARAMETER(rollbackRefetchThreads, int, 4)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 1 && newVal <= 64) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "rollbackRefetchThreads must be between 1 and 64, inclusive");
+    });
+
+// Whether the documents whose version at the common point could be reconstructed from our own
+// oplog are restored to it, rather than refetched from the sync source.
+MONGO_EXPORT_SERVER_PARAMETER(rollbackRestoreDocumentsFromLocalOplog, bool, true);
+
+/**
+ * Documents of a single collection refetched from the sync source together.
+ */
+struct RefetchBatch {
+    RefetchBatch(UUID uuid, NamespaceString nss) : uuid(uuid), nss(std::move(nss)) {}
+
+    UUID uuid;
+    NamespaceString nss;
+    std::vector<const DocID*> docs;
+
+    // One per document, empty if the document does not exist on the sync source.
+    std::vector<BSONObj> goodVersions;
+
+    // The namespace of the collection on the sync source.
+    NamespaceString resNss;
+
+    // Set if the collection is a view or does not exist on the sync source.
+    bool skipped = false;
+};
+
+/**
+ * Refetches the batches from the sync source on up to rollbackRefetchThreads threads. Throws the
+ * first error other than the collection being a view or missing on the sync source, once every
+ * thread is done.
+ */
+void refetchBatches(OperationContext* opCtx,
+                    const RollbackSource& rollbackSource,
+                    unsigned long long sizeRestoredLocally,
+                    std::vector<RefetchBatch>* batches) {
+    auto progress = RollbackRefetchProgress::get(opCtx->getServiceContext());
+    AtomicUInt64 totalSize(sizeRestoredLocally);
+    AtomicWord<size_t> nextBatch(0);
+    AtomicWord<bool> failed(false);
+    stdx::mutex errorMutex;
+    std::exception_ptr error;
+
+    auto recordError = [&](std::exception_ptr e) {
+        stdx::lock_guard<stdx::mutex> lk(errorMutex);
+        if (!error) {
+            error = e;
+        }
+        failed.store(true);
+    };
+
+    auto fetchBatches = [&] {
+        while (!failed.load()) {
+            const size_t i = nextBatch.fetchAndAdd(1);
+            if (i >= batches->size()) {
+                return;
+            }
+            auto& batch = (*batches)[i];
+            try {
+                std::vector<BSONElement> ids;
+                for (auto doc : batch.docs) {
+                    ids.push_back(doc->_id);
+                }
+                LOG(2) << "Refetching " << ids.size() << " documents, collection: " << batch.nss
+                       << ", UUID: " << batch.uuid;
+                std::tie(batch.goodVersions, batch.resNss) =
+                    rollbackSource.findManyByUUID(batch.nss.db().toString(), batch.uuid, ids);
+                invariant(batch.goodVersions.size() == ids.size());
+
+                unsigned long long batchSize = 0;
+                for (const auto& good : batch.goodVersions) {
+                    batchSize += good.objsize();
+                }
+                progress->onBatchRefetched(ids.size(), batchSize);
+
+                // Checks that the total amount of data that needs to be refetched is at most
+                // 300 MB. We do not roll back more than 300 MB of documents in order to
+                // prevent out of memory errors from too much data being stored. See SERVER-23392.
+                if (totalSize.addAndFetch(batchSize) >= 300 * 1024 * 1024) {
+                    throw RSFatalException("replSet too much data to roll back.");
+                }
+            } catch (const DBException& ex) {
+                // If the collection turned into a view, we might get an error trying to
+                // refetch documents, but these errors should be ignored, as we'll be creating
+                // the view during oplog replay.
+                // Collection may be dropped on the sync source, in which case it will be dropped
+                // during oplog replay. So it is safe to ignore NamespaceNotFound errors while
+                // trying to refetch documents.
+                if (ex.code() == ErrorCodes::CommandNotSupportedOnView ||
+                    ex.code() == ErrorCodes::NamespaceNotFound) {
+                    batch.skipped = true;
+                    continue;
+                }
+
+                log() << "Rollback couldn't re-fetch " << batch.docs.size()
+                      << " documents from uuid: " << batch.uuid << ": " << redact(ex);
+                recordError(std::current_exception());
+            } catch (...) {
+                recordError(std::current_exception());
+            }
+        }
+    };
+
+    const auto numThreads =
+        std::min(static_cast<size_t>(rollbackRefetchThreads.load()), batches->size());
+    if (numThreads <= 1) {
+        fetchBatches();
+    } else {
+        log() << "Refetching " << batches->size() << " batches of documents on " << numThreads
+              << " threads";
+        std::vector<stdx::thread> threads;
+        for (size_t t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&fetchBatches, t] {
+                Client::initThread(str::stream() << "rollbackRefetcher-" << t);
+                fetchBatches();
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
 }  // namespace
 
 void rollback_internal::syncFixUp(OperationContext* opCtx,
@@ -972,76 +1144,76 @@ void rollback_internal::syncFixUp(OperationContext* opCtx,
                                   const RollbackSource& rollbackSource,
                                   ReplicationCoordinator* replCoord,
                                   ReplicationProcess* replicationProcess) {
-    unsigned long long totalSize = 0;
-
     // UUID -> doc id -> doc
     stdx::unordered_map<UUID, std::map<DocID, BSONObj>, UUID::Hash> goodVersions;
     auto& catalog = UUIDCatalog::get(opCtx);
 
-    // Fetches all the goodVersions of each document from the current sync source.
-    unsigned long long numFetched = 0;
-
     log() << "Starting refetching documents";
 
+    // Restores the documents whose version at the common point we know from our own oplog, and
+    // batches the others by collection to fetch their goodVersions from the current sync source.
+    // The transactions collection is always refetched, for the namespace check below.
+    const bool restoreLocally = rollbackRestoreDocumentsFromLocalOplog.load();
+    const size_t batchSize = rollbackRefetchBatchSize.load();
+    std::vector<RefetchBatch> batches;
+    unsigned long long numRestoredLocally = 0;
+    unsigned long long sizeRestoredLocally = 0;
     for (auto&& doc : fixUpInfo.docsToRefetch) {
         invariant(!doc._id.eoo());  // This is checked when we insert to the set.
 
         UUID uuid = doc.uuid;
-        NamespaceString nss = catalog.lookupNSSByUUID(uuid);
-
-        try {
-            LOG(2) << "Refetching document, collection: " << nss << ", UUID: " << uuid << ", "
-                   << redact(doc._id);
-            // TODO : Slow. Lots of round trips.
-            numFetched++;
-
-            BSONObj good;
-            NamespaceString resNss;
-            std::tie(good, resNss) =
-                rollbackSource.findOneByUUID(nss.db().toString(), uuid, doc._id.wrap());
-
-            // To prevent inconsistencies in the transactions collection, rollback fails if the UUID
-            // of the collection is different on the sync source than on the node rolling back,
-            // forcing an initial sync. This is detected if the returned namespace for a refetch of
-            // a transaction table document is not "config.transactions," which implies a rename or
-            // drop of the collection occured on either node.
-            if (uuid == fixUpInfo.transactionTableUUID &&
-                resNss != NamespaceString::kSessionTransactionsTableNamespace) {
-                throw RSFatalException(
-                    str::stream()
-                    << "A fetch on the transactions collection returned an unexpected namespace: "
-                    << resNss.ns()
-                    << ". The transactions collection cannot be correctly rolled back, a full "
-                       "resync is required.");
+        if (restoreLocally && uuid != fixUpInfo.transactionTableUUID) {
+            auto localVersion = fixUpInfo.commonPointVersions.find(doc);
+            if (localVersion != fixUpInfo.commonPointVersions.end()) {
+                goodVersions[uuid].insert(std::pair<DocID, BSONObj>(doc, localVersion->second));
+                numRestoredLocally++;
+                sizeRestoredLocally += localVersion->second.objsize();
+                continue;
             }
+        }
 
-            totalSize += good.objsize();
+        if (batches.empty() || batches.back().uuid != uuid ||
+            batches.back().docs.size() >= batchSize) {
+            batches.emplace_back(uuid, catalog.lookupNSSByUUID(uuid));
+        }
+        batches.back().docs.push_back(&doc);
+    }
 
-            // Checks that the total amount of data that needs to be refetched is at most
-            // 300 MB. We do not roll back more than 300 MB of documents in order to
-            // prevent out of memory errors from too much data being stored. See SERVER-23392.
-            if (totalSize >= 300 * 1024 * 1024) {
-                throw RSFatalException("replSet too much data to roll back.");
-            }
+    auto progress = RollbackRefetchProgress::get(opCtx->getServiceContext());
+    progress->start(fixUpInfo.docsToRefetch.size() - numRestoredLocally, numRestoredLocally);
+    ON_BLOCK_EXIT([&] { progress->finish(); });
 
-            // Note good might be empty, indicating we should delete it.
-            goodVersions[uuid].insert(std::pair<DocID, BSONObj>(doc, good));
-
-        } catch (const DBException& ex) {
-            // If the collection turned into a view, we might get an error trying to
-            // refetch documents, but these errors should be ignored, as we'll be creating
-            // the view during oplog replay.
-            // Collection may be dropped on the sync source, in which case it will be dropped during
-            // oplog replay. So it is safe to ignore NamespaceNotFound errors while trying to
-            // refetch documents.
-            if (ex.code() == ErrorCodes::CommandNotSupportedOnView ||
-                ex.code() == ErrorCodes::NamespaceNotFound)
-                continue;
+    log() << "Restored " << numRestoredLocally << " documents from our oplog, refetching "
+          << fixUpInfo.docsToRefetch.size() - numRestoredLocally << " documents in "
+          << batches.size() << " batches";
+
+    refetchBatches(opCtx, rollbackSource, sizeRestoredLocally, &batches);
+
+    for (const auto& batch : batches) {
+        if (batch.skipped) {
+            continue;
+        }
+
+        // To prevent inconsistencies in the transactions collection, rollback fails if the UUID
+        // of the collection is different on the sync source than on the node rolling back,
+        // forcing an initial sync. This is detected if the returned namespace for a refetch of
+        // a transaction table document is not "config.transactions," which implies a rename or
+        // drop of the collection occured on either node.
+        if (batch.uuid == fixUpInfo.transactionTableUUID &&
+            batch.resNss != NamespaceString::kSessionTransactionsTableNamespace) {
+            throw RSFatalException(
+                str::stream()
+                << "A fetch on the transactions collection returned an unexpected namespace: "
+                << batch.resNss.ns()
+                << ". The transactions collection cannot be correctly rolled back, a full "
+                   "resync is required.");
+        }
 
-            log() << "Rollback couldn't re-fetch from uuid: " << uuid << " _id: " << redact(doc._id)
-                  << ' ' << numFetched << '/' << fixUpInfo.docsToRefetch.size() << ": "
-                  << redact(ex);
-            throw;
+        // Note a good version might be empty, indicating we should delete it.
+        auto& goodVersionsByDocID = goodVersions[batch.uuid];
+        for (size_t i = 0; i < batch.docs.size(); ++i) {
+            goodVersionsByDocID.insert(
+                std::pair<DocID, BSONObj>(*batch.docs[i], batch.goodVersions[i]));
         }
     }
 
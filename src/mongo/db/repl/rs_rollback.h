@@ -251,6 +251,15 @@ struct FixUpInfo {
     // we only need to refetch it once.
     std::set<DocID> docsToRefetch;
 
+    // Versions of documents in docsToRefetch as of the common point which could be reconstructed
+    // from our own oplog, and need not be refetched from the sync source. An empty document means
+    // that the document did not exist at the common point.
+    std::map<DocID, BSONObj> commonPointVersions;
+
+    // OpTimes of the no-op oplog entries holding the pre-images of updates and deletes which were
+    // walked over before them, and the documents the pre-images belong to.
+    std::map<OpTime, DocID> pendingPreImages;
+
     // UUID of collections that need to be dropped.
     stdx::unordered_set<UUID, UUID::Hash> collectionsToDrop;
 
@@ -52,6 +52,7 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_interface.h"
 #include "mongo/db/repl/oplog_interface_mock.h"
+#include "mongo/db/repl/rollback_refetch_progress.h"
 #include "mongo/db/repl/rollback_source.h"
 #include "mongo/db/repl/rollback_test_fixture.h"
 #include "mongo/db/repl/rs_rollback.h"
@@ -470,6 +471,234 @@ TEST_F(RSRollbackTest, RollbackInsertDocumentWithNoId) {
     ASSERT_FALSE(rollbackSource.called);
 }
 
+TEST(RSRollbackTest, LocalOplogEntriesRecordDocumentVersionsAtCommonPoint) {
+    UUID uuid = UUID::gen();
+    auto makeCrudOp = [&](int secs, StringData opType, BSONObj o, BSONObj extra) {
+        BSONObjBuilder bob;
+        bob.append("ts", Timestamp(Seconds(secs), 0));
+        bob.append("t", 1LL);
+        bob.append("h", 1LL);
+        bob.append("op", opType);
+        uuid.appendToBuilder(&bob, "ui");
+        bob.append("ns", "test.t");
+        bob.append("o", o);
+        bob.appendElements(extra);
+        return bob.obj();
+    };
+    auto preImageOpTime = BSON("ts" << Timestamp(Seconds(3), 0) << "t" << 1LL);
+    auto version = [&](const FixUpInfo& fui, int id) -> boost::optional<BSONObj> {
+        auto obj = BSON("_id" << id);
+        auto it = fui.commonPointVersions.find(DocID(obj, obj.firstElement(), uuid));
+        if (it == fui.commonPointVersions.end()) {
+            return boost::none;
+        }
+        return it->second;
+    };
+
+    // Walking backwards from the newest operation: _id 1 is updated with a pre-image, _id 2 is
+    // inserted and _id 3 is updated without a pre-image.
+    FixUpInfo fui;
+    ASSERT_OK(updateFixUpInfoFromLocalOplogEntry(
+        fui,
+        makeCrudOp(6, "u", BSON("$set" << BSON("a" << 3)), BSON("o2" << BSON("_id" << 3))),
+        false));
+    ASSERT_OK(updateFixUpInfoFromLocalOplogEntry(
+        fui, makeCrudOp(5, "i", BSON("_id" << 2), BSONObj()), false));
+    ASSERT_OK(updateFixUpInfoFromLocalOplogEntry(
+        fui,
+        makeCrudOp(4,
+                   "u",
+                   BSON("$set" << BSON("a" << 2)),
+                   BSON("o2" << BSON("_id" << 1) << "preImageOpTime" << preImageOpTime)),
+        false));
+    ASSERT_EQ(1U, fui.pendingPreImages.size());
+    ASSERT_FALSE(version(fui, 1));
+    ASSERT_OK(updateFixUpInfoFromLocalOplogEntry(
+        fui, makeCrudOp(3, "n", BSON("_id" << 1 << "a" << 1), BSONObj()), false));
+    ASSERT_EQ(0U, fui.pendingPreImages.size());
+    ASSERT_EQ(3U, fui.docsToRefetch.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "a" << 1), *version(fui, 1));
+    ASSERT_BSONOBJ_EQ(BSONObj(), *version(fui, 2));
+    ASSERT_FALSE(version(fui, 3));
+
+    // An older update of _id 1 without a pre-image, nested in applyOps, makes its version unknown.
+    ASSERT_OK(updateFixUpInfoFromLocalOplogEntry(
+        fui,
+        makeCrudOp(2, "u", BSON("$set" << BSON("a" << 1)), BSON("o2" << BSON("_id" << 1))),
+        true));
+    ASSERT_FALSE(version(fui, 1));
+    ASSERT_BSONOBJ_EQ(BSONObj(), *version(fui, 2));
+}
+
+TEST_F(RSRollbackTest, RollbackRestoresDocumentsFromLocalOplogWithoutRefetchingThem) {
+    createOplog(_opCtx.get());
+    CollectionOptions options;
+    options.uuid = UUID::gen();
+    auto coll = _createCollection(_opCtx.get(), "test.t", options);
+    {
+        AutoGetCollection autoColl(_opCtx.get(), NamespaceString("test.t"), MODE_X);
+        WriteUnitOfWork wuow(_opCtx.get());
+        OpDebug* const nullOpDebug = nullptr;
+        for (const auto& doc : {BSON("_id" << 1 << "v" << 2),
+                                BSON("_id" << 2 << "v" << 2),
+                                BSON("_id" << 3 << "v" << 2)}) {
+            ASSERT_OK(autoColl.getCollection()->insertDocument(
+                _opCtx.get(), InsertStatement(doc), nullOpDebug, false));
+        }
+        wuow.commit();
+    }
+    const auto uuid = *options.uuid;
+
+    auto makeOperation = [&](int secs, StringData opType, BSONObj o, BSONObj extra) {
+        BSONObjBuilder bob;
+        bob.append("ts", Timestamp(Seconds(secs), 0));
+        bob.append("h", 1LL);
+        bob.append("op", opType);
+        uuid.appendToBuilder(&bob, "ui");
+        bob.append("ns", "test.t");
+        bob.append("o", o);
+        bob.appendElements(extra);
+        return std::make_pair(bob.obj(), RecordId(secs));
+    };
+    const auto commonOperation = makeOpAndRecordId(1, 1);
+    const auto preImageOperation =
+        makeOperation(2, "n", BSON("_id" << 1 << "v" << 1), BSONObj());
+    const auto updateOperation = makeOperation(
+        3,
+        "u",
+        BSON("$set" << BSON("v" << 2)),
+        BSON("o2" << BSON("_id" << 1) << "preImageOpTime"
+                  << BSON("ts" << Timestamp(Seconds(2), 0) << "t" << -1LL)));
+    const auto insertOperation = makeOperation(4, "i", BSON("_id" << 2 << "v" << 2), BSONObj());
+    const auto updateWithoutPreImageOperation = makeOperation(
+        5, "u", BSON("$set" << BSON("v" << 2)), BSON("o2" << BSON("_id" << 3)));
+
+    class RollbackSourceLocal : public RollbackSourceMock {
+    public:
+        using RollbackSourceMock::RollbackSourceMock;
+
+        std::pair<BSONObj, NamespaceString> findOneByUUID(const std::string& db,
+                                                          UUID uuid,
+                                                          const BSONObj& filter) const override {
+            searchedIds.push_back(filter.firstElement().numberInt());
+            return {BSON("_id" << 3 << "v" << 1), NamespaceString("test.t")};
+        }
+
+        mutable std::vector<int> searchedIds;
+    } rollbackSource(std::unique_ptr<OplogInterface>(new OplogInterfaceMock({commonOperation})));
+
+    ASSERT_OK(syncRollback(_opCtx.get(),
+                           OplogInterfaceMock({updateWithoutPreImageOperation,
+                                               insertOperation,
+                                               updateOperation,
+                                               preImageOperation,
+                                               commonOperation}),
+                           rollbackSource,
+                           {},
+                           _coordinator,
+                           _replicationProcess.get()));
+    ASSERT_EQ(1U, rollbackSource.searchedIds.size());
+    ASSERT_EQ(3, rollbackSource.searchedIds.front());
+
+    AutoGetCollectionForReadCommand acr(_opCtx.get(), NamespaceString("test.t"));
+    BSONObj result;
+    ASSERT(Helpers::findOne(_opCtx.get(), acr.getCollection(), BSON("_id" << 1), result));
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "v" << 1), result);
+    ASSERT_FALSE(Helpers::findOne(_opCtx.get(), acr.getCollection(), BSON("_id" << 2), result));
+    ASSERT(Helpers::findOne(_opCtx.get(), acr.getCollection(), BSON("_id" << 3), result));
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3 << "v" << 1), result);
+
+    BSONObjBuilder status;
+    RollbackRefetchProgress::get(_opCtx->getServiceContext())->append(&status);
+    auto progress = status.obj()["rollbackRefetch"].Obj();
+    ASSERT_FALSE(progress["active"].trueValue()) << progress;
+    ASSERT_EQ(1, progress["docsToRefetch"].numberLong()) << progress;
+    ASSERT_EQ(1, progress["docsRefetched"].numberLong()) << progress;
+    ASSERT_EQ(2, progress["docsRestoredLocally"].numberLong()) << progress;
+    ASSERT_EQ(1, progress["batchesRefetched"].numberLong()) << progress;
+}
+
+TEST_F(RSRollbackTest, RollbackRefetchesDocumentsOfEachCollectionInOneBatch) {
+    createOplog(_opCtx.get());
+    std::vector<UUID> uuids;
+    for (const auto& ns : {"test.a", "test.b"}) {
+        CollectionOptions options;
+        options.uuid = UUID::gen();
+        _createCollection(_opCtx.get(), ns, options);
+        uuids.push_back(*options.uuid);
+    }
+
+    const auto commonOperation = makeOpAndRecordId(1, 1);
+    OplogInterfaceMock::Operations operations;
+    int secs = 1;
+    for (const auto& ns : {"test.a", "test.b"}) {
+        const auto& uuid = uuids[operations.size() / 3];
+        for (int id = 0; id < 3; ++id) {
+            ++secs;
+            operations.push_front(
+                std::make_pair(BSON("ts" << Timestamp(Seconds(secs), 0) << "h" << 1LL << "op"
+                                         << "d"
+                                         << "ui"
+                                         << uuid
+                                         << "ns"
+                                         << ns
+                                         << "o"
+                                         << BSON("_id" << id)),
+                               RecordId(secs)));
+        }
+    }
+    operations.push_back(commonOperation);
+
+    // Returns the documents with an even _id, as if the others were deleted on the sync source.
+    class RollbackSourceLocal : public RollbackSourceMock {
+    public:
+        using RollbackSourceMock::RollbackSourceMock;
+
+        std::pair<BSONObj, NamespaceString> findOneByUUID(const std::string& db,
+                                                          UUID uuid,
+                                                          const BSONObj& filter) const override {
+            FAIL("Unexpected findOneByUUID request") << filter;
+            return {};
+        }
+
+        std::pair<std::vector<BSONObj>, NamespaceString> findManyByUUID(
+            const std::string& db, UUID uuid, const std::vector<BSONElement>& ids) const override {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            numIdsByUUID[uuid.toString()].push_back(ids.size());
+            std::vector<BSONObj> docs;
+            for (const auto& id : ids) {
+                docs.push_back(id.numberInt() % 2 == 0 ? BSON("_id" << id.numberInt() << "v" << 1)
+                                                       : BSONObj());
+            }
+            return {docs, NamespaceString()};
+        }
+
+        mutable stdx::mutex mutex;
+        mutable std::map<std::string, std::vector<size_t>> numIdsByUUID;
+    } rollbackSource(std::unique_ptr<OplogInterface>(new OplogInterfaceMock({commonOperation})));
+
+    ASSERT_OK(syncRollback(_opCtx.get(),
+                           OplogInterfaceMock(operations),
+                           rollbackSource,
+                           {},
+                           _coordinator,
+                           _replicationProcess.get()));
+    ASSERT_EQ(2U, rollbackSource.numIdsByUUID.size());
+    for (const auto& uuid : uuids) {
+        const auto& numIds = rollbackSource.numIdsByUUID[uuid.toString()];
+        ASSERT_EQ(1U, numIds.size());
+        ASSERT_EQ(3U, numIds.front());
+    }
+
+    for (const auto& ns : {"test.a", "test.b"}) {
+        AutoGetCollectionForReadCommand acr(_opCtx.get(), NamespaceString(ns));
+        ASSERT_EQ(2, acr.getCollection()->numRecords(_opCtx.get()));
+        BSONObj result;
+        ASSERT(Helpers::findOne(_opCtx.get(), acr.getCollection(), BSON("_id" << 2), result));
+        ASSERT_BSONOBJ_EQ(BSON("_id" << 2 << "v" << 1), result);
+    }
+}
+
 TEST_F(RSRollbackTest, RollbackCreateIndexCommand) {
     createOplog(_opCtx.get());
     CollectionOptions options;
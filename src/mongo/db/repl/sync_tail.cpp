@@ -33,6 +33,7 @@
 #include "mongo/db/repl/sync_tail.h"
 
 #include "third_party/murmurhash3/MurmurHash3.h"
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <memory>
 
@@ -75,6 +76,7 @@
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/storage/recovery_unit.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -136,6 +138,23 @@ public:
     }
 } exportedBatchLimitOperationsParam;
 
+// If true, the next batch is written to the oplog and partitioned among the writer threads while
+// the current batch is being applied. Only used with storage engines that support document level
+// locking, and with majority read concern enabled.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replPipelineBatchApplication, bool, false);
+
+// Writer vectors of at least twice this many ops, and twice the average number of ops per writer
+// thread, are split into chunks which idle writer threads can take over. Only used with storage
+// engines that support document level locking. A value of 0 disables the splitting.
+MONGO_EXPORT_SERVER_PARAMETER(replWriterMinOpsPerChunk, int, 64)
+    ->withValidator([](const int& newVal) {
+        if (newVal >= 0 && newVal <= 1000 * 1000) {
+            return Status::OK();
+        }
+        return Status(ErrorCodes::BadValue,
+                      "replWriterMinOpsPerChunk must be between 0 and 1 million, inclusive");
+    });
+
 // The oplog entries applied
 Counter64 opsAppliedStats;
 ServerStatusMetricField<Counter64> displayOpsApplied("repl.apply.ops", &opsAppliedStats);
@@ -149,6 +168,57 @@ ServerStatusMetricField<Counter64> displayAttemptsToBecomeSecondary(
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// Number of batches which were written to the oplog and partitioned while the batch before them
+// was being applied.
+Counter64 pipelinedBatchesStats;
+ServerStatusMetricField<Counter64> displayPipelinedBatches("repl.apply.pipelinedBatches",
+                                                           &pipelinedBatchesStats);
+
+// Time spent in each phase of applying a batch: waiting for the batch to be ready, writing it to
+// the oplog, partitioning it among the writer threads, and applying it on them. The journal flush
+// is waited for by ApplyBatchFinalizerForJournal, while the next batch is applied.
+TimerHistogramStats batchWaitLatencyStats;
+ServerStatusMetricField<TimerHistogramStats> displayBatchWaitLatency(
+    "repl.apply.latency.batchWait", &batchWaitLatencyStats);
+TimerHistogramStats oplogWriteLatencyStats;
+ServerStatusMetricField<TimerHistogramStats> displayOplogWriteLatency(
+    "repl.apply.latency.oplogWrite", &oplogWriteLatencyStats);
+TimerHistogramStats partitionLatencyStats;
+ServerStatusMetricField<TimerHistogramStats> displayPartitionLatency(
+    "repl.apply.latency.partition", &partitionLatencyStats);
+TimerHistogramStats writersLatencyStats;
+ServerStatusMetricField<TimerHistogramStats> displayWritersLatency("repl.apply.latency.writers",
+                                                                   &writersLatencyStats);
+TimerHistogramStats journalFlushLatencyStats;
+ServerStatusMetricField<TimerHistogramStats> displayJournalFlushLatency(
+    "repl.apply.latency.journalFlush", &journalFlushLatencyStats);
+
+// How evenly the ops of a batch were spread among the writer threads. The busiest writer thread
+// handled 'busiestWriterOps' of the 'ops' of the batches together, and more than half of the ops of
+// each 'serializedBatches' batch, which usually means that they wrote to a single document or
+// capped collection. 'writerSkew' is the time the slowest writer thread took longer than the
+// average one.
+Counter64 writerOpsStats;
+ServerStatusMetricField<Counter64> displayWriterOps("repl.apply.writers.ops", &writerOpsStats);
+Counter64 busiestWriterOpsStats;
+ServerStatusMetricField<Counter64> displayBusiestWriterOps("repl.apply.writers.busiestWriterOps",
+                                                           &busiestWriterOpsStats);
+Counter64 serializedBatchesStats;
+ServerStatusMetricField<Counter64> displaySerializedBatches("repl.apply.writers.serializedBatches",
+                                                            &serializedBatchesStats);
+TimerHistogramStats writerSkewStats;
+ServerStatusMetricField<TimerHistogramStats> displayWriterSkew("repl.apply.writers.skew",
+                                                               &writerSkewStats);
+
+// Number of writer vectors which were split for idle writer threads to take over, and number of
+// chunks they were split into.
+Counter64 splitWriterVectorsStats;
+ServerStatusMetricField<Counter64> displaySplitWriterVectors(
+    "repl.apply.writers.splitWriterVectors", &splitWriterVectorsStats);
+Counter64 splitChunksStats;
+ServerStatusMetricField<Counter64> displaySplitChunks("repl.apply.writers.splitChunks",
+                                                      &splitChunksStats);
+
 class ApplyBatchFinalizer {
 public:
     ApplyBatchFinalizer(ReplicationCoordinator* replCoord) : _replCoord(replCoord) {}
@@ -247,7 +317,9 @@ void ApplyBatchFinalizerForJournal::_run() {
         }
 
         auto opCtx = cc().makeOperationContext();
+        Timer timer;
         opCtx->recoveryUnit()->waitUntilDurable();
+        journalFlushLatencyStats.record(timer);
         _recordDurable(latestOpTime);
     }
 }
@@ -267,6 +339,23 @@ NamespaceString parseUUIDOrNs(OperationContext* opCtx, const OplogEntry& oplogEn
     return nss;
 }
 
+std::unique_ptr<ThreadPool> makeReplWorkerPool(const std::string& name, int threadCount) {
+    ThreadPool::Options options;
+    options.threadNamePrefix = name + " ";
+    options.poolName = name + " Pool";
+    options.maxThreads = options.minThreads = static_cast<size_t>(threadCount);
+    options.onCreateThread = [](const std::string&) {
+        // Only do this once per thread
+        if (!Client::getCurrent()) {
+            Client::initThreadIfNotAlready();
+            AuthorizationSession::get(cc())->grantInternalAuthorization();
+        }
+    };
+    auto pool = stdx::make_unique<ThreadPool>(options);
+    pool->startup();
+    return pool;
+}
+
 NamespaceStringOrUUID getNsOrUUID(const NamespaceString& nss, const BSONObj& op) {
     if (auto ui = op["ui"]) {
         return {nss.db().toString(), uassertStatusOK(UUID::parse(ui))};
@@ -289,20 +378,7 @@ std::unique_ptr<ThreadPool> SyncTail::makeWriterPool() {
 }
 
 std::unique_ptr<ThreadPool> SyncTail::makeWriterPool(int threadCount) {
-    ThreadPool::Options options;
-    options.threadNamePrefix = "repl writer worker ";
-    options.poolName = "repl writer worker Pool";
-    options.maxThreads = options.minThreads = static_cast<size_t>(threadCount);
-    options.onCreateThread = [](const std::string&) {
-        // Only do this once per thread
-        if (!Client::getCurrent()) {
-            Client::initThreadIfNotAlready();
-            AuthorizationSession::get(cc())->grantInternalAuthorization();
-        }
-    };
-    auto pool = stdx::make_unique<ThreadPool>(options);
-    pool->startup();
-    return pool;
+    return makeReplWorkerPool("repl writer worker", threadCount);
 }
 
 // static
@@ -457,29 +533,79 @@ void prefetchOps(const MultiApplier::Operations& ops, ThreadPool* prefetcherPool
     prefetcherPool->waitForIdle();
 }
 
-// Doles out all the work to the writer pool threads.
-// Does not modify writerVectors, but passes non-const pointers to inner vectors into func.
-void applyOps(std::vector<MultiApplier::OperationPtrs>& writerVectors,
+// Doles out the chunks of a batch to writerMicros->size() threads of the writer pool, each of which
+// applies the chunks it claims, longest first, until none are left. A thread done with its chunks
+// early thus takes over the chunks a busy one would otherwise have applied after its own.
+// Does not modify chunks, but passes non-const pointers to them into func.
+// Records in writerMicros the time each writer thread took to apply its chunks.
+void applyOps(std::vector<MultiApplier::OperationPtrs>& chunks,
               ThreadPool* writerPool,
               const SyncTail::MultiSyncApplyFunc& func,
               SyncTail* st,
               std::vector<Status>* statusVector,
-              std::vector<WorkerMultikeyPathInfo>* workerMultikeyPathInfo) {
-    invariant(writerVectors.size() == statusVector->size());
-    for (size_t i = 0; i < writerVectors.size(); i++) {
-        if (!writerVectors[i].empty()) {
-            invariant(writerPool->schedule([
-                &func,
-                st,
-                &writer = writerVectors.at(i),
-                &status = statusVector->at(i),
-                &workerMultikeyPathInfo = workerMultikeyPathInfo->at(i)
-            ] {
+              std::vector<WorkerMultikeyPathInfo>* workerMultikeyPathInfo,
+              std::vector<long long>* writerMicros) {
+    invariant(chunks.size() == statusVector->size());
+    invariant(chunks.size() == workerMultikeyPathInfo->size());
+    invariant(chunks.size() >= writerMicros->size());
+    auto nextChunk = std::make_shared<AtomicWord<unsigned long long>>(0);
+    for (size_t i = 0; i < writerMicros->size(); i++) {
+        invariant(writerPool->schedule([
+            &func,
+            &chunks,
+            st,
+            statusVector,
+            workerMultikeyPathInfo,
+            writerMicros,
+            nextChunk,
+            i
+        ] {
+            Timer timer;
+            for (size_t chunk; (chunk = nextChunk->fetchAndAdd(1)) < chunks.size();) {
                 auto opCtx = cc().makeOperationContext();
-                status = func(opCtx.get(), &writer, st, &workerMultikeyPathInfo);
-            }));
+                statusVector->at(chunk) =
+                    func(opCtx.get(), &chunks[chunk], st, &workerMultikeyPathInfo->at(chunk));
+            }
+            writerMicros->at(i) = timer.micros();
+        }));
+    }
+}
+
+// Records how evenly the ops of a batch were spread among the writer vectors, and how long the
+// slowest writer thread took compared with the average one, given the time each of them took.
+void recordWriterSkew(const std::vector<MultiApplier::OperationPtrs>& writerVectors,
+                      const std::vector<long long>& writerMicros) {
+    size_t numOps = 0;
+    size_t busiestWriter = 0;
+    for (size_t i = 0; i < writerVectors.size(); i++) {
+        numOps += writerVectors[i].size();
+        if (writerVectors[i].size() > writerVectors[busiestWriter].size()) {
+            busiestWriter = i;
         }
     }
+    if (numOps == 0 || writerMicros.empty()) {
+        return;
+    }
+
+    long long totalMicros = 0;
+    long long slowestMicros = 0;
+    for (auto micros : writerMicros) {
+        totalMicros += micros;
+        slowestMicros = std::max(slowestMicros, micros);
+    }
+
+    const auto busiestWriterOps = writerVectors[busiestWriter].size();
+    writerOpsStats.increment(numOps);
+    busiestWriterOpsStats.increment(busiestWriterOps);
+    writerSkewStats.recordMicros(slowestMicros - totalMicros / writerMicros.size());
+
+    // A batch of a single op, or of a few ops on a pool of a few threads, can't be spread.
+    if (busiestWriterOps * 2 > numOps && numOps >= writerVectors.size() * 2) {
+        serializedBatchesStats.increment();
+        LOG(1) << "Writer vector " << busiestWriter << " held " << busiestWriterOps << " of the "
+               << numOps << " ops of a batch, starting with an op on "
+               << writerVectors[busiestWriter].front()->getNamespace();
+    }
 }
 
 // Schedules the writes to the oplog for 'ops' into threadPool. The caller must guarantee that 'ops'
@@ -588,9 +714,165 @@ private:
     StringMap<CollectionProperties> _cache;
 };
 
+/**
+ * Returns the hash which decides the writer thread of 'op'. Marks inserts into capped collections,
+ * which is the only change made to 'op'.
+ */
+uint32_t hashOp(OperationContext* opCtx,
+                CachedCollectionProperties* collPropertiesCache,
+                bool supportsDocLocking,
+                OplogEntry* op) {
+    StringMapTraits::HashedKey hashedNs(op->getNamespace().ns());
+    uint32_t hash = hashedNs.hash();
+
+    if (op->isCrudOpType()) {
+        auto collProperties = collPropertiesCache->getCollectionProperties(opCtx, hashedNs);
+
+        // For doc locking engines, include the _id of the document in the hash so we get
+        // parallelism even if all writes are to a single collection.
+        //
+        // For capped collections, this is illegal, since capped collections must preserve
+        // insertion order.
+        if (supportsDocLocking && !collProperties.isCapped) {
+            BSONElement id = op->getIdElement();
+            BSONElementComparator elementHasher(BSONElementComparator::FieldNamesMode::kIgnore,
+                                                collProperties.collator);
+            const size_t idHash = elementHasher.hash(id);
+            MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+        }
+
+        if (op->getOpType() == OpTypeEnum::kInsert && collProperties.isCapped) {
+            // Mark capped collection ops before storing them to ensure we do not attempt to
+            // bulk insert them.
+            op->isForCappedCollection = true;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * Hashes the ops of a batch in ranges, which the thread partitioning the batch and the threads of
+ * a pool claim one at a time. The batch is hashed once every range is, whether or not all the
+ * tasks scheduled on the pool have run, so the pool may be busy with other work.
+ */
+class BatchHasher {
+    MONGO_DISALLOW_COPYING(BatchHasher);
+
+public:
+    // Number of ops in each range. Small enough that a batch of the default size spreads across
+    // the writer threads, large enough to amortize the collection lookups of each range.
+    static const size_t kOpsPerRange = 128;
+
+    BatchHasher(MultiApplier::Operations* ops, bool supportsDocLocking)
+        : _ops(ops),
+          _supportsDocLocking(supportsDocLocking),
+          _hashes(ops->size()),
+          _numRanges((ops->size() + kOpsPerRange - 1) / kOpsPerRange) {}
+
+    size_t numRanges() const {
+        return _numRanges;
+    }
+
+    /**
+     * Hashes ranges until none are left to claim.
+     */
+    void hashRanges(OperationContext* opCtx) {
+        CachedCollectionProperties collPropertiesCache;
+        for (size_t range; (range = _nextRange.fetchAndAdd(1)) < _numRanges;) {
+            Status status = Status::OK();
+            try {
+                const size_t end = std::min(_ops->size(), (range + 1) * kOpsPerRange);
+                for (size_t i = range * kOpsPerRange; i < end; i++) {
+                    _hashes[i] =
+                        hashOp(opCtx, &collPropertiesCache, _supportsDocLocking, &(*_ops)[i]);
+                }
+            } catch (...) {
+                status = exceptionToStatus();
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (_status.isOK()) {
+                _status = status;
+            }
+            if (++_numRangesHashed == _numRanges) {
+                _allRangesHashed.notify_all();
+            }
+        }
+    }
+
+    /**
+     * Returns true if there are ranges left for another thread to claim. Lets the tasks which only
+     * run once the batch is hashed return without setting anything up.
+     */
+    bool hasRangesLeft() {
+        return _nextRange.load() < _numRanges;
+    }
+
+    /**
+     * Waits until every range is hashed and returns the hash of each op, throwing the first error
+     * met while hashing.
+     */
+    std::vector<uint32_t> waitForHashes() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _allRangesHashed.wait(lk, [&] { return _numRangesHashed == _numRanges; });
+        uassertStatusOK(_status);
+        return std::move(_hashes);
+    }
+
+private:
+    MultiApplier::Operations* const _ops;
+    const bool _supportsDocLocking;
+
+    // Each entry is written by the thread which claimed its range.
+    std::vector<uint32_t> _hashes;
+
+    const size_t _numRanges;
+    AtomicWord<unsigned long long> _nextRange{0};
+
+    stdx::mutex _mutex;  // Guards the members below.
+    stdx::condition_variable _allRangesHashed;
+    size_t _numRangesHashed = 0;
+    Status _status = Status::OK();
+};
+
+/**
+ * Returns the hash of each op in 'ops', hashing ranges of them on the threads of 'hashPool' as
+ * well as on the current thread. See hashOp().
+ */
+std::vector<uint32_t> hashOps(OperationContext* opCtx,
+                              ThreadPool* hashPool,
+                              MultiApplier::Operations* ops) {
+    const bool supportsDocLocking =
+        opCtx->getServiceContext()->getStorageEngine()->supportsDocLocking();
+    auto hasher = std::make_shared<BatchHasher>(ops, supportsDocLocking);
+
+    const size_t numHelpers = hashPool && hasher->numRanges() > 1
+        ? std::min(hasher->numRanges(), size_t(hashPool->getStats().numThreads)) - 1
+        : 0;
+    for (size_t i = 0; i < numHelpers; i++) {
+        invariant(hashPool->schedule([hasher] {
+            if (!hasher->hasRangesLeft()) {
+                return;
+            }
+            auto opCtx = cc().makeOperationContext();
+
+            // The thread applying the batch may be holding the ParallelBatchWriterMode lock.
+            ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
+                opCtx->lockState());
+            hasher->hashRanges(opCtx.get());
+        }));
+    }
+
+    hasher->hashRanges(opCtx);
+    return hasher->waitForHashes();
+}
+
 /**
  * ops - This only modifies the isForCappedCollection field on each op. It does not alter the ops
  *      vector in any other way.
+ * opHashes - If provided, the hash of each op in 'ops', as returned by hashOp(). Otherwise the ops
+ *      are hashed here.
  * writerVectors - Set of operations for each worker thread to apply.
  * derivedOps - If provided, this function inserts a decomposition of applyOps operations
  *      and instructions for updating the transactions table.
@@ -598,6 +880,7 @@ private:
  */
 void fillWriterVectors(OperationContext* opCtx,
                        MultiApplier::Operations* ops,
+                       const std::vector<uint32_t>* opHashes,
                        std::vector<MultiApplier::OperationPtrs>* writerVectors,
                        std::vector<MultiApplier::Operations>* derivedOps,
                        SessionUpdateTracker* sessionUpdateTracker) {
@@ -609,39 +892,19 @@ void fillWriterVectors(OperationContext* opCtx,
 
     CachedCollectionProperties collPropertiesCache;
 
-    for (auto&& op : *ops) {
-        StringMapTraits::HashedKey hashedNs(op.getNamespace().ns());
-        uint32_t hash = hashedNs.hash();
+    for (size_t i = 0; i < ops->size(); i++) {
+        auto& op = (*ops)[i];
+        const uint32_t hash = opHashes
+            ? (*opHashes)[i]
+            : hashOp(opCtx, &collPropertiesCache, supportsDocLocking, &op);
 
         // We need to track all types of ops, including type 'n' (these are generated from chunk
         // migrations).
         if (sessionUpdateTracker) {
             if (auto newOplogWrites = sessionUpdateTracker->updateOrFlush(op)) {
                 derivedOps->emplace_back(std::move(*newOplogWrites));
-                fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
-            }
-        }
-
-        if (op.isCrudOpType()) {
-            auto collProperties = collPropertiesCache.getCollectionProperties(opCtx, hashedNs);
-
-            // For doc locking engines, include the _id of the document in the hash so we get
-            // parallelism even if all writes are to a single collection.
-            //
-            // For capped collections, this is illegal, since capped collections must preserve
-            // insertion order.
-            if (supportsDocLocking && !collProperties.isCapped) {
-                BSONElement id = op.getIdElement();
-                BSONElementComparator elementHasher(BSONElementComparator::FieldNamesMode::kIgnore,
-                                                    collProperties.collator);
-                const size_t idHash = elementHasher.hash(id);
-                MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
-            }
-
-            if (op.getOpType() == OpTypeEnum::kInsert && collProperties.isCapped) {
-                // Mark capped collection ops before storing them to ensure we do not attempt to
-                // bulk insert them.
-                op.isForCappedCollection = true;
+                fillWriterVectors(
+                    opCtx, &derivedOps->back(), nullptr, writerVectors, derivedOps, nullptr);
             }
         }
 
@@ -650,8 +913,12 @@ void fillWriterVectors(OperationContext* opCtx,
         if (op.isCommand() && op.getCommandType() == OplogEntry::CommandType::kApplyOps) {
             try {
                 derivedOps->emplace_back(ApplyOps::extractOperations(op));
-                fillWriterVectors(
-                    opCtx, &derivedOps->back(), writerVectors, derivedOps, sessionUpdateTracker);
+                fillWriterVectors(opCtx,
+                                  &derivedOps->back(),
+                                  nullptr,
+                                  writerVectors,
+                                  derivedOps,
+                                  sessionUpdateTracker);
             } catch (...) {
                 fassertFailedWithStatusNoTrace(
                     50711,
@@ -666,22 +933,111 @@ void fillWriterVectors(OperationContext* opCtx,
         if (writer.empty()) {
             writer.reserve(8);  // Skip a few growth rounds
         }
+        op.writerHash = hash;
         writer.push_back(&op);
     }
 }
 
+}  // namespace
+
 void fillWriterVectors(OperationContext* opCtx,
+                       ThreadPool* hashPool,
                        MultiApplier::Operations* ops,
                        std::vector<MultiApplier::OperationPtrs>* writerVectors,
                        std::vector<MultiApplier::Operations>* derivedOps) {
+    // Hashing is most of the work, and is independent for each op. Assigning the ops to writers in
+    // the order of the batch, expanding applyOps and tracking sessions along the way, is left to
+    // this thread.
+    const auto opHashes = hashOps(opCtx, hashPool, ops);
+
     SessionUpdateTracker sessionUpdateTracker;
-    fillWriterVectors(opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker);
+    fillWriterVectors(opCtx, ops, &opHashes, writerVectors, derivedOps, &sessionUpdateTracker);
 
     auto newOplogWrites = sessionUpdateTracker.flushAll();
     if (!newOplogWrites.empty()) {
         derivedOps->emplace_back(std::move(newOplogWrites));
-        fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+        fillWriterVectors(opCtx, &derivedOps->back(), nullptr, writerVectors, derivedOps, nullptr);
+    }
+}
+
+std::vector<MultiApplier::OperationPtrs> splitWriterVectors(
+    const std::vector<MultiApplier::OperationPtrs>& writerVectors, size_t minOpsPerChunk) {
+    size_t numOps = 0;
+    for (auto&& writer : writerVectors) {
+        numOps += writer.size();
     }
+    const size_t opsPerChunk =
+        std::max(minOpsPerChunk, (numOps + writerVectors.size() - 1) / writerVectors.size());
+
+    std::vector<MultiApplier::OperationPtrs> chunks;
+    for (auto&& writer : writerVectors) {
+        if (writer.empty()) {
+            continue;
+        }
+        if (minOpsPerChunk == 0 || writer.size() < 2 * opsPerChunk) {
+            chunks.push_back(writer);
+            continue;
+        }
+
+        // Counts the ops of the writer vector with each hash. Ops with different hashes only share
+        // the writer vector because of the modulo, so each group may go to a different chunk.
+        stdx::unordered_map<uint32_t, size_t> groupOfHash;
+        std::vector<size_t> groupSizes;
+        for (auto&& op : writer) {
+            const auto group = groupOfHash.emplace(op->writerHash, groupSizes.size());
+            if (group.second) {
+                groupSizes.push_back(0);
+            }
+            ++groupSizes[group.first->second];
+        }
+
+        // Assigns the groups to chunks. A single group larger than a chunk, such as the ops on one
+        // capped collection, stays whole.
+        std::vector<size_t> chunkOfGroup(groupSizes.size());
+        size_t numChunks = 0;
+        size_t chunkSize = 0;
+        for (size_t group = 0; group < groupSizes.size(); ++group) {
+            chunkOfGroup[group] = numChunks;
+            chunkSize += groupSizes[group];
+            if (chunkSize >= opsPerChunk) {
+                ++numChunks;
+                chunkSize = 0;
+            }
+        }
+        if (chunkSize > 0) {
+            ++numChunks;
+        }
+
+        // Fills the chunks in the order of the writer vector rather than group after group, so
+        // that the ops of a chunk on one namespace stay in the order of the batch, which grouped
+        // inserts rely on.
+        const size_t numChunksBefore = chunks.size();
+        chunks.resize(numChunksBefore + numChunks);
+        for (auto&& op : writer) {
+            chunks[numChunksBefore + chunkOfGroup[groupOfHash[op->writerHash]]].push_back(op);
+        }
+        if (numChunks > 1) {
+            splitWriterVectorsStats.increment();
+            splitChunksStats.increment(numChunks);
+        }
+    }
+
+    // The longest chunks are claimed first, so that the shortest ones fill in at the end.
+    std::stable_sort(chunks.begin(), chunks.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.size() > rhs.size();
+    });
+    return chunks;
+}
+
+namespace {
+
+/**
+ * Returns true if applying 'ops' may change the collection properties which fillWriterVectors()
+ * partitions by, so that the batch after them must not be partitioned until they are applied.
+ */
+bool mayChangeCollectionProperties(const MultiApplier::Operations& ops) {
+    return std::any_of(
+        ops.begin(), ops.end(), [](const OplogEntry& op) { return op.isCommand(); });
 }
 
 }  // namespace
@@ -834,6 +1190,130 @@ private:
     stdx::thread _thread;  // Must be last so all other members are initialized before starting.
 };
 
+/**
+ * Takes the batches of an OpQueueBatcher and prepares them on a thread of its own, so that the
+ * next batch is written to the oplog and partitioned while the current one is being applied.
+ */
+class SyncTail::OpQueuePreparer {
+    MONGO_DISALLOW_COPYING(OpQueuePreparer);
+
+public:
+    OpQueuePreparer(SyncTail* syncTail, OpQueueBatcher* batcher)
+        : _syncTail(syncTail),
+          _batcher(batcher),
+          // The oplog writes of a batch compete with the writer threads applying the batch before
+          // it, so they get a fraction of the threads.
+          _oplogWriterPool(
+              makeReplWorkerPool("repl oplog writer", std::max(1, replWriterThreadCount / 4))),
+          _thread([this] { run(); }) {}
+    ~OpQueuePreparer() {
+        invariant(_isDead);
+        _thread.join();
+        _oplogWriterPool->shutdown();
+        _oplogWriterPool->join();
+    }
+
+    /**
+     * Like OpQueueBatcher::getNextBatch(), except that past 'maxWaitTime' it keeps waiting until
+     * the batcher has come up empty, rather than return while a batch is being prepared. An empty
+     * batch therefore means that no batch taken from the oplog buffer is still to be applied.
+     */
+    PreparedBatch getNextBatch(Seconds maxWaitTime) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        const auto emptyBatches = _emptyBatches;
+        if (!_cv.wait_for(lk, maxWaitTime.toSystemDuration(), [&] { return _ready; })) {
+            _cv.wait(lk, [&] { return _ready || _emptyBatches != emptyBatches; });
+        }
+        if (!_ready) {
+            return PreparedBatch();
+        }
+
+        PreparedBatch batch = std::move(_batch);
+        _batch = PreparedBatch();
+        _ready = false;
+        _applying = true;
+        _cv.notify_all();
+
+        return batch;
+    }
+
+    /**
+     * Called after each batch returned by getNextBatch() has been applied.
+     */
+    void onBatchApplied() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _applying = false;
+        _awaitingApplication = false;
+        _cv.notify_all();
+    }
+
+private:
+    void run() {
+        Client::initThread("ReplBatchPreparer");
+
+        while (true) {
+            {
+                // Only start on the next batch once the previous one has been taken, and once the
+                // collection properties it depends on can no longer be changed by a command in the
+                // batch being applied.
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                _cv.wait(lk, [&] { return !_ready && !_awaitingApplication; });
+            }
+
+            PreparedBatch batch(_batcher->getNextBatch(Seconds(1)));
+            if (!batch.ops.empty()) {
+                // Use a new operation context for each batch, as the applier does.
+                auto opCtx = cc().makeOperationContext();
+
+                // The batch being applied holds the ParallelBatchWriterMode lock.
+                ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
+                    opCtx->lockState());
+                _syncTail->_prepareBatch(opCtx.get(), _oplogWriterPool.get(), &batch);
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (batch.ops.empty() && !batch.mustShutdown) {
+                _emptyBatches++;
+                _cv.notify_all();
+                continue;  // Don't emit empty batches.
+            }
+
+            if (_applying && !batch.ops.empty()) {
+                pipelinedBatchesStats.increment();
+            }
+            _awaitingApplication = mayChangeCollectionProperties(batch.ops);
+            _batch = std::move(batch);
+            _ready = true;
+            _cv.notify_all();
+            if (_batch.mustShutdown) {
+                _isDead = true;
+                return;
+            }
+        }
+    }
+
+    SyncTail* const _syncTail;
+    OpQueueBatcher* const _batcher;
+    const std::unique_ptr<ThreadPool> _oplogWriterPool;
+
+    stdx::mutex _mutex;  // Guards the members below.
+    stdx::condition_variable _cv;
+    PreparedBatch _batch;
+    bool _ready = false;     // Set while '_batch' waits to be taken.
+    bool _applying = false;  // Set while a batch handed out is being applied.
+
+    // Number of times the batcher had no batch to prepare.
+    uint64_t _emptyBatches = 0;
+
+    // Set from handing out a batch that may change collection properties until it is applied.
+    bool _awaitingApplication = false;
+
+    // This only exists so the destructor invariants rather than deadlocking.
+    bool _isDead = false;
+
+    stdx::thread _thread;  // Must be last so all other members are initialized before starting.
+};
+
 void SyncTail::oplogApplication(OplogBuffer* oplogBuffer, ReplicationCoordinator* replCoord) {
     if (isMMAPV1()) {
         // Overwrite prefetch index mode if ReplSettings has a mode set.
@@ -849,12 +1329,26 @@ void SyncTail::oplogApplication(OplogBuffer* oplogBuffer, ReplicationCoordinator
 
     OpQueueBatcher batcher(this, _storageInterface, oplogBuffer);
 
-    _oplogApplication(oplogBuffer, replCoord, &batcher);
+    // A prepared batch is written to the oplog before the batch ahead of it is applied. Storage
+    // engines without document level locking cannot write to the oplog while a batch is applied,
+    // and without majority read concern the oldest timestamp is only pinned by the batch being
+    // applied, and could move past the next batch.
+    if (replPipelineBatchApplication &&
+        getGlobalServiceContext()->getStorageEngine()->supportsDocLocking() &&
+        serverGlobalParams.enableMajorityReadConcern) {
+        log() << "Pipelining oplog batch preparation with batch application";
+        OpQueuePreparer preparer(this, &batcher);
+        _oplogApplication(oplogBuffer, replCoord, &batcher, &preparer);
+        return;
+    }
+
+    _oplogApplication(oplogBuffer, replCoord, &batcher, nullptr);
 }
 
 void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
                                  ReplicationCoordinator* replCoord,
-                                 OpQueueBatcher* batcher) noexcept {
+                                 OpQueueBatcher* batcher,
+                                 OpQueuePreparer* preparer) noexcept {
     std::unique_ptr<ApplyBatchFinalizer> finalizer{
         getGlobalServiceContext()->getStorageEngine()->isDurable()
             ? new ApplyBatchFinalizerForJournal(replCoord)
@@ -893,9 +1387,11 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
         long long termWhenBufferIsEmpty = replCoord->getTerm();
         // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
         // ready in time, we'll loop again so we can do the above checks periodically.
-        OpQueue ops = batcher->getNextBatch(Seconds(1));
-        if (ops.empty()) {
-            if (ops.mustShutdown()) {
+        Timer batchWaitTimer;
+        PreparedBatch batch = preparer ? preparer->getNextBatch(Seconds(1))
+                                       : PreparedBatch(batcher->getNextBatch(Seconds(1)));
+        if (batch.ops.empty()) {
+            if (batch.mustShutdown) {
                 // Shut down and exit oplog application loop.
                 return;
             }
@@ -906,10 +1402,11 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
             replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
             continue;  // Try again.
         }
+        batchWaitLatencyStats.record(batchWaitTimer);
 
         // Extract some info from ops that we'll need after releasing the batch below.
-        const auto firstOpTimeInBatch = ops.front().getOpTime();
-        const auto lastOpTimeInBatch = ops.back().getOpTime();
+        const auto firstOpTimeInBatch = batch.ops.front().getOpTime();
+        const auto lastOpTimeInBatch = batch.ops.back().getOpTime();
         const auto lastAppliedOpTimeAtStartOfBatch = replCoord->getMyLastAppliedOpTime();
 
         // Make sure the oplog doesn't go back in time or repeat an entry.
@@ -928,9 +1425,11 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
 
         // Apply the operations in this batch. 'multiApply' returns the optime of the last op that
         // was applied, which should be the last optime in the batch.
-        auto lastOpTimeAppliedInBatch =
-            fassertNoTrace(34437, multiApply(&opCtx, ops.releaseBatch()));
+        auto lastOpTimeAppliedInBatch = fassertNoTrace(34437, _applyBatch(&opCtx, &batch));
         invariant(lastOpTimeAppliedInBatch == lastOpTimeInBatch);
+        if (preparer) {
+            preparer->onBatchApplied();
+        }
 
         // In order to provide resilience in the event of a crash in the middle of batch
         // application, 'multiApply' will update 'minValid' so that it is at least as great as the
@@ -1266,6 +1765,7 @@ Status multiSyncApply(OperationContext* opCtx,
         : OplogApplication::Mode::kSecondary;
 
     ApplierHelpers::InsertGroup insertGroup(ops, opCtx, oplogApplicationMode);
+    ApplierHelpers::CommitGroup commitGroup(ops, opCtx, oplogApplicationMode);
 
     {  // Ensure that the MultikeyPathTracker stops tracking paths.
         ON_BLOCK_EXIT([opCtx] { MultikeyPathTracker::get(opCtx).stopTrackingMultikeyPathInfo(); });
@@ -1282,6 +1782,14 @@ Status multiSyncApply(OperationContext* opCtx,
                 continue;
             }
 
+            // Otherwise, try to apply the op along with the following ones in a single storage
+            // transaction.
+            auto commitGroupResult = commitGroup.groupAndApplyOps(it);
+            if (commitGroupResult.isOK()) {
+                it = commitGroupResult.getValue();
+                continue;
+            }
+
             // If we didn't create a group, try to apply the op individually.
             try {
                 const Status status = SyncTail::syncApply(opCtx, entry.raw, oplogApplicationMode);
@@ -1376,7 +1884,57 @@ Status multiInitialSyncApply(OperationContext* opCtx,
     return Status::OK();
 }
 
+void SyncTail::_prepareBatch(OperationContext* opCtx,
+                             ThreadPool* oplogWriterPool,
+                             PreparedBatch* batch) {
+    invariant(!batch->prepared);
+    const auto& ops = batch->ops;
+
+    // We must wait for the all work we've dispatched to complete before leaving this function
+    // because the spawned threads refer to 'ops'.
+    ON_BLOCK_EXIT([&] { oplogWriterPool->waitForIdle(); });
+
+    // Write batch of ops into oplog.
+    Timer oplogWriteTimer;
+    if (!_options.skipWritesToOplog) {
+        _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, ops.front().getTimestamp());
+        scheduleWritesToOplog(opCtx, _storageInterface, oplogWriterPool, ops);
+    }
+
+    Timer partitionTimer;
+    batch->writerVectors.resize(_writerPool->getStats().numThreads);
+    fillWriterVectors(
+        opCtx, oplogWriterPool, &batch->ops, &batch->writerVectors, &batch->derivedOps);
+
+    // Without document level locking the ops of a writer vector are on a few collections, which
+    // would be locked in turn by the threads applying its chunks.
+    const bool supportsDocLocking =
+        opCtx->getServiceContext()->getStorageEngine()->supportsDocLocking();
+    batch->writerChunks = splitWriterVectors(
+        batch->writerVectors, supportsDocLocking ? replWriterMinOpsPerChunk.load() : 0);
+    partitionLatencyStats.record(partitionTimer);
+
+    // Wait for writes to finish before applying ops.
+    oplogWriterPool->waitForIdle();
+    if (!_options.skipWritesToOplog) {
+        oplogWriteLatencyStats.record(oplogWriteTimer);
+    }
+
+    // The oplog now holds every op of the batch, so it no longer needs truncating on startup.
+    if (!_options.skipWritesToOplog) {
+        _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, Timestamp());
+    }
+    batch->prepared = true;
+}
+
 StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::Operations ops) {
+    PreparedBatch batch;
+    batch.ops = std::move(ops);
+    return _applyBatch(opCtx, &batch);
+}
+
+StatusWith<OpTime> SyncTail::_applyBatch(OperationContext* opCtx, PreparedBatch* batch) {
+    const auto& ops = batch->ops;
     invariant(!ops.empty());
 
     if (isMMAPV1()) {
@@ -1396,7 +1954,7 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
                 "attempting to replicate ops while primary"};
     }
 
-    std::vector<WorkerMultikeyPathInfo> multikeyVector(_writerPool->getStats().numThreads);
+    std::vector<WorkerMultikeyPathInfo> multikeyVector;
     {
         // Each node records cumulative batch application stats for itself using this timer.
         TimerHolder timer(&applyBatchStats);
@@ -1418,6 +1976,9 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
             // move forward.
             pinningTransaction = std::unique_ptr<RecoveryUnit>(
                 opCtx->getServiceContext()->getStorageEngine()->newRecoveryUnit());
+            // A batch prepared ahead would have been written to the oplog before the pin of the
+            // batch ahead of it was released, so this only happens with majority read concern.
+            invariant(!batch->prepared);
             pinningTransaction->beginUnitOfWork(opCtx);
             fassert(40677, pinningTransaction->setTimestamp(ops.front().getTimestamp()));
         }
@@ -1431,37 +1992,32 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
             }
         });
 
-        // Write batch of ops into oplog.
-        if (!_options.skipWritesToOplog) {
-            _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, ops.front().getTimestamp());
-            scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, ops);
+        if (!batch->prepared) {
+            _prepareBatch(opCtx, _writerPool, batch);
         }
 
-        // Holds 'pseudo operations' generated by secondaries to aid in replication.
-        // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
-        // Pseudo operations include:
-        // - applyOps operations expanded to individual ops.
-        // - ops to update config.transactions. Normal writes to config.transactions in the
-        //   primary don't create an oplog entry, so extract info from writes with transactions
-        //   and create a pseudo oplog.
-        std::vector<MultiApplier::Operations> derivedOps;
-
-        std::vector<MultiApplier::OperationPtrs> writerVectors(_writerPool->getStats().numThreads);
-        fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
-
-        // Wait for writes to finish before applying ops.
-        _writerPool->waitForIdle();
-
-        // Reset consistency markers in case the node fails while applying ops.
+        // Update minValid in case the node fails while applying ops.
         if (!_options.skipWritesToOplog) {
-            _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, Timestamp());
             _consistencyMarkers->setMinValidToAtLeast(opCtx, ops.back().getOpTime());
         }
 
         {
-            std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
-            applyOps(writerVectors, _writerPool, _applyFunc, this, &statusVector, &multikeyVector);
+            auto& chunks = batch->writerChunks;
+            std::vector<Status> statusVector(chunks.size(), Status::OK());
+            multikeyVector.resize(chunks.size());
+            std::vector<long long> writerMicros(
+                std::min(chunks.size(), size_t(_writerPool->getStats().numThreads)), 0);
+            Timer writersTimer;
+            applyOps(chunks,
+                     _writerPool,
+                     _applyFunc,
+                     this,
+                     &statusVector,
+                     &multikeyVector,
+                     &writerMicros);
             _writerPool->waitForIdle();
+            writersLatencyStats.record(writersTimer);
+            recordWriterSkew(batch->writerVectors, writerMicros);
 
             // If any of the statuses is not ok, return error.
             for (auto it = statusVector.cbegin(); it != statusVector.cend(); ++it) {
@@ -1471,7 +2027,7 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
                         << "Failed to apply batch of operations. Number of operations in batch: "
                         << ops.size() << ". First operation: " << redact(ops.front().toBSON())
                         << ". Last operation: " << redact(ops.back().toBSON())
-                        << ". Oplog application failed in writer thread "
+                        << ". Oplog application failed in chunk "
                         << std::distance(statusVector.cbegin(), it) << ": " << redact(status);
                     return status;
                 }
@@ -265,10 +265,61 @@ private:
     void _consume(OperationContext* opCtx, OplogBuffer* oplogBuffer);
 
     class OpQueueBatcher;
+    class OpQueuePreparer;
 
+    /**
+     * A batch of operations together with what multiApply() derives from it before applying it.
+     * The batch is prepared once its operations have been written to the oplog and partitioned
+     * among the writer threads. Moving a PreparedBatch keeps the operations at their addresses, so
+     * 'writerVectors' stay valid.
+     */
+    struct PreparedBatch {
+        PreparedBatch() = default;
+        explicit PreparedBatch(OpQueue opQueue)
+            : mustShutdown(opQueue.mustShutdown()), ops(opQueue.releaseBatch()) {}
+
+        // Set on the empty batch which ends oplog application. See OpQueue::mustShutdown().
+        bool mustShutdown = false;
+
+        MultiApplier::Operations ops;
+
+        // Holds 'pseudo operations' generated by secondaries to aid in replication. They must be
+        // kept until all operations in 'ops' and 'derivedOps' have been applied. They include:
+        // - applyOps operations expanded to individual ops.
+        // - ops to update config.transactions. Normal writes to config.transactions in the
+        //   primary don't create an oplog entry, so extract info from writes with transactions
+        //   and create a pseudo oplog.
+        std::vector<MultiApplier::Operations> derivedOps;
+
+        std::vector<MultiApplier::OperationPtrs> writerVectors;
+
+        // The ops of 'writerVectors' in chunks which the writer threads claim one at a time. See
+        // splitWriterVectors().
+        std::vector<MultiApplier::OperationPtrs> writerChunks;
+        bool prepared = false;
+    };
+
+    /**
+     * Writes the operations of 'batch' to the oplog using the threads of 'oplogWriterPool', and
+     * partitions them among the writer threads in the meantime.
+     */
+    void _prepareBatch(OperationContext* opCtx,
+                       ThreadPool* oplogWriterPool,
+                       PreparedBatch* batch);
+
+    /**
+     * Implements multiApply(), skipping the oplog writes and partitioning if 'batch' has already
+     * been prepared.
+     */
+    StatusWith<OpTime> _applyBatch(OperationContext* opCtx, PreparedBatch* batch);
+
+    /**
+     * Applies the batches of 'batcher', or of 'preparer' if one is given, until shutdown.
+     */
     void _oplogApplication(OplogBuffer* oplogBuffer,
                            ReplicationCoordinator* replCoord,
-                           OpQueueBatcher* batcher) noexcept;
+                           OpQueueBatcher* batcher,
+                           OpQueuePreparer* preparer) noexcept;
 
     std::string _hostname;
 
@@ -307,5 +358,29 @@ Status multiInitialSyncApply(OperationContext* opCtx,
                              SyncTail* st,
                              WorkerMultikeyPathInfo* workerMultikeyPathInfo);
 
+/**
+ * Partitions 'ops' among 'writerVectors' by the hash of their namespace, and of their _id if the
+ * storage engine supports document level locking, keeping the order of the batch in each writer
+ * vector. The ops are hashed in ranges on the threads of 'hashPool', if given, and on the current
+ * thread. applyOps operations are expanded into 'derivedOps', along with the updates to the
+ * transactions table for the operations with session info.
+ */
+void fillWriterVectors(OperationContext* opCtx,
+                       ThreadPool* hashPool,
+                       MultiApplier::Operations* ops,
+                       std::vector<MultiApplier::OperationPtrs>* writerVectors,
+                       std::vector<MultiApplier::Operations>* derivedOps);
+
+/**
+ * Returns the ops of 'writerVectors' in chunks for the writer threads to claim, longest first. The
+ * writer vectors with at least twice 'minOpsPerChunk' ops, and twice the average number of ops of a
+ * writer vector, are split by the hash of their ops, as set by fillWriterVectors(), so that idle
+ * threads can take over part of them. The ops with the same hash, such as the ops on one document
+ * or on one capped collection, stay in one chunk in the order of the batch. A 'minOpsPerChunk' of
+ * 0 keeps every writer vector whole.
+ */
+std::vector<MultiApplier::OperationPtrs> splitWriterVectors(
+    const std::vector<MultiApplier::OperationPtrs>& writerVectors, size_t minOpsPerChunk);
+
 }  // namespace repl
 }  // namespace mongo
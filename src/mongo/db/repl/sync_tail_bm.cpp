@@ -0,0 +1,91 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/repl/idempotency_test_fixture.h"
+#include "mongo/db/repl/sync_tail.h"
+#include "mongo/db/repl/sync_tail_test_fixture.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+/**
+ * Partitions a batch of inserts among 16 writers, over and over. The first argument is the number
+ * of ops in the batch, and the second the number of threads hashing them. Runs against WiredTiger,
+ * since the _id of the documents is only hashed with document level locking.
+ */
+class PartitionBatchBenchmark : public SyncTailTest {
+public:
+    explicit PartitionBatchBenchmark(benchmark::State& state)
+        : SyncTailTest("wiredTiger"), _state(state) {}
+
+private:
+    void _doTest() override {
+        const NamespaceString nss("test.t");
+        ASSERT_OK(getStorageInterface()->createCollection(_opCtx.get(), nss, CollectionOptions()));
+
+        const int numOps = _state.range(0);
+        MultiApplier::Operations ops;
+        for (int i = 0; i < numOps; i++) {
+            ops.push_back(makeInsertDocumentOplogEntry(
+                {Timestamp(Seconds(1), i), 1LL}, nss, BSON("_id" << i << "x" << i)));
+        }
+
+        // A single thread hashes the whole batch when there is no pool.
+        auto hashPool = _state.range(1) > 1 ? SyncTail::makeWriterPool(_state.range(1)) : nullptr;
+        for (auto keepRunning : _state) {
+            std::vector<MultiApplier::OperationPtrs> writerVectors(16);
+            std::vector<MultiApplier::Operations> derivedOps;
+            fillWriterVectors(_opCtx.get(), hashPool.get(), &ops, &writerVectors, &derivedOps);
+            benchmark::DoNotOptimize(writerVectors.data());
+        }
+        _state.SetItemsProcessed(_state.iterations() * numOps);
+    }
+
+    benchmark::State& _state;
+};
+
+void BM_PartitionBatch(benchmark::State& state) {
+    PartitionBatchBenchmark(state).run();
+}
+
+BENCHMARK(BM_PartitionBatch)
+    ->Args({5000, 1})
+    ->Args({5000, 4})
+    ->Args({5000, 16})
+    ->Args({50000, 16})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -29,6 +29,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -510,6 +511,118 @@ TEST_F(SyncTailTest, MultiApplyAssignsOperationsToWriterThreadsBasedOnNamespaceH
     ASSERT_EQUALS(op2, lastEntry);
 }
 
+TEST_F(SyncTailTest, FillWriterVectorsHashesRangesOfTheBatchOnThePoolThreads) {
+    NamespaceString cappedNss("test.capped");
+    createCollection(_opCtx.get(), cappedNss, createOplogCollectionOptions());
+    const std::vector<NamespaceString> namespaces = {
+        NamespaceString("test.t0"), NamespaceString("test.t1"), cappedNss};
+
+    // Enough ops for the batch to be hashed in several ranges.
+    MultiApplier::Operations ops;
+    for (int i = 0; i < 1000; i++) {
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(1), i), 1LL}, namespaces[i % namespaces.size()], BSON("_id" << i)));
+    }
+
+    // Returns the optimes of the ops assigned to each writer.
+    auto partition = [this](ThreadPool* hashPool, MultiApplier::Operations* opsToPartition) {
+        std::vector<MultiApplier::OperationPtrs> writerVectors(4);
+        std::vector<MultiApplier::Operations> derivedOps;
+        fillWriterVectors(_opCtx.get(), hashPool, opsToPartition, &writerVectors, &derivedOps);
+        ASSERT_TRUE(derivedOps.empty());
+
+        std::vector<std::vector<OpTime>> opTimes;
+        for (auto&& writer : writerVectors) {
+            opTimes.emplace_back();
+            for (auto&& op : writer) {
+                opTimes.back().push_back(op->getOpTime());
+            }
+        }
+        return opTimes;
+    };
+
+    auto opsHashedOnOneThread = ops;
+    auto expected = partition(nullptr, &opsHashedOnOneThread);
+    auto writerPool = SyncTail::makeWriterPool(4);
+    auto actual = partition(writerPool.get(), &ops);
+
+    ASSERT_TRUE(expected == actual);
+    for (auto&& opTimes : actual) {
+        // Each writer applies its ops in the order of the batch.
+        ASSERT_TRUE(std::is_sorted(opTimes.begin(), opTimes.end()));
+    }
+    for (auto&& op : ops) {
+        ASSERT_EQUALS(op.getNamespace() == cappedNss, op.isForCappedCollection);
+    }
+}
+
+TEST_F(SyncTailTest, SplitWriterVectorsKeepsTheOpsWithTheSameHashInOneChunkInOrder) {
+    NamespaceString nss("test.t");
+    NamespaceString cappedNss("test.capped");
+
+    // The first writer vector holds most of the batch: ops on 100 documents, and ops on a capped
+    // collection which share a single hash. The others hold a few ops each.
+    MultiApplier::Operations ops;
+    std::vector<size_t> writerOfOp;
+    for (int i = 0; i < 1000; i++) {
+        const bool capped = i % 10 == 0;
+        ops.push_back(makeInsertDocumentOplogEntry({Timestamp(Seconds(1), i), 1LL},
+                                                   capped ? cappedNss : nss,
+                                                   BSON("_id" << i % 100)));
+        ops.back().writerHash = capped ? 4000 : (i % 100) * 4;
+        writerOfOp.push_back(0);
+    }
+    for (int i = 0; i < 30; i++) {
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(2), i), 1LL}, nss, BSON("_id" << 1000 + i)));
+        ops.back().writerHash = i * 4 + 1 + i % 3;
+        writerOfOp.push_back(1 + i % 3);
+    }
+    std::vector<MultiApplier::OperationPtrs> writerVectors(4);
+    for (size_t i = 0; i < ops.size(); i++) {
+        writerVectors[writerOfOp[i]].push_back(&ops[i]);
+    }
+
+    // A minimum of 0 ops per chunk keeps every writer vector whole.
+    auto chunks = splitWriterVectors(writerVectors, 0);
+    ASSERT_EQUALS(4U, chunks.size());
+    ASSERT_EQUALS(1000U, chunks.front().size());
+
+    chunks = splitWriterVectors(writerVectors, 16);
+    ASSERT_GREATER_THAN(chunks.size(), 4U);
+    size_t numOps = 0;
+    std::map<uint32_t, size_t> chunkOfHash;
+    std::map<uint32_t, OpTime> lastOpTimeOfHash;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (i > 0) {
+            ASSERT_LESS_THAN_OR_EQUALS(chunks[i].size(), chunks[i - 1].size());
+        }
+        for (size_t j = 0; j < chunks[i].size(); j++) {
+            const auto op = chunks[i][j];
+            numOps++;
+            // Each chunk keeps the order of the batch, and not only the order of each hash.
+            if (j > 0) {
+                ASSERT_LESS_THAN(chunks[i][j - 1]->getOpTime(), op->getOpTime());
+            }
+            ASSERT_EQUALS(i, chunkOfHash.emplace(op->writerHash, i).first->second);
+            auto lastOpTime = lastOpTimeOfHash.find(op->writerHash);
+            if (lastOpTime != lastOpTimeOfHash.end()) {
+                ASSERT_LESS_THAN(lastOpTime->second, op->getOpTime());
+            }
+            lastOpTimeOfHash[op->writerHash] = op->getOpTime();
+        }
+    }
+    ASSERT_EQUALS(ops.size(), numOps);
+
+    // The ops on the capped collection stay together.
+    ASSERT_GREATER_THAN_OR_EQUALS(chunks[chunkOfHash[4000]].size(), 100U);
+
+    // The short writer vectors are not split.
+    for (size_t i = 0; i < 30; i++) {
+        ASSERT_EQUALS(10U, chunks[chunkOfHash[ops[1000 + i].writerHash]].size());
+    }
+}
+
 TEST_F(SyncTailTest, MultiSyncApplyUsesSyncApplyToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
     auto op = makeCreateCollectionOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nss);
@@ -996,6 +1109,107 @@ TEST_F(SyncTailTest, MultiSyncApplyFallsBackOnApplyingInsertsIndividuallyWhenGro
     ASSERT_EQUALS(1U, numFailedGroupedInserts);
 }
 
+TEST_F(SyncTailTest, MultiSyncApplyCommitsOperationsOnDifferentCollectionsTogether) {
+    NamespaceString nss1("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_1");
+    NamespaceString nss2("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_2");
+    createCollectionWithUuid(_opCtx.get(), nss1);
+    createCollectionWithUuid(_opCtx.get(), nss2);
+
+    // The inserts cannot be grouped into a single insert since they are on different collections.
+    auto insertOp1 = makeInsertDocumentOplogEntry(
+        {Timestamp(Seconds(1), 0), 1LL}, nss1, BSON("_id" << 1));
+    auto insertOp2 = makeInsertDocumentOplogEntry(
+        {Timestamp(Seconds(2), 0), 1LL}, nss2, BSON("_id" << 2));
+    auto deleteOp1 = makeDeleteDocumentOplogEntry(
+        {Timestamp(Seconds(3), 0), 1LL}, nss1, BSON("_id" << 1));
+
+    std::vector<bool> insertedInGroup;
+    _opObserver->onInsertsFn =
+        [&](OperationContext* opCtx, const NamespaceString&, const std::vector<BSONObj>& docs) {
+            ASSERT_EQUALS(1U, docs.size());
+            insertedInGroup.push_back(OplogApplicationGroupBlock::isActive(opCtx));
+        };
+
+    ASSERT_OK(runOpsSteadyState({insertOp1, insertOp2, deleteOp1}));
+    ASSERT_EQUALS(2U, insertedInGroup.size());
+    ASSERT_TRUE(insertedInGroup[0]);
+    ASSERT_TRUE(insertedInGroup[1]);
+    ASSERT_FALSE(OplogApplicationGroupBlock::isActive(_opCtx.get()));
+
+    {
+        AutoGetCollectionForReadCommand autoColl(_opCtx.get(), nss1);
+        ASSERT_EQUALS(0, autoColl.getCollection()->numRecords(_opCtx.get()));
+    }
+    {
+        AutoGetCollectionForReadCommand autoColl(_opCtx.get(), nss2);
+        ASSERT_EQUALS(1, autoColl.getCollection()->numRecords(_opCtx.get()));
+    }
+}
+
+TEST_F(SyncTailTest, MultiSyncApplyDoesNotCommitTogetherOperationsOlderThanTheFirstOfTheGroup) {
+    NamespaceString nss1("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_1");
+    NamespaceString nss2("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_2");
+    createCollectionWithUuid(_opCtx.get(), nss1);
+    createCollectionWithUuid(_opCtx.get(), nss2);
+
+    // Sorting by namespace moves the insert into "nss1" before the older insert into "nss2".
+    auto insertOp2 = makeInsertDocumentOplogEntry(
+        {Timestamp(Seconds(1), 0), 1LL}, nss2, BSON("_id" << 2));
+    auto insertOp1 = makeInsertDocumentOplogEntry(
+        {Timestamp(Seconds(2), 0), 1LL}, nss1, BSON("_id" << 1));
+
+    std::vector<bool> insertedInGroup;
+    _opObserver->onInsertsFn =
+        [&](OperationContext* opCtx, const NamespaceString&, const std::vector<BSONObj>&) {
+            insertedInGroup.push_back(OplogApplicationGroupBlock::isActive(opCtx));
+        };
+
+    ASSERT_OK(runOpsSteadyState({insertOp2, insertOp1}));
+    ASSERT_EQUALS(2U, insertedInGroup.size());
+    ASSERT_FALSE(insertedInGroup[0]);
+    ASSERT_FALSE(insertedInGroup[1]);
+}
+
+TEST_F(SyncTailTest, MultiSyncApplyFallsBackOnApplyingOperationsIndividuallyWhenGroupFails) {
+    NamespaceString nss1("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_1");
+    NamespaceString nss2("test." + _agent.getSuiteName() + "_" + _agent.getTestName() + "_2");
+    createCollectionWithUuid(_opCtx.get(), nss1);
+    createCollectionWithUuid(_opCtx.get(), nss2);
+
+    auto insertOp1 = makeInsertDocumentOplogEntry(
+        {Timestamp(Seconds(1), 0), 1LL}, nss1, BSON("_id" << 1));
+    auto insertOp2 = makeInsertDocumentOplogEntry(
+        {Timestamp(Seconds(2), 0), 1LL}, nss2, BSON("_id" << 2));
+
+    // Reject the second insert of the group only.
+    std::size_t numInsertsIntoNss1 = 0;
+    std::size_t numFailedGroups = 0;
+    _opObserver->onInsertsFn =
+        [&](OperationContext* opCtx, const NamespaceString& nss, const std::vector<BSONObj>&) {
+            if (nss == nss1) {
+                numInsertsIntoNss1++;
+            } else if (OplogApplicationGroupBlock::isActive(opCtx)) {
+                numFailedGroups++;
+                uasserted(ErrorCodes::OperationFailed, "insert not supported in a group");
+            }
+        };
+
+    ASSERT_OK(runOpsSteadyState({insertOp1, insertOp2}));
+
+    // The insert into "nss1" was rolled back with the group, then applied again on its own.
+    ASSERT_EQUALS(1U, numFailedGroups);
+    ASSERT_EQUALS(2U, numInsertsIntoNss1);
+
+    {
+        AutoGetCollectionForReadCommand autoColl(_opCtx.get(), nss1);
+        ASSERT_EQUALS(1, autoColl.getCollection()->numRecords(_opCtx.get()));
+    }
+    {
+        AutoGetCollectionForReadCommand autoColl(_opCtx.get(), nss2);
+        ASSERT_EQUALS(1, autoColl.getCollection()->numRecords(_opCtx.get()));
+    }
+}
+
 TEST_F(SyncTailTest, MultiInitialSyncApplyDisablesDocumentValidationWhileApplyingOperations) {
     SyncTailWithOperationContextChecker syncTail;
     NamespaceString nss("test.t");
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "mongo/base/status.h"
 #include "mongo/db/concurrency/lock_manager_defs.h"
 #include "mongo/db/op_observer_noop.h"
@@ -100,6 +102,13 @@ public:
 
 class SyncTailTest : public ServiceContextMongoDTest {
 protected:
+    SyncTailTest() = default;
+
+    /**
+     * Builds a SyncTailTest using the named storage engine.
+     */
+    explicit SyncTailTest(std::string engine) : ServiceContextMongoDTest(std::move(engine)) {}
+
     void _testSyncApplyCrudOperation(ErrorCodes::Error expectedError,
                                      const BSONObj& op,
                                      bool expectedApplyOpCalled);
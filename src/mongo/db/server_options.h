@@ -77,7 +77,7 @@ struct ServerGlobalParams {
     bool noUnixSocket = false;    // --nounixsocket
     bool doFork = false;          // --fork
     std::string socket = "/tmp";  // UNIX domain socket directory
-    std::string transportLayer;   // --transportLayer (must be either "asio" or "legacy")
+    std::string transportLayer;   // --transportLayer ("asio", or "uring" on Linux)
 
     // --serviceExecutor ("adaptive", "synchronous")
     std::string serviceExecutor;
@@ -552,9 +552,17 @@ Status storeServerOptions(const moe::Environment& params) {
 
     if (params.count("net.transportLayer")) {
         serverGlobalParams.transportLayer = params["net.transportLayer"].as<std::string>();
+#ifdef MONGO_CONFIG_HAVE_LINUX_IO_URING
+        if (serverGlobalParams.transportLayer != "asio" &&
+            serverGlobalParams.transportLayer != "uring") {
+            return {ErrorCodes::BadValue,
+                    "Unsupported value for transportLayer. Must be \"asio\" or \"uring\""};
+        }
+#else
         if (serverGlobalParams.transportLayer != "asio") {
             return {ErrorCodes::BadValue, "Unsupported value for transportLayer. Must be \"asio\""};
         }
+#endif
     }
 
     if (params.count("net.serviceExecutor")) {
@@ -976,6 +976,24 @@ TEST_F(SessionTest, SameTransactionPreservesStoredStatements) {
     ASSERT_BSONOBJ_EQ(operation.toBSON(), session.transactionOperationsForTest()[0].toBSON());
 }
 
+TEST_F(SessionTest, StoredInsertDoesNotKeepLargerBufferAlive) {
+    const BSONObj doc = BSON("TestValue" << 0);
+    auto buffer = SharedBuffer::allocate(16 * 1024);
+    std::memcpy(buffer.get(), doc.objdata(), doc.objsize());
+    const BSONObj view = BSONObj(buffer.get()).shareOwnershipWith(buffer);
+
+    auto operation = repl::OplogEntry::makeInsertOperation(kNss, kUUID, view);
+    ASSERT_BSONOBJ_EQ(doc, operation.getObject());
+    ASSERT_NOT_EQUALS(buffer.get(), operation.getObject().objdata());
+}
+
+TEST_F(SessionTest, StoredInsertSharesBufferItFills) {
+    const BSONObj doc = BSON("TestValue" << 0).copy();
+
+    auto operation = repl::OplogEntry::makeInsertOperation(kNss, kUUID, doc);
+    ASSERT_EQUALS(doc.objdata(), operation.getObject().objdata());
+}
+
 TEST_F(SessionTest, AbortClearsStoredStatements) {
     const auto sessionId = makeLogicalSessionIdForTest();
     SessionMongoD session(sessionId);
@@ -48,6 +48,7 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <map>
 #include <snappy.h>
 #include <vector>
 
@@ -55,15 +56,24 @@
 #include "mongo/config.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/db/storage/encryption_hooks.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/is_mongos.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/unowned_ptr.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
 
 namespace mongo {
 namespace sorter {
@@ -114,6 +124,264 @@ private:
     const std::string _fileName;
 };
 
+// Reads 'size' bytes of a sorted file. Returns false on EOF - asserts on any other error.
+inline bool readSortedFile(std::ifstream& file,
+                           const std::string& fileName,
+                           void* out,
+                           size_t size) {
+    file.read(reinterpret_cast<char*>(out), size);
+    if (!file.good()) {
+        if (file.eof()) {
+            return false;
+        }
+
+        msgasserted(16817,
+                    str::stream() << "error reading file \"" << fileName << "\": "
+                                  << myErrnoWithDescription());
+    }
+    verify(file.gcount() == static_cast<std::streamsize>(size));
+    return true;
+}
+
+// Checksum of a block as it is stored on disk, after compression and encryption.
+inline uint32_t sortedFileBlockChecksum(const char* data, int32_t size) {
+    uint32_t checksum;
+    MurmurHash3_x86_32(data, size, 0, &checksum);
+    return checksum;
+}
+
+/**
+ * Reads the next block written by SortedFileWriter::spill() into 'out', verifying its checksum
+ * and undoing encryption and compression. Returns false once the whole file has been read.
+ */
+inline bool readSortedFileBlock(std::ifstream& file,
+                                const std::string& fileName,
+                                std::unique_ptr<char[]>* out,
+                                size_t* outSize) {
+    int32_t rawSize;
+    if (!readSortedFile(file, fileName, &rawSize, sizeof(rawSize)))
+        return false;
+
+    // negative size means compressed
+    const bool compressed = rawSize < 0;
+    int32_t blockSize = std::abs(rawSize);
+
+    uint32_t checksum;
+    std::unique_ptr<char[]> buffer(new char[blockSize]);
+    massert(16816,
+            "file too short?",
+            readSortedFile(file, fileName, &checksum, sizeof(checksum)) &&
+                readSortedFile(file, fileName, buffer.get(), blockSize));
+    massert(51007,
+            str::stream() << "checksum mismatch in sorted file \"" << fileName << "\" at offset "
+                          << static_cast<long long>(file.tellg()) - blockSize,
+            checksum == sortedFileBlockChecksum(buffer.get(), blockSize));
+
+    auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
+    if (encryptionHooks->enabled()) {
+        std::unique_ptr<char[]> unprotected(new char[blockSize]);
+        size_t outLen;
+        Status status =
+            encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(buffer.get()),
+                                              blockSize,
+                                              reinterpret_cast<uint8_t*>(unprotected.get()),
+                                              blockSize,
+                                              &outLen);
+        massert(28841,
+                str::stream() << "Failed to unprotect data: " << status.toString(),
+                status.isOK());
+        blockSize = outLen;
+        buffer.swap(unprotected);
+    }
+
+    if (!compressed) {
+        *out = std::move(buffer);
+        *outSize = blockSize;
+        return true;
+    }
+
+    dassert(snappy::IsValidCompressedBuffer(buffer.get(), blockSize));
+
+    size_t uncompressedSize;
+    massert(17061,
+            "couldn't get uncompressed length",
+            snappy::GetUncompressedLength(buffer.get(), blockSize, &uncompressedSize));
+
+    std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
+    massert(17062,
+            "decompression failed",
+            snappy::RawUncompress(buffer.get(), blockSize, decompressionBuffer.get()));
+
+    *out = std::move(decompressionBuffer);
+    *outSize = uncompressedSize;
+    return true;
+}
+
+/**
+ * Reads the blocks of sorted files on a background thread ahead of the FileIterators consuming
+ * them, so that reading, decrypting and decompressing the next blocks of every file overlaps with
+ * merging the current ones. One instance is shared by all the files of a sort, and its thread is
+ * only started once the first block is needed.
+ */
+class FileReadAhead {
+    MONGO_DISALLOW_COPYING(FileReadAhead);
+
+public:
+    typedef size_t FileId;
+
+    /**
+     * 'depth' is the number of blocks read ahead of each file.
+     */
+    explicit FileReadAhead(size_t depth) : _depth(depth) {}
+
+    ~FileReadAhead() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _shutdown = true;
+        }
+        _cv.notify_all();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    /**
+     * Opens 'fileName' to be read ahead. Returns the id to pass to nextBlock() and removeFile().
+     */
+    FileId addFile(const std::string& fileName) {
+        auto file = stdx::make_unique<File>(fileName);
+        massert(90438,
+                str::stream() << "error opening file \"" << fileName << "\": "
+                              << myErrnoWithDescription(),
+                file->stream.good());
+
+        massert(90439,
+                str::stream() << "unexpected empty file: " << fileName,
+                boost::filesystem::file_size(fileName) != 0);
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        const FileId id = _nextFileId++;
+        _files[id] = std::move(file);
+        return id;
+    }
+
+    /**
+     * Stops reading 'id' ahead and closes it.
+     */
+    void removeFile(FileId id) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        auto it = _files.find(id);
+        invariant(it != _files.end());
+        _cv.wait(lk, [&] { return !it->second->reading; });
+        _files.erase(it);
+    }
+
+    /**
+     * Waits for the next block of 'id'. Returns false once the whole file has been read, and
+     * rethrows any error reading it.
+     */
+    bool nextBlock(FileId id, std::unique_ptr<char[]>* out, size_t* outSize) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (!_thread.joinable()) {
+            _thread = stdx::thread([this] { _readLoop(); });
+        }
+
+        File& file = *_files.at(id);
+        _cv.wait(lk, [&] { return !file.blocks.empty() || file.eof || !file.status.isOK(); });
+        uassertStatusOK(file.status);
+        if (file.blocks.empty())
+            return false;
+
+        *out = std::move(file.blocks.front().data);
+        *outSize = file.blocks.front().size;
+        file.blocks.pop_front();
+        _cv.notify_all();
+        return true;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    struct File {
+        explicit File(const std::string& fileName)
+            : fileName(fileName), stream(fileName.c_str(), std::ios::in | std::ios::binary) {}
+
+        const std::string fileName;
+        std::ifstream stream;  // Only used by the read-ahead thread once added.
+        std::deque<Block> blocks;
+        bool reading = false;
+        bool eof = false;
+        Status status = Status::OK();
+    };
+
+    // Returns the file that most needs its next block, or nullptr if none needs one.
+    File* _fileToRead_inlock() {
+        File* next = nullptr;
+        for (auto&& entry : _files) {
+            File* file = entry.second.get();
+            if (file->reading || file->eof || !file->status.isOK() ||
+                file->blocks.size() >= _depth) {
+                continue;
+            }
+            if (!next || file->blocks.size() < next->blocks.size()) {
+                next = file;
+            }
+        }
+        return next;
+    }
+
+    void _readLoop() {
+        setThreadName("sorterReadAhead");
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        while (true) {
+            File* file = nullptr;
+            {
+                MONGO_IDLE_THREAD_BLOCK;
+                _cv.wait(lk, [&] { return _shutdown || (file = _fileToRead_inlock()); });
+            }
+            if (_shutdown)
+                return;
+
+            file->reading = true;
+            lk.unlock();
+
+            Block block;
+            bool haveBlock = false;
+            Status status = Status::OK();
+            try {
+                haveBlock =
+                    readSortedFileBlock(file->stream, file->fileName, &block.data, &block.size);
+            } catch (...) {
+                status = exceptionToStatus();
+            }
+
+            lk.lock();
+            file->reading = false;
+            if (!status.isOK()) {
+                file->status = status;
+            } else if (haveBlock) {
+                file->blocks.push_back(std::move(block));
+            } else {
+                file->eof = true;
+            }
+            _cv.notify_all();
+        }
+    }
+
+    const size_t _depth;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;  // Signaled when blocks are read, consumed or files removed.
+    std::map<FileId, std::unique_ptr<File>> _files;
+    FileId _nextFileId = 0;
+    bool _shutdown = false;
+    stdx::thread _thread;
+};
+
 /** Returns results from sorted in-memory storage */
 template <typename Key, typename Value>
 class InMemIterator : public SortIteratorInterface<Key, Value> {
@@ -154,12 +422,19 @@ public:
 
     FileIterator(const std::string& fileName,
                  const Settings& settings,
-                 std::shared_ptr<FileDeleter> fileDeleter)
+                 std::shared_ptr<FileDeleter> fileDeleter,
+                 std::shared_ptr<FileReadAhead> readAhead = nullptr)
         : _settings(settings),
           _done(false),
           _fileName(fileName),
           _fileDeleter(fileDeleter),
-          _file(_fileName.c_str(), std::ios::in | std::ios::binary) {
+          _readAhead(readAhead) {
+        if (_readAhead) {
+            _readAheadId = _readAhead->addFile(_fileName);
+            return;
+        }
+
+        _file.open(_fileName.c_str(), std::ios::in | std::ios::binary);
         massert(16814,
                 str::stream() << "error opening file \"" << _fileName << "\": "
                               << myErrnoWithDescription(),
@@ -170,6 +445,12 @@ public:
                 boost::filesystem::file_size(_fileName) != 0);
     }
 
+    ~FileIterator() {
+        if (_readAhead) {
+            DESTRUCTOR_GUARD(_readAhead->removeFile(_readAheadId);)
+        }
+    }
+
     bool more() {
         if (!_done)
             fillIfNeeded();  // may change _done
@@ -194,73 +475,18 @@ private:
             fill();
     }
 
+    // sets _done to true on EOF
     void fill() {
-        int32_t rawSize;
-        read(&rawSize, sizeof(rawSize));
-        if (_done)
-            return;
-
-        // negative size means compressed
-        const bool compressed = rawSize < 0;
-        int32_t blockSize = std::abs(rawSize);
-
-        _buffer.reset(new char[blockSize]);
-        read(_buffer.get(), blockSize);
-        massert(16816, "file too short?", !_done);
-
-        auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
-        if (encryptionHooks->enabled()) {
-            std::unique_ptr<char[]> out(new char[blockSize]);
-            size_t outLen;
-            Status status =
-                encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(_buffer.get()),
-                                                  blockSize,
-                                                  reinterpret_cast<uint8_t*>(out.get()),
-                                                  blockSize,
-                                                  &outLen);
-            massert(28841,
-                    str::stream() << "Failed to unprotect data: " << status.toString(),
-                    status.isOK());
-            blockSize = outLen;
-            _buffer.swap(out);
-        }
-
-        if (!compressed) {
-            _reader.reset(new BufReader(_buffer.get(), blockSize));
+        size_t blockSize;
+        const bool haveBlock = _readAhead
+            ? _readAhead->nextBlock(_readAheadId, &_buffer, &blockSize)
+            : readSortedFileBlock(_file, _fileName, &_buffer, &blockSize);
+        if (!haveBlock) {
+            _done = true;
             return;
         }
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
-
-        size_t uncompressedSize;
-        massert(17061,
-                "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
-
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-        massert(17062,
-                "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
-
-        // hold on to decompressed data and throw out compressed data at block exit
-        _buffer.swap(decompressionBuffer);
-        _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
-    }
-
-    // sets _done to true on EOF - asserts on any other error
-    void read(void* out, size_t size) {
-        _file.read(reinterpret_cast<char*>(out), size);
-        if (!_file.good()) {
-            if (_file.eof()) {
-                _done = true;
-                return;
-            }
-
-            msgasserted(16817,
-                        str::stream() << "error reading file \"" << _fileName << "\": "
-                                      << myErrnoWithDescription());
-        }
-        verify(_file.gcount() == static_cast<std::streamsize>(size));
+        _reader.reset(new BufReader(_buffer.get(), blockSize));
     }
 
     const Settings _settings;
@@ -269,10 +495,19 @@ private:
     std::unique_ptr<BufReader> _reader;
     std::string _fileName;
     std::shared_ptr<FileDeleter> _fileDeleter;  // Must outlive _file
+    std::shared_ptr<FileReadAhead> _readAhead;  // Reads the file instead of _file, if set
+    FileReadAhead::FileId _readAheadId = 0;
     std::ifstream _file;
 };
 
-/** Merge-sorts results from 0 or more FileIterators */
+/**
+ * Merge-sorts results from 0 or more FileIterators.
+ *
+ * The inputs are the leaves of a tournament tree of losers: each internal node remembers the input
+ * that lost the match played there, and the overall winner is kept on the side. Once the winner
+ * advances, it only replays the matches on the path from its leaf to the root, which takes one
+ * comparison per level rather than the two per level of sifting down a heap.
+ */
 template <typename Key, typename Value, typename Comparator>
 class MergeIterator : public SortIteratorInterface<Key, Value> {
 public:
@@ -285,33 +520,50 @@ public:
                   const Comparator& comp)
         : _opts(opts),
           _remaining(opts.limit ? opts.limit : std::numeric_limits<unsigned long long>::max()),
-          _first(true),
-          _greater(comp) {
+          _advanceWinner(false),
+          _comp(comp) {
         for (size_t i = 0; i < iters.size(); i++) {
             if (iters[i]->more()) {
-                _heap.push_back(std::make_shared<Stream>(i, iters[i]->next(), iters[i]));
+                _streams.emplace_back(iters[i]->next(), iters[i]);
             }
         }
 
-        if (_heap.empty()) {
+        if (_streams.empty()) {
             _remaining = 0;
             return;
         }
 
-        std::make_heap(_heap.begin(), _heap.end(), _greater);
-        std::pop_heap(_heap.begin(), _heap.end(), _greater);
-        _current = _heap.back();
-        _heap.pop_back();
+        // Play the initial tournament bottom up. The leaves for the streams are the nodes
+        // [size, 2 * size) and every node i > 0 is the parent of 2i and 2i + 1.
+        const size_t size = _streams.size();
+        std::vector<size_t> winners(2 * size);
+        _losers.resize(size);
+        for (size_t i = 0; i < size; i++) {
+            winners[size + i] = i;
+        }
+        for (size_t node = size - 1; node > 0; node--) {
+            const size_t left = winners[2 * node];
+            const size_t right = winners[2 * node + 1];
+            const bool leftWins = beats(left, right);
+            winners[node] = leftWins ? left : right;
+            _losers[node] = leftWins ? right : left;
+        }
+        _winner = size == 1 ? 0 : winners[1];
     }
 
     bool more() {
-        if (_remaining > 0 && (_first || !_heap.empty() || _current->more()))
+        if (_remaining > 0 && _advanceWinner) {
+            advanceWinner();
+            _advanceWinner = false;
+        }
+
+        if (_remaining > 0 && !_streams[_winner].exhausted)
             return true;
 
         // We are done so clean up resources.
         // Can't do this in next() due to lifetime guarantees of unowned Data.
-        _heap.clear();
-        _current.reset();
+        _streams.clear();
+        _losers.clear();
         _remaining = 0;
 
         return false;
@@ -320,80 +572,217 @@ public:
     Data next() {
         verify(_remaining);
 
+        if (_advanceWinner) {
+            advanceWinner();
+        }
+        verify(!_streams[_winner].exhausted);
+
         _remaining--;
+        _advanceWinner = true;
+        return _streams[_winner].current;
+    }
+
+private:
+    struct Stream {  // Data + Iterator
+        Stream(const Data& first, std::shared_ptr<Input> rest)
+            : current(first), rest(std::move(rest)) {}
+
+        Data current;
+        std::shared_ptr<Input> rest;
+        bool exhausted = false;
+    };
+
+    // Returns true if stream 'lhs' should be returned before stream 'rhs'. Exhausted streams lose
+    // to everything, and ties go to the earlier input to keep the merge stable.
+    bool beats(size_t lhs, size_t rhs) const {
+        const Stream& left = _streams[lhs];
+        const Stream& right = _streams[rhs];
+        if (left.exhausted || right.exhausted)
+            return !left.exhausted || (right.exhausted && lhs < rhs);
+
+        dassertCompIsSane(_comp, left.current, right.current);
+        int ret = _comp(left.current, right.current);
+        if (ret)
+            return ret < 0;
 
-        if (_first) {
-            _first = false;
-            return _current->current();
+        return lhs < rhs;
+    }
+
+    // Moves the winner on to its next value and replays its matches up to the root.
+    void advanceWinner() {
+        Stream& stream = _streams[_winner];
+        if (stream.rest->more()) {
+            stream.current = stream.rest->next();
+        } else {
+            stream.exhausted = true;
+            stream.rest.reset();
         }
 
-        if (!_current->advance()) {
-            verify(!_heap.empty());
+        size_t winner = _winner;
+        for (size_t node = (_streams.size() + _winner) / 2; node > 0; node /= 2) {
+            if (beats(_losers[node], winner)) {
+                std::swap(_losers[node], winner);
+            }
+        }
+        _winner = winner;
+    }
+
+    SortOptions _opts;
+    unsigned long long _remaining;
+    bool _advanceWinner;  // The last value returned is the winner's, which must advance first.
+    const Comparator _comp;
+    std::vector<Stream> _streams;
+    std::vector<size_t> _losers;  // Stream that lost the match at each internal node. [0] unused.
+    size_t _winner = 0;
+};
 
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            _current = _heap.back();
-            _heap.pop_back();
-        } else if (!_heap.empty() && _greater(_current, _heap.front())) {
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            std::swap(_current, _heap.back());
-            std::push_heap(_heap.begin(), _heap.end(), _greater);
+/**
+ * Sorts the runs of a NoLimitSorter and writes them to sorted files on worker threads, so that
+ * the sorter can keep accepting data while earlier runs are sorted and spilled. At most one run
+ * per worker is handed over at a time, so that the memory they hold stays bounded.
+ */
+template <typename Key, typename Value>
+class ParallelRunWriter {
+    MONGO_DISALLOW_COPYING(ParallelRunWriter);
+
+public:
+    typedef std::pair<Key, Value> Data;
+    typedef SortIteratorInterface<Key, Value> Iterator;
+    typedef std::pair<typename Key::SorterDeserializeSettings,
+                      typename Value::SorterDeserializeSettings>
+        Settings;
+    typedef stdx::function<void(std::deque<Data>*)> SortFunction;
+
+    ParallelRunWriter(const SortOptions& opts,
+                      const Settings& settings,
+                      SortFunction sortRun,
+                      std::shared_ptr<FileReadAhead> readAhead)
+        : _opts(opts),
+          _settings(settings),
+          _sortRun(std::move(sortRun)),
+          _readAhead(std::move(readAhead)) {
+        invariant(_opts.workerThreads > 1);
+        try {
+            for (size_t i = 0; i < _opts.workerThreads; i++) {
+                _workers.emplace_back([this] { _workerLoop(); });
+            }
+        } catch (...) {
+            _stopWorkers();
+            throw;
         }
+    }
 
-        return _current->current();
+    ~ParallelRunWriter() {
+        _stopWorkers();
     }
 
+    /**
+     * Hands 'run' over to be sorted and written, waiting while every worker is busy. Leaves 'run'
+     * empty. Rethrows the error of any earlier run that failed.
+     */
+    void write(std::deque<Data>* run) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _numPending < _workers.size() || !_status.isOK(); });
+        uassertStatusOK(_status);
+
+        _queue.emplace_back(_runs.size(), std::deque<Data>());
+        _queue.back().second.swap(*run);
+        _runs.emplace_back();
+        _numPending++;
+        _cv.notify_all();
+    }
 
-private:
-    class Stream {  // Data + Iterator
-    public:
-        Stream(size_t fileNum, const Data& first, std::shared_ptr<Input> rest)
-            : fileNum(fileNum), _current(first), _rest(rest) {}
+    /**
+     * Waits for all the runs to be written, and returns iterators over them in the order they were
+     * handed over.
+     */
+    std::vector<std::shared_ptr<Iterator>> finish() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _numPending == 0; });
+        uassertStatusOK(_status);
+        return _runs;
+    }
+
+    size_t numRuns() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _runs.size();
+    }
+
+    SorterSpillStats spillStats() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _spillStats;
+    }
 
-        const Data& current() const {
-            return _current;
+private:
+    void _stopWorkers() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _shutdown = true;
         }
-        bool more() {
-            return _rest->more();
+        _cv.notify_all();
+        for (auto&& worker : _workers) {
+            worker.join();
         }
-        bool advance() {
-            if (!_rest->more())
-                return false;
+    }
 
-            _current = _rest->next();
-            return true;
-        }
+    void _workerLoop() {
+        setThreadName("sorterWorker");
 
-        const size_t fileNum;
+        while (true) {
+            std::pair<size_t, std::deque<Data>> job;
+            {
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                _cv.wait(lk, [&] { return _shutdown || !_queue.empty(); });
+                if (_shutdown)
+                    return;
 
-    private:
-        Data _current;
-        std::shared_ptr<Input> _rest;
-    };
+                job.first = _queue.front().first;
+                job.second.swap(_queue.front().second);
+                _queue.pop_front();
+            }
 
-    class STLComparator {  // uses greater rather than less-than to maintain a MinHeap
-    public:
-        explicit STLComparator(const Comparator& comp) : _comp(comp) {}
-        bool operator()(unowned_ptr<const Stream> lhs, unowned_ptr<const Stream> rhs) const {
-            // first compare data
-            dassertCompIsSane(_comp, lhs->current(), rhs->current());
-            int ret = _comp(lhs->current(), rhs->current());
-            if (ret)
-                return ret > 0;
+            std::shared_ptr<Iterator> iter;
+            SorterSpillStats spillStats;
+            Status status = Status::OK();
+            try {
+                _sortRun(&job.second);
+
+                SortedFileWriter<Key, Value> writer(_opts, _settings, _readAhead);
+                for (; !job.second.empty(); job.second.pop_front()) {
+                    writer.addAlreadySorted(job.second.front().first, job.second.front().second);
+                }
+                iter.reset(writer.done());
+                spillStats = writer.spillStats();
+            } catch (...) {
+                status = exceptionToStatus();
+            }
 
-            // then compare fileNums to ensure stability
-            return lhs->fileNum > rhs->fileNum;
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _spillStats += spillStats;
+            if (status.isOK()) {
+                _runs[job.first] = std::move(iter);
+            } else if (_status.isOK()) {
+                _status = status;
+            }
+            _numPending--;
+            _cv.notify_all();
         }
+    }
 
-    private:
-        const Comparator _comp;
-    };
-
-    SortOptions _opts;
-    unsigned long long _remaining;
-    bool _first;
-    std::shared_ptr<Stream> _current;
-    std::vector<std::shared_ptr<Stream>> _heap;  // MinHeap
-    STLComparator _greater;                      // named so calls make sense
+    const SortOptions _opts;
+    const Settings _settings;
+    const SortFunction _sortRun;
+    const std::shared_ptr<FileReadAhead> _readAhead;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _cv;  // Signaled when runs are handed over or finished.
+    std::deque<std::pair<size_t, std::deque<Data>>> _queue;  // Runs waiting for a worker.
+    std::vector<std::shared_ptr<Iterator>> _runs;  // Indexed by the order runs were handed over.
+    size_t _numPending = 0;                        // Runs queued or being written.
+    Status _status = Status::OK();                 // The first error writing a run.
+    SorterSpillStats _spillStats;                  // Of the runs written so far.
+    bool _shutdown = false;
+    std::vector<stdx::thread> _workers;
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -418,27 +807,42 @@ public:
         _memUsed += key.memUsageForSorter();
         _memUsed += val.memUsageForSorter();
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        if (_memUsed > maxRunBytes())
             spill();
     }
 
     Iterator* done() {
-        if (_iters.empty()) {
+        if (_iters.empty() && !_runWriter) {
             sort();
             return new InMemIterator<Key, Value>(_data);
         }
 
-        spill();
+        if (_runWriter) {
+            if (!_data.empty())
+                _runWriter->write(&_data);
+            _memUsed = 0;
+            _iters = _runWriter->finish();
+            _spillStats += _runWriter->spillStats();
+            _runWriter.reset();
+        } else {
+            spill();
+        }
         return Iterator::merge(_iters, _opts, _comp);
     }
 
     // TEMP these are here for compatibility. Will be replaced with a general stats API
     int numFiles() const {
-        return _iters.size();
+        return _runWriter ? _runWriter->numRuns() : _iters.size();
     }
     size_t memUsed() const {
         return _memUsed;
     }
+    SorterSpillStats spillStats() const {
+        SorterSpillStats stats = _spillStats;
+        if (_runWriter)
+            stats += _runWriter->spillStats();
+        return stats;
+    }
 
 private:
     class STLComparator {
@@ -479,6 +883,11 @@ private:
                           << " Pass allowDiskUse:true to opt in.");
         }
 
+        if (_opts.workerThreads > 1) {
+            spillInParallel();
+            return;
+        }
+
         sort();
 
         SortedFileWriter<Key, Value> writer(_opts, _settings);
@@ -487,16 +896,62 @@ private:
         }
 
         _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+        _spillStats += writer.spillStats();
 
         _memUsed = 0;
     }
 
+    // Once runs are being written in the background, the data being added and the runs handed
+    // over to the workers share the memory limit.
+    size_t maxRunBytes() const {
+        return _runWriter ? _opts.maxMemoryUsageBytes / (_opts.workerThreads + 1)
+                          : _opts.maxMemoryUsageBytes;
+    }
+
+    // Hands _data over to the workers to be sorted and spilled, in runs of maxRunBytes(). The
+    // first spill is split up like the ones that follow, so that it is sorted in parallel too and
+    // the memory limit holds while later runs are added. Whatever is left over stays in _data.
+    void spillInParallel() {
+        if (!_runWriter) {
+            _runWriter = stdx::make_unique<ParallelRunWriter<Key, Value>>(
+                _opts,
+                _settings,
+                [this](std::deque<Data>* run) {
+                    STLComparator less(_comp);
+                    std::stable_sort(run->begin(), run->end(), less);
+                },
+                std::make_shared<FileReadAhead>(kReadAheadBlocks));
+        }
+
+        const size_t runBytes = maxRunBytes();
+        while (_memUsed > runBytes) {
+            std::deque<Data> run;
+            size_t runUsed = 0;
+            while (!_data.empty() && runUsed < runBytes) {
+                runUsed += _data.front().first.memUsageForSorter();
+                runUsed += _data.front().second.memUsageForSorter();
+                run.push_back(std::move(_data.front()));
+                _data.pop_front();
+            }
+            _memUsed -= runUsed;
+            _runWriter->write(&run);
+        }
+    }
+
+    // Blocks of each spilled run that are read ahead while merging.
+    enum { kReadAheadBlocks = 2 };
+
     const Comparator _comp;
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
+    SorterSpillStats _spillStats;                   // of the runs spilled on this thread
+
+    // Sorts and spills runs on worker threads. Only used with _opts.workerThreads > 1, once the
+    // first run is spilled. Declared last so that the workers stop before the rest is destroyed.
+    std::unique_ptr<ParallelRunWriter<Key, Value>> _runWriter;
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -541,6 +996,9 @@ public:
     size_t memUsed() const {
         return _best.first.memUsageForSorter() + _best.second.memUsageForSorter();
     }
+    SorterSpillStats spillStats() const {
+        return SorterSpillStats();
+    }
 
 private:
     const Comparator _comp;
@@ -638,6 +1096,9 @@ public:
     size_t memUsed() const {
         return _memUsed;
     }
+    SorterSpillStats spillStats() const {
+        return _spillStats;
+    }
 
 private:
     class STLComparator {
@@ -772,6 +1233,7 @@ private:
         std::vector<Data>().swap(_data);
 
         _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+        _spillStats += writer.spillStats();
 
         _memUsed = 0;
     }
@@ -782,6 +1244,7 @@ private:
     size_t _memUsed;
     std::vector<Data> _data;  // the "current" data. Organized as max-heap if size == limit.
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
+    SorterSpillStats _spillStats;
 
     // See updateCutoff() for a full description of how these members are used.
     bool _haveCutoff;
@@ -805,8 +1268,10 @@ inline unsigned nextFileNumber() {
 
 
 template <typename Key, typename Value>
-SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts, const Settings& settings)
-    : _settings(settings) {
+SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
+                                               const Settings& settings,
+                                               std::shared_ptr<sorter::FileReadAhead> readAhead)
+    : _settings(settings), _compress(opts.compressionLevel > 0), _readAhead(std::move(readAhead)) {
     namespace str = mongoutils::str;
 
     // This should be checked by consumers, but if we get here don't allow writes.
@@ -857,10 +1322,13 @@ void SortedFileWriter<Key, Value>::spill() {
         return;
 
     std::string compressed;
-    snappy::Compress(outBuffer, size, &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    if (_compress) {
+        snappy::Compress(outBuffer, size, &compressed);
+        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    }
 
-    const bool shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
+    const bool shouldCompress =
+        _compress && compressed.size() < size_t(_buffer.len() / 10 * 9);
     if (shouldCompress) {
         size = compressed.size();
         outBuffer = const_cast<char*>(compressed.data());
@@ -884,10 +1352,14 @@ void SortedFileWriter<Key, Value>::spill() {
         size = resultLen;
     }
 
+    // Each block is stored as its size, the checksum of its data, then the data itself.
     // negative size means compressed
+    const uint32_t checksum = sorter::sortedFileBlockChecksum(outBuffer, size);
+    const long long bytesWritten = sizeof(size) + sizeof(checksum) + size;
     size = shouldCompress ? -size : size;
     try {
         _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        _file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
         _file.write(outBuffer, std::abs(size));
 
     } catch (const std::exception&) {
@@ -896,6 +1368,11 @@ void SortedFileWriter<Key, Value>::spill() {
                                   << sorter::myErrnoWithDescription());
     }
 
+    _spillStats.bytes += _buffer.len();
+    _spillStats.compressedBytes += bytesWritten;
+    sorterSpilledBytes.increment(_buffer.len());
+    sorterSpilledCompressedBytes.increment(bytesWritten);
+
     _buffer.reset();
 }
 
@@ -903,7 +1380,7 @@ template <typename Key, typename Value>
 SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     spill();
     _file.close();
-    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter);
+    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter, _readAhead);
 }
 
 //
@@ -933,6 +1410,8 @@ Sorter<Key, Value>* Sorter<Key, Value>::make(const SortOptions& opts,
             "Attempting to use external sort without setting SortOptions::tempDir",
             !(opts.extSortAllowed && opts.tempDir.empty()));
 
+    invariant(opts.workerThreads > 0);
+
     switch (opts.limit) {
         case 0:
             return new sorter::NoLimitSorter<Key, Value, Comparator>(opts, comp, settings);
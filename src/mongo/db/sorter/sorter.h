@@ -64,7 +64,8 @@
  *
  * Comparators are functors that that compare std::pair<Key, Value> and return an
  * int less than, equal to, or greater than 0 depending on how the two pairs
- * compare with the same semantics as memcmp.
+ * compare with the same semantics as memcmp. With SortOptions::workerThreads
+ * above one, the comparator is called from several threads at once.
  * Example for Key=BSONObj, Value=int:
  *
  * class MyComparator {
@@ -87,6 +88,7 @@ namespace mongo {
 namespace sorter {
 // Everything in this namespace is internal to the sorter
 class FileDeleter;
+class FileReadAhead;
 }
 
 /**
@@ -98,8 +100,17 @@ struct SortOptions {
     bool extSortAllowed;         /// If false, uassert if more mem needed than allowed.
     std::string tempDir;         /// Directory to directly place files in.
                                  /// Must be explicitly set if extSortAllowed is true.
-
-    SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
+    size_t workerThreads;        /// Threads that sort and spill runs of an external sort
+                                 /// without a limit. 1 does it all on the calling thread.
+    int compressionLevel;        /// How spilled blocks are compressed. 0 writes them as is,
+                                 /// 1 compresses them with snappy.
+
+    SortOptions()
+        : limit(0),
+          maxMemoryUsageBytes(64 * 1024 * 1024),
+          extSortAllowed(false),
+          workerThreads(1),
+          compressionLevel(1) {}
 
     /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
 
@@ -122,6 +133,28 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& WorkerThreads(size_t newWorkerThreads) {
+        workerThreads = newWorkerThreads;
+        return *this;
+    }
+
+    SortOptions& CompressionLevel(int newCompressionLevel) {
+        compressionLevel = newCompressionLevel;
+        return *this;
+    }
+};
+
+/// The amount of data a sort has spilled to disk
+struct SorterSpillStats {
+    long long bytes = 0;            /// Serialized data, before compression.
+    long long compressedBytes = 0;  /// Written to disk, including block headers.
+
+    SorterSpillStats& operator+=(const SorterSpillStats& other) {
+        bytes += other.bytes;
+        compressedBytes += other.compressedBytes;
+        return *this;
+    }
 };
 
 /// This is the output from the sorting framework
@@ -175,6 +208,7 @@ public:
     // TEMP these are here for compatibility. Will be replaced with a general stats API
     virtual int numFiles() const = 0;
     virtual size_t memUsed() const = 0;
+    virtual SorterSpillStats spillStats() const = 0;
 
 protected:
     Sorter() {}  // can only be constructed as a base
@@ -191,19 +225,28 @@ public:
                       typename Value::SorterDeserializeSettings>
         Settings;
 
-    explicit SortedFileWriter(const SortOptions& opts, const Settings& settings = Settings());
+    explicit SortedFileWriter(const SortOptions& opts,
+                              const Settings& settings = Settings(),
+                              std::shared_ptr<sorter::FileReadAhead> readAhead = nullptr);
 
     void addAlreadySorted(const Key&, const Value&);
     Iterator* done();  /// Can't add more data after calling done()
 
+    SorterSpillStats spillStats() const {
+        return _spillStats;
+    }
+
 private:
     void spill();
 
     const Settings _settings;
+    const bool _compress;
     std::string _fileName;
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
+    std::shared_ptr<sorter::FileReadAhead> _readAhead;  // Reads the file for the iterator, if set
     std::ofstream _file;
     BufBuilder _buffer;
+    SorterSpillStats _spillStats;
 };
 }
 
@@ -223,6 +266,7 @@ private:
     template class ::mongo::sorter::MergeIterator<Key, Value, Comparator>;               \
     template class ::mongo::sorter::InMemIterator<Key, Value>;                           \
     template class ::mongo::sorter::FileIterator<Key, Value>;                            \
+    template class ::mongo::sorter::ParallelRunWriter<Key, Value>;                       \
     /* factory functions */                                                              \
     template ::mongo::SortIteratorInterface<Key, Value>* ::mongo::                       \
         SortIteratorInterface<Key, Value>::merge<Comparator>(                            \
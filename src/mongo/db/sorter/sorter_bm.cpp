@@ -0,0 +1,104 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/platform/random.h"
+
+namespace mongo {
+namespace {
+
+class BSONObjRecordIdComparator {
+public:
+    typedef std::pair<BSONObj, RecordId> Data;
+    int operator()(const Data& lhs, const Data& rhs) const {
+        int ret = lhs.first.woCompare(rhs.first, BSONObj(), false);
+        if (ret)
+            return ret;
+        return lhs.second.compare(rhs.second);
+    }
+};
+
+typedef Sorter<BSONObj, RecordId> BSONObjRecordIdSorter;
+
+const int kNumKeys = 1000 * 1000;
+const size_t kMaxMemoryUsageBytes = 16 * 1024 * 1024;
+
+/**
+ * Sorts index-like keys of several fields through an external sort which has to spill and merge a
+ * few dozen runs. The argument is the number of worker threads.
+ */
+void BM_ExternalSort(benchmark::State& state) {
+    const boost::filesystem::path tempDir =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("sorter_bm-%%%%");
+
+    std::vector<BSONObj> keys;
+    keys.reserve(kNumKeys);
+    PseudoRandom random(1);
+    for (int i = 0; i < kNumKeys; i++) {
+        keys.push_back(BSON("" << random.nextInt32() << "" << random.nextInt64() << ""
+                               << "key"));
+    }
+
+    const SortOptions opts = SortOptions()
+                                 .TempDir(tempDir.string())
+                                 .ExtSortAllowed()
+                                 .MaxMemoryUsageBytes(kMaxMemoryUsageBytes)
+                                 .WorkerThreads(state.range(0));
+
+    for (auto keepRunning : state) {
+        std::unique_ptr<BSONObjRecordIdSorter> sorter(
+            BSONObjRecordIdSorter::make(opts, BSONObjRecordIdComparator()));
+        for (int i = 0; i < kNumKeys; i++) {
+            sorter->add(keys[i], RecordId(i + 1));
+        }
+
+        std::unique_ptr<BSONObjRecordIdSorter::Iterator> it(sorter->done());
+        sorter.reset();
+        while (it->more()) {
+            benchmark::DoNotOptimize(it->next());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * kNumKeys);
+    boost::filesystem::remove_all(tempDir);
+}
+
+BENCHMARK(BM_ExternalSort)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::RecordId, mongo::BSONObjRecordIdComparator);
@@ -45,6 +45,7 @@
 // Need access to internal classes
 #include "mongo/db/sorter/sorter.cpp"
 
+#include <fstream>
 #include <memory>
 
 namespace mongo {
@@ -267,6 +268,74 @@ public:
     }
 };
 
+class SortedFileWriterCompressionTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterCompressionTests");
+        const int kNumPairs = 100 * 1000;
+        SorterSpillStats uncompressed;
+        {
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(
+                SortOptions().TempDir(tempDir.path()).CompressionLevel(0));
+            for (int i = 0; i < kNumPairs; i++)
+                sorter.addAlreadySorted(0, 0);
+
+            std::shared_ptr<IWIterator> iter(sorter.done());
+            uncompressed = sorter.spillStats();
+            for (int i = 0; i < kNumPairs; i++) {
+                ASSERT(iter->more());
+                ASSERT_EQUALS(0, iter->next().first);
+            }
+            ASSERT_FALSE(iter->more());
+        }
+        ASSERT_EQUALS(kNumPairs * 2 * static_cast<long long>(sizeof(int)), uncompressed.bytes);
+        ASSERT_GREATER_THAN(uncompressed.compressedBytes, uncompressed.bytes);
+
+        SorterSpillStats compressed;
+        {
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(
+                SortOptions().TempDir(tempDir.path()).CompressionLevel(1));
+            for (int i = 0; i < kNumPairs; i++)
+                sorter.addAlreadySorted(0, 0);
+
+            std::shared_ptr<IWIterator> iter(sorter.done());
+            compressed = sorter.spillStats();
+            for (int i = 0; i < kNumPairs; i++) {
+                ASSERT(iter->more());
+                ASSERT_EQUALS(0, iter->next().first);
+            }
+            ASSERT_FALSE(iter->more());
+        }
+        ASSERT_EQUALS(uncompressed.bytes, compressed.bytes);
+        ASSERT_LESS_THAN(compressed.compressedBytes, compressed.bytes / 2);
+
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
+class SortedFileWriterChecksumTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterChecksumTests");
+        SortedFileWriter<IntWrapper, IntWrapper> sorter(SortOptions().TempDir(tempDir.path()));
+        for (int i = 0; i < 1000; i++)
+            sorter.addAlreadySorted(i, -i);
+        std::shared_ptr<IWIterator> iter(sorter.done());
+
+        // Flip the last byte of the only block in the file.
+        boost::filesystem::directory_iterator file(tempDir.path());
+        ASSERT(file != boost::filesystem::directory_iterator());
+        std::fstream stream(file->path().string(),
+                            std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekg(-1, std::ios::end);
+        const char last = stream.get();
+        stream.seekp(-1, std::ios::end);
+        stream.put(~last);
+        stream.close();
+
+        ASSERT_THROWS_CODE(iter->more(), AssertionException, 51007);
+    }
+};
 
 class MergeIteratorTests {
 public:
@@ -321,6 +390,19 @@ public:
                 mergeIterators(iterators, ASC, SortOptions().Limit(10)),
                 make_shared<LimitIterator>(10, make_shared<IntIterator>(0, 20, 1)));
         }
+        {  // test more sources than fit a balanced tournament
+            std::shared_ptr<IWIterator> iterators[] = {make_shared<IntIterator>(0, 100, 7),
+                                                       make_shared<IntIterator>(1, 100, 7),
+                                                       make_shared<EmptyIterator>(),
+                                                       make_shared<IntIterator>(2, 100, 7),
+                                                       make_shared<IntIterator>(3, 100, 7),
+                                                       make_shared<IntIterator>(4, 100, 7),
+                                                       make_shared<IntIterator>(5, 100, 7),
+                                                       make_shared<IntIterator>(6, 100, 7)};
+
+            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC),
+                                        make_shared<IntIterator>(0, 100, 1));
+        }
     }
 };
 
@@ -509,6 +591,13 @@ public:
 };
 
 
+template <bool Random = true>
+class LotsOfDataParallel : public LotsOfDataLittleMemory<Random> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        return LotsOfDataLittleMemory<Random>::adjustSortOptions(opts).WorkerThreads(4);
+    }
+};
+
 template <long long Limit, bool Random = true>
 class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
     typedef LotsOfDataLittleMemory<Random> Parent;
@@ -541,12 +630,16 @@ public:
     void setupTests() {
         add<InMemIterTests>();
         add<SortedFileWriterAndFileIteratorTests>();
+        add<SortedFileWriterCompressionTests>();
+        add<SortedFileWriterChecksumTests>();
         add<MergeIteratorTests>();
         add<SorterTests::Basic>();
         add<SorterTests::Limit>();
         add<SorterTests::Dupes>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/false>>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::LotsOfDataParallel</*random=*/false>>();
+        add<SorterTests::LotsOfDataParallel</*random=*/true>>();
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/false>>();     // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/true>>();      // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/false>>();   // fits in mem
@@ -225,6 +225,7 @@ const StringData stageName[] = {
     "MultiPlanStage",           /// STAGE_MULTI_PLAN,
     "OplogStart",               /// STAGE_OPLOG_START,
     "OrStage",                  /// STAGE_OR,
+    "ParallelCollectionScan",   /// STAGE_PARALLEL_COLLSCAN,
     "ProjectionStage",          /// STAGE_PROJECTION,
     "PipelineProxyStage",       /// STAGE_PIPELINE_PROXY,
     "QueuedDataStage",          /// STAGE_QUEUED_DATA,
@@ -242,51 +243,113 @@ const StringData stageName[] = {
     ""                          /// STAGE_INVALID
 };
 
+const size_t StageMemCounter::kNumSlabs;
+const int64_t StageMemCounter::kSlabReconcileBytes;
+
+StageMemCounter::Slab& StageMemCounter::_slabForThisThread() {
+    static AtomicUInt32 nextSlab;
+    static thread_local const size_t slab = nextSlab.fetchAndAdd(1) % kNumSlabs;
+    return _slabs[slab];
+}
+
+int64_t StageMemCounter::_sum(const StageType& type,
+                              AtomicInt64 StageTypeCounter::*field) const {
+    int64_t sum = 0;
+    for (auto&& slab : _slabs) {
+        sum += (slab.stages[type].*field).load();
+    }
+    return sum;
+}
+
+int64_t StageMemCounter::getTotalMemSize() const {
+    int64_t total = _reconciledMem.load();
+    for (auto&& slab : _slabs) {
+        total += slab.unreconciledMem.load();
+    }
+    return total;
+}
+
 BSONObj StageMemCounter::getObj() const {
     if (!internalQueryStageMemUsageSwitch.load()) {
         return BSONObj();
     }
-    BSONObjBuilder b;
-    b.append("Total Stage Memory", _totalMem.get());
+
+    BSONObjBuilder stages;
+    long long totalSpilled = 0;
     for (int32_t i = 0; (i < STAGE_INVALID) && (stageName[i] != ""); ++i) {
-        BSONObjBuilder sub;
-        sub.append("objectCount", _stageMap[i]._objectCount.get());
-        sub.append("StageMem", _stageMap[i]._memSize.get());
-        b.append(stageName[i], sub.obj());
+        const StageType type = static_cast<StageType>(i);
+        const long long spilled = _sum(type, &StageTypeCounter::spilledSize);
+        totalSpilled += spilled;
+
+        BSONObjBuilder sub(stages.subobjStart(stageName[i]));
+        sub.append("objectCount",
+                   static_cast<long long>(_sum(type, &StageTypeCounter::objectCount)));
+        sub.append("StageMem", static_cast<long long>(_sum(type, &StageTypeCounter::memSize)));
+        sub.append("SpilledBytes", spilled);
     }
+
+    BSONObjBuilder b;
+    b.append("Total Stage Memory", static_cast<long long>(getTotalMemSize()));
+    b.append("Total Spilled Stage Memory", totalSpilled);
+    b.appendElements(stages.done());
     return b.obj();
 }
 
 void StageMemCounter::incCachedMemSize(const StageType& type, const size_t& size) {
-    _totalMem.increment(size);
-    _stageMap[type]._memSize.increment(size);
+    Slab& slab = _slabForThisThread();
+    slab.stages[type].memSize.fetchAndAdd(size);
+    if (slab.unreconciledMem.addAndFetch(size) >= kSlabReconcileBytes) {
+        _reconciledMem.fetchAndAdd(slab.unreconciledMem.swap(0));
+    }
 }
 
 void StageMemCounter::incMemObj(const StageType& type) {
-    _stageMap[type]._objectCount.increment();
+    _slabForThisThread().stages[type].objectCount.fetchAndAdd(1);
 }
 
 void StageMemCounter::decCachedMemSize(const StageType& type, const size_t& size) {
-    _totalMem.decrement(size);
-    _stageMap[type]._memSize.decrement(size);
+    Slab& slab = _slabForThisThread();
+    slab.stages[type].memSize.fetchAndSubtract(size);
+    if (slab.unreconciledMem.subtractAndFetch(size) <= -kSlabReconcileBytes) {
+        _reconciledMem.fetchAndAdd(slab.unreconciledMem.swap(0));
+    }
 }
 
 void StageMemCounter::decMemObj(const StageType& type) {
-    _stageMap[type]._objectCount.decrement();
+    _slabForThisThread().stages[type].objectCount.fetchAndSubtract(1);
+}
+
+void StageMemCounter::incSpilledMemSize(const StageType& type, const size_t& size) {
+    _slabForThisThread().stages[type].spilledSize.fetchAndAdd(size);
 }
 
 bool StageMemCounter::chkCachedMemOversize(const size_t& cachedMemSize) const {
-    if (internalQueryStageMemUsageSwitch.load() &&
-        (cachedMemSize > static_cast<size_t>(internalQueryStageMemUsageMIN.load())) &&
-        (_totalMem.get() > static_cast<int64_t>(internalQueryStageMemUsageMAX.load()))) {
+    if (!internalQueryStageMemUsageSwitch.load() ||
+        (cachedMemSize <= static_cast<size_t>(internalQueryStageMemUsageMIN.load()))) {
+        return false;
+    }
+
+    // Each slab holds back less than kSlabReconcileBytes, so the reconciled total is only worth
+    // summing up exactly when it is within that much per slab of the limit.
+    const int64_t maxMem = internalQueryStageMemUsageMAX.load();
+    const int64_t maxError = kSlabReconcileBytes * static_cast<int64_t>(kNumSlabs);
+    const int64_t reconciledMem = _reconciledMem.load();
+    if (reconciledMem > maxMem + maxError) {
         return true;
     }
-    return false;
+    if (reconciledMem + maxError <= maxMem) {
+        return false;
+    }
+    return getTotalMemSize() > maxMem;
 }
 
 OpCounters globalOpCounters;
 OpCounters replOpCounters;
 NetworkCounter networkCounter;
+
+Counter64 sorterSpilledBytes;
+Counter64 sorterSpilledCompressedBytes;
+
 /// OOM feature
 StageMemCounter globalStageMemCounters;
 }
@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <array>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -128,9 +130,25 @@ private:
 
 extern NetworkCounter networkCounter;
 
+// Bytes written to the spill files of external sorts, before and after compression. Reported
+// under serverStatus.metrics.sorter.
+extern Counter64 sorterSpilledBytes;
+extern Counter64 sorterSpilledCompressedBytes;
+
 // Provide a memory usage limitation for the stage object.
+//
+// Every buffered working set member updates these counters, so they are split into slabs which
+// each thread updates without contending with the threads on other slabs. The global total that
+// chkCachedMemOversize() compares against the limit is only reconciled once a slab has
+// accumulated kSlabReconcileBytes, and it is read exactly only when it is close to the limit.
 class StageMemCounter {
 public:
+    // Number of slabs. Threads are assigned to them round robin.
+    static const size_t kNumSlabs = 64;
+
+    // The change in memory a slab may hold back from the global total.
+    static const int64_t kSlabReconcileBytes = 64 * 1024;
+
     StageMemCounter() {}
     ~StageMemCounter() {}
 
@@ -140,21 +158,43 @@ public:
     void incMemObj(const StageType& type);
     void decMemObj(const StageType& type);
 
+    /**
+     * Records 'size' bytes of buffered stage data that were moved to disk instead of failing the
+     * operation. See internalQueryStageMemUsageSpill.
+     */
+    void incSpilledMemSize(const StageType& type, const size_t& size);
+
     bool chkCachedMemOversize(const size_t& cachedMemSize) const;
-    int64_t getTotalMemSize() const {
-        return _totalMem.get();
-    };
+
+    /**
+     * Returns the memory cached by all stages, summed over all slabs.
+     */
+    int64_t getTotalMemSize() const;
 
     BSONObj getObj() const;
 
 private:
-    Counter64 _totalMem;
-
     struct StageTypeCounter {
-        Counter64 _objectCount;
-        Counter64 _memSize;
+        AtomicInt64 objectCount;
+        AtomicInt64 memSize;
+        AtomicInt64 spilledSize;
+    };
+
+    struct Slab {
+        // Change of the total not yet added to _reconciledMem.
+        AtomicInt64 unreconciledMem;
+        StageTypeCounter stages[STAGE_INVALID];
     };
-    StageTypeCounter _stageMap[STAGE_INVALID];
+
+    Slab& _slabForThisThread();
+
+    // Sums 'field' of the counters of 'type' over all slabs.
+    int64_t _sum(const StageType& type, AtomicInt64 StageTypeCounter::*field) const;
+
+    // The total of the memory cached by all stages, without the unreconciled slab deltas.
+    CacheAligned<AtomicInt64> _reconciledMem{0};
+
+    std::array<CacheAligned<Slab>, kNumSlabs> _slabs;
 };
 
 extern StageMemCounter globalStageMemCounters;
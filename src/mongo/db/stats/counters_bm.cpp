@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+namespace {
+
+const int kMaxPerfThreads = 64;
+
+// Roughly what a sort stage accounts for one buffered working set member.
+const size_t kMemberBytes = 200;
+
+/**
+ * Turns on the stage memory limit for stages of any size, with a limit high enough that it is never
+ * reached, and restores the previous settings afterwards.
+ */
+class StageMemCounterTest : public benchmark::Fixture {
+public:
+    void SetUp(benchmark::State& state) override {
+        if (state.thread_index == 0) {
+            _oldSwitch = internalQueryStageMemUsageSwitch.swap(true);
+            _oldMax = internalQueryStageMemUsageMAX.swap(1024LL * 1024 * 1024 * 1024);
+            _oldMin = internalQueryStageMemUsageMIN.swap(0);
+        }
+    }
+
+    void TearDown(benchmark::State& state) override {
+        if (state.thread_index == 0) {
+            internalQueryStageMemUsageSwitch.store(_oldSwitch);
+            internalQueryStageMemUsageMAX.store(_oldMax);
+            internalQueryStageMemUsageMIN.store(_oldMin);
+        }
+    }
+
+private:
+    bool _oldSwitch;
+    long long _oldMax;
+    long long _oldMin;
+};
+
+/**
+ * What a stage does for each member it buffers and later releases: account for it, check the
+ * limit, and give it back.
+ */
+BENCHMARK_DEFINE_F(StageMemCounterTest, BM_StageMemCounterIncCheckDec)(benchmark::State& state) {
+    static StageMemCounter counter;
+    size_t cachedMemSize = 0;
+
+    for (auto keepRunning : state) {
+        counter.incCachedMemSize(STAGE_SORT, kMemberBytes);
+        cachedMemSize += kMemberBytes;
+        benchmark::DoNotOptimize(counter.chkCachedMemOversize(cachedMemSize));
+        counter.decCachedMemSize(STAGE_SORT, kMemberBytes);
+        cachedMemSize -= kMemberBytes;
+    }
+}
+
+/**
+ * Same as above against the single pair of shared counters that every thread used to update, for
+ * comparison.
+ */
+BENCHMARK_DEFINE_F(StageMemCounterTest, BM_SharedAtomicIncCheckDec)(benchmark::State& state) {
+    static AtomicInt64 totalMem;
+    static AtomicInt64 sortMem;
+    size_t cachedMemSize = 0;
+
+    for (auto keepRunning : state) {
+        totalMem.fetchAndAdd(kMemberBytes);
+        sortMem.fetchAndAdd(kMemberBytes);
+        cachedMemSize += kMemberBytes;
+        benchmark::DoNotOptimize(
+            internalQueryStageMemUsageSwitch.load() &&
+            cachedMemSize > static_cast<size_t>(internalQueryStageMemUsageMIN.load()) &&
+            totalMem.load() > internalQueryStageMemUsageMAX.load());
+        totalMem.fetchAndSubtract(kMemberBytes);
+        sortMem.fetchAndSubtract(kMemberBytes);
+        cachedMemSize -= kMemberBytes;
+    }
+}
+
+BENCHMARK_REGISTER_F(StageMemCounterTest, BM_StageMemCounterIncCheckDec)
+    ->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK_REGISTER_F(StageMemCounterTest, BM_SharedAtomicIncCheckDec)
+    ->ThreadRange(1, kMaxPerfThreads);
+
+}  // namespace
+}  // namespace mongo
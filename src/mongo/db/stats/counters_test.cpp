@@ -0,0 +1,132 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/counters.h"
+
+#include <vector>
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class StageMemCounterTest : public unittest::Test {
+protected:
+    void setUp() final {
+        _oldSwitch = internalQueryStageMemUsageSwitch.swap(true);
+        _oldMax = internalQueryStageMemUsageMAX.load();
+        _oldMin = internalQueryStageMemUsageMIN.swap(0);
+    }
+
+    void tearDown() final {
+        internalQueryStageMemUsageSwitch.store(_oldSwitch);
+        internalQueryStageMemUsageMAX.store(_oldMax);
+        internalQueryStageMemUsageMIN.store(_oldMin);
+    }
+
+private:
+    bool _oldSwitch;
+    long long _oldMax;
+    long long _oldMin;
+};
+
+TEST_F(StageMemCounterTest, TotalsAreExactAcrossThreads) {
+    // StageMemCounter is over-aligned, so it lives on the stack rather than the heap.
+    StageMemCounter counter;
+    const int kThreads = 8;
+    const int kIncrements = 10000;
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            counter.incMemObj(STAGE_SORT);
+            for (int j = 0; j < kIncrements; ++j) {
+                counter.incCachedMemSize(STAGE_SORT, 100);
+            }
+            counter.incSpilledMemSize(STAGE_SORT, 10);
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQUALS(kThreads * kIncrements * 100LL, counter.getTotalMemSize());
+    BSONObj stats = counter.getObj();
+    ASSERT_EQUALS(kThreads * kIncrements * 100LL, stats["Total Stage Memory"].numberLong());
+    ASSERT_EQUALS(kThreads * 10LL, stats["Total Spilled Stage Memory"].numberLong());
+    ASSERT_EQUALS(kThreads * kIncrements * 100LL, stats["SortStage"]["StageMem"].numberLong());
+    ASSERT_EQUALS(kThreads, stats["SortStage"]["objectCount"].numberLong());
+    ASSERT_EQUALS(0, stats["AndHashStage"]["StageMem"].numberLong());
+
+    for (int i = 0; i < kThreads; ++i) {
+        threads[i] = stdx::thread([&] {
+            for (int j = 0; j < kIncrements; ++j) {
+                counter.decCachedMemSize(STAGE_SORT, 100);
+            }
+            counter.decMemObj(STAGE_SORT);
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQUALS(0, counter.getTotalMemSize());
+    ASSERT_EQUALS(0, counter.getObj()["SortStage"]["objectCount"].numberLong());
+}
+
+TEST_F(StageMemCounterTest, OversizeCheckIsExactNearTheLimit) {
+    StageMemCounter counter;
+    internalQueryStageMemUsageMAX.store(1000);
+
+    // Far less than a slab reconciles, so none of this has reached the global total yet.
+    counter.incCachedMemSize(STAGE_SORT, 1000);
+    ASSERT_FALSE(counter.chkCachedMemOversize(1000));
+    counter.incCachedMemSize(STAGE_SORT, 1);
+    ASSERT_TRUE(counter.chkCachedMemOversize(1001));
+    counter.decCachedMemSize(STAGE_SORT, 1);
+    ASSERT_FALSE(counter.chkCachedMemOversize(1000));
+}
+
+TEST_F(StageMemCounterTest, OversizeCheckHonoursSwitchAndMinimum) {
+    StageMemCounter counter;
+    internalQueryStageMemUsageMAX.store(0);
+    counter.incCachedMemSize(STAGE_SORT, 100);
+    ASSERT_TRUE(counter.chkCachedMemOversize(100));
+
+    internalQueryStageMemUsageMIN.store(100);
+    ASSERT_FALSE(counter.chkCachedMemOversize(100));
+
+    internalQueryStageMemUsageMIN.store(0);
+    internalQueryStageMemUsageSwitch.store(false);
+    ASSERT_FALSE(counter.chkCachedMemOversize(100));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -29,6 +29,10 @@
 
 #include "mongo/db/stats/timer_stats.h"
 
+#include <algorithm>
+
+#include "mongo/platform/bits.h"
+
 namespace mongo {
 
 TimerHolder::TimerHolder(TimerStats* stats) : _stats(stats), _recorded(false) {}
@@ -69,4 +73,42 @@ BSONObj TimerStats::getReport() const {
     b.appendNumber("totalMillis", t);
     return b.obj();
 }
+
+constexpr int TimerHistogramStats::kNumBuckets;
+
+const std::array<long long, TimerHistogramStats::kNumBuckets> TimerHistogramStats::kLowerBounds = {
+    0, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216};
+
+int TimerHistogramStats::getBucket(long long micros) {
+    if (micros < kLowerBounds[1]) {
+        return 0;
+    }
+    // 64 micros is 4^3, the lower bound of the second bucket.
+    const int log4 = (63 - countLeadingZeros64(micros)) / 2;
+    return std::min(log4 - 2, kNumBuckets - 1);
+}
+
+void TimerHistogramStats::recordMicros(long long micros) {
+    _num.fetchAndAdd(1);
+    _totalMicros.fetchAndAdd(micros);
+    _buckets[getBucket(micros)].fetchAndAdd(1);
+}
+
+long long TimerHistogramStats::record(const Timer& timer) {
+    long long micros = timer.micros();
+    recordMicros(micros);
+    return micros;
+}
+
+BSONObj TimerHistogramStats::getReport() const {
+    BSONObjBuilder b(512);
+    b.appendNumber("num", _num.loadRelaxed());
+    b.appendNumber("totalMicros", _totalMicros.loadRelaxed());
+    BSONObjBuilder histogram(b.subobjStart("histogram"));
+    for (int i = 0; i < kNumBuckets; i++) {
+        histogram.appendNumber(std::to_string(kLowerBounds[i]), _buckets[i].loadRelaxed());
+    }
+    histogram.doneFast();
+    return b.obj();
+}
 }
@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <array>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/util/timer.h"
 
@@ -59,6 +61,38 @@ private:
     AtomicInt64 _totalMillis;
 };
 
+/**
+ * Holds the number, total and distribution of durations in microseconds, with buckets whose lower
+ * bounds are 0 and the powers of 4 from 64 micros to 16 seconds. The report always has the same
+ * fields, so that FTDC can keep it in a single schema.
+ */
+class TimerHistogramStats {
+public:
+    static constexpr int kNumBuckets = 11;
+
+    // Inclusive lower bounds of the buckets, in microseconds.
+    static const std::array<long long, kNumBuckets> kLowerBounds;
+
+    void recordMicros(long long micros);
+
+    /**
+     * @return number of micros
+     */
+    long long record(const Timer& timer);
+
+    BSONObj getReport() const;
+    operator BSONObj() const {
+        return getReport();
+    }
+
+    static int getBucket(long long micros);
+
+private:
+    AtomicInt64 _num;
+    AtomicInt64 _totalMicros;
+    std::array<AtomicInt64, kNumBuckets> _buckets;
+};
+
 /**
  * Holds an instance of a Timer such that we the time is recorded
  * when the TimerHolder goes out of scope
@@ -48,4 +48,42 @@ TEST(TimerStatsTest, GetReportOneRecording) {
     ASSERT_BSONOBJ_EQ(BSON("num" << 1 << "totalMillis" << millis), timerStats.getReport());
 }
 
+TEST(TimerHistogramStatsTest, GetReportNoRecording) {
+    auto report = TimerHistogramStats().getReport();
+    ASSERT_EQ(0, report["num"].numberLong());
+    ASSERT_EQ(0, report["totalMicros"].numberLong());
+    ASSERT_EQ(TimerHistogramStats::kNumBuckets, report["histogram"].Obj().nFields());
+    for (auto&& bucket : report["histogram"].Obj()) {
+        ASSERT_EQ(0, bucket.numberLong());
+    }
+}
+
+TEST(TimerHistogramStatsTest, BucketBounds) {
+    ASSERT_EQ(0, TimerHistogramStats::getBucket(0));
+    ASSERT_EQ(0, TimerHistogramStats::getBucket(63));
+    for (int i = 1; i < TimerHistogramStats::kNumBuckets; i++) {
+        const auto lowerBound = TimerHistogramStats::kLowerBounds[i];
+        ASSERT_EQ(i - 1, TimerHistogramStats::getBucket(lowerBound - 1));
+        ASSERT_EQ(i, TimerHistogramStats::getBucket(lowerBound));
+    }
+    ASSERT_EQ(TimerHistogramStats::kNumBuckets - 1,
+              TimerHistogramStats::getBucket(1000LL * 1000 * 1000 * 1000));
+}
+
+TEST(TimerHistogramStatsTest, GetReportRecordings) {
+    TimerHistogramStats stats;
+    stats.recordMicros(10);
+    stats.recordMicros(300);
+    stats.recordMicros(1000);
+    stats.recordMicros(20 * 1000 * 1000);
+    auto report = stats.getReport();
+    ASSERT_EQ(4, report["num"].numberLong());
+    ASSERT_EQ(20 * 1000 * 1000 + 1310, report["totalMicros"].numberLong());
+    auto histogram = report["histogram"].Obj();
+    ASSERT_EQ(1, histogram["0"].numberLong());
+    ASSERT_EQ(2, histogram["256"].numberLong());
+    ASSERT_EQ(0, histogram["1024"].numberLong());
+    ASSERT_EQ(1, histogram["16777216"].numberLong());
+}
+
 }  // namespace
@@ -509,6 +509,28 @@ public:
         return out;
     }
 
+    /**
+     * Returns up to 'maxRanges' - 1 RecordIds, in increasing order, which split the store into
+     * ranges of RecordIds that getRangeCursor() can scan concurrently. Returns no RecordIds if the
+     * store can't be split.
+     */
+    virtual std::vector<RecordId> getRangeSplitPoints(OperationContext* opCtx,
+                                                      size_t maxRanges) const {
+        return {};
+    }
+
+    /**
+     * Returns a forward cursor over the records with RecordIds in ['start', 'end'). A null bound
+     * leaves that end of the range open. Stores which don't return split points from
+     * getRangeSplitPoints() only support the range that covers the whole store.
+     */
+    virtual std::unique_ptr<RecordCursor> getRangeCursor(OperationContext* opCtx,
+                                                         const RecordId& start,
+                                                         const RecordId& end) const {
+        invariant(start.isNull() && end.isNull());
+        return getCursor(opCtx);
+    }
+
     // higher level
 
 
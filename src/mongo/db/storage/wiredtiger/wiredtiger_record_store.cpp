@@ -1441,6 +1441,40 @@ std::vector<std::unique_ptr<RecordCursor>> WiredTigerRecordStore::getManyCursors
     return cursors;
 }
 
+std::vector<RecordId> WiredTigerRecordStore::getRangeSplitPoints(OperationContext* opCtx,
+                                                                 size_t maxRanges) const {
+    std::vector<RecordId> splitPoints;
+
+    // Capped collections and the oplog are only ever read in order.
+    if (_isCapped || _isOplog || maxRanges < 2) {
+        return splitPoints;
+    }
+
+    auto first = getCursor(opCtx, /*forward=*/true)->next();
+    auto last = getCursor(opCtx, /*forward=*/false)->next();
+    if (!first || !last) {
+        return splitPoints;
+    }
+
+    // RecordIds are handed out in increasing order, so splitting the span between the first and
+    // the last one evenly gives ranges of similar size, unless long runs of records were deleted.
+    const uint64_t span = static_cast<uint64_t>(last->id.repr() - first->id.repr()) + 1;
+    const uint64_t numRanges = std::min<uint64_t>(maxRanges, span);
+    for (uint64_t i = 1; i < numRanges; i++) {
+        const uint64_t offset = span / numRanges * i + span % numRanges * i / numRanges;
+        splitPoints.push_back(RecordId(first->id.repr() + static_cast<int64_t>(offset)));
+    }
+    return splitPoints;
+}
+
+std::unique_ptr<RecordCursor> WiredTigerRecordStore::getRangeCursor(OperationContext* opCtx,
+                                                                    const RecordId& start,
+                                                                    const RecordId& end) const {
+    auto cursor = getCursor(opCtx, /*forward=*/true);
+    checked_cast<WiredTigerRecordStoreCursorBase*>(cursor.get())->setRange(start, end);
+    return std::move(cursor);
+}
+
 Status WiredTigerRecordStore::truncate(OperationContext* opCtx) {
     WiredTigerCursor startWrap(_uri, _tableId, true, opCtx);
     WT_CURSOR* start = startWrap.get();
@@ -1863,8 +1897,10 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
         // Nothing after the next line can throw WCEs.
         // Note that an unpositioned (or eof) WT_CURSOR returns the first/last entry in the
         // table when you call next/prev.
-        int advanceRet = wiredTigerPrepareConflictRetry(
-            _opCtx, [&] { return _forward ? c->next(c) : c->prev(c); });
+        int advanceRet = _lastReturnedId.isNull() && !_rangeStart.isNull()
+            ? seekToRangeStart(c)
+            : wiredTigerPrepareConflictRetry(
+                  _opCtx, [&] { return _forward ? c->next(c) : c->prev(c); });
         if (advanceRet == WT_NOTFOUND) {
             _eof = true;
             return {};
@@ -1881,6 +1917,11 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
         id = getKey(c);
     }
 
+    if (!_rangeEnd.isNull() && id >= _rangeEnd) {
+        _eof = true;
+        return {};
+    }
+
     if (_forward && _lastReturnedId >= id) {
         log() << "WTCursor::next -- c->next_key ( " << id
               << ") was not greater than _lastReturnedId (" << _lastReturnedId
@@ -1897,6 +1938,17 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+int WiredTigerRecordStoreCursorBase::seekToRangeStart(WT_CURSOR* c) {
+    setKey(c, _rangeStart);
+    int cmp;
+    int ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->search_near(c, &cmp); });
+    if (ret == 0 && cmp < 0) {
+        // We landed on the record before the start of the range.
+        ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->next(c); });
+    }
+    return ret;
+}
+
 boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordId& id) {
     _skipNextAdvance = false;
     WT_CURSOR* c = _cursor->get();
@@ -2003,6 +2055,12 @@ void WiredTigerRecordStoreCursorBase::reattachToOperationContext(OperationContex
     // _cursor recreated in restore() to avoid risk of WT_ROLLBACK issues.
 }
 
+void WiredTigerRecordStoreCursorBase::setRange(const RecordId& start, const RecordId& end) {
+    invariant(_forward && _lastReturnedId.isNull());
+    _rangeStart = start;
+    _rangeEnd = end;
+}
+
 // Standard Implementations:
 
 
@@ -180,6 +180,13 @@ public:
 
     std::vector<std::unique_ptr<RecordCursor>> getManyCursors(OperationContext* opCtx) const final;
 
+    std::vector<RecordId> getRangeSplitPoints(OperationContext* opCtx,
+                                              size_t maxRanges) const final;
+
+    std::unique_ptr<RecordCursor> getRangeCursor(OperationContext* opCtx,
+                                                 const RecordId& start,
+                                                 const RecordId& end) const final;
+
     virtual Status truncate(OperationContext* opCtx);
 
     virtual bool compactSupported() const {
@@ -430,6 +437,12 @@ public:
 
     void reattachToOperationContext(OperationContext* opCtx);
 
+    /**
+     * Limits a forward cursor which has not returned anything yet to the RecordIds in
+     * ['start', 'end'). A null bound leaves that end of the range open.
+     */
+    void setRange(const RecordId& start, const RecordId& end);
+
 protected:
     virtual RecordId getKey(WT_CURSOR* cursor) const = 0;
 
@@ -457,8 +470,17 @@ protected:
     bool _eof = false;
     RecordId _lastReturnedId;  // If null, need to seek to first/last record.
 
+    // Set by setRange(). If _rangeStart is not null, the cursor seeks to it instead of starting
+    // from the first record.
+    RecordId _rangeStart;
+    RecordId _rangeEnd;
+
 private:
     bool isVisible(const RecordId& id);
+
+    // Positions the cursor on the first record at or after _rangeStart, returning the WT error
+    // code of the positioning call.
+    int seekToRangeStart(WT_CURSOR* c);
 };
 
 class WiredTigerRecordStoreStandardCursor final : public WiredTigerRecordStoreCursorBase {
@@ -403,6 +403,71 @@ TEST(WiredTigerRecordStoreTest, CappedCursorYieldFirst) {
     ASSERT(!cursor->next());
 }
 
+TEST(WiredTigerRecordStoreTest, RangeCursorsCoverAllRecords) {
+    unique_ptr<RecordStoreHarnessHelper> harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore("a.b"));
+
+    const int nToInsert = 100;
+    std::vector<RecordId> inserted;
+    for (int i = 0; i < nToInsert; i++) {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        StatusWith<RecordId> res = rs->insertRecord(opCtx.get(), "a", 2, Timestamp(), false);
+        ASSERT_OK(res.getStatus());
+        inserted.push_back(res.getValue());
+        uow.commit();
+    }
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto splitPoints = rs->getRangeSplitPoints(opCtx.get(), 7);
+    ASSERT_EQ(6U, splitPoints.size());
+    for (size_t i = 1; i < splitPoints.size(); i++) {
+        ASSERT_LT(splitPoints[i - 1], splitPoints[i]);
+    }
+
+    // Each record is returned by exactly one range, in order. Yield halfway through every range
+    // to check that the end of the range survives a save and restore.
+    splitPoints.push_back(RecordId());
+    std::vector<RecordId> scanned;
+    RecordId start;
+    for (auto&& end : splitPoints) {
+        auto cursor = rs->getRangeCursor(opCtx.get(), start, end);
+        bool yielded = false;
+        while (auto record = cursor->next()) {
+            ASSERT_GTE(record->id, start);
+            if (!end.isNull()) {
+                ASSERT_LT(record->id, end);
+            }
+            scanned.push_back(record->id);
+
+            if (!yielded) {
+                yielded = true;
+                cursor->save();
+                opCtx->recoveryUnit()->abandonSnapshot();
+                ASSERT_TRUE(cursor->restore());
+            }
+        }
+        start = end;
+    }
+    ASSERT(inserted == scanned);
+}
+
+TEST(WiredTigerRecordStoreTest, NoRangeSplitPointsForCappedCollections) {
+    unique_ptr<RecordStoreHarnessHelper> harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("a.b", 10000, 50));
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    {
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < 10; i++) {
+            ASSERT_OK(rs->insertRecord(opCtx.get(), "a", 2, Timestamp(), false).getStatus());
+        }
+        uow.commit();
+    }
+
+    ASSERT(rs->getRangeSplitPoints(opCtx.get(), 4).empty());
+}
+
 BSONObj makeBSONObjWithSize(const Timestamp& opTime, int size, char fill = 'x') {
     BSONObj objTemplate = BSON("ts" << opTime << "str"
                                     << "");
@@ -450,6 +450,89 @@ Status IndexBuildBase::createIndex(const std::string& dbname, const BSONObj& ind
     return Status::OK();
 }
 
+/** Keys generated on worker threads end up in the indexes, and still mark them multikey. */
+class InsertBuildWithParallelKeyGeneration : public IndexBuildBase {
+public:
+    void run() {
+        Database* db = _ctx.db();
+        Collection* coll;
+        const int nDocs = 2500;
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            db->dropCollection(&_opCtx, _ns).transitional_ignore();
+            coll = db->createCollection(&_opCtx, _ns);
+
+            OpDebug* const nullOpDebug = nullptr;
+            for (int i = 0; i < nDocs; ++i) {
+                BSONObjBuilder doc;
+                doc.append("_id", i);
+                doc.append("a", i);
+                doc.append("b", BSON_ARRAY(i << i + 1));
+                if (i % 2) {
+                    doc.append("c", i);
+                }
+                ASSERT_OK(
+                    coll->insertDocument(&_opCtx, InsertStatement(doc.obj()), nullOpDebug, true));
+            }
+            wunit.commit();
+        }
+
+        MultiIndexBlock indexer(&_opCtx, coll);
+        indexer.allowParallelKeyGeneration(2);
+        const std::vector<BSONObj> specs = {
+            BSON("name"
+                 << "a_1"
+                 << "ns"
+                 << _ns
+                 << "key"
+                 << BSON("a" << 1)
+                 << "v"
+                 << static_cast<int>(kIndexVersion)),
+            BSON("name"
+                 << "b_1"
+                 << "ns"
+                 << _ns
+                 << "key"
+                 << BSON("b" << 1)
+                 << "v"
+                 << static_cast<int>(kIndexVersion)),
+            BSON("name"
+                 << "c_1"
+                 << "ns"
+                 << _ns
+                 << "key"
+                 << BSON("c" << 1)
+                 << "v"
+                 << static_cast<int>(kIndexVersion)
+                 << "partialFilterExpression"
+                 << BSON("c" << BSON("$exists" << true)))};
+        ASSERT_OK(indexer.init(specs).getStatus());
+        ASSERT_OK(indexer.insertAllDocumentsInCollection());
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            indexer.commit();
+            wunit.commit();
+        }
+
+        auto indexCatalog = coll->getIndexCatalog();
+        ASSERT_FALSE(
+            indexCatalog->isMultikey(&_opCtx, indexCatalog->findIndexByName(&_opCtx, "a_1")));
+        ASSERT_TRUE(
+            indexCatalog->isMultikey(&_opCtx, indexCatalog->findIndexByName(&_opCtx, "b_1")));
+
+        ASSERT_EQUALS(nDocs, countWithHint(BSONObj(), BSON("a" << 1)));
+        ASSERT_EQUALS(nDocs, countWithHint(BSONObj(), BSON("b" << 1)));
+        ASSERT_EQUALS(2, countWithHint(BSON("b" << 1000), BSON("b" << 1)));
+        ASSERT_EQUALS(nDocs / 2,
+                      countWithHint(BSON("c" << BSON("$exists" << true)), BSON("c" << 1)));
+    }
+
+private:
+    int countWithHint(const BSONObj& filter, const BSONObj& hint) {
+        return _client.query(_ns, Query(filter).hint(hint))->itcount();
+    }
+};
+
 /**
  * Fixture class that has a basic compound index.
  */
@@ -834,6 +917,7 @@ public:
         add<InsertBuildIndexInterruptDisallowed>();
         add<InsertBuildIdIndexInterrupt>();
         add<InsertBuildIdIndexInterruptDisallowed>();
+        add<InsertBuildWithParallelKeyGeneration>();
         add<SameSpecDifferentOption>();
         add<SameSpecSameOptions>();
         add<DifferentSpecSameName>();
@@ -34,6 +34,8 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/filesystem/operations.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
@@ -49,6 +51,8 @@
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/mongoutils/str.h"
@@ -407,6 +411,101 @@ public:
     }
 };
 
+// An AND with two children, which spills the members hashed from its first child. The spill file
+// is removed as soon as the AND is EOF, although members from the first child are left over.
+class QueryStageAndHashSpillIsReleasedAtEOF : public QueryStageAndBase {
+public:
+    QueryStageAndHashSpillIsReleasedAtEOF()
+        : _oldSwitch(internalQueryStageMemUsageSwitch.swap(true)),
+          _oldMax(internalQueryStageMemUsageMAX.swap(0)),
+          _oldMin(internalQueryStageMemUsageMIN.swap(0)),
+          _oldSpill(internalQueryStageMemUsageSpill.swap(true)) {}
+
+    ~QueryStageAndHashSpillIsReleasedAtEOF() {
+        internalQueryStageMemUsageSwitch.store(_oldSwitch);
+        internalQueryStageMemUsageMAX.store(_oldMax);
+        internalQueryStageMemUsageMIN.store(_oldMin);
+        internalQueryStageMemUsageSpill.store(_oldSpill);
+    }
+
+    static size_t numSpillFiles() {
+        const boost::filesystem::path tempDir(storageGlobalParams.dbpath + "/_tmp");
+        if (!boost::filesystem::exists(tempDir)) {
+            return 0;
+        }
+        size_t count = 0;
+        for (boost::filesystem::directory_iterator it(tempDir), end; it != end; ++it) {
+            if (it->path().filename().string().find("stagespill.") == 0) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        for (int i = 0; i < 50; ++i) {
+            insert(BSON("foo" << i << "bar" << i));
+        }
+
+        addIndex(BSON("foo" << 1));
+        addIndex(BSON("bar" << 1));
+
+        WorkingSet ws;
+        auto ah = make_unique<AndHashStage>(&_opCtx, &ws, coll);
+
+        // Foo <= 20
+        IndexScanParams params;
+        params.descriptor = getIndex(BSON("foo" << 1), coll);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 20);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = -1;
+        ah->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Bar >= 10
+        params.descriptor = getIndex(BSON("bar" << 1), coll);
+        params.bounds.startKey = BSON("" << 10);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ah->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        const size_t spillFilesBefore = numSpillFiles();
+        size_t maxSpillFiles = spillFilesBefore;
+        int count = 0;
+        while (!ah->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState status = ah->work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+            if (PlanStage::ADVANCED == status) {
+                ++count;
+            }
+            maxSpillFiles = std::max(maxSpillFiles, numSpillFiles());
+        }
+
+        // foo == 10, 11, 12, 13, 14, 15. 16, 17, 18, 19, 20, and foo 0 to 9 were left over.
+        ASSERT_EQUALS(11, count);
+        ASSERT_GREATER_THAN(maxSpillFiles, spillFilesBefore);
+        ASSERT_EQUALS(spillFilesBefore, numSpillFiles());
+    }
+
+private:
+    const bool _oldSwitch;
+    const long long _oldMax;
+    const long long _oldMin;
+    const bool _oldSpill;
+};
+
 // An AND with two children.
 // Add large keys (512 bytes) to index of first child to cause
 // internal buffer within hashed AND to exceed threshold (32MB)
@@ -1455,6 +1554,7 @@ public:
     void setupTests() {
         add<QueryStageAndHashInvalidation>();
         add<QueryStageAndHashTwoLeaf>();
+        add<QueryStageAndHashSpillIsReleasedAtEOF>();
         add<QueryStageAndHashTwoLeafFirstChildLargeKeys>();
         add<QueryStageAndHashTwoLeafLastChildLargeKeys>();
         add<QueryStageAndHashThreeLeaf>();
@@ -0,0 +1,351 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file tests PlanStage::workBatch() against PlanStage::work(), and compares their throughput.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
+
+namespace QueryStageBatch {
+
+using std::unique_ptr;
+using std::vector;
+using stdx::make_unique;
+
+const size_t kBatchSize = 64;
+
+class QueryStageBatchBase {
+public:
+    QueryStageBatchBase()
+        : _dbLock(&_opCtx, nsToDatabaseSubstring(ns()), MODE_X), _ctx(&_opCtx, ns()) {}
+
+    virtual ~QueryStageBatchBase() {}
+
+    void setup(int numDocs) {
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            _ctx.db()->dropCollection(&_opCtx, ns()).transitional_ignore();
+            _coll = _ctx.db()->createCollection(&_opCtx, ns());
+            ASSERT_OK(_coll->getIndexCatalog()->createIndexOnEmptyCollection(
+                &_opCtx,
+                BSON("ns" << ns() << "key" << BSON("x" << 1) << "name"
+                          << DBClientBase::genIndexName(BSON("x" << 1))
+                          << "v"
+                          << static_cast<int>(IndexDescriptor::IndexVersion::kV2))));
+            wunit.commit();
+        }
+
+        for (int i = 0; i < numDocs; ++i) {
+            WriteUnitOfWork wunit(&_opCtx);
+            OpDebug* const nullOpDebug = nullptr;
+            BSONObj doc = BSON("_id" << i << "x" << i << "y" << i % 10 << "z"
+                                     << "some padding to make the documents less tiny");
+            ASSERT_OK(_coll->insertDocument(&_opCtx, InsertStatement(doc), nullOpDebug, false));
+            wunit.commit();
+        }
+    }
+
+    unique_ptr<MatchExpression> parse(const BSONObj& filterObj) {
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return std::move(statusWithMatcher.getValue());
+    }
+
+    unique_ptr<PlanStage> makeCollScan(WorkingSet* ws, const MatchExpression* filter) {
+        CollectionScanParams params;
+        params.collection = _coll;
+        params.direction = CollectionScanParams::FORWARD;
+        return make_unique<CollectionScan>(&_opCtx, params, ws, filter);
+    }
+
+    /**
+     * Makes a PROJECTION over a FETCH over an IXSCAN of x in [start, end].
+     */
+    unique_ptr<PlanStage> makeIndexPlan(WorkingSet* ws,
+                                        int start,
+                                        int end,
+                                        const MatchExpression* filter) {
+        std::vector<IndexDescriptor*> indexes;
+        _coll->getIndexCatalog()->findIndexesByKeyPattern(
+            &_opCtx, BSON("x" << 1), false, &indexes);
+        ASSERT_EQ(indexes.size(), 1U);
+
+        IndexScanParams ixParams;
+        ixParams.descriptor = indexes[0];
+        ixParams.bounds.isSimpleRange = true;
+        ixParams.bounds.startKey = BSON("" << start);
+        ixParams.bounds.endKey = BSON("" << end);
+        ixParams.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        ixParams.direction = 1;
+        auto ixscan = new IndexScan(&_opCtx, ixParams, ws, nullptr);
+
+        auto fetch = new FetchStage(&_opCtx, ws, ixscan, filter, _coll);
+
+        ProjectionStageParams projParams;
+        projParams.projObj = BSON("_id" << 0 << "x" << 1 << "y" << 1);
+        return make_unique<ProjectionStage>(&_opCtx, projParams, ws, fetch);
+    }
+
+    /**
+     * Runs 'root' to EOF one unit of work at a time, or in batches, and returns its results.
+     */
+    vector<BSONObj> drain(PlanStage* root, WorkingSet* ws, bool batched) {
+        vector<BSONObj> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        vector<WorkingSetID> ids;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            ids.clear();
+            if (batched) {
+                state = root->workBatch(kBatchSize, &ids, &id);
+            } else {
+                state = root->work(&id);
+                if (PlanStage::ADVANCED == state) {
+                    ids.push_back(id);
+                }
+            }
+            ASSERT(PlanStage::ADVANCED == state || PlanStage::NEED_TIME == state ||
+                   PlanStage::IS_EOF == state)
+                << PlanStage::stateStr(state);
+
+            for (auto resultId : ids) {
+                WorkingSetMember* member = ws->get(resultId);
+                ASSERT(member->hasObj());
+                results.push_back(member->obj.value().getOwned());
+                ws->free(resultId);
+            }
+        }
+        return results;
+    }
+
+    static const char* ns() {
+        return "unittests.QueryStageBatch";
+    }
+
+protected:
+    const ServiceContext::UniqueOperationContext _opCtxPtr = cc().makeOperationContext();
+    OperationContext& _opCtx = *_opCtxPtr;
+
+    Lock::DBLock _dbLock;
+    OldClientContext _ctx;
+    Collection* _coll = nullptr;
+};
+
+void assertSameResults(const vector<BSONObj>& expected, const vector<BSONObj>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_BSONOBJ_EQ(expected[i], actual[i]);
+    }
+}
+
+// A batched collection scan returns the same documents in the same order, and reports the same
+// stats, as one worked a document at a time.
+class QueryStageBatchCollScan : public QueryStageBatchBase {
+public:
+    void run() {
+        setup(1000);
+        auto filter = parse(BSON("y" << BSON("$lt" << 3) << "x" << BSON("$gte" << 100)));
+
+        WorkingSet ws1;
+        auto scan1 = makeCollScan(&ws1, filter.get());
+        auto expected = drain(scan1.get(), &ws1, false);
+        ASSERT_EQ(270U, expected.size());
+
+        WorkingSet ws2;
+        auto scan2 = makeCollScan(&ws2, filter.get());
+        assertSameResults(expected, drain(scan2.get(), &ws2, true));
+
+        const CommonStats* stats1 = scan1->getCommonStats();
+        const CommonStats* stats2 = scan2->getCommonStats();
+        ASSERT_EQ(stats1->works, stats2->works);
+        ASSERT_EQ(stats1->advanced, stats2->advanced);
+        ASSERT_EQ(stats1->needTime, stats2->needTime);
+
+        auto specific1 = static_cast<const CollectionScanStats*>(scan1->getSpecificStats());
+        auto specific2 = static_cast<const CollectionScanStats*>(scan2->getSpecificStats());
+        ASSERT_EQ(specific1->docsTested, specific2->docsTested);
+    }
+};
+
+// Only the last document of a collection scan's batch may point into its cursor, and the scan makes
+// it owned when it saves its state.
+class QueryStageBatchCollScanOwnership : public QueryStageBatchBase {
+public:
+    void run() {
+        setup(100);
+
+        WorkingSet ws;
+        auto scan = makeCollScan(&ws, nullptr);
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        ASSERT_EQ(PlanStage::NEED_TIME, scan->work(&id));
+        ASSERT(scan->canWorkBatch());
+
+        vector<WorkingSetID> ids;
+        ASSERT_EQ(PlanStage::ADVANCED, scan->workBatch(10, &ids, &id));
+        ASSERT_EQ(10U, ids.size());
+        for (size_t i = 0; i + 1 < ids.size(); ++i) {
+            ASSERT(ws.get(ids[i])->obj.value().isOwned());
+        }
+
+        scan->saveState();
+        WorkingSetMember* last = ws.get(ids.back());
+        ASSERT(last->obj.value().isOwned());
+        ASSERT_EQ(9, last->obj.value()["_id"].numberInt());
+        scan->restoreState();
+
+        for (auto resultId : ids) {
+            ws.free(resultId);
+        }
+        ids.clear();
+        ASSERT_EQ(PlanStage::ADVANCED, scan->workBatch(10, &ids, &id));
+        ASSERT_EQ(10, ws.get(ids.front())->obj.value()["_id"].numberInt());
+    }
+};
+
+// Batches work for a stage tree mixing stages which can batch and filters which do.
+class QueryStageBatchFetchProjection : public QueryStageBatchBase {
+public:
+    void run() {
+        setup(1000);
+        auto filter = parse(BSON("y" << 5));
+
+        WorkingSet ws1;
+        auto plan1 = makeIndexPlan(&ws1, 100, 899, filter.get());
+        auto expected = drain(plan1.get(), &ws1, false);
+        ASSERT_EQ(80U, expected.size());
+        ASSERT_BSONOBJ_EQ(BSON("x" << 105 << "y" << 5), expected[0]);
+
+        WorkingSet ws2;
+        auto plan2 = makeIndexPlan(&ws2, 100, 899, filter.get());
+        ASSERT(plan2->canWorkBatch());
+        assertSameResults(expected, drain(plan2.get(), &ws2, true));
+
+        ASSERT_EQ(plan1->getCommonStats()->advanced, plan2->getCommonStats()->advanced);
+    }
+};
+
+// Stages without a batch implementation go through the per-document adapter.
+class QueryStageBatchAdapter : public QueryStageBatchBase {
+public:
+    void run() {
+        setup(100);
+
+        WorkingSet ws;
+        auto scan = makeCollScan(&ws, nullptr);
+
+        // The scan has no cursor before its first unit of work, so it cannot batch yet.
+        ASSERT_FALSE(scan->canWorkBatch());
+        vector<WorkingSetID> ids;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        ASSERT_EQ(PlanStage::ADVANCED, scan->workBatch(10, &ids, &id));
+        ASSERT_EQ(9U, ids.size());
+        ASSERT(scan->canWorkBatch());
+
+        ids.clear();
+        ASSERT_EQ(PlanStage::IS_EOF, scan->workBatch(1000, &ids, &id));
+        ASSERT_EQ(91U, ids.size());
+    }
+};
+
+// Compares the throughput of per-document and batched execution. Does not fail on the numbers,
+// which depend on the machine, but logs them.
+class QueryStageBatchThroughput : public QueryStageBatchBase {
+public:
+    void run() {
+        const int numDocs = 50 * 1000;
+        setup(numDocs);
+        auto filter = parse(BSON("y" << BSON("$in" << BSON_ARRAY(1 << 2)) << "x"
+                                     << BSON("$gte" << 0)));
+
+        for (bool batched : {false, true}) {
+            WorkingSet ws;
+            auto scan = makeCollScan(&ws, filter.get());
+            Timer t;
+            auto results = drain(scan.get(), &ws, batched);
+            const long long micros = std::max(t.micros(), 1LL);
+            ASSERT_EQ(static_cast<size_t>(numDocs / 5), results.size());
+            mongo::log() << "collection scan, " << (batched ? "batched" : "per document") << ": "
+                  << numDocs * 1000LL * 1000 / micros << " docs/sec";
+        }
+
+        for (bool batched : {false, true}) {
+            WorkingSet ws;
+            auto plan = makeIndexPlan(&ws, 0, numDocs, filter.get());
+            Timer t;
+            auto results = drain(plan.get(), &ws, batched);
+            const long long micros = std::max(t.micros(), 1LL);
+            ASSERT_EQ(static_cast<size_t>(numDocs / 5), results.size());
+            mongo::log() << "index scan, fetch and projection, "
+                  << (batched ? "batched" : "per document") << ": "
+                  << numDocs * 1000LL * 1000 / micros << " docs/sec";
+        }
+    }
+};
+
+class All : public Suite {
+public:
+    All() : Suite("query_stage_batch") {}
+
+    void setupTests() {
+        add<QueryStageBatchCollScan>();
+        add<QueryStageBatchCollScanOwnership>();
+        add<QueryStageBatchFetchProjection>();
+        add<QueryStageBatchAdapter>();
+        add<QueryStageBatchThroughput>();
+    }
+};
+
+SuiteInstance<All> queryStageBatchAll;
+
+}  // namespace QueryStageBatch
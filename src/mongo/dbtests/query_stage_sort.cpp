@@ -41,6 +41,7 @@
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 
@@ -157,6 +158,7 @@ public:
         params.collection = coll;
         params.pattern = BSON("foo" << direction);
         params.limit = limit();
+        params.allowDiskUse = allowDiskUse();
 
         auto keyGenStage = make_unique<SortKeyGeneratorStage>(
             &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
@@ -216,6 +218,10 @@ public:
         return 0;
     };
 
+    // Returns whether the sort may spill to disk.
+    virtual bool allowDiskUse() const {
+        return false;
+    }
 
     static const char* ns() {
         return "unittests.QueryStageSort";
@@ -303,6 +309,82 @@ public:
     }
 };
 
+// Sort a big bunch of objects with a memory limit small enough to force an external sort.
+template <int LIMIT>
+class QueryStageSortExtAllowDiskUse : public QueryStageSortExt {
+public:
+    QueryStageSortExtAllowDiskUse()
+        : _oldMaxBlockingSortBytes(internalQueryExecMaxBlockingSortBytes.load()) {
+        internalQueryExecMaxBlockingSortBytes.store(16 * 1024);
+    }
+
+    ~QueryStageSortExtAllowDiskUse() {
+        internalQueryExecMaxBlockingSortBytes.store(_oldMaxBlockingSortBytes);
+    }
+
+    virtual int limit() const {
+        return LIMIT;
+    }
+
+    bool allowDiskUse() const final {
+        return true;
+    }
+
+private:
+    const int _oldMaxBlockingSortBytes;
+};
+
+// Results read back from an external sort keep the RecordId they were sorted with.
+class QueryStageSortExtKeepsRecordId : public QueryStageSortExtAllowDiskUse<0> {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+        fillData();
+
+        WorkingSet ws;
+        auto queuedDataStage = make_unique<QueuedDataStage>(&_opCtx, &ws);
+        insertVarietyOfObjects(&ws, queuedDataStage.get(), coll);
+
+        SortStageParams params;
+        params.collection = coll;
+        params.pattern = BSON("foo" << 1);
+        params.allowDiskUse = true;
+
+        auto keyGenStage = make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), &ws, params.pattern, nullptr);
+        SortStage ss(&_opCtx, params, &ws, keyGenStage.release());
+
+        int count = 0;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (state != PlanStage::IS_EOF) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            state = ss.work(&id);
+            if (PlanStage::ADVANCED != state) {
+                continue;
+            }
+
+            WorkingSetMember* member = ws.get(id);
+            ASSERT_TRUE(member->hasObj());
+            if (supportsDocLocking()) {
+                ASSERT_TRUE(member->hasRecordId());
+                ASSERT_BSONOBJ_EQ(coll->docFor(&_opCtx, member->recordId).value(),
+                                  member->obj.value());
+            }
+            ++count;
+        }
+
+        ASSERT_GREATER_THAN(static_cast<const SortStats*>(ss.getSpecificStats())->spills, 0U);
+        ASSERT_EQUALS(numObj(), count);
+    }
+};
+
 // Mutation invalidation of docs fed to sort.
 class QueryStageSortMutationInvalidation : public QueryStageSortTestBase {
 public:
@@ -590,6 +672,9 @@ public:
         // and a special case for limit == 1
         add<QueryStageSortDecWithLimit<1>>();
         add<QueryStageSortExt>();
+        add<QueryStageSortExtAllowDiskUse<0>>();
+        add<QueryStageSortExtAllowDiskUse<1000>>();
+        add<QueryStageSortExtKeepsRecordId>();
         add<QueryStageSortMutationInvalidation>();
         add<QueryStageSortDeletionInvalidation>();
         add<QueryStageSortDeletionInvalidationWithLimit<10>>();
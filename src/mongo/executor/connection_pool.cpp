@@ -43,7 +43,7 @@
 #include "mongo/util/scopeguard.h"
 
 // One interesting implementation note herein concerns how setup() and
-// refresh() are invoked outside of the global lock, but setTimeout is not.
+// refresh() are invoked outside of the lock of the specific pool, but setTimeout is not.
 // This implementation detail simplifies mocks, allowing them to return
 // synchronously sometimes, whereas having timeouts fire instantly adds little
 // value. In practice, dumping the locks is always safe (because we restrict
@@ -69,7 +69,7 @@ public:
      *
      * The complexity comes from the need to hold a lock when writing to the
      * _activeClients param on the specific pool.  Because the code beneath the client needs to lock
-     * and unlock the parent mutex (and can leave unlocked), we want to start the client with the
+     * and unlock the pool mutex (and can leave unlocked), we want to start the client with the
      * lock acquired, move it into the client, then re-acquire to decrement the counter on the way
      * out.
      *
@@ -85,11 +85,11 @@ public:
     template <typename Callback>
     auto guardCallback(Callback&& cb) {
         return [ cb = std::forward<Callback>(cb), anchor = shared_from_this() ](auto&&... args) {
-            stdx::unique_lock<stdx::mutex> lk(anchor->_parent->_mutex);
+            stdx::unique_lock<stdx::mutex> lk(anchor->_mutex);
             ++(anchor->_activeClients);
 
             ON_BLOCK_EXIT([anchor]() {
-                stdx::unique_lock<stdx::mutex> lk(anchor->_parent->_mutex);
+                stdx::unique_lock<stdx::mutex> lk(anchor->_mutex);
                 --(anchor->_activeClients);
             });
 
@@ -101,8 +101,7 @@ public:
     ~SpecificPool();
 
     /**
-     * Gets a connection from the specific pool. Sinks a unique_lock from the
-     * parent to preserve the lock on _mutex
+     * Gets a connection from the specific pool. Sinks a unique_lock on _mutex
      */
     Future<ConnectionHandle> getConnection(const HostAndPort& hostAndPort,
                                            Milliseconds timeout,
@@ -124,8 +123,7 @@ public:
     void processFailure(const Status& status, stdx::unique_lock<stdx::mutex> lk);
 
     /**
-     * Returns a connection to a specific pool. Sinks a unique_lock from the
-     * parent to preserve the lock on _mutex
+     * Returns a connection to a specific pool. Sinks a unique_lock on _mutex
      */
     void returnConnection(ConnectionInterface* connection, stdx::unique_lock<stdx::mutex> lk);
 
@@ -156,6 +154,25 @@ public:
      */
     size_t openConnections(const stdx::unique_lock<stdx::mutex>& lk);
 
+    /**
+     * Returns true once the pool has been shut down. It then only waits for its refreshing
+     * connections and clients to be done before it delists itself.
+     */
+    bool isInShutdown(const stdx::unique_lock<stdx::mutex>& lk) const {
+        return _state == State::kInShutdown;
+    }
+
+    const HostAndPort& getHostAndPort() const {
+        return _hostAndPort;
+    }
+
+    /**
+     * Locks the pool, which guards all of its state.
+     */
+    stdx::unique_lock<stdx::mutex> lock() const {
+        return stdx::unique_lock<stdx::mutex>(_mutex);
+    }
+
     /**
      * Return true if the tags on the specific pool match the passed in tags
      */
@@ -203,6 +220,8 @@ private:
 
     const HostAndPort _hostAndPort;
 
+    mutable stdx::mutex _mutex;
+
     LRUOwnershipPool _readyPool;
     OwnershipPool _processingPool;
     OwnershipPool _droppedProcessingPool;
@@ -248,6 +267,7 @@ private:
 };
 
 constexpr Milliseconds ConnectionPool::kDefaultHostTimeout;
+constexpr size_t ConnectionPool::kNumPoolShards;
 size_t const ConnectionPool::kDefaultMaxConns = std::numeric_limits<size_t>::max();
 size_t const ConnectionPool::kDefaultMinConns = 1;
 size_t const ConnectionPool::kDefaultMaxConnecting = std::numeric_limits<size_t>::max();
@@ -280,46 +300,29 @@ ConnectionPool::~ConnectionPool() {
 }
 
 void ConnectionPool::shutdown() {
+    _inShutdown.store(true);
     _factory->shutdown();
 
-    // Grab all current pools (under the lock)
-    auto pools = [&] {
-        stdx::unique_lock<stdx::mutex> lk(_mutex);
-        return _pools;
-    }();
-
-    for (const auto& pair : pools) {
-        stdx::unique_lock<stdx::mutex> lk(_mutex);
-        pair.second->triggerShutdown(
+    for (const auto& pool : allPools()) {
+        pool->triggerShutdown(
             Status(ErrorCodes::ShutdownInProgress, "Shutting down the connection pool"),
-            std::move(lk));
+            pool->lock());
     }
 }
 
 void ConnectionPool::dropConnections(const HostAndPort& hostAndPort) {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    auto pool = findPool(hostAndPort);
 
-    auto iter = _pools.find(hostAndPort);
-
-    if (iter == _pools.end())
+    if (!pool)
         return;
 
-    auto pool = iter->second;
     pool->processFailure(Status(ErrorCodes::PooledConnectionsDropped, "Pooled connections dropped"),
-                         std::move(lk));
+                         pool->lock());
 }
 
 void ConnectionPool::dropConnections(transport::Session::TagMask tags) {
-    // Grab all current pools (under the lock)
-    auto pools = [&] {
-        stdx::unique_lock<stdx::mutex> lk(_mutex);
-        return _pools;
-    }();
-
-    for (const auto& pair : pools) {
-        auto& pool = pair.second;
-
-        stdx::unique_lock<stdx::mutex> lk(_mutex);
+    for (const auto& pool : allPools()) {
+        auto lk = pool->lock();
         if (pool->matchesTags(lk, tags))
             continue;
 
@@ -332,15 +335,12 @@ void ConnectionPool::dropConnections(transport::Session::TagMask tags) {
 void ConnectionPool::mutateTags(
     const HostAndPort& hostAndPort,
     const stdx::function<transport::Session::TagMask(transport::Session::TagMask)>& mutateFunc) {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
-
-    auto iter = _pools.find(hostAndPort);
+    auto pool = findPool(hostAndPort);
 
-    if (iter == _pools.end())
+    if (!pool)
         return;
 
-    auto pool = iter->second;
-    pool->mutateTags(lk, mutateFunc);
+    pool->mutateTags(pool->lock(), mutateFunc);
 }
 
 void ConnectionPool::get(const HostAndPort& hostAndPort,
@@ -351,60 +351,96 @@ void ConnectionPool::get(const HostAndPort& hostAndPort,
 
 Future<ConnectionPool::ConnectionHandle> ConnectionPool::get(const HostAndPort& hostAndPort,
                                                              Milliseconds timeout) {
+    auto& shard = shardFor(hostAndPort);
     std::shared_ptr<SpecificPool> pool;
 
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    while (true) {
+        {
+            stdx::lock_guard<stdx::mutex> shardLk(shard.mutex);
+            if (_inShutdown.load()) {
+                return Status(ErrorCodes::ShutdownInProgress,
+                              "Connection pool is shutting down");
+            }
 
-    auto iter = _pools.find(hostAndPort);
+            auto& listedPool = shard.pools[hostAndPort];
 
-    if (iter == _pools.end()) {
-        pool = stdx::make_unique<SpecificPool>(this, hostAndPort);
-        _pools[hostAndPort] = pool;
-    } else {
-        pool = iter->second;
-    }
+            // A pool which was shut down stays listed until its refreshing connections are done,
+            // but no longer hands out connections, so a new pool takes its place. Connections
+            // checked out of the old pool still go back to it, through their handles.
+            if (!listedPool || listedPool == pool) {
+                listedPool = std::make_shared<SpecificPool>(this, hostAndPort);
+            }
+            pool = listedPool;
+        }
 
-    invariant(pool);
+        invariant(pool);
 
-    return pool->getConnection(hostAndPort, timeout, std::move(lk));
+        auto lk = pool->lock();
+        if (!pool->isInShutdown(lk)) {
+            return pool->getConnection(hostAndPort, timeout, std::move(lk));
+        }
+    }
 }
 
 void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
-
-    for (const auto& kv : _pools) {
-        HostAndPort host = kv.first;
-
-        auto& pool = kv.second;
+    for (const auto& pool : allPools()) {
+        auto lk = pool->lock();
         ConnectionStatsPer hostStats{pool->inUseConnections(lk),
                                      pool->availableConnections(lk),
                                      pool->createdConnections(lk),
                                      pool->refreshingConnections(lk)};
-        stats->updateStatsForHost(_name, host, hostStats);
+        stats->updateStatsForHost(_name, pool->getHostAndPort(), hostStats);
     }
 }
 
 size_t ConnectionPool::getNumConnectionsPerHost(const HostAndPort& hostAndPort) const {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
-    auto iter = _pools.find(hostAndPort);
-    if (iter != _pools.end()) {
-        return iter->second->openConnections(lk);
+    auto pool = findPool(hostAndPort);
+    if (pool) {
+        return pool->openConnections(pool->lock());
     }
 
     return 0;
 }
 
-void ConnectionPool::returnConnection(ConnectionInterface* conn) {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+ConnectionPool::PoolShard& ConnectionPool::shardFor(const HostAndPort& hostAndPort) {
+    return _poolShards[std::hash<HostAndPort>()(hostAndPort) % kNumPoolShards];
+}
+
+const ConnectionPool::PoolShard& ConnectionPool::shardFor(const HostAndPort& hostAndPort) const {
+    return _poolShards[std::hash<HostAndPort>()(hostAndPort) % kNumPoolShards];
+}
+
+std::shared_ptr<ConnectionPool::SpecificPool> ConnectionPool::findPool(
+    const HostAndPort& hostAndPort) const {
+    auto& shard = shardFor(hostAndPort);
+    stdx::lock_guard<stdx::mutex> shardLk(shard.mutex);
 
-    auto iter = _pools.find(conn->getHostAndPort());
+    auto iter = shard.pools.find(hostAndPort);
+    if (iter == shard.pools.end())
+        return nullptr;
 
-    invariant(iter != _pools.end(),
-              str::stream() << "Tried to return connection but no pool found for "
-                            << conn->getHostAndPort());
+    return iter->second;
+}
 
-    auto pool = iter->second;
-    pool->returnConnection(conn, std::move(lk));
+std::vector<std::shared_ptr<ConnectionPool::SpecificPool>> ConnectionPool::allPools() const {
+    std::vector<std::shared_ptr<SpecificPool>> pools;
+    for (const auto& shard : _poolShards) {
+        stdx::lock_guard<stdx::mutex> shardLk(shard.mutex);
+        for (const auto& kv : shard.pools) {
+            pools.push_back(kv.second);
+        }
+    }
+    return pools;
+}
+
+void ConnectionPool::delistPool(SpecificPool* pool) {
+    auto& shard = shardFor(pool->getHostAndPort());
+    stdx::lock_guard<stdx::mutex> shardLk(shard.mutex);
+
+    auto iter = shard.pools.find(pool->getHostAndPort());
+    if (iter != shard.pools.end() && iter->second.get() == pool) {
+        shard.pools.erase(iter);
+    }
 }
 
 ConnectionPool::SpecificPool::SpecificPool(ConnectionPool* parent, const HostAndPort& hostAndPort)
@@ -806,7 +842,7 @@ void ConnectionPool::SpecificPool::updateStateInLock() {
         if (_processingPool.empty() && !_activeClients) {
             // If we have no more clients that require access to us, delist from the parent pool
             LOG(2) << "Delisting connection pool for " << _hostAndPort;
-            _parent->_pools.erase(_hostAndPort);
+            _parent->delistPool(this);
         }
         return;
     }
@@ -876,7 +912,7 @@ void ConnectionPool::SpecificPool::updateStateInLock() {
 
         // Set the shutdown timer, this gets reset on any request
         _requestTimer->setTimeout(timeout, [ this, anchor = shared_from_this() ]() {
-            stdx::unique_lock<stdx::mutex> lk(anchor->_parent->_mutex);
+            stdx::unique_lock<stdx::mutex> lk(anchor->_mutex);
             if (_state != State::kIdle)
                 return;
 
@@ -27,12 +27,15 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/executor/egress_tag_closer.h"
 #include "mongo/executor/egress_tag_closer_manager.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/chrono.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/stdx/mutex.h"
@@ -155,7 +158,34 @@ public:
     size_t getNumConnectionsPerHost(const HostAndPort& hostAndPort) const;
 
 private:
-    void returnConnection(ConnectionInterface* connection);
+    // The specific pools are spread by host over this many shards, so that requests for
+    // connections to different hosts rarely contend on the same mutex.
+    static constexpr size_t kNumPoolShards = 16;
+
+    struct PoolShard {
+        // Only guards the map. The state of each specific pool is guarded by its own mutex, which
+        // may be held while taking the mutex of a shard, but not the other way around.
+        mutable stdx::mutex mutex;
+        stdx::unordered_map<HostAndPort, std::shared_ptr<SpecificPool>> pools;
+    };
+
+    PoolShard& shardFor(const HostAndPort& hostAndPort);
+    const PoolShard& shardFor(const HostAndPort& hostAndPort) const;
+
+    /**
+     * Returns the specific pool for 'hostAndPort', or nullptr if there is none.
+     */
+    std::shared_ptr<SpecificPool> findPool(const HostAndPort& hostAndPort) const;
+
+    /**
+     * Returns every specific pool, taking the mutex of one shard at a time.
+     */
+    std::vector<std::shared_ptr<SpecificPool>> allPools() const;
+
+    /**
+     * Removes 'pool' from its shard, unless another pool for the same host has replaced it.
+     */
+    void delistPool(SpecificPool* pool);
 
     std::string _name;
 
@@ -165,9 +195,11 @@ private:
 
     const std::shared_ptr<DependentTypeFactoryInterface> _factory;
 
-    // The global mutex for specific pool access and the generation counter
-    mutable stdx::mutex _mutex;
-    stdx::unordered_map<HostAndPort, std::shared_ptr<SpecificPool>> _pools;
+    std::array<PoolShard, kNumPoolShards> _poolShards;
+
+    // Set by shutdown() before it shuts down the pools. get() reads it under the mutex of a shard,
+    // so any pool it adds afterwards is seen, and shut down, by shutdown().
+    AtomicWord<bool> _inShutdown{false};
 
     EgressTagCloserManager* _manager;
 };
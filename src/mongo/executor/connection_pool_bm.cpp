@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/executor/connection_pool.h"
+#include "mongo/executor/connection_pool_test_fixture.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+namespace executor {
+namespace connection_pool_test_details {
+namespace {
+
+const int kMaxThreads = 64;
+
+/**
+ * Drives threads which get a connection and return it right away against a pool with ready
+ * connections to a number of hosts, so that the time measured is the time the pool takes to hand
+ * out and take back a connection, including the waits on its locks.
+ */
+class ConnectionPoolBM : public benchmark::Fixture {
+protected:
+    /**
+     * Makes a pool with a ready connection to each of 'numHosts' hosts for each of 'numThreads'
+     * threads.
+     */
+    void makePool(int numHosts, int numThreads) {
+        ConnectionPool::Options options;
+        options.minConnections = numThreads;
+        options.maxConnections = numThreads;
+        options.refreshRequirement = Minutes(60);
+        options.hostTimeout = Minutes(60);
+        pool = stdx::make_unique<ConnectionPool>(stdx::make_unique<PoolImpl>(), "bm pool", options);
+
+        for (int i = 0; i < numHosts; i++) {
+            hosts.emplace_back("shard" + std::to_string(i), 27017);
+            for (int j = 0; j < numThreads; j++) {
+                ConnectionImpl::pushSetup(Status::OK());
+            }
+            pool->get(hosts.back(), Milliseconds(5000)).get()->indicateSuccess();
+        }
+    }
+
+    void destroyPool() {
+        pool.reset();
+        hosts.clear();
+        ConnectionImpl::clear();
+        TimerImpl::clear();
+    }
+
+    std::unique_ptr<ConnectionPool> pool;
+    std::vector<HostAndPort> hosts;
+};
+
+BENCHMARK_DEFINE_F(ConnectionPoolBM, BM_GetAndReturnConnection)(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        makePool(state.range(0), state.threads);
+    }
+
+    // Each thread goes round the hosts starting from its own, so that the threads spread over them.
+    size_t nextHost = state.thread_index;
+    for (auto keepRunning : state) {
+        auto conn = pool->get(hosts[nextHost++ % hosts.size()], Milliseconds(5000)).get();
+        conn->indicateSuccess();
+    }
+
+    if (state.thread_index == 0) {
+        destroyPool();
+    }
+}
+
+BENCHMARK_REGISTER_F(ConnectionPoolBM, BM_GetAndReturnConnection)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(40)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace connection_pool_test_details
+}  // namespace executor
+}  // namespace mongo
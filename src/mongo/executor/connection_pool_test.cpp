@@ -35,7 +35,9 @@
 
 #include "mongo/executor/connection_pool.h"
 #include "mongo/stdx/future.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/scopeguard.h"
 
@@ -1376,6 +1378,73 @@ TEST_F(ConnectionPoolTest, DropConnectionsByTagInMultipleViaManager) {
     dropConnectionsByTagTest(pool, manager);
 }
 
+/**
+ * Verify that threads getting and returning connections to several hosts at once, which lock the
+ * pools of different hosts independently, all get a connection from the ready ones.
+ */
+TEST_F(ConnectionPoolTest, ConcurrentGetAndReturnAcrossHosts) {
+    const size_t kNumThreads = 8;
+    const size_t kNumHosts = 4;
+    const int kNumGetsPerThread = 1000;
+
+    ConnectionPool::Options options;
+    options.minConnections = kNumThreads;
+    options.maxConnections = kNumThreads;
+    ConnectionPool pool(stdx::make_unique<PoolImpl>(), "test pool", options);
+
+    // Setting up the connections is single threaded in the mocks, so it is done ahead.
+    std::vector<HostAndPort> hosts;
+    for (size_t i = 0; i < kNumHosts; i++) {
+        hosts.emplace_back("host" + std::to_string(i), 27017);
+        for (size_t j = 0; j < kNumThreads; j++) {
+            ConnectionImpl::pushSetup(Status::OK());
+        }
+        doneWith(pool.get(hosts.back(), Milliseconds(5000)).get());
+        ASSERT_EQ(kNumThreads, pool.getNumConnectionsPerHost(hosts.back()));
+    }
+
+    std::vector<stdx::thread> threads;
+    AtomicWord<int> numGets{0};
+    for (size_t i = 0; i < kNumThreads; i++) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < kNumGetsPerThread; j++) {
+                auto conn = pool.get(hosts[(i + j) % kNumHosts], Milliseconds(5000)).get();
+                doneWith(conn);
+                numGets.fetchAndAdd(1);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(int(kNumThreads) * kNumGetsPerThread, numGets.load());
+    for (auto&& host : hosts) {
+        ASSERT_EQ(kNumThreads, pool.getNumConnectionsPerHost(host));
+    }
+}
+
+/**
+ * Verify that a connection checked out before the pool was shut down can still be returned, and
+ * that the pool refuses requests once shut down instead of creating a new specific pool.
+ */
+TEST_F(ConnectionPoolTest, GetFailsAndReturnsSucceedAfterShutdown) {
+    ConnectionPool pool(stdx::make_unique<PoolImpl>(), "test pool");
+
+    ConnectionImpl::pushSetup(Status::OK());
+    auto conn = pool.get(HostAndPort(), Milliseconds(5000)).get();
+    ASSERT_EQ(1U, pool.getNumConnectionsPerHost(HostAndPort()));
+
+    pool.shutdown();
+
+    auto swConn = pool.get(HostAndPort(), Milliseconds(5000)).getNoThrow();
+    ASSERT_EQ(ErrorCodes::ShutdownInProgress, swConn.getStatus());
+
+    doneWith(conn);
+    conn.reset();
+    ASSERT_EQ(0U, pool.getNumConnectionsPerHost(HostAndPort()));
+}
+
 }  // namespace connection_pool_test_details
 }  // namespace executor
 }  // namespace mongo
@@ -42,8 +42,14 @@ TimerImpl::~TimerImpl() {
 }
 
 void TimerImpl::setTimeout(Milliseconds timeout, TimeoutCallback cb) {
+    // The replaced callback may hold the last reference to a specific pool, whose destructor
+    // cancels its timer, so it is destroyed outside of the lock.
+    TimeoutCallback replacedCb;
+
+    stdx::lock_guard<stdx::mutex> lk(_timersMutex);
     _timers.erase(this);
 
+    replacedCb = std::move(_cb);
     _cb = std::move(cb);
     _expiration = _global->now() + timeout;
 
@@ -51,13 +57,24 @@ void TimerImpl::setTimeout(Milliseconds timeout, TimeoutCallback cb) {
 }
 
 void TimerImpl::cancelTimeout() {
+    TimeoutCallback canceledCb;
+
+    stdx::lock_guard<stdx::mutex> lk(_timersMutex);
     _timers.erase(this);
+    canceledCb = std::move(_cb);
     _cb = TimeoutCallback{};
 }
 
 void TimerImpl::clear() {
-    while (!_timers.empty()) {
-        auto* timer = *_timers.begin();
+    while (true) {
+        TimerImpl* timer;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+            if (_timers.empty()) {
+                return;
+            }
+            timer = *_timers.begin();
+        }
         timer->cancelTimeout();
     }
 }
@@ -65,15 +82,25 @@ void TimerImpl::clear() {
 void TimerImpl::fireIfNecessary() {
     auto now = PoolImpl().now();
 
-    auto timers = _timers;
+    auto timers = [] {
+        stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+        return _timers;
+    }();
 
     for (auto&& x : timers) {
-        if (_timers.count(x) && (x->_expiration <= now)) {
-            x->_cb();
+        TimeoutCallback cb;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+            if (!_timers.count(x) || x->_expiration > now) {
+                continue;
+            }
+            cb = x->_cb;
         }
+        cb();
     }
 }
 
+stdx::mutex TimerImpl::_timersMutex;
 std::set<TimerImpl*> TimerImpl::_timers;
 
 ConnectionImpl::ConnectionImpl(const HostAndPort& hostAndPort, size_t generation, PoolImpl* global)
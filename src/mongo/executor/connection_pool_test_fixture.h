@@ -30,6 +30,7 @@
 #include <set>
 
 #include "mongo/executor/connection_pool.h"
+#include "mongo/stdx/mutex.h"
 
 namespace mongo {
 namespace executor {
@@ -40,6 +41,8 @@ class PoolImpl;
 
 /**
  * Mock interface for the timer
+ *
+ * Timers may be set and canceled from several threads, as the benchmarks do.
  */
 class TimerImpl final : public ConnectionPool::TimerInterface {
 public:
@@ -57,6 +60,7 @@ public:
     static void clear();
 
 private:
+    static stdx::mutex _timersMutex;  // Guards _timers, and the members of the timers in it.
     static std::set<TimerImpl*> _timers;
 
     TimeoutCallback _cb;
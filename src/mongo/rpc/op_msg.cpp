@@ -126,7 +126,9 @@ OpMsg OpMsg::parse(const Message& message) try {
 
                 msg.sequences.push_back({name.toString()});
                 while (!seqBuf.atEof()) {
-                    msg.sequences.back().objs.push_back(seqBuf.read<Validated<BSONObj>>());
+                    msg.sequences.back().objs.push_back(
+                        seqBuf.read<Validated<BSONObj>>().val.shareOwnershipWith(
+                            message.sharedBuffer()));
                 }
                 break;
             }
@@ -72,7 +72,9 @@ struct OpMsg {
     }
 
     /**
-     * Parses and returns an OpMsg containing unowned BSON.
+     * Parses and returns an OpMsg containing unowned BSON, except for the documents of its
+     * sequences. Those share ownership of the message's buffer so that they, usually the bulk of
+     * the message, can be held on to without copying them.
      */
     static OpMsg parse(const Message& message);
 
@@ -161,7 +163,9 @@ class OpMsgBuilder {
     MONGO_DISALLOW_COPYING(OpMsgBuilder);
 
 public:
-    OpMsgBuilder() {
+    OpMsgBuilder() : _buf(0) {
+        // Messages are built at the rate operations are run, so their buffers come from the pool.
+        _buf.useSharedBuffer(SharedBuffer::allocatePooled(kInitialBufferSize));
         skipHeaderAndFlags();
     }
 
@@ -232,6 +236,8 @@ private:
 
     void finishDocumentStream(DocSequenceBuilder* docSequenceBuilder);
 
+    static constexpr size_t kInitialBufferSize = 512;
+
     void skipHeaderAndFlags() {
         _buf.skip(sizeof(MSGHEADER::Layout));  // This is filled in by finish().
         _buf.appendNum(uint32_t(0));           // flags (currently always 0).
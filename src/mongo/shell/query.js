@@ -46,6 +46,7 @@ DBQuery.prototype.help = function() {
     print("\t.tailable(<isAwaitData>)");
     print("\t.noCursorTimeout()");
     print("\t.allowPartialResults()");
+    print("\t.allowDiskUse()");
     print("\t.returnKey()");
     print("\t.showRecordId() - adds a $recordId field to each returned object");
 
@@ -222,6 +223,10 @@ DBQuery.prototype._convertToCommand = function(canAttachReadPref) {
         cmd["showRecordId"] = this._query.$showDiskLoc;
     }
 
+    if ("$allowDiskUse" in this._query) {
+        cmd["allowDiskUse"] = this._query.$allowDiskUse;
+    }
+
     if ("readConcern" in this._query) {
         cmd["readConcern"] = this._query.readConcern;
     }
@@ -580,6 +585,17 @@ DBQuery.prototype.allowPartialResults = function() {
     return this;
 };
 
+/**
+* Allow a blocking sort to write temporary files to disk rather than fail once it exceeds its
+* memory limit.
+*
+* @method
+* @return {DBQuery}
+*/
+DBQuery.prototype.allowDiskUse = function() {
+    return this._addSpecial("$allowDiskUse", true);
+};
+
 /**
 * The server normally times out idle cursors after an inactivity period (10 minutes)
 * to prevent excess memory use. Set this option to prevent that.
@@ -32,14 +32,20 @@
 #include "mongo/base/status_with.h"
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/duration.h"
 
 #include <type_traits>
 
 namespace mongo {
+
+class BSONObj;
+class BSONObjBuilder;
+
 enum class MessageCompressor : uint8_t {
     kNoop = 0,
     kSnappy = 1,
     kZlib = 2,
+    kZstd = 3,
     kExtended = 255,
 };
 
@@ -86,6 +92,40 @@ public:
      */
     virtual StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) = 0;
 
+    /*
+     * Compressors which can compress with a dictionary they share with the peer of a connection
+     * agree on it during the isMaster negotiation through the three methods below.
+     *
+     * appendDictionaryRequest is called on the client for every compressor it offers.
+     * negotiateDictionary and acceptDictionary are called on the server and the client for the
+     * first negotiated compressor only, which is the one used to compress. They return the id of
+     * the dictionary to pass to compressDataWithDictionary for the connection, or 0 for none.
+     */
+    virtual void appendDictionaryRequest(BSONObjBuilder* output) {}
+
+    virtual uint32_t negotiateDictionary(const BSONObj& input, BSONObjBuilder* output) {
+        return 0;
+    }
+
+    virtual uint32_t acceptDictionary(const BSONObj& input) {
+        return 0;
+    }
+
+    /*
+     * Like compressData, with the dictionary 'dictionaryId' agreed on with the peer.
+     */
+    virtual StatusWith<std::size_t> compressDataWithDictionary(ConstDataRange input,
+                                                               DataRange output,
+                                                               uint32_t dictionaryId) {
+        invariant(dictionaryId == 0);
+        return compressData(input, output);
+    }
+
+    /*
+     * Appends statistics specific to the compressor to the serverStatus section of it.
+     */
+    virtual void appendStats(BSONObjBuilder* b) const {}
+
     /*
      * This returns the number of bytes passed in the input for compressData
      */
@@ -114,6 +154,26 @@ public:
         return _decompressBytesOut.loadRelaxed();
     }
 
+    /*
+     * Called by the MessageCompressorManager to account for the time spent in compressData and
+     * decompressData for messages.
+     */
+    void counterHitCompressTime(Microseconds time) {
+        _compressMicros.addAndFetch(durationCount<Microseconds>(time));
+    }
+
+    void counterHitDecompressTime(Microseconds time) {
+        _decompressMicros.addAndFetch(durationCount<Microseconds>(time));
+    }
+
+    int64_t getCompressorMicros() const {
+        return _compressMicros.loadRelaxed();
+    }
+
+    int64_t getDecompressorMicros() const {
+        return _decompressMicros.loadRelaxed();
+    }
+
 
 protected:
     /*
@@ -148,5 +208,8 @@ private:
 
     AtomicInt64 _decompressBytesIn;
     AtomicInt64 _decompressBytesOut;
+
+    AtomicInt64 _compressMicros;
+    AtomicInt64 _decompressMicros;
 };
 }  // namespace mongo
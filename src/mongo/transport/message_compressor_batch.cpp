@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/message_compressor_batch.h"
+
+#include <memory>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/util/bson_extract.h"
+#include "mongo/transport/message_compressor_base.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+const char CompressedBatch::kCompressorFieldName[] = "compressor";
+const char CompressedBatch::kCountFieldName[] = "count";
+const char CompressedBatch::kSizeFieldName[] = "size";
+const char CompressedBatch::kDataFieldName[] = "data";
+
+void CompressedBatch::append(MessageCompressorBase* compressor,
+                             ConstDataRange documents,
+                             int count,
+                             StringData fieldName,
+                             BSONObjBuilder* builder) {
+    const auto maxCompressedSize = compressor->getMaxCompressedSize(documents.length());
+    std::unique_ptr<char[]> compressed(new char[maxCompressedSize]);
+    auto compressedSize = uassertStatusOK(
+        compressor->compressData(documents, DataRange(compressed.get(), maxCompressedSize)));
+
+    BSONObjBuilder blockBob(builder->subobjStart(fieldName));
+    blockBob.append(kCompressorFieldName, compressor->getName());
+    blockBob.append(kCountFieldName, count);
+    blockBob.append(kSizeFieldName, static_cast<int>(documents.length()));
+    blockBob.appendBinData(
+        kDataFieldName, static_cast<int>(compressedSize), BinDataGeneral, compressed.get());
+    blockBob.doneFast();
+}
+
+StatusWith<CompressedBatch> CompressedBatch::parse(const BSONObj& block) {
+    std::string compressorName;
+    auto status = bsonExtractStringField(block, kCompressorFieldName, &compressorName);
+    if (!status.isOK()) {
+        return status;
+    }
+    long long count;
+    status = bsonExtractIntegerField(block, kCountFieldName, &count);
+    if (!status.isOK()) {
+        return status;
+    }
+    long long size;
+    status = bsonExtractIntegerField(block, kSizeFieldName, &size);
+    if (!status.isOK()) {
+        return status;
+    }
+    BSONElement dataElement;
+    status = bsonExtractTypedField(block, kDataFieldName, BinData, &dataElement);
+    if (!status.isOK()) {
+        return status;
+    }
+    if (count < 0 || size < 0 || size > BSONObjMaxInternalSize) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "invalid count or size of compressed batch: " << block};
+    }
+
+    auto compressor = MessageCompressorRegistry::get().getCompressor(compressorName);
+    if (!compressor) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "batch was compressed with unsupported compressor '"
+                              << compressorName
+                              << "'"};
+    }
+
+    int compressedSize;
+    const char* compressed = dataElement.binData(compressedSize);
+    auto buffer = SharedBuffer::allocate(size);
+    auto decompressedSize = compressor->decompressData(ConstDataRange(compressed, compressedSize),
+                                                       DataRange(buffer.get(), size));
+    if (!decompressedSize.isOK()) {
+        return decompressedSize.getStatus();
+    }
+    if (decompressedSize.getValue() != static_cast<std::size_t>(size)) {
+        return {ErrorCodes::BadValue, "compressed batch did not decompress to its stated size"};
+    }
+    // The count comes from the peer, so bound it by what the data could hold before reserving.
+    if (count > size / BSONObj::kMinBSONLength) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "compressed batch of " << size << " bytes cannot hold " << count
+                              << " documents"};
+    }
+
+    CompressedBatch batch;
+    batch.compressedBytes = compressedSize;
+    batch.uncompressedBytes = size;
+    batch.documents.reserve(count);
+    ConstSharedBuffer documents(std::move(buffer));
+    for (long long offset = 0; offset < size;) {
+        const char* data = documents.get() + offset;
+        status = validateBSON(data, size - offset, BSONVersion::kLatest);
+        if (!status.isOK()) {
+            return status;
+        }
+        batch.documents.emplace_back(BSONObj(data).shareOwnershipWith(documents));
+        offset += batch.documents.back().objsize();
+    }
+    if (batch.documents.size() != static_cast<std::size_t>(count)) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "compressed batch held " << batch.documents.size()
+                              << " documents rather than "
+                              << count};
+    }
+
+    return std::move(batch);
+}
+
+}  // namespace mongo
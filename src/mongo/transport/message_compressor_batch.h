@@ -0,0 +1,81 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "mongo/base/data_range.h"
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class MessageCompressorBase;
+
+/**
+ * A batch of documents which a cursor reply carried as a single compressed block, rather than
+ * as an array of documents compressed (if at all) along with the rest of the message.
+ *
+ * The block is a sub-object of the form
+ *   { compressor: <String>, count: <Int>, size: <Int>, data: <BinData> }
+ * where 'data' is the compressed concatenation of the 'count' documents, 'size' bytes in all.
+ */
+struct CompressedBatch {
+    static const char kCompressorFieldName[];
+    static const char kCountFieldName[];
+    static const char kSizeFieldName[];
+    static const char kDataFieldName[];
+
+    /**
+     * Compresses the 'count' documents laid end to end in 'documents' with 'compressor', and
+     * appends the block to 'builder' as the field 'fieldName'. Throws if compressing fails.
+     */
+    static void append(MessageCompressorBase* compressor,
+                       ConstDataRange documents,
+                       int count,
+                       StringData fieldName,
+                       BSONObjBuilder* builder);
+
+    /**
+     * Decompresses 'block' with the compressor of the same name in the global
+     * MessageCompressorRegistry. The documents share ownership of a single buffer.
+     */
+    static StatusWith<CompressedBatch> parse(const BSONObj& block);
+
+    std::vector<BSONObj> documents;
+
+    // Length of 'data' in the block, and of the documents once decompressed.
+    std::size_t compressedBytes = 0;
+    std::size_t uncompressedBytes = 0;
+};
+
+}  // namespace mongo
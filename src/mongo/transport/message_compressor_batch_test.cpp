@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <limits>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_batch.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_snappy.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+MessageCompressorBase* getSnappyCompressor() {
+    auto& registry = MessageCompressorRegistry::get();
+    if (!registry.getCompressor("snappy")) {
+        registry.setSupportedCompressors({"snappy"});
+        registry.registerImplementation(stdx::make_unique<SnappyMessageCompressor>());
+    }
+    return registry.getCompressor("snappy");
+}
+
+BSONObj makeBlock(const std::vector<BSONObj>& documents) {
+    BufBuilder buf;
+    for (const auto& doc : documents) {
+        doc.appendSelfToBufBuilder(buf);
+    }
+    BSONObjBuilder bob;
+    CompressedBatch::append(getSnappyCompressor(),
+                            ConstDataRange(buf.buf(), buf.len()),
+                            documents.size(),
+                            "compressedBatch",
+                            &bob);
+    return bob.obj()["compressedBatch"].Obj().getOwned();
+}
+
+TEST(CompressedBatchTest, RoundTrip) {
+    std::vector<BSONObj> documents;
+    for (int i = 0; i < 100; i++) {
+        documents.push_back(BSON("ts" << Timestamp(1, i) << "op"
+                                      << "i"
+                                      << "ns"
+                                      << "test.coll"
+                                      << "o"
+                                      << BSON("_id" << i)));
+    }
+    auto block = makeBlock(documents);
+    ASSERT_EQ("snappy", block[CompressedBatch::kCompressorFieldName].str());
+
+    auto batch = unittest::assertGet(CompressedBatch::parse(block));
+    ASSERT_EQ(documents.size(), batch.documents.size());
+    for (std::size_t i = 0; i < documents.size(); i++) {
+        ASSERT_BSONOBJ_EQ(documents[i], batch.documents[i]);
+    }
+    ASSERT_LT(batch.compressedBytes, batch.uncompressedBytes);
+    ASSERT_EQ(static_cast<std::size_t>(block[CompressedBatch::kSizeFieldName].numberInt()),
+              batch.uncompressedBytes);
+}
+
+TEST(CompressedBatchTest, EmptyBatch) {
+    auto batch = unittest::assertGet(CompressedBatch::parse(makeBlock({})));
+    ASSERT_TRUE(batch.documents.empty());
+    ASSERT_EQ(0U, batch.uncompressedBytes);
+}
+
+TEST(CompressedBatchTest, WrongCountIsRejected) {
+    auto block = makeBlock({BSON("a" << 1), BSON("a" << 2)});
+    BSONObjBuilder bob;
+    for (auto&& elem : block) {
+        if (elem.fieldNameStringData() == CompressedBatch::kCountFieldName) {
+            bob.append(CompressedBatch::kCountFieldName, 3);
+        } else {
+            bob.append(elem);
+        }
+    }
+    ASSERT_EQUALS(ErrorCodes::BadValue, CompressedBatch::parse(bob.obj()).getStatus());
+}
+
+TEST(CompressedBatchTest, CountLargerThanTheDataCanHoldIsRejected) {
+    auto block = makeBlock({BSON("a" << 1), BSON("a" << 2)});
+    BSONObjBuilder bob;
+    for (auto&& elem : block) {
+        if (elem.fieldNameStringData() == CompressedBatch::kCountFieldName) {
+            bob.append(CompressedBatch::kCountFieldName, std::numeric_limits<int>::max());
+        } else {
+            bob.append(elem);
+        }
+    }
+    ASSERT_EQUALS(ErrorCodes::BadValue, CompressedBatch::parse(bob.obj()).getStatus());
+}
+
+TEST(CompressedBatchTest, WrongSizeIsRejected) {
+    auto block = makeBlock({BSON("a" << 1), BSON("a" << 2)});
+    BSONObjBuilder bob;
+    for (auto&& elem : block) {
+        if (elem.fieldNameStringData() == CompressedBatch::kSizeFieldName) {
+            bob.append(CompressedBatch::kSizeFieldName, elem.numberInt() - 1);
+        } else {
+            bob.append(elem);
+        }
+    }
+    ASSERT_NOT_OK(CompressedBatch::parse(bob.obj()).getStatus());
+}
+
+TEST(CompressedBatchTest, UnknownCompressorIsRejected) {
+    auto block = makeBlock({BSON("a" << 1)});
+    BSONObjBuilder bob;
+    for (auto&& elem : block) {
+        if (elem.fieldNameStringData() == CompressedBatch::kCompressorFieldName) {
+            bob.append(CompressedBatch::kCompressorFieldName, "lz4");
+        } else {
+            bob.append(elem);
+        }
+    }
+    ASSERT_EQUALS(ErrorCodes::BadValue, CompressedBatch::parse(bob.obj()).getStatus());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/session.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 namespace {
@@ -117,7 +118,7 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
         return {msg};
     }
 
-    auto outputMessageBuffer = SharedBuffer::allocate(bufferSize);
+    auto outputMessageBuffer = SharedBuffer::allocatePooled(bufferSize);
 
     MsgData::View outMessage(outputMessageBuffer.get());
     outMessage.setId(inputHeader.getId());
@@ -129,7 +130,13 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     compressionHeader.serialize(&output);
     ConstDataRange input(inputHeader.data(), inputHeader.data() + inputHeader.dataLen());
 
-    auto sws = compressor->compressData(input, output);
+    // The dictionary agreed on during negotiation belongs to the first negotiated compressor.
+    const auto dictionaryId =
+        !_negotiated.empty() && compressor == _negotiated[0] ? _dictionaryId : 0;
+
+    Timer timer;
+    auto sws = compressor->compressDataWithDictionary(input, output, dictionaryId);
+    compressor->counterHitCompressTime(Microseconds(timer.micros()));
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -167,7 +174,7 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
                 "Decompressed message would be larger than maximum message size"};
     }
 
-    auto outputMessageBuffer = SharedBuffer::allocate(bufferSize);
+    auto outputMessageBuffer = SharedBuffer::allocatePooled(bufferSize);
     MsgData::View outMessage(outputMessageBuffer.get());
     outMessage.setId(inputHeader.getId());
     outMessage.setResponseToMsgId(inputHeader.getResponseToMsgId());
@@ -176,7 +183,9 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
 
     DataRangeCursor output(outMessage.data(), outMessage.data() + outMessage.dataLen());
 
+    Timer timer;
     auto sws = compressor->decompressData(input, output);
+    compressor->counterHitDecompressTime(Microseconds(timer.micros()));
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -195,6 +204,7 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
 
     // We're about to update the compressor list with the negotiation result from the server.
     _negotiated.clear();
+    _dictionaryId = 0;
 
     auto& compressorList = _registry->getCompressorNames();
     if (compressorList.size() == 0)
@@ -206,6 +216,10 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
         sub.append(e);
     }
     sub.doneFast();
+
+    for (const auto& e : _registry->getCompressorNames()) {
+        _registry->getCompressor(e)->appendDictionaryRequest(output);
+    }
 }
 
 void MessageCompressorManager::clientFinish(const BSONObj& input) {
@@ -231,6 +245,10 @@ void MessageCompressorManager::clientFinish(const BSONObj& input) {
         LOG(3) << "Adding compressor " << ret->getName();
         _negotiated.push_back(ret);
     }
+
+    if (!_negotiated.empty()) {
+        _dictionaryId = _negotiated[0]->acceptDictionary(input);
+    }
 }
 
 void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuilder* output) {
@@ -258,6 +276,7 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
     // If compression has already been negotiated, then this is a renegotiation, so we should
     // reset the state of the manager.
     _negotiated.clear();
+    _dictionaryId = 0;
 
     // First we go through all the compressor names that the client has requested support for
     BSONObj theirObj = elem.Obj();
@@ -288,6 +307,8 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
             sub.append(algo->getName());
         }
         sub.doneFast();
+
+        _dictionaryId = _negotiated[0]->negotiateDictionary(input, output);
     } else {
         LOG(3) << "Could not agree on compressor to use";
     }
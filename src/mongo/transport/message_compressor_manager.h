@@ -127,6 +127,8 @@ public:
 
 private:
     std::vector<MessageCompressorBase*> _negotiated;
+    // The dictionary of the first negotiated compressor agreed on with the peer, or 0.
+    uint32_t _dictionaryId = 0;
     MessageCompressorRegistry* _registry;
 };
 
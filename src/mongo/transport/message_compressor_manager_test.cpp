@@ -38,6 +38,7 @@
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/message_compressor_snappy.h"
 #include "mongo/transport/message_compressor_zlib.h"
+#include "mongo/transport/message_compressor_zstd.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
 
@@ -233,6 +234,11 @@ TEST(ZlibMessageCompressor, Fidelity) {
     checkFidelity(testMessage, stdx::make_unique<ZlibMessageCompressor>());
 }
 
+TEST(ZstdMessageCompressor, Fidelity) {
+    auto testMessage = buildMessage();
+    checkFidelity(testMessage, stdx::make_unique<ZstdMessageCompressor>());
+}
+
 TEST(SnappyMessageCompressor, Overflow) {
     checkOverflow(stdx::make_unique<SnappyMessageCompressor>());
 }
@@ -241,6 +247,146 @@ TEST(ZlibMessageCompressor, Overflow) {
     checkOverflow(stdx::make_unique<ZlibMessageCompressor>());
 }
 
+TEST(ZstdMessageCompressor, Overflow) {
+    checkOverflow(stdx::make_unique<ZstdMessageCompressor>());
+}
+
+BSONObj buildCommand(int i) {
+    return BSON("find"
+                << "collection"
+                << "filter"
+                << BSON("_id" << i << "name"
+                              << "user"
+                              << "score"
+                              << BSON("$gt" << i * 7))
+                << "limit"
+                << 1
+                << "lsid"
+                << BSON("id"
+                        << "d2f1d4a0-1b25-4d1c-9f9e-3c1d0a1e6b7f")
+                << "$db"
+                << "test");
+}
+
+Message buildCommandMessage(const BSONObj& command) {
+    const auto bufferSize = MsgData::MsgDataHeaderSize + command.objsize();
+    auto buf = SharedBuffer::allocate(bufferSize);
+    MsgData::View view(buf.get());
+    view.setId(1);
+    view.setResponseToMsgId(0);
+    view.setOperation(dbMsg);
+    view.setLen(bufferSize);
+    memcpy(view.data(), command.objdata(), command.objsize());
+    return Message{buf};
+}
+
+MessageCompressorRegistry buildZstdRegistry(ZstdMessageCompressor** compressor) {
+    MessageCompressorRegistry registry;
+    auto zstdCompressor = stdx::make_unique<ZstdMessageCompressor>();
+    *compressor = zstdCompressor.get();
+    registry.setSupportedCompressors({zstdCompressor->getName()});
+    registry.registerImplementation(std::move(zstdCompressor));
+    ASSERT_OK(registry.finalizeSupportedCompressors());
+    return registry;
+}
+
+BSONObj dictionaryStats(const ZstdMessageCompressor& compressor) {
+    BSONObjBuilder b;
+    compressor.appendStats(&b);
+    return b.obj()["dictionary"].Obj().getOwned();
+}
+
+TEST(ZstdMessageCompressor, NegotiatesTrainedDictionary) {
+    ZstdMessageCompressor* serverCompressor;
+    auto serverRegistry = buildZstdRegistry(&serverCompressor);
+    ZstdMessageCompressor* clientCompressor;
+    auto clientRegistry = buildZstdRegistry(&clientCompressor);
+
+    std::string samples;
+    std::vector<size_t> sampleSizes;
+    for (int i = 0; i < 1000; i++) {
+        auto command = buildCommand(i);
+        samples.append(command.objdata(), command.objsize());
+        sampleSizes.push_back(command.objsize());
+    }
+    const auto dictionaryId = assertOk(serverCompressor->trainDictionary(samples, sampleSizes));
+
+    // The first connection sends the dictionary to the client.
+    MessageCompressorManager clientManager(&clientRegistry);
+    MessageCompressorManager serverManager(&serverRegistry);
+    BSONObjBuilder clientOutput;
+    clientManager.clientBegin(&clientOutput);
+    auto clientObj = clientOutput.done();
+    ASSERT_EQ(0, clientObj["zstdDictionaryIds"].Obj().nFields());
+
+    BSONObjBuilder serverOutput;
+    serverManager.serverNegotiate(clientObj, &serverOutput);
+    auto serverObj = serverOutput.done();
+    ASSERT_EQ(dictionaryId, serverObj["zstdDictionary"]["id"].numberLong());
+    ASSERT_EQ(BinData, serverObj["zstdDictionary"]["data"].type());
+    clientManager.clientFinish(serverObj);
+
+    // Both directions compress with it.
+    const auto command = buildCommand(12345);
+    auto toSend = assertOk(clientManager.compressMessage(buildCommandMessage(command)));
+    auto recvd = assertOk(serverManager.decompressMessage(toSend));
+    ASSERT_BSONOBJ_EQ(command, BSONObj(recvd.singleData().data()));
+    toSend = assertOk(serverManager.compressMessage(recvd));
+    recvd = assertOk(clientManager.decompressMessage(toSend));
+    ASSERT_BSONOBJ_EQ(command, BSONObj(recvd.singleData().data()));
+
+    ASSERT_EQ(1, dictionaryStats(*serverCompressor)["compressed"].numberLong());
+    ASSERT_EQ(1, dictionaryStats(*serverCompressor)["decompressed"].numberLong());
+    ASSERT_EQ(1, dictionaryStats(*clientCompressor)["compressed"].numberLong());
+    ASSERT_EQ(1, dictionaryStats(*clientCompressor)["decompressed"].numberLong());
+
+    // Later connections only name the dictionary the client has already.
+    MessageCompressorManager secondClientManager(&clientRegistry);
+    MessageCompressorManager secondServerManager(&serverRegistry);
+    BSONObjBuilder secondClientOutput;
+    secondClientManager.clientBegin(&secondClientOutput);
+    clientObj = secondClientOutput.done();
+    ASSERT_EQ(dictionaryId, clientObj["zstdDictionaryIds"].Obj().firstElement().numberLong());
+
+    BSONObjBuilder secondServerOutput;
+    secondServerManager.serverNegotiate(clientObj, &secondServerOutput);
+    serverObj = secondServerOutput.done();
+    ASSERT_EQ(dictionaryId, serverObj["zstdDictionary"]["id"].numberLong());
+    ASSERT_TRUE(serverObj["zstdDictionary"]["data"].eoo());
+    secondClientManager.clientFinish(serverObj);
+
+    toSend = assertOk(secondClientManager.compressMessage(buildCommandMessage(command)));
+    recvd = assertOk(secondServerManager.decompressMessage(toSend));
+    ASSERT_BSONOBJ_EQ(command, BSONObj(recvd.singleData().data()));
+    ASSERT_EQ(2, dictionaryStats(*serverCompressor)["decompressed"].numberLong());
+}
+
+TEST(ZstdMessageCompressor, NoDictionaryForClientsWhichDontAskForOne) {
+    ZstdMessageCompressor* serverCompressor;
+    auto serverRegistry = buildZstdRegistry(&serverCompressor);
+
+    std::string samples;
+    std::vector<size_t> sampleSizes;
+    for (int i = 0; i < 1000; i++) {
+        auto command = buildCommand(i);
+        samples.append(command.objdata(), command.objsize());
+        sampleSizes.push_back(command.objsize());
+    }
+    assertOk(serverCompressor->trainDictionary(samples, sampleSizes));
+
+    MessageCompressorManager serverManager(&serverRegistry);
+    BSONObjBuilder serverOutput;
+    serverManager.serverNegotiate(BSON("isMaster" << 1 << "compression" << BSON_ARRAY("zstd")),
+                                  &serverOutput);
+    auto serverObj = serverOutput.done();
+    checkNegotiationResult(serverObj, {"zstd"});
+    ASSERT_TRUE(serverObj["zstdDictionary"].eoo());
+
+    auto toSend = assertOk(serverManager.compressMessage(buildCommandMessage(buildCommand(1))));
+    assertOk(serverManager.decompressMessage(toSend));
+    ASSERT_EQ(0, dictionaryStats(*serverCompressor)["compressed"].numberLong());
+}
+
 TEST(MessageCompressorManager, SERVER_28008) {
 
     // Create a client and server that will negotiate the same compressors,
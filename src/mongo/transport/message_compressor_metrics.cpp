@@ -35,6 +35,13 @@ namespace mongo {
 namespace {
 const auto kBytesIn = "bytesIn"_sd;
 const auto kBytesOut = "bytesOut"_sd;
+const auto kMicros = "micros"_sd;
+const auto kRatio = "ratio"_sd;
+
+// The ratio of the uncompressed to the compressed size, or 0 before anything was compressed.
+double compressionRatio(int64_t uncompressedBytes, int64_t compressedBytes) {
+    return compressedBytes > 0 ? static_cast<double>(uncompressedBytes) / compressedBytes : 0;
+}
 }  // namespace
 
 void appendMessageCompressionStats(BSONObjBuilder* b) {
@@ -51,13 +58,21 @@ void appendMessageCompressionStats(BSONObjBuilder* b) {
 
         BSONObjBuilder compressorSection(base.subobjStart("compressor"));
         compressorSection << kBytesIn << compressor->getCompressorBytesIn() << kBytesOut
-                          << compressor->getCompressorBytesOut();
+                          << compressor->getCompressorBytesOut() << kRatio
+                          << compressionRatio(compressor->getCompressorBytesIn(),
+                                              compressor->getCompressorBytesOut())
+                          << kMicros << compressor->getCompressorMicros();
         compressorSection.doneFast();
 
         BSONObjBuilder decompressorSection(base.subobjStart("decompressor"));
         decompressorSection << kBytesIn << compressor->getDecompressorBytesIn() << kBytesOut
-                            << compressor->getDecompressorBytesOut();
+                            << compressor->getDecompressorBytesOut() << kRatio
+                            << compressionRatio(compressor->getDecompressorBytesOut(),
+                                                compressor->getDecompressorBytesIn())
+                            << kMicros << compressor->getDecompressorMicros();
         decompressorSection.doneFast();
+
+        compressor->appendStats(&base);
         base.doneFast();
     }
     compressionSection.doneFast();
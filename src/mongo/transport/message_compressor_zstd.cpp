@@ -0,0 +1,437 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/message_compressor_zstd.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "mongo/base/init.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+#include <zdict.h>
+#include <zstd.h>
+
+namespace mongo {
+namespace {
+
+MONGO_EXPORT_SERVER_PARAMETER(zstdCompressionLevel, int, 1)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 19) {
+            return Status(ErrorCodes::BadValue,
+                          "zstdCompressionLevel must be between 1 and 19 (inclusive)");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(zstdTrainDictionary, bool, false);
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(zstdDictionaryTrainingSamples, int, 2000)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 10 || potentialNewValue > 100000) {
+            return Status(ErrorCodes::BadValue,
+                          "zstdDictionaryTrainingSamples must be between 10 and 100000 "
+                          "(inclusive)");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(zstdDictionarySizeKB, int, 16)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "zstdDictionarySizeKB must be between 1 and 1024 (inclusive)");
+        }
+        return Status::OK();
+    });
+
+// Commands and replies are told apart by their first few hundred bytes, so the rest of a large
+// message is left out of its sample.
+constexpr size_t kMaxSampleSize = 4 * 1024;
+
+// Larger dictionaries than a server would train are refused.
+constexpr size_t kMaxDictionarySize = 1024 * 1024;
+
+const auto kDictionaryIdsField = "zstdDictionaryIds"_sd;
+const auto kDictionaryField = "zstdDictionary"_sd;
+
+struct CompressionContextDeleter {
+    void operator()(ZSTD_CCtx* context) const {
+        ZSTD_freeCCtx(context);
+    }
+};
+
+struct DecompressionContextDeleter {
+    void operator()(ZSTD_DCtx* context) const {
+        ZSTD_freeDCtx(context);
+    }
+};
+
+// The contexts hold the state the compressor needs between frames, which is expensive to set up,
+// so every thread keeps one of each.
+ZSTD_CCtx* compressionContext() {
+    thread_local std::unique_ptr<ZSTD_CCtx, CompressionContextDeleter> context(ZSTD_createCCtx());
+    invariant(context);
+    return context.get();
+}
+
+ZSTD_DCtx* decompressionContext() {
+    thread_local std::unique_ptr<ZSTD_DCtx, DecompressionContextDeleter> context(
+        ZSTD_createDCtx());
+    invariant(context);
+    return context.get();
+}
+
+}  // namespace
+
+class ZstdMessageCompressor::Dictionary {
+    MONGO_DISALLOW_COPYING(Dictionary);
+
+public:
+    /**
+     * The compression level of the dictionary is the one of zstdCompressionLevel when it is made.
+     */
+    static StatusWith<std::shared_ptr<Dictionary>> make(ConstDataRange data) {
+        const uint32_t id = ZDICT_getDictID(data.data(), data.length());
+        if (id == 0 || data.length() > kMaxDictionarySize) {
+            return Status(ErrorCodes::BadValue, "Not a valid zstd dictionary");
+        }
+
+        auto dictionary = std::make_shared<Dictionary>(id, data);
+        dictionary->_compressionDictionary =
+            ZSTD_createCDict(data.data(), data.length(), zstdCompressionLevel.load());
+        dictionary->_decompressionDictionary = ZSTD_createDDict(data.data(), data.length());
+        if (!dictionary->_compressionDictionary || !dictionary->_decompressionDictionary) {
+            return Status(ErrorCodes::BadValue, "Not a valid zstd dictionary");
+        }
+        return dictionary;
+    }
+
+    Dictionary(uint32_t id, ConstDataRange data) : _id(id), _data(data.data(), data.length()) {}
+
+    ~Dictionary() {
+        ZSTD_freeCDict(_compressionDictionary);
+        ZSTD_freeDDict(_decompressionDictionary);
+    }
+
+    uint32_t id() const {
+        return _id;
+    }
+
+    const std::string& data() const {
+        return _data;
+    }
+
+    const ZSTD_CDict* compressionDictionary() const {
+        return _compressionDictionary;
+    }
+
+    const ZSTD_DDict* decompressionDictionary() const {
+        return _decompressionDictionary;
+    }
+
+private:
+    const uint32_t _id;
+    const std::string _data;
+    ZSTD_CDict* _compressionDictionary = nullptr;
+    ZSTD_DDict* _decompressionDictionary = nullptr;
+};
+
+ZstdMessageCompressor::ZstdMessageCompressor()
+    : MessageCompressorBase(MessageCompressor::kZstd), _collectingSamples(zstdTrainDictionary) {}
+
+ZstdMessageCompressor::~ZstdMessageCompressor() = default;
+
+std::size_t ZstdMessageCompressor::getMaxCompressedSize(size_t inputSize) {
+    return ZSTD_compressBound(inputSize);
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::compressData(ConstDataRange input,
+                                                            DataRange output) {
+    return compressDataWithDictionary(input, output, 0);
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::compressDataWithDictionary(ConstDataRange input,
+                                                                          DataRange output,
+                                                                          uint32_t dictionaryId) {
+    _sample(input);
+
+    size_t outLength;
+    if (dictionaryId != 0) {
+        auto dictionary = _getDictionary(dictionaryId);
+        invariant(dictionary);
+        outLength = ZSTD_compress_usingCDict(compressionContext(),
+                                             const_cast<char*>(output.data()),
+                                             output.length(),
+                                             input.data(),
+                                             input.length(),
+                                             dictionary->compressionDictionary());
+        _compressedWithDictionary.addAndFetch(1);
+    } else {
+        outLength = ZSTD_compressCCtx(compressionContext(),
+                                      const_cast<char*>(output.data()),
+                                      output.length(),
+                                      input.data(),
+                                      input.length(),
+                                      zstdCompressionLevel.load());
+    }
+
+    if (ZSTD_isError(outLength)) {
+        return Status{ErrorCodes::BadValue,
+                      str::stream() << "Could not compress input: "
+                                    << ZSTD_getErrorName(outLength)};
+    }
+
+    counterHitCompress(input.length(), outLength);
+    return {outLength};
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::decompressData(ConstDataRange input,
+                                                              DataRange output) {
+    size_t length;
+    const auto dictionaryId = ZSTD_getDictID_fromFrame(input.data(), input.length());
+    if (dictionaryId != 0) {
+        auto dictionary = _getDictionary(dictionaryId);
+        if (!dictionary) {
+            return Status{ErrorCodes::BadValue,
+                          str::stream() << "Compressed message refers to unknown dictionary "
+                                        << dictionaryId};
+        }
+        length = ZSTD_decompress_usingDDict(decompressionContext(),
+                                            const_cast<char*>(output.data()),
+                                            output.length(),
+                                            input.data(),
+                                            input.length(),
+                                            dictionary->decompressionDictionary());
+        _decompressedWithDictionary.addAndFetch(1);
+    } else {
+        length = ZSTD_decompressDCtx(decompressionContext(),
+                                     const_cast<char*>(output.data()),
+                                     output.length(),
+                                     input.data(),
+                                     input.length());
+    }
+
+    if (ZSTD_isError(length) || length != output.length()) {
+        return Status{ErrorCodes::BadValue, "Compressed message was invalid or corrupted"};
+    }
+
+    counterHitDecompress(input.length(), output.length());
+    _sample(ConstDataRange(output.data(), output.length()));
+    return {output.length()};
+}
+
+void ZstdMessageCompressor::appendDictionaryRequest(BSONObjBuilder* output) {
+    // Listing the dictionaries, even if there are none, tells the server we accept one.
+    BSONArrayBuilder ids(output->subarrayStart(kDictionaryIdsField));
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    for (const auto& entry : _dictionaries) {
+        ids.append(static_cast<long long>(entry.first));
+    }
+}
+
+uint32_t ZstdMessageCompressor::negotiateDictionary(const BSONObj& input,
+                                                    BSONObjBuilder* output) {
+    auto idsElem = input[kDictionaryIdsField];
+    if (idsElem.type() != Array) {
+        return 0;
+    }
+
+    std::shared_ptr<Dictionary> offered;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        offered = _offered;
+    }
+    if (!offered) {
+        return 0;
+    }
+
+    bool clientHasDictionary = false;
+    for (const auto& id : idsElem.Obj()) {
+        if (id.isNumber() && id.numberLong() == offered->id()) {
+            clientHasDictionary = true;
+        }
+    }
+
+    BSONObjBuilder dictionaryBuilder(output->subobjStart(kDictionaryField));
+    dictionaryBuilder.append("id", static_cast<long long>(offered->id()));
+    if (!clientHasDictionary) {
+        dictionaryBuilder.appendBinData(
+            "data", offered->data().size(), BinDataGeneral, offered->data().data());
+    }
+    dictionaryBuilder.doneFast();
+
+    LOG(3) << "Offering zstd dictionary " << offered->id() << " to client";
+    return offered->id();
+}
+
+uint32_t ZstdMessageCompressor::acceptDictionary(const BSONObj& input) {
+    auto dictionaryElem = input[kDictionaryField];
+    if (dictionaryElem.type() != Object) {
+        return 0;
+    }
+
+    const auto dictionaryObj = dictionaryElem.Obj();
+    const auto id = dictionaryObj["id"].numberLong();
+    uassert(51015,
+            str::stream() << "Server agreed on invalid zstd dictionary id " << id,
+            id > 0 && id <= std::numeric_limits<uint32_t>::max());
+    if (_getDictionary(id)) {
+        return id;
+    }
+
+    // The server only leaves the dictionary out if we listed it in our request, so it failing to
+    // send one we don't have means the connection can't be used.
+    auto dataElem = dictionaryObj["data"];
+    uassert(51016,
+            str::stream() << "Server agreed on zstd dictionary " << id << " without sending it",
+            dataElem.type() == BinData);
+
+    int length;
+    const char* data = dataElem.binData(length);
+    auto dictionary = uassertStatusOK(_addDictionary(ConstDataRange(data, data + length)));
+    uassert(51017,
+            str::stream() << "Server sent zstd dictionary " << dictionary->id() << " as " << id,
+            dictionary->id() == id);
+
+    LOG(1) << "Received zstd dictionary " << id << " of " << length << " bytes from server";
+    return id;
+}
+
+void ZstdMessageCompressor::appendStats(BSONObjBuilder* b) const {
+    BSONObjBuilder dictionarySection(b->subobjStart("dictionary"));
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_offered) {
+            dictionarySection.append("offeredId", static_cast<long long>(_offered->id()));
+        }
+        dictionarySection.append("known", static_cast<long long>(_dictionaries.size()));
+        dictionarySection.append("samples", static_cast<long long>(_sampleSizes.size()));
+    }
+    dictionarySection.append("compressed", _compressedWithDictionary.load());
+    dictionarySection.append("decompressed", _decompressedWithDictionary.load());
+    dictionarySection.doneFast();
+}
+
+StatusWith<uint32_t> ZstdMessageCompressor::trainDictionary(
+    const std::string& samples, const std::vector<size_t>& sampleSizes) {
+    std::string data(static_cast<size_t>(zstdDictionarySizeKB) * 1024, '\0');
+    const auto length = ZDICT_trainFromBuffer(
+        &data[0], data.size(), samples.data(), sampleSizes.data(), sampleSizes.size());
+    if (ZDICT_isError(length)) {
+        return Status(ErrorCodes::OperationFailed,
+                      str::stream() << "Could not train a zstd dictionary from "
+                                    << sampleSizes.size()
+                                    << " messages: "
+                                    << ZDICT_getErrorName(length));
+    }
+
+    auto swDictionary = _addDictionary(ConstDataRange(data.data(), data.data() + length));
+    if (!swDictionary.isOK()) {
+        return swDictionary.getStatus();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _offered = std::move(swDictionary.getValue());
+    return _offered->id();
+}
+
+StatusWith<std::shared_ptr<ZstdMessageCompressor::Dictionary>>
+ZstdMessageCompressor::_addDictionary(ConstDataRange data) {
+    auto swDictionary = Dictionary::make(data);
+    if (!swDictionary.isOK()) {
+        return swDictionary.getStatus();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto& dictionary = swDictionary.getValue();
+    return _dictionaries.emplace(dictionary->id(), dictionary).first->second;
+}
+
+std::shared_ptr<ZstdMessageCompressor::Dictionary> ZstdMessageCompressor::_getDictionary(
+    uint32_t id) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _dictionaries.find(id);
+    return it == _dictionaries.end() ? nullptr : it->second;
+}
+
+void ZstdMessageCompressor::_sample(ConstDataRange message) {
+    if (!_collectingSamples.load()) {
+        return;
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (!_collectingSamples.load()) {
+        return;
+    }
+
+    const auto length = std::min(message.length(), kMaxSampleSize);
+    _samples.append(message.data(), length);
+    _sampleSizes.push_back(length);
+    if (_sampleSizes.size() < static_cast<size_t>(zstdDictionaryTrainingSamples)) {
+        return;
+    }
+
+    // Training takes long enough that it mustn't hold up the message which completed the samples.
+    _collectingSamples.store(false);
+    stdx::thread([ this, samples = std::move(_samples), sampleSizes = std::move(_sampleSizes) ] {
+        setThreadName("zstdDictionaryTrainer");
+        auto swId = trainDictionary(samples, sampleSizes);
+        if (!swId.isOK()) {
+            warning() << "Compressing messages with zstd without a dictionary: "
+                      << swId.getStatus();
+            return;
+        }
+        log() << "Trained zstd dictionary " << swId.getValue() << " from "
+              << sampleSizes.size() << " messages";
+    })
+        .detach();
+    _samples.clear();
+    _sampleSizes.clear();
+}
+
+MONGO_INITIALIZER_GENERAL(ZstdMessageCompressorInit,
+                          ("EndStartupOptionHandling"),
+                          ("AllCompressorsRegistered"))
+(InitializerContext* context) {
+    auto& compressorRegistry = MessageCompressorRegistry::get();
+    compressorRegistry.registerImplementation(stdx::make_unique<ZstdMessageCompressor>());
+    return Status::OK();
+}
+}  // namespace mongo
@@ -0,0 +1,116 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/transport/message_compressor_base.h"
+
+namespace mongo {
+
+/**
+ * Compresses messages with Zstandard.
+ *
+ * With zstdTrainDictionary set, the first messages it compresses or decompresses are collected
+ * and a dictionary is trained from them in the background, which is then offered to clients in
+ * the isMaster replies of new connections. Clients keep every dictionary they have been sent and
+ * list their ids in isMaster, so that a server only sends its dictionary once to each of them.
+ * Both peers of a connection which agreed on a dictionary compress with it, and any dictionary
+ * this process knows is used to decompress the frames which refer to it.
+ */
+class ZstdMessageCompressor final : public MessageCompressorBase {
+public:
+    ZstdMessageCompressor();
+    ~ZstdMessageCompressor();
+
+    std::size_t getMaxCompressedSize(size_t inputSize) override;
+
+    StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override;
+
+    StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override;
+
+    void appendDictionaryRequest(BSONObjBuilder* output) override;
+
+    uint32_t negotiateDictionary(const BSONObj& input, BSONObjBuilder* output) override;
+
+    uint32_t acceptDictionary(const BSONObj& input) override;
+
+    StatusWith<std::size_t> compressDataWithDictionary(ConstDataRange input,
+                                                       DataRange output,
+                                                       uint32_t dictionaryId) override;
+
+    void appendStats(BSONObjBuilder* b) const override;
+
+    /**
+     * Trains a dictionary from the concatenated 'samples', whose lengths are 'sampleSizes', and
+     * offers it to clients from then on. Returns the id of the dictionary.
+     */
+    StatusWith<uint32_t> trainDictionary(const std::string& samples,
+                                         const std::vector<size_t>& sampleSizes);
+
+private:
+    class Dictionary;
+
+    /**
+     * Adds the dictionary 'data' unless one with its id is known already, and returns the one
+     * with its id.
+     */
+    StatusWith<std::shared_ptr<Dictionary>> _addDictionary(ConstDataRange data);
+
+    std::shared_ptr<Dictionary> _getDictionary(uint32_t id) const;
+
+    /**
+     * Collects 'message' as a sample for training, and starts the training once enough have been
+     * collected.
+     */
+    void _sample(ConstDataRange message);
+
+    mutable stdx::mutex _mutex;
+
+    // Every dictionary this process trained or was sent by a server, by id. Dictionaries are never
+    // removed, since a peer may use one for as long as the connection it was agreed on for lasts.
+    std::map<uint32_t, std::shared_ptr<Dictionary>> _dictionaries;
+
+    // The dictionary trained by this process, offered to clients.
+    std::shared_ptr<Dictionary> _offered;
+
+    AtomicBool _collectingSamples;
+    std::string _samples;
+    std::vector<size_t> _sampleSizes;
+
+    AtomicInt64 _compressedWithDictionary;
+    AtomicInt64 _decompressedWithDictionary;
+};
+
+}  // namespace mongo
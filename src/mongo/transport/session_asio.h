@@ -371,7 +371,7 @@ private:
                     return Future<Message>::makeReady(Message(std::move(headerBuffer)));
                 }
 
-                auto buffer = SharedBuffer::allocate(msgLen);
+                auto buffer = SharedBuffer::allocatePooled(msgLen);
                 memcpy(buffer.get(), headerBuffer.get(), kHeaderSize);
 
                 MsgData::View msgView(buffer.get());
@@ -30,6 +30,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "mongo/client/async_client.h"
 #include "mongo/client/connection_string.h"
 #include "mongo/db/client.h"
@@ -42,6 +45,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 #include "asio.hpp"
 
@@ -157,5 +161,80 @@ TEST(TransportLayerASIO, asyncConnectTimeoutCleansUpSocket) {
     ASSERT_EQ(client.getStatus(), ErrorCodes::NetworkTimeout);
 }
 
+// Drives pings over several connections for a fixed duration and logs the throughput and latency
+// percentiles. It makes no assertions about the numbers; running it against servers started with
+// different --transportLayer values compares their overhead per round trip.
+TEST(TransportLayerASIO, PingThroughputAndLatency) {
+    const int kConnections = 8;
+    const Milliseconds kDuration{2000};
+
+    auto connectionString = unittest::getFixtureConnectionString();
+    auto server = connectionString.getServers().front();
+
+    auto sc = getGlobalServiceContext();
+    auto reactor = sc->getTransportLayer()->getReactor(transport::TransportLayer::kNewReactor);
+
+    stdx::thread thread([&] { reactor->run(); });
+    const auto threadGuard = MakeGuard([&] {
+        reactor->stop();
+        thread.join();
+    });
+
+    const executor::RemoteCommandRequest ping{
+        server, "admin", BSON("ping" << 1), BSONObj(), nullptr};
+
+    std::vector<std::vector<long long>> latencies(kConnections);
+    std::vector<Status> statuses(kConnections, Status::OK());
+    std::vector<stdx::thread> workers;
+    const auto deadline = Date_t::now() + kDuration;
+    for (int i = 0; i < kConnections; i++) {
+        workers.emplace_back([&, i] {
+            auto swHandle = AsyncDBClient::connect(
+                                server, transport::kGlobalSSLMode, sc, reactor, Milliseconds::max())
+                                .getNoThrow();
+            if (!swHandle.isOK()) {
+                statuses[i] = swHandle.getStatus();
+                return;
+            }
+            auto handle = std::move(swHandle.getValue());
+            statuses[i] = handle->initWireVersion(__FILE__, nullptr).getNoThrow();
+            if (!statuses[i].isOK()) {
+                return;
+            }
+
+            while (Date_t::now() < deadline) {
+                Timer timer;
+                auto reply = handle->runCommandRequest(ping).get();
+                if (!reply.status.isOK()) {
+                    statuses[i] = reply.status;
+                    return;
+                }
+                latencies[i].push_back(timer.micros());
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& status : statuses) {
+        ASSERT_OK(status);
+    }
+
+    std::vector<long long> all;
+    for (const auto& connectionLatencies : latencies) {
+        all.insert(all.end(), connectionLatencies.begin(), connectionLatencies.end());
+    }
+    ASSERT_FALSE(all.empty());
+    std::sort(all.begin(), all.end());
+
+    const auto percentile = [&](double p) {
+        return all[static_cast<size_t>(p * (all.size() - 1))];
+    };
+    log() << "Ran " << all.size() << " pings over " << kConnections << " connections to "
+          << server << ": " << (all.size() * 1000 / durationCount<Milliseconds>(kDuration))
+          << " ops/sec, latency p50 " << percentile(0.5) << "us, p99 " << percentile(0.99)
+          << "us, max " << all.back() << "us";
+}
+
 }  // namespace
 }  // namespace mongo
@@ -31,6 +31,7 @@
 #include "mongo/transport/transport_layer_manager.h"
 
 #include "mongo/base/status.h"
+#include "mongo/config.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/stdx/memory.h"
@@ -38,6 +39,9 @@
 #include "mongo/transport/service_executor_synchronous.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
+#ifdef MONGO_CONFIG_HAVE_LINUX_IO_URING
+#include "mongo/transport/transport_layer_uring.h"
+#endif
 #include "mongo/util/net/ssl_types.h"
 #include "mongo/util/time_support.h"
 #include <limits>
@@ -140,6 +144,33 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
         MONGO_UNREACHABLE;
     }
 
+#ifdef MONGO_CONFIG_HAVE_LINUX_IO_URING
+    if (config->transportLayer == "uring") {
+        transport::TransportLayerUring::Options uringOpts(config);
+        uringOpts.transportMode = opts.transportMode;
+        auto transportLayerUring =
+            stdx::make_unique<transport::TransportLayerUring>(uringOpts, sep);
+
+        if (config->serviceExecutor == "adaptive") {
+            auto reactor = transportLayerUring->getReactor(TransportLayer::kIngress);
+            ctx->setServiceExecutor(
+                stdx::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+        } else if (config->serviceExecutor == "synchronous") {
+            ctx->setServiceExecutor(stdx::make_unique<ServiceExecutorSynchronous>(ctx));
+        }
+
+        // The io_uring transport layer only accepts connections, so an egress-only ASIO transport
+        // layer comes first to make the connections and reactors the manager is asked for.
+        opts.mode = transport::TransportLayerASIO::Options::kEgress;
+        opts.ipList.clear();
+
+        std::vector<std::unique_ptr<TransportLayer>> retVector;
+        retVector.emplace_back(stdx::make_unique<transport::TransportLayerASIO>(opts, nullptr));
+        retVector.emplace_back(std::move(transportLayerUring));
+        return stdx::make_unique<TransportLayerManager>(std::move(retVector));
+    }
+#endif
+
     auto transportLayerASIO = stdx::make_unique<transport::TransportLayerASIO>(opts, sep);
 
     if (config->serviceExecutor == "adaptive") {
@@ -0,0 +1,1430 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_uring.h"
+
+#include <deque>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "mongo/config.h"
+#include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/hex.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/hostandport.h"
+#include "mongo/util/net/socket_utils.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/shared_buffer.h"
+
+// Older C libraries don't know about the io_uring system calls, whose numbers are the same on all
+// the architectures we build for.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace mongo {
+namespace transport {
+namespace {
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(uringRingEntries, int, 4096)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 32768) {
+            return Status(ErrorCodes::BadValue,
+                          "uringRingEntries must be between 1 and 32768 (inclusive)");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(uringRegisteredBuffers, int, 256)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 0 || potentialNewValue > 16384) {
+            return Status(ErrorCodes::BadValue,
+                          "uringRegisteredBuffers must be between 0 and 16384 (inclusive)");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(uringRegisteredBufferSizeKB, int, 16)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 16 * 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "uringRegisteredBufferSizeKB must be between 1 and 16384 (inclusive)");
+        }
+        return Status::OK();
+    });
+
+constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+// Size of the rings of the reactors made for getReactor(kNewReactor), which only run tasks and
+// timers.
+constexpr unsigned kNewReactorRingEntries = 64;
+
+// The user_data of the completions which don't belong to an Operation.
+constexpr uint64_t kWakeupUserData = 1;
+constexpr uint64_t kIgnoredUserData = 2;
+
+// An operation is submitted as at most this many linked entries.
+constexpr size_t kMaxLinkedEntries = 2;
+
+__kernel_timespec toTimespec(Milliseconds duration) {
+    __kernel_timespec ts;
+    ts.tv_sec = durationCount<Seconds>(duration);
+    ts.tv_nsec = durationCount<Nanoseconds>(duration - Seconds(ts.tv_sec));
+    return ts;
+}
+
+/**
+ * An operation submitted to the ring. The address of the operation is the user_data of its entry,
+ * and the operation is deleted once its completion has been handled.
+ */
+class Operation {
+public:
+    virtual ~Operation() = default;
+
+    static Operation* fromUserData(uint64_t userData) {
+        return reinterpret_cast<Operation*>(static_cast<uintptr_t>(userData));
+    }
+
+    uint64_t userData() const {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    /**
+     * Called with the result of the completion of the operation, which is a negative errno on
+     * failure.
+     */
+    virtual void complete(int result) = 0;
+
+    // Set by whoever asked the kernel to cancel the operation, which tells that cancellation
+    // apart from the expiry of a linked timeout.
+    bool cancelled = false;
+
+    // The timeout linked to the operation, if 'timed'. The kernel reads it when it is submitted.
+    bool timed = false;
+    __kernel_timespec timeout{};
+};
+
+template <typename Callback>
+class CallbackOperation final : public Operation {
+public:
+    explicit CallbackOperation(Callback callback) : _callback(std::move(callback)) {}
+
+    void complete(int result) override {
+        _callback(this, result);
+    }
+
+private:
+    Callback _callback;
+};
+
+template <typename Callback>
+Operation* makeOperation(Callback&& callback) {
+    return new CallbackOperation<std::decay_t<Callback>>(std::forward<Callback>(callback));
+}
+
+/**
+ * Translates the failed result of an operation the same way errorCodeToStatus() translates the
+ * errors of ASIO. A result of 0 means the peer closed the connection.
+ */
+Status statusFromResult(const Operation& op, int result) {
+    const auto err = -result;
+    if (err == ECANCELED) {
+        if (op.timed && !op.cancelled) {
+            return {ErrorCodes::NetworkTimeout, "Socket operation timed out"};
+        }
+        return {ErrorCodes::CallbackCanceled, "Callback was canceled"};
+    } else if (err == 0 || err == ECONNRESET || err == ENETRESET || err == EPIPE) {
+        return {ErrorCodes::HostUnreachable, "Connection was closed"};
+    }
+    return {ErrorCodes::SocketException, errnoWithDescription(err)};
+}
+
+/**
+ * The submission and completion rings of an io_uring instance, set up and entered through the
+ * system calls directly. Entries must be prepared and submitted by one thread at a time, and so
+ * must completions be reaped; the UringReactor serializes both.
+ */
+class Ring {
+    MONGO_DISALLOW_COPYING(Ring);
+
+public:
+    // One mapping for both rings, no completions dropped when the completion ring is full, and
+    // waiting for completions with a timeout.
+    static constexpr uint32_t kRequiredFeatures =
+        IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+
+    static StatusWith<std::unique_ptr<Ring>> make(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        const int fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0) {
+            return Status(ErrorCodes::InvalidOptions,
+                          str::stream() << "Failed to set up io_uring: " << errnoWithDescription());
+        }
+
+        std::unique_ptr<Ring> ring(new Ring(fd));
+        if ((params.features & kRequiredFeatures) != kRequiredFeatures) {
+            return Status(ErrorCodes::InvalidOptions,
+                          str::stream() << "The io_uring of this kernel lacks required features, "
+                                        << "it supports "
+                                        << integerToHex(params.features));
+        }
+
+        ring->_ringsSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        ring->_rings = ::mmap(nullptr,
+                              ring->_ringsSize,
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE,
+                              fd,
+                              IORING_OFF_SQ_RING);
+        if (ring->_rings == MAP_FAILED) {
+            ring->_rings = nullptr;
+            return Status(ErrorCodes::InvalidOptions,
+                          str::stream() << "Failed to map the io_uring rings: "
+                                        << errnoWithDescription());
+        }
+
+        ring->_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        auto sqes = ::mmap(nullptr,
+                           ring->_sqesSize,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE,
+                           fd,
+                           IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return Status(ErrorCodes::InvalidOptions,
+                          str::stream() << "Failed to map the io_uring submission entries: "
+                                        << errnoWithDescription());
+        }
+        ring->_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        auto base = static_cast<char*>(ring->_rings);
+        ring->_sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+        ring->_sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+        ring->_sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+        ring->_sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+        ring->_sqEntries = params.sq_entries;
+        ring->_cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+        ring->_cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+        ring->_cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+        ring->_cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+        ring->_sqeTail = ring->_submittedTail = *ring->_sqTail;
+        return std::move(ring);
+    }
+
+    ~Ring() {
+        if (_sqes) {
+            ::munmap(_sqes, _sqesSize);
+        }
+        if (_rings) {
+            ::munmap(_rings, _ringsSize);
+        }
+        ::close(_fd);
+    }
+
+    /**
+     * Returns how many entries can be prepared before the ring has to be submitted.
+     */
+    size_t freeEntries() const {
+        return _sqEntries - (_sqeTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE));
+    }
+
+    /**
+     * Returns the next entry, cleared. The caller must have checked that there is a free one.
+     */
+    io_uring_sqe* nextEntry() {
+        const unsigned index = _sqeTail++ & _sqMask;
+        _sqArray[index] = index;
+        auto sqe = &_sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    /**
+     * Hands the prepared entries to the kernel. Returns how many were submitted, or a negative
+     * errno.
+     */
+    int submit() {
+        const unsigned pending = _sqeTail - _submittedTail;
+        if (pending == 0) {
+            return 0;
+        }
+
+        __atomic_store_n(_sqTail, _sqeTail, __ATOMIC_RELEASE);
+        const int ret = _enter(pending, 0, 0, nullptr, 0);
+        if (ret > 0) {
+            _submittedTail += ret;
+        }
+        return ret;
+    }
+
+    /**
+     * Waits up to 'timeout' for a completion. Returns a negative errno, which is -ETIME if none
+     * arrived in time.
+     */
+    int wait(Milliseconds timeout) {
+        const auto ts = toTimespec(timeout);
+        io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = reinterpret_cast<uintptr_t>(&ts);
+        return _enter(0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+
+    /**
+     * Calls 'callback' with the user_data and the result of each completion in the ring.
+     */
+    template <typename Callback>
+    void reap(Callback&& callback) {
+        unsigned head = *_cqHead;
+        const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const auto& cqe = _cqes[head & _cqMask];
+            callback(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Registers 'buffers' so that reads can refer to them by index. Returns a negative errno on
+     * failure.
+     */
+    int registerBuffers(const std::vector<iovec>& buffers) {
+        const int ret = syscall(
+            __NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, buffers.data(), buffers.size());
+        return ret < 0 ? -errno : ret;
+    }
+
+private:
+    explicit Ring(int fd) : _fd(fd) {}
+
+    int _enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+        const int ret =
+            syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags, arg, argSize);
+        return ret < 0 ? -errno : ret;
+    }
+
+    const int _fd;
+
+    void* _rings = nullptr;
+    size_t _ringsSize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned* _sqArray = nullptr;
+    unsigned _sqMask = 0;
+    unsigned _sqEntries = 0;
+
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned _cqMask = 0;
+    io_uring_cqe* _cqes = nullptr;
+
+    // The tail of the prepared entries, and of the ones the kernel has taken.
+    unsigned _sqeTail = 0;
+    unsigned _submittedTail = 0;
+};
+
+}  // namespace
+
+/**
+ * A Reactor running the completions of one ring. The threads running it take turns polling the
+ * ring: the poller submits the entries queued since it last polled, waits for completions, and
+ * runs them once it has let another thread take over polling. Entries queued while the poller
+ * waits are submitted right away, and the others wait for the poller to submit them together.
+ *
+ * The reactor also owns the buffers registered with the ring for receiving messages.
+ */
+class TransportLayerUring::UringReactor final : public Reactor {
+public:
+    UringReactor() = default;
+
+    ~UringReactor() {
+        if (_wakeupFd >= 0) {
+            ::close(_wakeupFd);
+        }
+    }
+
+    /**
+     * Sets up the ring, and registers 'bufferCount' buffers of 'bufferSize' bytes with it. Must be
+     * called before the reactor is run or any operation is queued.
+     */
+    Status start(size_t ringEntries, size_t bufferCount, size_t bufferSize) {
+        auto swRing = Ring::make(ringEntries);
+        if (!swRing.isOK()) {
+            return swRing.getStatus();
+        }
+        _ring = std::move(swRing.getValue());
+
+        _wakeupFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (_wakeupFd < 0) {
+            return Status(ErrorCodes::InvalidOptions,
+                          str::stream() << "Failed to create an eventfd: "
+                                        << errnoWithDescription());
+        }
+        _armWakeup();
+
+        _bufferSize = bufferSize;
+        if (bufferCount > 0) {
+            std::vector<iovec> iovecs;
+            for (size_t i = 0; i < bufferCount; ++i) {
+                _buffers.push_back(SharedBuffer::allocate(bufferSize));
+                iovecs.push_back({_buffers.back().get(), bufferSize});
+            }
+
+            const int ret = _ring->registerBuffers(iovecs);
+            if (ret < 0) {
+                warning() << "Failed to register " << bufferCount
+                          << " receive buffers with io_uring, messages will be received into "
+                             "buffers allocated for them: "
+                          << errnoWithDescription(-ret);
+                _buffers.clear();
+            }
+        }
+
+        return Status::OK();
+    }
+
+    void run() noexcept override {
+        _run(Date_t::max());
+    }
+
+    void runFor(Milliseconds time) noexcept override {
+        _run(now() + time);
+    }
+
+    void stop() override {
+        _stopped.store(true);
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+        }
+        _tasksCondition.notify_all();
+        _wakeup();
+    }
+
+    void drain() override {
+        ThreadIdGuard threadIdGuard(this);
+        _stopped.store(true);
+
+        LOG(2) << "Draining remaining work in reactor.";
+        while (_runOneTask() || _pollIfIdle(Date_t())) {
+        }
+    }
+
+    std::unique_ptr<ReactorTimer> makeTimer() override;
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+    void schedule(ScheduleMode mode, Task task) override {
+        if (mode == kDispatch && onReactorThread()) {
+            task();
+            return;
+        }
+
+        bool wakePoller;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+            _tasks.push_back(std::move(task));
+            wakePoller = _idleThreads == 0;
+        }
+        _tasksCondition.notify_one();
+        if (wakePoller) {
+            _wakeup();
+        }
+    }
+
+    bool onReactorThread() const override {
+        return this == _reactorForThread;
+    }
+
+    /**
+     * Queues the 'count' linked entries which 'prepare' fills in, submitting them right away if a
+     * thread is waiting for completions.
+     */
+    template <typename Prepare>
+    void enqueue(size_t count, Prepare&& prepare) {
+        invariant(count <= kMaxLinkedEntries);
+        stdx::unique_lock<stdx::mutex> lk(_submissionMutex);
+
+        // Linked entries must be submitted together, so there must be room for all of them.
+        while (_ring->freeEntries() < count) {
+            if (_submit(lk) < 0) {
+                // The kernel can't take more entries before completions are reaped.
+                lk.unlock();
+                stdx::this_thread::yield();
+                lk.lock();
+            }
+        }
+
+        io_uring_sqe* sqes[kMaxLinkedEntries];
+        for (size_t i = 0; i < count; ++i) {
+            sqes[i] = _ring->nextEntry();
+        }
+        prepare(sqes);
+
+        if (_pollerWaiting.load()) {
+            _submit(lk);
+        }
+    }
+
+    /**
+     * Returns a registered buffer which no Message refers to anymore along with its index, or a
+     * buffer of the same size which isn't registered and -1 if all of them are in use.
+     */
+    std::pair<SharedBuffer, int> claimBuffer() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_buffersMutex);
+            for (size_t i = 0; i < _buffers.size(); ++i) {
+                const size_t index = _nextBuffer++ % _buffers.size();
+                if (!_buffers[index].isShared()) {
+                    return {_buffers[index], static_cast<int>(index)};
+                }
+            }
+        }
+        return {SharedBuffer::allocatePooled(_bufferSize), -1};
+    }
+
+    size_t bufferSize() const {
+        return _bufferSize;
+    }
+
+private:
+    class Timer;
+
+    class ThreadIdGuard {
+    public:
+        ThreadIdGuard(TransportLayerUring::UringReactor* reactor) {
+            _reactorForThread = reactor;
+        }
+
+        ~ThreadIdGuard() {
+            _reactorForThread = nullptr;
+        }
+    };
+
+    void _run(Date_t deadline) noexcept {
+        ThreadIdGuard threadIdGuard(this);
+        try {
+            while (!_stopped.load()) {
+                if (_runOneTask() || _pollIfIdle(deadline)) {
+                    continue;
+                }
+
+                stdx::unique_lock<stdx::mutex> lk(_tasksMutex);
+                if (!_tasks.empty() || (!_polling && _ring) || _stopped.load()) {
+                    continue;
+                }
+                if (now() >= deadline) {
+                    return;
+                }
+
+                // Another thread is polling the ring, and hands us tasks or the polling.
+                ++_idleThreads;
+                if (deadline == Date_t::max()) {
+                    _tasksCondition.wait(lk);
+                } else {
+                    _tasksCondition.wait_until(lk, deadline.toSystemTimePoint());
+                }
+                --_idleThreads;
+            }
+        } catch (...) {
+            severe() << "Uncaught exception in reactor: " << exceptionToStatus();
+            fassertFailed(51013);
+        }
+    }
+
+    bool _runOneTask() {
+        stdx::unique_lock<stdx::mutex> lk(_tasksMutex);
+        if (_tasks.empty()) {
+            return false;
+        }
+
+        auto task = std::move(_tasks.front());
+        _tasks.pop_front();
+        lk.unlock();
+
+        task();
+        return true;
+    }
+
+    /**
+     * Polls the ring unless another thread is, waiting for completions until 'deadline' if there
+     * are no tasks. Returns whether it polled.
+     */
+    bool _pollIfIdle(Date_t deadline) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+            if (_polling || !_ring) {
+                return false;
+            }
+            _polling = true;
+        }
+
+        {
+            stdx::lock_guard<stdx::mutex> lk(_submissionMutex);
+            _pollerWaiting.store(true);
+            _submit(lk);
+        }
+
+        bool mayWait;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+            mayWait = _tasks.empty();
+        }
+
+        const auto timeout = deadline - now();
+        if (mayWait && !_stopped.load() && timeout > Milliseconds(0)) {
+            const int ret = _ring->wait(timeout);
+            if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+                severe() << "Failed to wait for io_uring completions: "
+                         << errnoWithDescription(-ret);
+                fassertFailed(51012);
+            }
+        }
+        _pollerWaiting.store(false);
+
+        std::vector<std::pair<Operation*, int>> completions;
+        bool rearmWakeup = false;
+        _ring->reap([&](uint64_t userData, int result) {
+            if (userData == kWakeupUserData) {
+                rearmWakeup = true;
+            } else if (userData != kIgnoredUserData) {
+                completions.emplace_back(Operation::fromUserData(userData), result);
+            }
+        });
+
+        if (rearmWakeup) {
+            eventfd_t value;
+            ::eventfd_read(_wakeupFd, &value);
+            _armWakeup();
+        }
+
+        // Let another thread take over polling, and hand it all but the first completion if
+        // there are threads waiting for work.
+        size_t toComplete = completions.size();
+        bool notify;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+            _polling = false;
+            notify = _idleThreads > 0;
+            if (notify && toComplete > 1) {
+                for (size_t i = 1; i < completions.size(); ++i) {
+                    const auto completion = completions[i];
+                    _tasks.push_back([completion] { _complete(completion); });
+                }
+                toComplete = 1;
+            }
+        }
+        if (notify) {
+            _tasksCondition.notify_all();
+        }
+
+        for (size_t i = 0; i < toComplete; ++i) {
+            _complete(completions[i]);
+        }
+        return true;
+    }
+
+    static void _complete(std::pair<Operation*, int> completion) {
+        std::unique_ptr<Operation> op(completion.first);
+        op->complete(completion.second);
+    }
+
+    int _submit(WithLock) {
+        const int ret = _ring->submit();
+        if (ret < 0 && ret != -EBUSY && ret != -EAGAIN && ret != -EINTR) {
+            severe() << "Failed to submit io_uring entries: " << errnoWithDescription(-ret);
+            fassertFailed(51014);
+        }
+        return ret;
+    }
+
+    /**
+     * Polls the eventfd with which other threads interrupt the poller's wait.
+     */
+    void _armWakeup() {
+        enqueue(1, [&](io_uring_sqe** sqes) {
+            sqes[0]->opcode = IORING_OP_POLL_ADD;
+            sqes[0]->fd = _wakeupFd;
+            sqes[0]->poll32_events = POLLIN;
+            sqes[0]->user_data = kWakeupUserData;
+        });
+    }
+
+    void _wakeup() {
+        if (_pollerWaiting.load()) {
+            ::eventfd_write(_wakeupFd, 1);
+        }
+    }
+
+    static thread_local UringReactor* _reactorForThread;
+
+    std::unique_ptr<Ring> _ring;
+    int _wakeupFd = -1;
+
+    // Guards preparing and submitting entries.
+    stdx::mutex _submissionMutex;
+
+    // Set while the poller might be waiting for completions.
+    AtomicWord<bool> _pollerWaiting{false};
+
+    AtomicWord<bool> _stopped{false};
+
+    stdx::mutex _tasksMutex;
+    stdx::condition_variable _tasksCondition;
+    std::deque<Task> _tasks;
+    // Whether a thread is polling the ring, and how many threads wait for tasks.
+    bool _polling = false;
+    size_t _idleThreads = 0;
+
+    stdx::mutex _buffersMutex;
+    std::vector<SharedBuffer> _buffers;
+    size_t _nextBuffer = 0;
+    size_t _bufferSize = 0;
+};
+
+thread_local TransportLayerUring::UringReactor*
+    TransportLayerUring::UringReactor::_reactorForThread = nullptr;
+
+class TransportLayerUring::UringReactor::Timer final : public ReactorTimer {
+public:
+    explicit Timer(UringReactor* reactor)
+        : _reactor(reactor), _state(std::make_shared<State>()) {}
+
+    ~Timer() {
+        cancel();
+    }
+
+    void cancel(const BatonHandle& baton = nullptr) override {
+        boost::optional<Promise<void>> promise;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+            if (!_state->op) {
+                return;
+            }
+
+            const auto target = _state->op->userData();
+            _reactor->enqueue(1, [&](io_uring_sqe** sqes) {
+                sqes[0]->opcode = IORING_OP_TIMEOUT_REMOVE;
+                sqes[0]->addr = target;
+                sqes[0]->user_data = kIgnoredUserData;
+            });
+            _state->op = nullptr;
+            promise.emplace(std::move(*_state->promise));
+            _state->promise.reset();
+        }
+        promise->setError({ErrorCodes::CallbackCanceled, "Timer was canceled"});
+    }
+
+    Future<void> waitFor(Milliseconds timeout, const BatonHandle& baton = nullptr) override {
+        cancel();
+
+        auto pf = makePromiseFuture<void>();
+        auto op = makeOperation([state = _state](Operation * op, int result) {
+            boost::optional<Promise<void>> promise;
+            {
+                stdx::lock_guard<stdx::mutex> lk(state->mutex);
+                if (state->op != op) {
+                    // The timer was cancelled or rearmed.
+                    return;
+                }
+                state->op = nullptr;
+                promise.emplace(std::move(*state->promise));
+                state->promise.reset();
+            }
+
+            if (result == -ETIME) {
+                promise->emplaceValue();
+            } else {
+                promise->setError(statusFromResult(*op, result));
+            }
+        });
+
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        _state->op = op;
+        _state->promise.emplace(std::move(pf.promise));
+        op->timeout = toTimespec(std::max(timeout, Milliseconds(0)));
+        _reactor->enqueue(1, [&](io_uring_sqe** sqes) {
+            sqes[0]->opcode = IORING_OP_TIMEOUT;
+            sqes[0]->addr = reinterpret_cast<uintptr_t>(&op->timeout);
+            sqes[0]->len = 1;
+            sqes[0]->user_data = op->userData();
+        });
+        return std::move(pf.future);
+    }
+
+    Future<void> waitUntil(Date_t expiration, const BatonHandle& baton = nullptr) override {
+        return waitFor(expiration - _reactor->now(), baton);
+    }
+
+private:
+    // Shared with the operation of the armed timeout, which may complete after the timer is gone.
+    struct State {
+        stdx::mutex mutex;
+        Operation* op = nullptr;
+        boost::optional<Promise<void>> promise;
+    };
+
+    UringReactor* const _reactor;
+    const std::shared_ptr<State> _state;
+};
+
+std::unique_ptr<ReactorTimer> TransportLayerUring::UringReactor::makeTimer() {
+    return std::make_unique<Timer>(this);
+}
+
+/**
+ * A session whose receives and sends are operations on the ring of the transport layer's reactor.
+ * The synchronous calls wait for the asynchronous ones, and the timeout of the session is linked
+ * to each of its operations.
+ */
+class TransportLayerUring::UringSession final : public Session {
+    MONGO_DISALLOW_COPYING(UringSession);
+
+public:
+    UringSession(TransportLayerUring* tl, int fd) : _tl(tl), _reactor(tl->_reactor), _fd(fd) {
+        sockaddr_storage localAddr, remoteAddr;
+        socklen_t localLen = sizeof(localAddr), remoteLen = sizeof(remoteAddr);
+        if (::getsockname(_fd, reinterpret_cast<sockaddr*>(&localAddr), &localLen) != 0 ||
+            ::getpeername(_fd, reinterpret_cast<sockaddr*>(&remoteAddr), &remoteLen) != 0) {
+            const auto ewd = errnoWithDescription();
+            ::close(_fd);
+            uasserted(ErrorCodes::SocketException,
+                      str::stream() << "Failed to configure socket: " << ewd);
+        }
+
+        SockAddr local(localAddr, localLen);
+        if (local.getType() == AF_INET || local.getType() == AF_INET6) {
+            const int on = 1;
+            ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            ::setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+            setSocketKeepAliveParams(_fd);
+        }
+
+        _local = HostAndPort(local);
+        _remote = HostAndPort(SockAddr(remoteAddr, remoteLen));
+    }
+
+    ~UringSession() {
+        ::close(_fd);
+    }
+
+    TransportLayer* getTransportLayer() const override {
+        return _tl;
+    }
+
+    const HostAndPort& remote() const override {
+        return _remote;
+    }
+
+    const HostAndPort& local() const override {
+        return _local;
+    }
+
+    void end() override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_ended) {
+            return;
+        }
+        _ended = true;
+
+        // This completes the operations in progress.
+        if (::shutdown(_fd, SHUT_RDWR) != 0 && errno != ENOTCONN) {
+            error() << "Error shutting down socket: " << errnoWithDescription();
+        }
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        return asyncSourceMessage().getNoThrow();
+    }
+
+    Future<Message> asyncSourceMessage(const transport::BatonHandle& baton = nullptr) override {
+        auto pf = makePromiseFuture<Message>();
+        _readPromise.emplace(std::move(pf.promise));
+        if (_readBuffer) {
+            _continueRead();
+        } else {
+            _waitForMessage();
+        }
+        return std::move(pf.future);
+    }
+
+    Status sinkMessage(Message message) override {
+        return asyncSinkMessage(std::move(message)).getNoThrow();
+    }
+
+    Future<void> asyncSinkMessage(Message message,
+                                  const transport::BatonHandle& baton = nullptr) override {
+        auto pf = makePromiseFuture<void>();
+        _writePromise.emplace(std::move(pf.promise));
+        _writeMessage = std::move(message);
+        _sent = 0;
+
+        _continueWrite();
+        return std::move(pf.future);
+    }
+
+    void cancelAsyncOperations(const transport::BatonHandle& baton = nullptr) override {
+        LOG(3) << "Cancelling outstanding I/O operations on connection to " << _remote;
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        for (auto op : {_readOp, _writeOp}) {
+            if (!op) {
+                continue;
+            }
+
+            op->cancelled = true;
+            _reactor->enqueue(1, [&](io_uring_sqe** sqes) {
+                sqes[0]->opcode = IORING_OP_ASYNC_CANCEL;
+                sqes[0]->addr = op->userData();
+                sqes[0]->user_data = kIgnoredUserData;
+            });
+        }
+    }
+
+    void setTimeout(boost::optional<Milliseconds> timeout) override {
+        invariant(!timeout || timeout->count() > 0);
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _timeout = timeout;
+    }
+
+    bool isConnected() override {
+        pollfd pfd;
+        pfd.fd = _fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int ret = ::poll(&pfd, 1, 0);
+        if (ret < 0) {
+            warning() << "Failed to poll socket for connectivity check: "
+                      << errnoWithDescription();
+            return false;
+        } else if (ret == 0) {
+            return true;
+        }
+
+        if (pfd.revents & POLLIN) {
+            char testByte;
+            const int size = ::recv(_fd, &testByte, sizeof(testByte), MSG_PEEK | MSG_DONTWAIT);
+            if (size == sizeof(testByte)) {
+                return true;
+            } else if (size == -1) {
+                auto errDesc = errnoWithDescription(errno);
+                warning() << "Failed to check socket connectivity: " << errDesc;
+            }
+            // If size == 0 then we got disconnected and we should return false.
+        }
+
+        return false;
+    }
+
+private:
+    /**
+     * Waits for the start of a message before claiming a buffer to receive it into, so that idle
+     * sessions don't hold on to registered buffers.
+     */
+    void _waitForMessage() {
+        auto op = makeOperation([ this, self = shared_from_this() ](Operation * op, int result) {
+            auto status = _finishOperation(&_readOp, *op, result);
+            if (!status.isOK()) {
+                _failRead(std::move(status));
+                return;
+            }
+
+            std::tie(_readBuffer, _readBufferIndex) = _reactor->claimBuffer();
+            _received = 0;
+            _continueRead();
+        });
+
+        _submit(&_readOp, op, [&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = _fd;
+            sqe->poll32_events = POLLIN;
+        });
+    }
+
+    /**
+     * Receives until _readBuffer holds a whole message. A message too large for the buffer it
+     * started in is moved to a buffer of its own.
+     */
+    void _continueRead() {
+        if (_received >= kHeaderSize) {
+            const auto msgLen =
+                size_t(MSGHEADER::ConstView(_readBuffer.get()).getMessageLength());
+            if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+                StringBuilder sb;
+                sb << "recv(): message msgLen " << msgLen << " is invalid. "
+                   << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+                const auto str = sb.str();
+                LOG(0) << str;
+
+                _failRead(Status(ErrorCodes::ProtocolError, str));
+                return;
+            }
+
+            if (msgLen > _readBuffer.capacity()) {
+                auto buffer = SharedBuffer::allocatePooled(msgLen);
+                memcpy(buffer.get(), _readBuffer.get(), _received);
+                _readBuffer = std::move(buffer);
+                _readBufferIndex = -1;
+            }
+
+            if (_received >= msgLen) {
+                _finishRead(msgLen);
+                return;
+            }
+        }
+
+        auto op = makeOperation([ this, self = shared_from_this() ](Operation * op, int result) {
+            auto status = _finishOperation(&_readOp, *op, result);
+            if (!status.isOK()) {
+                _failRead(std::move(status));
+                return;
+            }
+
+            _received += result;
+            _continueRead();
+        });
+
+        const auto data = _readBuffer.get() + _received;
+        const auto len = _readBuffer.capacity() - _received;
+        _submit(&_readOp, op, [&](io_uring_sqe* sqe) {
+            sqe->fd = _fd;
+            sqe->addr = reinterpret_cast<uintptr_t>(data);
+            sqe->len = len;
+            if (_readBufferIndex >= 0) {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->buf_index = _readBufferIndex;
+            } else {
+                sqe->opcode = IORING_OP_RECV;
+            }
+        });
+    }
+
+    void _finishRead(size_t msgLen) {
+        // Whatever was received past the message is the start of the next one, which the peer
+        // only sends before our reply when it doesn't wait for replies. That is rare enough for
+        // copying it not to matter.
+        SharedBuffer leftover;
+        const size_t excess = _received - msgLen;
+        if (excess > 0) {
+            leftover = SharedBuffer::allocatePooled(std::max(excess, _reactor->bufferSize()));
+            memcpy(leftover.get(), _readBuffer.get() + msgLen, excess);
+        }
+
+        Message message(std::move(_readBuffer));
+        _readBuffer = std::move(leftover);
+        _readBufferIndex = -1;
+        _received = excess;
+
+        networkCounter.hitPhysicalIn(msgLen);
+        _takePromise(&_readPromise).emplaceValue(std::move(message));
+    }
+
+    void _failRead(Status status) {
+        _readBuffer = {};
+        _readBufferIndex = -1;
+        _received = 0;
+        _takePromise(&_readPromise).setError(std::move(status));
+    }
+
+    void _continueWrite() {
+        auto op = makeOperation([ this, self = shared_from_this() ](Operation * op, int result) {
+            auto status = _finishOperation(&_writeOp, *op, result);
+            if (!status.isOK()) {
+                _writeMessage.reset();
+                _takePromise(&_writePromise).setError(std::move(status));
+                return;
+            }
+
+            _sent += result;
+            if (_sent < size_t(_writeMessage.size())) {
+                _continueWrite();
+                return;
+            }
+
+            networkCounter.hitPhysicalOut(_writeMessage.size());
+            _writeMessage.reset();
+            _takePromise(&_writePromise).emplaceValue();
+        });
+
+        const auto data = _writeMessage.buf() + _sent;
+        const auto len = _writeMessage.size() - _sent;
+        _submit(&_writeOp, op, [&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = _fd;
+            sqe->addr = reinterpret_cast<uintptr_t>(data);
+            sqe->len = len;
+            sqe->msg_flags = MSG_NOSIGNAL;
+        });
+    }
+
+    /**
+     * Queues 'op' as the operation in progress in 'slot', linking the session's timeout to it.
+     */
+    template <typename Prepare>
+    void _submit(Operation** slot, Operation* op, Prepare&& prepare) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        *slot = op;
+        _reactor->enqueue(_timeout ? 2 : 1, [&](io_uring_sqe** sqes) {
+            prepare(sqes[0]);
+            sqes[0]->user_data = op->userData();
+            if (!_timeout) {
+                return;
+            }
+
+            op->timed = true;
+            op->timeout = toTimespec(*_timeout);
+            sqes[0]->flags |= IOSQE_IO_LINK;
+            sqes[1]->opcode = IORING_OP_LINK_TIMEOUT;
+            sqes[1]->addr = reinterpret_cast<uintptr_t>(&op->timeout);
+            sqes[1]->len = 1;
+            sqes[1]->user_data = kIgnoredUserData;
+        });
+    }
+
+    /**
+     * Clears the operation in progress in 'slot' and translates its result.
+     */
+    Status _finishOperation(Operation** slot, const Operation& op, int result) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        *slot = nullptr;
+        return result > 0 ? Status::OK() : statusFromResult(op, result);
+    }
+
+    template <typename T>
+    static Promise<T> _takePromise(boost::optional<Promise<T>>* promise) {
+        auto taken = std::move(**promise);
+        promise->reset();
+        return taken;
+    }
+
+    TransportLayerUring* const _tl;
+    const std::shared_ptr<UringReactor> _reactor;
+    const int _fd;
+
+    HostAndPort _local;
+    HostAndPort _remote;
+
+    // Guards the fields below, up to the state of the read and the write in progress, which only
+    // their own completions touch.
+    stdx::mutex _mutex;
+    bool _ended = false;
+    boost::optional<Milliseconds> _timeout;
+    Operation* _readOp = nullptr;
+    Operation* _writeOp = nullptr;
+
+    // The buffer being received into, which is a registered buffer if _readBufferIndex isn't -1.
+    // It may hold the start of the next message between reads.
+    boost::optional<Promise<Message>> _readPromise;
+    SharedBuffer _readBuffer;
+    int _readBufferIndex = -1;
+    size_t _received = 0;
+
+    boost::optional<Promise<void>> _writePromise;
+    Message _writeMessage;
+    size_t _sent = 0;
+};
+
+TransportLayerUring::Options::Options(const ServerGlobalParams* params)
+    : port(params->port),
+      ipList(params->bind_ips),
+      useUnixSockets(!params->noUnixSocket),
+      enableIPv6(params->enableIPv6),
+      ringEntries(uringRingEntries),
+      registeredBuffers(uringRegisteredBuffers),
+      registeredBufferSize(uringRegisteredBufferSizeKB * 1024) {}
+
+bool TransportLayerUring::isSupported() {
+    return Ring::make(kNewReactorRingEntries).isOK();
+}
+
+TransportLayerUring::TransportLayerUring(const TransportLayerUring::Options& opts,
+                                         ServiceEntryPoint* sep)
+    : _reactor(std::make_shared<UringReactor>()), _sep(sep), _listenerOptions(opts) {}
+
+TransportLayerUring::~TransportLayerUring() {
+    // The sessions of the synchronous mode wait for completions the listener thread reaps, so it
+    // keeps running until the transport layer is destroyed rather than stopping in shutdown().
+    if (_listenerThread.joinable()) {
+        _reactor->stop();
+        _listenerThread.join();
+    }
+
+    for (auto& listener : _listeners) {
+        ::close(listener->fd);
+    }
+}
+
+StatusWith<SessionHandle> TransportLayerUring::connect(HostAndPort peer,
+                                                       ConnectSSLMode sslMode,
+                                                       Milliseconds timeout) {
+    return {ErrorCodes::IllegalOperation,
+            "The io_uring transport layer does not support egress connections"};
+}
+
+Future<SessionHandle> TransportLayerUring::asyncConnect(HostAndPort peer,
+                                                        ConnectSSLMode sslMode,
+                                                        const ReactorHandle& reactor,
+                                                        Milliseconds timeout) {
+    return Status{ErrorCodes::IllegalOperation,
+                  "The io_uring transport layer does not support egress connections"};
+}
+
+Status TransportLayerUring::setup() {
+#ifdef MONGO_CONFIG_SSL
+    if (getSSLGlobalParams().sslMode.load() != SSLParams::SSLMode_disabled) {
+        return {ErrorCodes::InvalidOptions, "The io_uring transport layer does not support SSL"};
+    }
+#endif
+
+    auto status = _reactor->start(_listenerOptions.ringEntries,
+                                  _listenerOptions.registeredBuffers,
+                                  _listenerOptions.registeredBufferSize);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    std::vector<std::string> listenAddrs;
+    if (_listenerOptions.ipList.empty()) {
+        listenAddrs = {"127.0.0.1"};
+        if (_listenerOptions.enableIPv6) {
+            listenAddrs.emplace_back("::1");
+        }
+    } else {
+        listenAddrs = _listenerOptions.ipList;
+    }
+
+    if (_listenerOptions.useUnixSockets) {
+        listenAddrs.emplace_back(makeUnixSockPath(_listenerOptions.port));
+    }
+
+    _listenerPort = _listenerOptions.port;
+    for (auto& ip : listenAddrs) {
+        if (ip.empty()) {
+            warning() << "Skipping empty bind address";
+            continue;
+        }
+
+        auto addrs = SockAddr::createAll(
+            ip, _listenerPort, _listenerOptions.enableIPv6 ? AF_UNSPEC : AF_INET);
+        if (addrs.empty()) {
+            warning() << "Found no addresses for " << ip;
+            continue;
+        }
+
+        for (auto& addr : addrs) {
+            if (addr.getType() == AF_UNIX) {
+                if (::unlink(addr.getAddr().c_str()) == -1 && errno != ENOENT) {
+                    return {ErrorCodes::SocketException,
+                            str::stream() << "Failed to unlink socket file " << addr.getAddr()
+                                          << " "
+                                          << errnoWithDescription()};
+                }
+            }
+            if (addr.getType() == AF_INET6 && !_listenerOptions.enableIPv6) {
+                return {ErrorCodes::BadValue, "Specified ipv6 bind address, but ipv6 is disabled"};
+            }
+
+            const int fd = ::socket(addr.getType(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to create a socket for " << addr.toString()
+                                      << ": "
+                                      << errnoWithDescription()};
+            }
+            _listeners.emplace_back(new Listener{addr, fd});
+
+            const int on = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (addr.getType() == AF_INET6) {
+                ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+            }
+
+            if (::bind(fd, addr.raw(), addr.addressSize) != 0) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to bind to " << addr.toString() << ": "
+                                      << errnoWithDescription()};
+            }
+
+            if (addr.getType() == AF_UNIX) {
+                if (::chmod(addr.getAddr().c_str(), serverGlobalParams.unixSocketPermissions) ==
+                    -1) {
+                    return {ErrorCodes::SocketException,
+                            str::stream() << "Failed to chmod socket file " << addr.getAddr()
+                                          << " "
+                                          << errnoWithDescription()};
+                }
+            }
+
+            if (_listenerOptions.port == 0 &&
+                (addr.getType() == AF_INET || addr.getType() == AF_INET6)) {
+                if (_listenerPort != _listenerOptions.port) {
+                    return Status(ErrorCodes::BadValue,
+                                  "Port 0 (ephemeral port) is not allowed when"
+                                  " listening on multiple IP interfaces");
+                }
+
+                sockaddr_storage bound;
+                socklen_t boundLen = sizeof(bound);
+                if (::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &boundLen) != 0) {
+                    return {ErrorCodes::SocketException, errnoWithDescription()};
+                }
+                _listenerPort = SockAddr(bound, boundLen).getPort();
+            }
+        }
+    }
+
+    if (_listeners.empty()) {
+        return Status(ErrorCodes::SocketException, "No available addresses/ports to bind to");
+    }
+
+    return Status::OK();
+}
+
+Status TransportLayerUring::start() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _running.store(true);
+
+    for (auto& listener : _listeners) {
+        if (::listen(listener->fd, serverGlobalParams.listenBacklog) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to listen on " << listener->addr.toString() << ": "
+                                  << errnoWithDescription()};
+        }
+        _acceptConnection(listener.get());
+    }
+
+    if (_listenerOptions.transportMode == Mode::kSynchronous) {
+        _listenerThread = stdx::thread([this] {
+            setThreadName("listener");
+            _reactor->run();
+        });
+    }
+
+    log() << "waiting for connections on port " << _listenerPort << " using io_uring";
+    return Status::OK();
+}
+
+void TransportLayerUring::shutdown() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _running.store(false);
+
+    // Shutting the listening sockets down completes the accepts in progress, which aren't
+    // requeued since we aren't running anymore.
+    for (auto& listener : _listeners) {
+        ::shutdown(listener->fd, SHUT_RDWR);
+        auto& addr = listener->addr;
+        if (addr.getType() == AF_UNIX && !addr.isAnonymousUNIXSocket()) {
+            auto path = addr.getAddr();
+            log() << "removing socket file: " << path;
+            if (::unlink(path.c_str()) != 0) {
+                const auto ewd = errnoWithDescription();
+                warning() << "Unable to remove UNIX socket " << path << ": " << ewd;
+            }
+        }
+    }
+}
+
+ReactorHandle TransportLayerUring::getReactor(WhichReactor which) {
+    switch (which) {
+        case TransportLayer::kIngress:
+        case TransportLayer::kEgress:
+            return _reactor;
+        case TransportLayer::kNewReactor: {
+            auto reactor = std::make_shared<UringReactor>();
+            uassertStatusOK(reactor->start(kNewReactorRingEntries, 0, 0));
+            return reactor;
+        }
+    }
+
+    MONGO_UNREACHABLE;
+}
+
+void TransportLayerUring::_acceptConnection(Listener* listener) {
+    auto op = makeOperation([this, listener](Operation*, int result) {
+        if (!_running.load()) {
+            if (result >= 0) {
+                ::close(result);
+            }
+            return;
+        }
+
+        if (result < 0) {
+            log() << "Error accepting new connection on " << listener->addr.toString() << ": "
+                  << errnoWithDescription(-result);
+        } else {
+            try {
+                _sep->startSession(std::make_shared<UringSession>(this, result));
+            } catch (const DBException& e) {
+                warning() << "Error accepting new connection " << e;
+            }
+        }
+
+        _acceptConnection(listener);
+    });
+
+    _reactor->enqueue(1, [&](io_uring_sqe** sqes) {
+        sqes[0]->opcode = IORING_OP_ACCEPT;
+        sqes[0]->fd = listener->fd;
+        sqes[0]->accept_flags = SOCK_CLOEXEC;
+        sqes[0]->user_data = op->userData();
+    });
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,143 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/db/server_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/transport/transport_mode.h"
+#include "mongo/util/net/sockaddr.h"
+
+namespace mongo {
+
+class ServiceEntryPoint;
+
+namespace transport {
+
+/**
+ * An experimental ingress-only TransportLayer for Linux based on io_uring. The accepts, receives
+ * and sends of all sessions are queued on one submission ring, so that the operations started
+ * while the completions of a batch are being handled reach the kernel in a single system call.
+ *
+ * Messages are received into buffers registered with the ring and become the buffers of the
+ * Messages handed to the ServiceStateMachine without being copied. A registered buffer is reused
+ * once the Message received into it is destroyed. A session only claims one once data arrives,
+ * so idle sessions don't exhaust them.
+ *
+ * Connecting to other hosts and SSL are not supported, so the TransportLayerManager puts this
+ * transport layer behind an egress-only TransportLayerASIO.
+ */
+class TransportLayerUring final : public TransportLayer {
+    MONGO_DISALLOW_COPYING(TransportLayerUring);
+
+public:
+    struct Options {
+        explicit Options(const ServerGlobalParams* params);
+        Options() = default;
+
+        int port = ServerGlobalParams::DefaultDBPort;  // port to bind to
+        std::vector<std::string> ipList;               // addresses to bind to
+        bool useUnixSockets = true;                    // whether to allow UNIX sockets in ipList
+        bool enableIPv6 = false;                       // whether to allow IPv6 sockets in ipList
+        Mode transportMode = Mode::kSynchronous;       // whether the sessions are run by a
+                                                       // ServiceExecutor running our reactor
+        size_t ringEntries = 4096;                     // size of the submission ring
+        size_t registeredBuffers = 256;                // number of registered receive buffers
+        size_t registeredBufferSize = 16 * 1024;       // size of each registered receive buffer
+    };
+
+    /**
+     * Returns whether the running kernel provides the io_uring features this transport layer
+     * relies on. io_uring may also be unavailable because of a seccomp policy.
+     */
+    static bool isSupported();
+
+    TransportLayerUring(const Options& opts, ServiceEntryPoint* sep);
+
+    ~TransportLayerUring();
+
+    StatusWith<SessionHandle> connect(HostAndPort peer,
+                                      ConnectSSLMode sslMode,
+                                      Milliseconds timeout) final;
+
+    Future<SessionHandle> asyncConnect(HostAndPort peer,
+                                       ConnectSSLMode sslMode,
+                                       const ReactorHandle& reactor,
+                                       Milliseconds timeout) final;
+
+    Status setup() final;
+
+    ReactorHandle getReactor(WhichReactor which) final;
+
+    Status start() final;
+
+    void shutdown() final;
+
+    int listenerPort() const {
+        return _listenerPort;
+    }
+
+private:
+    class UringReactor;
+    class UringSession;
+
+    struct Listener {
+        SockAddr addr;
+        int fd;
+    };
+
+    void _acceptConnection(Listener* listener);
+
+    stdx::mutex _mutex;
+
+    // The reactor owns the ring, which all the listening sockets and sessions use. In synchronous
+    // mode it is run by _listenerThread, and otherwise by the ServiceExecutorAdaptive.
+    std::shared_ptr<UringReactor> _reactor;
+
+    std::vector<std::unique_ptr<Listener>> _listeners;
+
+    // Only used in synchronous mode.
+    stdx::thread _listenerThread;
+
+    ServiceEntryPoint* const _sep = nullptr;
+    AtomicWord<bool> _running{false};
+    Options _listenerOptions;
+    // The real incoming port in case of _listenerOptions.port==0 (ephemeral).
+    int _listenerPort = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,442 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_uring.h"
+
+#include <set>
+
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/sock.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+using transport::TransportLayerUring;
+
+/**
+ * Echoes each message a session receives until the session fails, in one thread per session in
+ * synchronous mode and as a chain of continuations on the reactor in asynchronous mode. Records
+ * the buffers the messages were received into.
+ */
+class EchoSEP : public ServiceEntryPoint {
+public:
+    explicit EchoSEP(transport::Mode mode, bool keepMessages = false)
+        : _mode(mode), _keepMessages(keepMessages) {}
+
+    void startSession(transport::SessionHandle session) override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        ++_sessions;
+        if (_mode == transport::Mode::kAsynchronous) {
+            _echoAsync(std::move(session));
+            return;
+        }
+
+        _threads.emplace_back([ this, session = std::move(session) ] {
+            while (true) {
+                auto swMessage = session->sourceMessage();
+                if (!swMessage.isOK()) {
+                    break;
+                }
+                _record(swMessage.getValue());
+                if (!session->sinkMessage(swMessage.getValue()).isOK()) {
+                    break;
+                }
+            }
+            _endSession();
+        });
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {}
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    Stats sessionStats() const override {
+        return {};
+    }
+
+    size_t numOpenSessions() const override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _sessions;
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+    /**
+     * Waits for all the sessions to end, once their peers have closed them.
+     */
+    void waitForSessionsToEnd() {
+        std::vector<stdx::thread> threads;
+        {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            _cv.wait(lk, [&] { return _sessions == 0; });
+            threads.swap(_threads);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::set<const char*> receivedIntoBuffers() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _buffers;
+    }
+
+private:
+    void _echoAsync(transport::SessionHandle session) {
+        session->asyncSourceMessage()
+            .then([this, session](Message message) {
+                _record(message);
+                return session->asyncSinkMessage(message);
+            })
+            .getAsync([this, session](Status status) {
+                if (status.isOK()) {
+                    _echoAsync(session);
+                } else {
+                    _endSession();
+                }
+            });
+    }
+
+    void _record(const Message& message) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _buffers.insert(message.buf());
+        if (_keepMessages) {
+            _kept.push_back(message);
+        }
+    }
+
+    void _endSession() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        --_sessions;
+        _cv.notify_all();
+    }
+
+    const transport::Mode _mode;
+    const bool _keepMessages;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    size_t _sessions = 0;
+    std::vector<stdx::thread> _threads;
+    std::set<const char*> _buffers;
+    std::vector<Message> _kept;
+};
+
+Message makeMessage(size_t padding) {
+    OpMsgBuilder builder;
+    builder.setBody(BSON("ping" << 1 << "padding" << std::string(padding, 'x')));
+    Message message = builder.finish();
+    message.header().setResponseToMsgId(0);
+    message.header().setId(0);
+    return message;
+}
+
+class Connection {
+public:
+    explicit Connection(int port) {
+        SockAddr sa{"localhost", port, AF_INET};
+        ASSERT_TRUE(_socket.connect(sa));
+    }
+
+    /**
+     * Sends 'messages' with a single send, so that the server may receive them together.
+     */
+    void send(const std::vector<Message>& messages) {
+        std::string data;
+        for (const auto& message : messages) {
+            data.append(message.buf(), message.size());
+        }
+        _socket.send(data.data(), data.size(), "test");
+    }
+
+    Message receive() {
+        auto buffer = SharedBuffer::allocate(sizeof(MSGHEADER::Value));
+        _socket.recv(buffer.get(), sizeof(MSGHEADER::Value));
+        const auto msgLen = MSGHEADER::ConstView(buffer.get()).getMessageLength();
+        buffer.realloc(msgLen);
+        _socket.recv(buffer.get() + sizeof(MSGHEADER::Value), msgLen - sizeof(MSGHEADER::Value));
+        return Message(std::move(buffer));
+    }
+
+    void close() {
+        _socket.close();
+    }
+
+private:
+    Socket _socket;
+};
+
+void assertEchoed(const Message& sent, const Message& received) {
+    ASSERT_EQ(sent.size(), received.size());
+    ASSERT_EQ(0, memcmp(sent.buf(), received.buf(), sent.size()));
+}
+
+std::unique_ptr<TransportLayerUring> makeAndStartTL(ServiceEntryPoint* sep,
+                                                    transport::Mode mode,
+                                                    size_t registeredBuffers = 16) {
+    auto options = [&] {
+        ServerGlobalParams params;
+        params.noUnixSocket = true;
+        TransportLayerUring::Options opts(&params);
+        opts.port = 0;
+        opts.transportMode = mode;
+        opts.registeredBuffers = registeredBuffers;
+        opts.registeredBufferSize = 4 * 1024;
+        return opts;
+    }();
+
+    auto tl = std::make_unique<TransportLayerUring>(options, sep);
+    ASSERT_OK(tl->setup());
+    ASSERT_OK(tl->start());
+    ASSERT_GT(tl->listenerPort(), 0);
+    return tl;
+}
+
+// The kernel the tests run on may not support io_uring, or a seccomp policy may forbid it.
+#define SKIP_UNLESS_SUPPORTED()                                             \
+    if (!TransportLayerUring::isSupported()) {                              \
+        log() << "Skipping test since io_uring is unavailable on this host"; \
+        return;                                                             \
+    }
+
+TEST(TransportLayerUring, EchoesMessagesOfAllSizes) {
+    SKIP_UNLESS_SUPPORTED();
+    EchoSEP sep(transport::Mode::kSynchronous);
+    auto tl = makeAndStartTL(&sep, transport::Mode::kSynchronous);
+
+    Connection connection(tl->listenerPort());
+    // Smaller than a registered buffer, close to its size, and several times larger.
+    for (size_t padding : {10, 4000, 100 * 1024}) {
+        auto message = makeMessage(padding);
+        connection.send({message});
+        assertEchoed(message, connection.receive());
+    }
+
+    // Messages received together, one of which spans the end of the first registered buffer.
+    std::vector<Message> messages{makeMessage(10), makeMessage(3000), makeMessage(20)};
+    connection.send(messages);
+    for (const auto& message : messages) {
+        assertEchoed(message, connection.receive());
+    }
+
+    connection.close();
+    sep.waitForSessionsToEnd();
+    tl->shutdown();
+}
+
+TEST(TransportLayerUring, ReusesRegisteredBuffersOnceMessagesAreDestroyed) {
+    SKIP_UNLESS_SUPPORTED();
+    EchoSEP sep(transport::Mode::kSynchronous);
+    auto tl = makeAndStartTL(&sep, transport::Mode::kSynchronous, 2);
+
+    Connection connection(tl->listenerPort());
+    for (int i = 0; i < 10; ++i) {
+        auto message = makeMessage(10);
+        connection.send({message});
+        assertEchoed(message, connection.receive());
+    }
+    ASSERT_EQ(2U, sep.receivedIntoBuffers().size());
+
+    connection.close();
+    sep.waitForSessionsToEnd();
+    tl->shutdown();
+}
+
+TEST(TransportLayerUring, AllocatesBuffersWhileRegisteredOnesAreInUse) {
+    SKIP_UNLESS_SUPPORTED();
+    EchoSEP sep(transport::Mode::kSynchronous, true /* keepMessages */);
+    auto tl = makeAndStartTL(&sep, transport::Mode::kSynchronous, 2);
+
+    Connection connection(tl->listenerPort());
+    for (int i = 0; i < 10; ++i) {
+        auto message = makeMessage(10);
+        connection.send({message});
+        assertEchoed(message, connection.receive());
+    }
+    ASSERT_EQ(10U, sep.receivedIntoBuffers().size());
+
+    connection.close();
+    sep.waitForSessionsToEnd();
+    tl->shutdown();
+}
+
+TEST(TransportLayerUring, IdleSessionsDoNotHoldRegisteredBuffers) {
+    SKIP_UNLESS_SUPPORTED();
+    EchoSEP sep(transport::Mode::kSynchronous);
+    auto tl = makeAndStartTL(&sep, transport::Mode::kSynchronous, 2);
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (int i = 0; i < 4; ++i) {
+        connections.push_back(std::make_unique<Connection>(tl->listenerPort()));
+    }
+    while (sep.numOpenSessions() < connections.size()) {
+        sleepmillis(10);
+    }
+
+    // Each session waits for its message before claiming a buffer, so the two registered buffers
+    // are enough for all of them.
+    for (auto& connection : connections) {
+        auto message = makeMessage(10);
+        connection->send({message});
+        assertEchoed(message, connection->receive());
+    }
+    ASSERT_EQ(2U, sep.receivedIntoBuffers().size());
+
+    for (auto& connection : connections) {
+        connection->close();
+    }
+    sep.waitForSessionsToEnd();
+    tl->shutdown();
+}
+
+TEST(TransportLayerUring, RunsAsyncSessionsOnTheReactor) {
+    SKIP_UNLESS_SUPPORTED();
+    EchoSEP sep(transport::Mode::kAsynchronous);
+    auto tl = makeAndStartTL(&sep, transport::Mode::kAsynchronous);
+
+    auto reactor = tl->getReactor(transport::TransportLayer::kIngress);
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] { reactor->run(); });
+    }
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (int i = 0; i < 8; ++i) {
+        connections.push_back(std::make_unique<Connection>(tl->listenerPort()));
+    }
+    for (int round = 0; round < 10; ++round) {
+        auto message = makeMessage(round * 1000);
+        for (auto& connection : connections) {
+            connection->send({message});
+        }
+        for (auto& connection : connections) {
+            assertEchoed(message, connection->receive());
+        }
+    }
+
+    for (auto& connection : connections) {
+        connection->close();
+    }
+    sep.waitForSessionsToEnd();
+    tl->shutdown();
+
+    reactor->stop();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+class TimeoutSEP : public EchoSEP {
+public:
+    TimeoutSEP() : EchoSEP(transport::Mode::kSynchronous) {}
+
+    void startSession(transport::SessionHandle session) override {
+        stdx::lock_guard<stdx::mutex> lk(_sessionMutex);
+        _session = std::move(session);
+        _sessionCv.notify_all();
+    }
+
+    transport::SessionHandle waitForSession() {
+        stdx::unique_lock<stdx::mutex> lk(_sessionMutex);
+        _sessionCv.wait(lk, [&] { return bool(_session); });
+        return std::move(_session);
+    }
+
+private:
+    stdx::mutex _sessionMutex;
+    stdx::condition_variable _sessionCv;
+    transport::SessionHandle _session;
+};
+
+TEST(TransportLayerUring, SourceMessageTimesOutAndRecovers) {
+    SKIP_UNLESS_SUPPORTED();
+    TimeoutSEP sep;
+    auto tl = makeAndStartTL(&sep, transport::Mode::kSynchronous);
+
+    Connection connection(tl->listenerPort());
+    auto session = sep.waitForSession();
+
+    session->setTimeout(Milliseconds{200});
+    ASSERT_EQ(ErrorCodes::NetworkTimeout, session->sourceMessage().getStatus());
+
+    auto message = makeMessage(10);
+    connection.send({message});
+    auto swReceived = session->sourceMessage();
+    ASSERT_OK(swReceived.getStatus());
+    assertEchoed(message, swReceived.getValue());
+
+    session->setTimeout(boost::none);
+    connection.close();
+    ASSERT_EQ(ErrorCodes::HostUnreachable, session->sourceMessage().getStatus());
+    ASSERT_FALSE(session->isConnected());
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerUring, ReactorTimersFireAndCancel) {
+    SKIP_UNLESS_SUPPORTED();
+    EchoSEP sep(transport::Mode::kAsynchronous);
+    auto tl = makeAndStartTL(&sep, transport::Mode::kAsynchronous);
+
+    auto reactor = tl->getReactor(transport::TransportLayer::kIngress);
+    stdx::thread thread([&] { reactor->run(); });
+
+    auto timer = reactor->makeTimer();
+    const auto start = reactor->now();
+    ASSERT_OK(timer->waitFor(Milliseconds{100}).getNoThrow());
+    ASSERT_GTE(reactor->now() - start, Milliseconds{90});
+
+    auto future = timer->waitFor(Seconds{60});
+    timer->cancel();
+    ASSERT_EQ(ErrorCodes::CallbackCanceled, future.getNoThrow());
+
+    ASSERT_EQ(42, reactor->execute([] { return 42; }).get());
+
+    tl->shutdown();
+    reactor->stop();
+    thread.join();
+}
+
+}  // namespace
+}  // namespace mongo
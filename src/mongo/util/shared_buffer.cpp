@@ -0,0 +1,240 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/shared_buffer.h"
+
+#include <array>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+namespace {
+
+// The size classes are the powers of two from 512 bytes, the initial size of a BufBuilder, to
+// 64KB. Larger buffers are rare enough that malloc serves them as well as a pool would.
+constexpr size_t kMinClassShift = 9;
+constexpr size_t kMaxClassShift = 16;
+constexpr size_t kNumClasses = kMaxClassShift - kMinClassShift + 1;
+
+// Every thread caches up to this many bytes of each size class, but at least one buffer.
+constexpr size_t kThreadCacheBytesPerClass = 16 * 1024;
+
+// The cache shared by all threads holds up to this many bytes of each size class.
+constexpr size_t kSharedCacheBytesPerClass = 4 * 1024 * 1024;
+
+constexpr size_t classSize(size_t sizeClass) {
+    return size_t(1) << (sizeClass + kMinClassShift);
+}
+
+size_t threadCacheLimit(size_t sizeClass) {
+    return std::max<size_t>(1, kThreadCacheBytesPerClass / classSize(sizeClass));
+}
+
+struct ClassStats {
+    AtomicUInt64 hits;
+    AtomicUInt64 misses;
+};
+
+std::array<ClassStats, kNumClasses> classStats;
+AtomicUInt64 oversizedAllocations;
+AtomicUInt64 freedBlocks;
+
+/**
+ * The blocks which don't fit into the cache of the thread releasing them. Blocks are moved between
+ * it and the thread caches in batches, so that its mutex is taken once per batch.
+ */
+class SharedCache {
+public:
+    /**
+     * Moves up to 'count' blocks of 'sizeClass' to 'out'.
+     */
+    void take(size_t sizeClass, std::vector<void*>* out, size_t count) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto& blocks = _blocks[sizeClass];
+        while (count-- > 0 && !blocks.empty()) {
+            out->push_back(blocks.back());
+            blocks.pop_back();
+        }
+    }
+
+    /**
+     * Moves as many of the blocks of 'sizeClass' in 'in' as there is room for, and frees the rest.
+     */
+    void give(size_t sizeClass, std::vector<void*>* in) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            auto& blocks = _blocks[sizeClass];
+            const size_t limit = kSharedCacheBytesPerClass / classSize(sizeClass);
+            while (blocks.size() < limit && !in->empty()) {
+                blocks.push_back(in->back());
+                in->pop_back();
+            }
+        }
+        freedBlocks.fetchAndAdd(in->size());
+        for (auto block : *in) {
+            free(block);
+        }
+        in->clear();
+    }
+
+    size_t bytes() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        size_t bytes = 0;
+        for (size_t sizeClass = 0; sizeClass < kNumClasses; sizeClass++) {
+            bytes += _blocks[sizeClass].size() * classSize(sizeClass);
+        }
+        return bytes;
+    }
+
+private:
+    mutable stdx::mutex _mutex;
+    std::array<std::vector<void*>, kNumClasses> _blocks;
+};
+
+SharedCache& sharedCache() {
+    // Leaked, since buffers may still be released by the destructors of other static objects.
+    static auto cache = new SharedCache();
+    return *cache;
+}
+
+// Set once the cache of the thread has been destroyed, after which buffers released by the thread
+// go straight to the shared cache.
+thread_local bool threadCacheDestroyed = false;
+
+class ThreadCache {
+public:
+    ~ThreadCache() {
+        threadCacheDestroyed = true;
+        for (size_t sizeClass = 0; sizeClass < kNumClasses; sizeClass++) {
+            sharedCache().give(sizeClass, &_blocks[sizeClass]);
+        }
+    }
+
+    void* take(size_t sizeClass) {
+        auto& blocks = _blocks[sizeClass];
+        if (blocks.empty()) {
+            sharedCache().take(sizeClass, &blocks, threadCacheLimit(sizeClass));
+            if (blocks.empty()) {
+                return nullptr;
+            }
+        }
+        auto block = blocks.back();
+        blocks.pop_back();
+        return block;
+    }
+
+    void give(size_t sizeClass, void* block) {
+        auto& blocks = _blocks[sizeClass];
+        if (blocks.size() >= threadCacheLimit(sizeClass)) {
+            sharedCache().give(sizeClass, &blocks);
+        }
+        blocks.push_back(block);
+    }
+
+private:
+    std::array<std::vector<void*>, kNumClasses> _blocks;
+};
+
+thread_local ThreadCache threadCache;
+
+}  // namespace
+
+SharedBuffer SharedBuffer::allocatePooled(size_t bytes) {
+    if (bytes > classSize(kNumClasses - 1)) {
+        oversizedAllocations.fetchAndAdd(1);
+        return allocate(bytes);
+    }
+
+    size_t sizeClass = 0;
+    while (classSize(sizeClass) < bytes) {
+        sizeClass++;
+    }
+
+    void* block = nullptr;
+    if (!threadCacheDestroyed) {
+        block = threadCache.take(sizeClass);
+    } else {
+        std::vector<void*> blocks;
+        sharedCache().take(sizeClass, &blocks, 1);
+        block = blocks.empty() ? nullptr : blocks.front();
+    }
+
+    if (block) {
+        classStats[sizeClass].hits.fetchAndAdd(1);
+    } else {
+        classStats[sizeClass].misses.fetchAndAdd(1);
+        block = mongoMalloc(sizeof(Holder) + classSize(sizeClass));
+    }
+    return takeOwnership(block, classSize(sizeClass), sizeClass);
+}
+
+void SharedBuffer::reallocPooled(size_t size) {
+    if (size <= _holder->_capacity) {
+        return;
+    }
+
+    auto newBuffer = allocatePooled(size);
+    memcpy(newBuffer.get(), get(), _holder->_capacity);
+    swap(newBuffer);
+}
+
+void SharedBuffer::releasePooled(void* holderPrefixedData, uint32_t sizeClass) {
+    if (!threadCacheDestroyed) {
+        threadCache.give(sizeClass, holderPrefixedData);
+    } else {
+        std::vector<void*> blocks{holderPrefixedData};
+        sharedCache().give(sizeClass, &blocks);
+    }
+}
+
+void SharedBuffer::appendPoolStats(BSONObjBuilder* b) {
+    long long hits = 0;
+    long long misses = 0;
+    BSONObjBuilder sizeClassesBuilder;
+    for (size_t sizeClass = 0; sizeClass < kNumClasses; sizeClass++) {
+        const long long classHits = classStats[sizeClass].hits.load();
+        const long long classMisses = classStats[sizeClass].misses.load();
+        sizeClassesBuilder.append(std::to_string(classSize(sizeClass)),
+                                  BSON("hits" << classHits << "misses" << classMisses));
+        hits += classHits;
+        misses += classMisses;
+    }
+
+    b->append("hits", hits);
+    b->append("misses", misses);
+    b->append("oversized", static_cast<long long>(oversizedAllocations.load()));
+    b->append("freed", static_cast<long long>(freedBlocks.load()));
+    b->append("sharedCacheBytes", static_cast<long long>(sharedCache().bytes()));
+    b->append("sizeClasses", sizeClassesBuilder.obj());
+}
+
+}  // namespace mongo
@@ -36,6 +36,8 @@
 
 namespace mongo {
 
+class BSONObjBuilder;
+
 /**
  * A mutable, ref-counted buffer.
  */
@@ -51,6 +53,22 @@ public:
         return takeOwnership(mongoMalloc(sizeof(Holder) + bytes), bytes);
     }
 
+    /**
+     * Allocates a buffer of at least 'bytes' from a pool of power-of-two size classes, for buffers
+     * which are allocated and released at a high rate such as those of wire protocol messages.
+     * The memory of a released pooled buffer is cached by the releasing thread, or in a shared
+     * cache once that is full, rather than returned to malloc. Requests larger than the largest
+     * class are served by allocate().
+     *
+     * capacity() reports the size of the class, and realloc() keeps the buffer pooled.
+     */
+    static SharedBuffer allocatePooled(size_t bytes);
+
+    /**
+     * Appends the hit and miss counts of allocatePooled() and the size of the caches to 'b'.
+     */
+    static void appendPoolStats(BSONObjBuilder* b);
+
     /**
      * Resizes the buffer, copying the current contents.
      *
@@ -62,6 +80,11 @@ public:
     void realloc(size_t size) {
         invariant(!_holder || !_holder->isShared());
 
+        if (_holder && _holder->_sizeClass != Holder::kUnpooled) {
+            reallocPooled(size);
+            return;
+        }
+
         const size_t realSize = size + sizeof(Holder);
         void* newPtr = mongoRealloc(_holder.get(), realSize);
 
@@ -99,8 +122,10 @@ public:
 private:
     class Holder {
     public:
-        explicit Holder(AtomicUInt32::WordType initial, size_t capacity)
-            : _refCount(initial), _capacity(capacity) {
+        static constexpr uint32_t kUnpooled = ~uint32_t(0);
+
+        explicit Holder(AtomicUInt32::WordType initial, size_t capacity, uint32_t sizeClass)
+            : _refCount(initial), _capacity(capacity), _sizeClass(sizeClass) {
             invariant(capacity == _capacity);
         }
 
@@ -111,10 +136,19 @@ private:
 
         friend void intrusive_ptr_release(Holder* h) {
             if (h->_refCount.subtractAndFetch(1) == 0) {
-                // We placement new'ed a Holder in takeOwnership above,
-                // so we must destroy the object here.
-                h->~Holder();
-                free(h);
+                h->destroy();
+            }
+        }
+
+        void destroy() {
+            const auto sizeClass = _sizeClass;
+            // We placement new'ed a Holder in takeOwnership above,
+            // so we must destroy the object here.
+            this->~Holder();
+            if (sizeClass == kUnpooled) {
+                free(this);
+            } else {
+                releasePooled(this, sizeClass);
             }
         }
 
@@ -132,6 +166,10 @@ private:
 
         AtomicUInt32 _refCount;
         uint32_t _capacity;
+        // The size class of a buffer from allocatePooled(), or kUnpooled.
+        uint32_t _sizeClass;
+        // Keeps the data 16 byte aligned.
+        uint32_t _padding = 0;
     };
 
     explicit SharedBuffer(Holder* holder) : _holder(holder, /*add_ref=*/false) {
@@ -146,14 +184,26 @@ private:
      * This class will call free(holderPrefixedData), so it must have been allocated in a way
      * that makes that valid.
      */
-    static SharedBuffer takeOwnership(void* holderPrefixedData, size_t capacity) {
+    static SharedBuffer takeOwnership(void* holderPrefixedData,
+                                      size_t capacity,
+                                      uint32_t sizeClass = Holder::kUnpooled) {
         // Initialize the refcount to 1 so we don't need to increment it in the constructor
         // (see private Holder* constructor above).
         //
         // TODO: Should dassert alignment of holderPrefixedData here if possible.
-        return SharedBuffer(new (holderPrefixedData) Holder(1U, capacity));
+        return SharedBuffer(new (holderPrefixedData) Holder(1U, capacity, sizeClass));
     }
 
+    /**
+     * Moves the contents of a pooled buffer to one of a large enough size class.
+     */
+    void reallocPooled(size_t size);
+
+    /**
+     * Returns the memory of a destroyed pooled Holder to the pool.
+     */
+    static void releasePooled(void* holderPrefixedData, uint32_t sizeClass);
+
     boost::intrusive_ptr<Holder> _holder;
 };
 
@@ -187,6 +237,10 @@ public:
         return _buffer.isShared();
     }
 
+    size_t capacity() const {
+        return _buffer.capacity();
+    }
+
     /**
      * Converts to a mutable SharedBuffer.
      * This is only legal to call if you have exclusive access to the underlying buffer.
@@ -0,0 +1,83 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+namespace {
+
+void BM_allocate(benchmark::State& state) {
+    for (auto _ : state) {
+        auto buffer = SharedBuffer::allocate(state.range(0));
+        benchmark::DoNotOptimize(buffer.get());
+    }
+}
+
+void BM_allocatePooled(benchmark::State& state) {
+    for (auto _ : state) {
+        auto buffer = SharedBuffer::allocatePooled(state.range(0));
+        benchmark::DoNotOptimize(buffer.get());
+    }
+}
+
+// Builds a reply of the given size the way OpMsgBuilder does, growing from 512 bytes.
+void BM_buildReply(benchmark::State& state) {
+    const std::string chunk(100, 'x');
+    for (auto _ : state) {
+        BufBuilder builder;
+        for (int64_t i = 0; i < state.range(0); i += chunk.size()) {
+            builder.appendStr(chunk, false);
+        }
+        benchmark::DoNotOptimize(builder.release().get());
+    }
+}
+
+void BM_buildReplyPooled(benchmark::State& state) {
+    const std::string chunk(100, 'x');
+    for (auto _ : state) {
+        BufBuilder builder(0);
+        builder.useSharedBuffer(SharedBuffer::allocatePooled(512));
+        for (int64_t i = 0; i < state.range(0); i += chunk.size()) {
+            builder.appendStr(chunk, false);
+        }
+        benchmark::DoNotOptimize(builder.release().get());
+    }
+}
+
+BENCHMARK(BM_allocate)->Arg(100)->Arg(4 * 1024)->Arg(48 * 1024)->ThreadRange(1, 16);
+BENCHMARK(BM_allocatePooled)->Arg(100)->Arg(4 * 1024)->Arg(48 * 1024)->ThreadRange(1, 16);
+BENCHMARK(BM_buildReply)->Arg(200)->Arg(4 * 1024)->Arg(48 * 1024);
+BENCHMARK(BM_buildReplyPooled)->Arg(200)->Arg(4 * 1024)->Arg(48 * 1024);
+
+}  // namespace
+}  // namespace mongo
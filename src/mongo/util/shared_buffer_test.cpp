@@ -0,0 +1,123 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/shared_buffer.h"
+
+#include <cstring>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/util/builder.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+BSONObj poolStats() {
+    BSONObjBuilder b;
+    SharedBuffer::appendPoolStats(&b);
+    return b.obj();
+}
+
+TEST(SharedBufferPool, RoundsUpToSizeClasses) {
+    ASSERT_EQ(512U, SharedBuffer::allocatePooled(1).capacity());
+    ASSERT_EQ(512U, SharedBuffer::allocatePooled(512).capacity());
+    ASSERT_EQ(1024U, SharedBuffer::allocatePooled(513).capacity());
+    ASSERT_EQ(64U * 1024, SharedBuffer::allocatePooled(64 * 1024).capacity());
+
+    const auto before = poolStats();
+    ASSERT_EQ(64U * 1024 + 1, SharedBuffer::allocatePooled(64 * 1024 + 1).capacity());
+    ASSERT_EQ(before["oversized"].numberLong() + 1, poolStats()["oversized"].numberLong());
+}
+
+TEST(SharedBufferPool, ReusesReleasedBuffers) {
+    const char* data;
+    {
+        auto buffer = SharedBuffer::allocatePooled(2000);
+        data = buffer.get();
+    }
+
+    const auto before = poolStats();
+    auto buffer = SharedBuffer::allocatePooled(2000);
+    ASSERT_EQ(data, buffer.get());
+
+    const auto after = poolStats();
+    ASSERT_EQ(before["hits"].numberLong() + 1, after["hits"].numberLong());
+    ASSERT_EQ(before["misses"].numberLong(), after["misses"].numberLong());
+    ASSERT_EQ(before["sizeClasses"]["2048"]["hits"].numberLong() + 1,
+              after["sizeClasses"]["2048"]["hits"].numberLong());
+}
+
+TEST(SharedBufferPool, ReallocMovesToLargerClass) {
+    auto buffer = SharedBuffer::allocatePooled(512);
+    for (int i = 0; i < 512; i++) {
+        buffer.get()[i] = static_cast<char>(i);
+    }
+
+    buffer.realloc(100);
+    ASSERT_EQ(512U, buffer.capacity());
+
+    buffer.realloc(3000);
+    ASSERT_EQ(4096U, buffer.capacity());
+    for (int i = 0; i < 512; i++) {
+        ASSERT_EQ(static_cast<char>(i), buffer.get()[i]);
+    }
+
+    buffer.realloc(100 * 1024);
+    ASSERT_EQ(100U * 1024, buffer.capacity());
+    for (int i = 0; i < 512; i++) {
+        ASSERT_EQ(static_cast<char>(i), buffer.get()[i]);
+    }
+}
+
+TEST(SharedBufferPool, BufBuilderGrowsThroughPool) {
+    BufBuilder builder(0);
+    builder.useSharedBuffer(SharedBuffer::allocatePooled(512));
+
+    const std::string str(10000, 'x');
+    for (int i = 0; i < 10; i++) {
+        builder.appendStr(str, false);
+    }
+
+    auto buffer = builder.release();
+    ASSERT_EQ(128U * 1024, buffer.capacity());
+    ASSERT_EQ(str, std::string(buffer.get() + 9 * str.size(), str.size()));
+}
+
+TEST(SharedBufferPool, BuffersCachedByExitingThreadsAreShared) {
+    auto buffer = SharedBuffer::allocatePooled(32 * 1024);
+
+    const auto before = poolStats()["sharedCacheBytes"].numberLong();
+    stdx::thread([buffer = std::move(buffer)]() mutable { buffer = {}; }).join();
+    ASSERT_EQ(before + 32 * 1024, poolStats()["sharedCacheBytes"].numberLong());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+
+set -o verbose
+set -o errexit
+
+# This script downloads and imports Zstandard.
+# Only the library is imported, and it is built by our own SConscript without any of the
+# build systems which come with it. The assembly Huffman decoder and the support for the legacy
+# formats are left out, see the SConscript.
+#
+
+VERSION=1.5.7
+NAME=zstd
+TARBALL=${NAME}-${VERSION}.tar.gz
+TARBALL_DEST_DIR=${NAME}-${VERSION}
+DEST_DIR=$(git rev-parse --show-toplevel)/src/third_party/zstandard-${VERSION}
+
+echo ${DEST_DIR}
+
+rm -fr ${TARBALL_DEST_DIR}
+rm -f ${TARBALL}
+
+if [ ! -f ${TARBALL} ]; then
+    echo "Get tarball"
+    wget https://github.com/facebook/${NAME}/releases/download/v${VERSION}/${TARBALL}
+fi
+
+tar -zxvf ${TARBALL}
+
+# Keep our SConscript
+mv ${DEST_DIR}/SConscript ${TARBALL_DEST_DIR}/SConscript.mongodb || true
+rm -rf ${DEST_DIR}
+mkdir -p ${DEST_DIR}/zstd/lib
+
+for dir in common compress decompress dictBuilder; do
+    mv ${TARBALL_DEST_DIR}/lib/${dir} ${DEST_DIR}/zstd/lib
+done
+mv ${TARBALL_DEST_DIR}/lib/{zstd.h,zdict.h,zstd_errors.h} ${DEST_DIR}/zstd/lib
+rm -f ${DEST_DIR}/zstd/lib/decompress/huf_decompress_amd64.S
+mv ${TARBALL_DEST_DIR}/{LICENSE,COPYING} ${DEST_DIR}/zstd
+mv ${TARBALL_DEST_DIR}/SConscript.mongodb ${DEST_DIR}/SConscript || true
+
+rm -fR ${TARBALL_DEST_DIR}
+rm -f ${TARBALL}
+
+echo "Done"